@@ -21,6 +21,7 @@
 #include <dm/pinctrl.h>
 #include <linux/soc/ti/ti_sci_protocol.h>
 #include <log.h>
+#include <malloc.h>
 #include <mmc.h>
 #include <stdlib.h>
 
@@ -207,7 +208,7 @@ void board_init_f(ulong dummy)
 	 * new malloc area inside the currently active pre-relocation "first"
 	 * malloc pool of which we use all that's left.
 	 */
-	pool_size = CONFIG_VAL(SYS_MALLOC_F_LEN) - gd->malloc_ptr;
+	pool_size = malloc_simple_avail();
 	pool_addr = malloc(pool_size);
 	if (!pool_addr)
 		panic("ERROR: Can't allocate full malloc pool!\n");
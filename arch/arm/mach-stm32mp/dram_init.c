@@ -57,6 +57,7 @@ ulong board_get_usable_ram_top(ulong total_size)
 	size = ALIGN(SZ_8M + CONFIG_SYS_MALLOC_LEN + total_size, MMU_SECTION_SIZE),
 	reg = lmb_alloc(&lmb, size, MMU_SECTION_SIZE);
 
+	lmb_uninit(&lmb);
 	if (!reg)
 		reg = gd->ram_top - size;
 
@@ -148,6 +148,32 @@ int sandbox_pwm_get_config(struct udevice *dev, uint channel, uint *period_nsp,
  */
 void sandbox_sf_set_block_protect(struct udevice *dev, int bp_mask);
 
+#define SANDBOX_SF_MAX_ERASES	16
+
+/**
+ * struct sandbox_sf_erase - An erase carried out by the SPI flash emulator
+ *
+ * @offset: Offset of the erased block in the flash
+ * @size: Size of the erased block in bytes
+ */
+struct sandbox_sf_erase {
+	uint offset;
+	uint size;
+};
+
+/**
+ * sandbox_sf_get_erases() - Get the erases carried out since the last call
+ *
+ * Only the first SANDBOX_SF_MAX_ERASES erases are recorded. The record is
+ * cleared by this call.
+ *
+ * @dev: Device to check
+ * @erasesp: Returns the erases which were recorded, oldest first
+ * Return: number of erases carried out
+ */
+int sandbox_sf_get_erases(struct udevice *dev,
+			  const struct sandbox_sf_erase **erasesp);
+
 /**
  * sandbox_get_codec_params() - Read back codec parameters
  *
@@ -578,17 +578,38 @@ int image_setup_libfdt(bootm_headers_t *images, void *blob,
 {
 	ulong *initrd_start = &images->initrd_start;
 	ulong *initrd_end = &images->initrd_end;
+	struct fdt_batch batch;
 	int ret = -EPERM;
 	int fdt_ret;
 
-	if (fdt_root(blob) < 0) {
+	/*
+	 * The root and chosen fixups only set properties, so collect them and
+	 * write them out together rather than moving the blob for each one
+	 */
+	fdt_batch_init(&batch, blob);
+	if (fdt_root_batch(&batch) < 0) {
 		printf("ERROR: root node setup failed\n");
-		goto err;
+		goto err_batch;
 	}
-	if (fdt_chosen(blob) < 0) {
+	if (fdt_chosen_batch(&batch) < 0) {
 		printf("ERROR: /chosen node create failed\n");
-		goto err;
+		goto err_batch;
+	}
+	fdt_ret = fdt_batch_commit(&batch);
+	if (fdt_ret) {
+		printf("ERROR: generic fdt fixups failed: %s\n",
+		       fdt_strerror(fdt_ret));
+		goto err_batch;
 	}
+
+	/* Update ethernet nodes, which does not stop the boot if it fails */
+	fdt_fixup_ethernet_batch(&batch);
+	fdt_ret = fdt_batch_commit(&batch);
+	fdt_batch_uninit(&batch);
+	if (fdt_ret)
+		printf("WARNING: could not update ethernet nodes: %s\n",
+		       fdt_strerror(fdt_ret));
+
 	if (arch_fixup_fdt(blob) < 0) {
 		printf("ERROR: arch-specific fdt fixup failed\n");
 		goto err;
@@ -601,8 +622,6 @@ int image_setup_libfdt(bootm_headers_t *images, void *blob,
 		goto err;
 	}
 
-	/* Update ethernet nodes */
-	fdt_fixup_ethernet(blob);
 #if CONFIG_IS_ENABLED(CMD_PSTORE)
 	/* Append PStore configuration */
 	fdt_fixup_pstore(blob);
@@ -659,6 +678,8 @@ int image_setup_libfdt(bootm_headers_t *images, void *blob,
 #endif
 
 	return 0;
+err_batch:
+	fdt_batch_uninit(&batch);
 err:
 	printf(" - must RESET the board to recover.\n\n");
 
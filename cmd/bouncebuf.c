@@ -0,0 +1,52 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Bounce buffer statistics
+ */
+
+#include <common.h>
+#include <bouncebuf.h>
+#include <command.h>
+
+static int do_bouncebuf_stats(struct cmd_tbl *cmdtp, int flag, int argc,
+			      char *const argv[])
+{
+	struct bounce_buffer_stats stats;
+	size_t pool_size;
+	int slots, count;
+
+	bounce_buffer_get_stats(&stats);
+	printf("sessions:       %lu\n", stats.starts);
+	printf("  direct:       %lu\n", stats.direct);
+	printf("  full bounce:  %lu\n", stats.full);
+	printf("  partial:      %lu\n", stats.partial);
+	printf("pool hits:      %lu\n", stats.pool_hits);
+	printf("pool misses:    %lu\n", stats.pool_misses);
+	printf("alloc failures: %lu\n", stats.alloc_failures);
+	printf("bytes copied:   %llu\n", (unsigned long long)stats.bytes_copied);
+
+	slots = bounce_buffer_pool_info(&count, &pool_size);
+	if (slots) {
+		printf("pool:           %d/%d buffers, ", count, slots);
+		print_size(pool_size, "\n");
+	}
+
+	return CMD_RET_SUCCESS;
+}
+
+static int do_bouncebuf_reset(struct cmd_tbl *cmdtp, int flag, int argc,
+			      char *const argv[])
+{
+	bounce_buffer_reset_stats();
+	bounce_buffer_pool_release();
+
+	return CMD_RET_SUCCESS;
+}
+
+static char bouncebuf_help_text[] =
+	"stats - show bounce buffer statistics\n"
+	"bouncebuf reset - reset statistics and release idle pool buffers";
+
+U_BOOT_CMD_WITH_SUBCMDS(bouncebuf, "DMA bounce buffer diagnostics",
+			bouncebuf_help_text,
+			U_BOOT_SUBCMD_MKENT(stats, 1, 1, do_bouncebuf_stats),
+			U_BOOT_SUBCMD_MKENT(reset, 1, 1, do_bouncebuf_reset));
@@ -64,6 +64,14 @@ static int do_dm_dump_static_driver_info(struct cmd_tbl *cmdtp, int flag, int ar
 	return 0;
 }
 
+static int do_dm_dump_ofnode_hash(struct cmd_tbl *cmdtp, int flag, int argc,
+				  char *const argv[])
+{
+	dm_dump_ofnode_hash();
+
+	return 0;
+}
+
 static struct cmd_tbl test_commands[] = {
 	U_BOOT_CMD_MKENT(tree, 0, 1, do_dm_dump_all, "", ""),
 	U_BOOT_CMD_MKENT(uclass, 1, 1, do_dm_dump_uclass, "", ""),
@@ -71,6 +79,7 @@ static struct cmd_tbl test_commands[] = {
 	U_BOOT_CMD_MKENT(drivers, 1, 1, do_dm_dump_drivers, "", ""),
 	U_BOOT_CMD_MKENT(compat, 1, 1, do_dm_dump_driver_compat, "", ""),
 	U_BOOT_CMD_MKENT(static, 1, 1, do_dm_dump_static_driver_info, "", ""),
+	U_BOOT_CMD_MKENT(hash, 1, 1, do_dm_dump_ofnode_hash, "", ""),
 };
 
 static __maybe_unused void dm_reloc(void)
@@ -114,5 +123,6 @@ U_BOOT_CMD(
 	"dm devres        Dump list of device resources for each device\n"
 	"dm drivers       Dump list of drivers with uclass and instances\n"
 	"dm compat        Dump list of drivers with compatibility strings\n"
-	"dm static        Dump list of drivers with static platform data"
+	"dm static        Dump list of drivers with static platform data\n"
+	"dm hash          Show statistics for finding devices by node"
 );
@@ -30,8 +30,11 @@ static int do_load_wrapper(struct cmd_tbl *cmdtp, int flag, int argc,
 }
 
 U_BOOT_CMD(
-	load,	7,	0,	do_load_wrapper,
+	load,	9,	0,	do_load_wrapper,
 	"load binary file from a filesystem",
+#if CONFIG_IS_ENABLED(HASH)
+	"[-h <algo>] "
+#endif
 	"<interface> [<dev[:part]> [<addr> [<filename> [bytes [pos]]]]]\n"
 	"    - Load binary file 'filename' from partition 'part' on device\n"
 	"       type 'interface' instance 'dev' to address 'addr' in memory.\n"
@@ -39,6 +42,10 @@ U_BOOT_CMD(
 	"      If 'bytes' is 0 or omitted, the file is read until the end.\n"
 	"      'pos' gives the file byte position to start reading from.\n"
 	"      If 'pos' is 0 or omitted, the file is read from the start."
+#if CONFIG_IS_ENABLED(HASH)
+	"\n"
+	"      With -h, the data is hashed with 'algo' while it is loaded."
+#endif
 )
 
 static int do_save_wrapper(struct cmd_tbl *cmdtp, int flag, int argc,
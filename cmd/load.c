@@ -157,7 +157,8 @@ static ulong load_serial(long offset)
 		type = srec_decode(record, &binlen, &addr, binbuf);
 
 		if (type < 0) {
-			return (~0);		/* Invalid S-Record		*/
+			ret = ~0;		/* Invalid S-Record		*/
+			goto out;
 		}
 
 		switch (type) {
@@ -172,7 +173,8 @@ static ulong load_serial(long offset)
 			rc = flash_write((char *)binbuf,store_addr,binlen);
 			if (rc != 0) {
 				flash_perror(rc);
-				return (~0);
+				ret = ~0;
+				goto out;
 			}
 		    } else
 #endif
@@ -181,7 +183,7 @@ static ulong load_serial(long offset)
 			if (ret) {
 				printf("\nCannot overwrite reserved area (%08lx..%08lx)\n",
 					store_addr, store_addr + binlen);
-				return ret;
+				goto out;
 			}
 			memcpy((char *)(store_addr), binbuf, binlen);
 			lmb_free(&lmb, store_addr, binlen);
@@ -204,7 +206,8 @@ static ulong load_serial(long offset)
 		    );
 		    flush_cache(start_addr, size);
 		    env_set_hex("filesize", size);
-		    return (addr);
+		    ret = addr;
+		    goto out;
 		case SREC_START:
 		    break;
 		default:
@@ -216,7 +219,11 @@ static ulong load_serial(long offset)
 		}
 	}
 
-	return (~0);			/* Download aborted		*/
+	ret = ~0;			/* Download aborted		*/
+out:
+	lmb_uninit(&lmb);
+
+	return ret;
 }
 
 static int read_record(char *buf, ulong len)
@@ -0,0 +1,52 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Command-line access to the malloc() heaps
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+#include <malloc_cache.h>
+
+/* Percentage of free space not in the largest free block */
+static uint frag_percent(ulong free, ulong largest)
+{
+	if (!free)
+		return 0;
+
+	return (free - largest) * 100ULL / free;
+}
+
+static int do_malloc_info(struct cmd_tbl *cmdtp, int flag, int argc,
+			  char *const argv[])
+{
+	struct malloc_heap_info info;
+
+	malloc_get_heap_info(&info);
+	printf("heap        size %lx, in use %lx, free %lx in %x chunks\n",
+	       info.size, info.in_use, info.free, info.free_chunks);
+	printf("            largest free %lx, fragmentation %u%%\n",
+	       info.largest_free, frag_percent(info.free, info.largest_free));
+	if (info.large_size) {
+		printf("large heap  size %lx, in use %lx in %x blocks\n",
+		       info.large_size, info.large_in_use, info.large_blocks);
+		printf("            largest free %lx, fragmentation %u%%\n",
+		       info.large_largest_free,
+		       frag_percent(info.large_size - info.large_in_use,
+				    info.large_largest_free));
+	}
+	if (CONFIG_IS_ENABLED(SYS_MALLOC_CACHE)) {
+		printf("caches      unused %lx\n", malloc_cache_unused());
+		malloc_cache_info();
+	}
+
+	return 0;
+}
+
+#ifdef CONFIG_SYS_LONGHELP
+static char malloc_help_text[] =
+	"info   - show the usage and fragmentation of the malloc() heaps";
+#endif
+
+U_BOOT_CMD_WITH_SUBCMDS(malloc, "malloc() heaps", malloc_help_text,
+	U_BOOT_SUBCMD_MKENT(info, 1, 1, do_malloc_info));
@@ -159,6 +159,7 @@ static int do_spi_flash_probe(int argc, char *const argv[])
  * what is already there.
  *
  * If the data being written is the same, then *skipped is incremented by len.
+ * A sector which is already blank is written without erasing it first.
  *
  * @param flash		flash context pointer
  * @param offset	flash offset to write
@@ -185,6 +186,13 @@ static const char *spi_flash_update_block(struct spi_flash *flash, u32 offset,
 		*skipped += len;
 		return NULL;
 	}
+	/* A blank sector only needs the new data programmed */
+	if (!memchr_inv(cmp_buf, 0xff, flash->sector_size)) {
+		debug("Skip erase %x: already blank\n", offset);
+		if (spi_flash_write(flash, offset, len, buf))
+			return "write";
+		return NULL;
+	}
 	/* Erase the entire sector */
 	if (spi_flash_erase(flash, offset, flash->sector_size))
 		return "erase";
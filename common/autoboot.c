@@ -18,6 +18,7 @@
 #include <memalign.h>
 #include <menu.h>
 #include <post.h>
+#include <stdio_dev.h>
 #include <time.h>
 #include <asm/global_data.h>
 #include <linux/delay.h>
@@ -38,6 +39,9 @@ DECLARE_GLOBAL_DATA_PTR;
 
 /* Stored value of bootdelay, used by autoboot_command() */
 static int stored_bootdelay;
+
+/* Whether console set-up is skipped: -1 if not decided yet, else 0 or 1 */
+static int console_deferred = -1;
 static int menukey;
 
 #if !defined(CONFIG_AUTOBOOT_STOP_STR_CRYPT)
@@ -436,19 +440,56 @@ static void process_fdt_options(const void *blob)
 #endif /* CONFIG_SYS_TEXT_BASE */
 }
 
-const char *bootdelay_process(void)
+static int get_bootdelay(void)
 {
 	char *s;
 	int bootdelay;
 
-	bootcount_inc();
-
 	s = env_get("bootdelay");
 	bootdelay = s ? (int)simple_strtol(s, NULL, 10) : CONFIG_BOOTDELAY;
 
 	if (IS_ENABLED(CONFIG_OF_CONTROL))
 		bootdelay = ofnode_conf_read_int("bootdelay", bootdelay);
 
+	return bootdelay;
+}
+
+bool autoboot_defer_console(void)
+{
+	int bootdelay;
+
+	if (!IS_ENABLED(CONFIG_AUTOBOOT_FAST))
+		return false;
+	if (console_deferred != -1)
+		return console_deferred;
+
+	/* A key waiting on the serial port means the user wants a prompt */
+	bootdelay = get_bootdelay();
+	console_deferred = env_get("bootcmd") &&
+		(bootdelay == -2 || (bootdelay == 0 && !tstc()));
+
+	return console_deferred;
+}
+
+void autoboot_console_init(void)
+{
+	if (console_deferred != 1)
+		return;
+
+	console_deferred = 0;
+	stdio_add_devices();
+	console_init_r();
+}
+
+const char *bootdelay_process(void)
+{
+	char *s;
+	int bootdelay;
+
+	bootcount_inc();
+
+	bootdelay = get_bootdelay();
+
 	debug("### main_loop entered: bootdelay=%d\n\n", bootdelay);
 
 	if (IS_ENABLED(CONFIG_AUTOBOOT_MENU_SHOW))
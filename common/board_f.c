@@ -541,6 +541,11 @@ static int reserve_bootstage(void)
 #ifdef CONFIG_BOOTSTAGE
 	int size = bootstage_get_size();
 
+	/* Leave room for the names of initcalls timed until relocation */
+	if (IS_ENABLED(CONFIG_BOOTSTAGE_INITCALL))
+		size += CONFIG_BOOTSTAGE_RECORD_COUNT *
+			BOOTSTAGE_INITCALL_NAME_LEN;
+
 	gd->start_addr_sp = reserve_stack_aligned(size);
 	gd->new_bootstage = map_sysmem(gd->start_addr_sp, size);
 	debug("Reserving %#x Bytes for bootstage at: %08lx\n", size,
@@ -11,6 +11,7 @@
 
 #include <common.h>
 #include <api.h>
+#include <autoboot.h>
 #include <bootstage.h>
 #include <cpu_func.h>
 #include <exports.h>
@@ -451,6 +452,23 @@ static int initr_env(void)
 	return 0;
 }
 
+/* With AUTOBOOT_FAST this is left until autoboot is interrupted */
+static int initr_stdio(void)
+{
+	if (autoboot_defer_console())
+		return 0;
+
+	return stdio_add_devices();
+}
+
+static int initr_console(void)
+{
+	if (autoboot_defer_console())
+		return 0;
+
+	return console_init_r();
+}
+
 #ifdef CONFIG_SYS_BOOTPARAMS_LEN
 static int initr_malloc_bootparams(void)
 {
@@ -719,12 +737,12 @@ static init_fnc_t init_sequence_r[] = {
 	 */
 	pci_init,
 #endif
-	stdio_add_devices,
+	initr_stdio,
 	jumptable_init,
 #ifdef CONFIG_API
 	api_init,
 #endif
-	console_init_r,		/* fully init console as a device */
+	initr_console,		/* fully init console as a device */
 #ifdef CONFIG_DISPLAY_BOARDINFO_LATE
 	console_announce_r,
 	show_board_info,
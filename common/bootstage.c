@@ -14,6 +14,7 @@
 #include <common.h>
 #include <bootstage.h>
 #include <hang.h>
+#include <kallsyms.h>
 #include <log.h>
 #include <malloc.h>
 #include <sort.h>
@@ -224,6 +225,44 @@ uint32_t bootstage_accum(enum bootstage_id id)
 	return duration;
 }
 
+uint32_t bootstage_initcall_start(void)
+{
+	if (!gd->bootstage)
+		return 0;
+
+	return timer_get_boot_us();
+}
+
+void bootstage_initcall_end(ulong func, uint32_t start_us)
+{
+	struct bootstage_data *data = gd->bootstage;
+	struct bootstage_record *rec;
+	const char *sym = NULL;
+	ulong base;
+	char *name;
+
+	if (!data || !start_us || data->rec_count >= RECORD_COUNT)
+		return;
+
+	name = malloc(BOOTSTAGE_INITCALL_NAME_LEN);
+	if (!name)
+		return;
+	if (IS_ENABLED(CONFIG_KALLSYMS))
+		sym = symbol_lookup(func, &base);
+	if (sym && base == func)
+		strlcpy(name, sym, BOOTSTAGE_INITCALL_NAME_LEN);
+	else
+		snprintf(name, BOOTSTAGE_INITCALL_NAME_LEN, "initcall %08lx",
+			 func);
+
+	rec = &data->record[data->rec_count++];
+	rec->id = data->next_id++;
+	rec->name = name;
+	rec->flags = 0;
+	rec->start_us = start_us;
+	rec->time_us = (uint32_t)timer_get_boot_us() - start_us;
+}
+
 /**
  * Get a record name as a printable string
  *
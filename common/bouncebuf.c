@@ -12,6 +12,166 @@
 #include <errno.h>
 #include <bouncebuf.h>
 #include <asm/cache.h>
+#include <asm/global_data.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+static struct bounce_buffer_stats bb_stats;
+
+#ifdef CONFIG_BOUNCE_BUFFER_POOL
+/**
+ * struct bb_pool_entry - A cached bounce buffer
+ *
+ * @buf:	Aligned buffer, NULL if the slot is empty
+ * @size:	Size of @buf in bytes
+ * @busy:	true if @buf is in use by a bounce buffer session
+ */
+struct bb_pool_entry {
+	void *buf;
+	size_t size;
+	bool busy;
+};
+
+static struct bb_pool_entry bb_pool[CONFIG_BOUNCE_BUFFER_POOL_ENTRIES];
+
+static bool bb_pool_usable(void)
+{
+	/*
+	 * Buffers allocated from the simple pre-relocation heap must not be
+	 * kept beyond relocation, so only pool buffers from the full heap.
+	 */
+	return gd->flags & GD_FLG_FULL_MALLOC_INIT;
+}
+
+static void *bb_alloc(size_t alignment, size_t size)
+{
+	struct bb_pool_entry *ent, *fit = NULL, *slot = NULL;
+	int i;
+
+	if (!bb_pool_usable())
+		return memalign(alignment, size);
+
+	/* Large buffers are freed again by bb_free() */
+	if (size > CONFIG_BOUNCE_BUFFER_POOL_MAX_SIZE) {
+		bb_stats.pool_misses++;
+		return memalign(alignment, size);
+	}
+
+	for (i = 0; i < ARRAY_SIZE(bb_pool); i++) {
+		ent = &bb_pool[i];
+		if (ent->busy)
+			continue;
+		if (!ent->buf) {
+			if (!slot || slot->buf)
+				slot = ent;
+			continue;
+		}
+		if (ent->size >= size &&
+		    !((ulong)ent->buf & (alignment - 1)) &&
+		    (!fit || ent->size < fit->size))
+			fit = ent;
+		else if (!slot || (slot->buf && ent->size < slot->size))
+			slot = ent;
+	}
+
+	if (fit) {
+		bb_stats.pool_hits++;
+		fit->busy = true;
+		return fit->buf;
+	}
+
+	bb_stats.pool_misses++;
+	if (!slot)
+		return memalign(alignment, size);
+
+	/* Replace the smallest idle buffer (or use an empty slot) */
+	free(slot->buf);
+	slot->buf = memalign(alignment, size);
+	if (!slot->buf)
+		return NULL;
+	slot->size = size;
+	slot->busy = true;
+
+	return slot->buf;
+}
+
+static void bb_free(void *buf)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(bb_pool); i++) {
+		if (bb_pool[i].buf == buf && bb_pool[i].busy) {
+			bb_pool[i].busy = false;
+			return;
+		}
+	}
+
+	free(buf);
+}
+
+int bounce_buffer_pool_info(int *count, size_t *size)
+{
+	int i;
+
+	*count = 0;
+	*size = 0;
+	for (i = 0; i < ARRAY_SIZE(bb_pool); i++) {
+		if (bb_pool[i].buf) {
+			(*count)++;
+			*size += bb_pool[i].size;
+		}
+	}
+
+	return ARRAY_SIZE(bb_pool);
+}
+
+void bounce_buffer_pool_release(void)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(bb_pool); i++) {
+		if (bb_pool[i].buf && !bb_pool[i].busy) {
+			free(bb_pool[i].buf);
+			bb_pool[i].buf = NULL;
+			bb_pool[i].size = 0;
+		}
+	}
+}
+#else
+static void *bb_alloc(size_t alignment, size_t size)
+{
+	bb_stats.pool_misses++;
+
+	return memalign(alignment, size);
+}
+
+static void bb_free(void *buf)
+{
+	free(buf);
+}
+
+int bounce_buffer_pool_info(int *count, size_t *size)
+{
+	*count = 0;
+	*size = 0;
+
+	return 0;
+}
+
+void bounce_buffer_pool_release(void)
+{
+}
+#endif
+
+void bounce_buffer_get_stats(struct bounce_buffer_stats *stats)
+{
+	*stats = bb_stats;
+}
+
+void bounce_buffer_reset_stats(void)
+{
+	memset(&bb_stats, '\0', sizeof(bb_stats));
+}
 
 static int addr_aligned(struct bounce_buffer *state)
 {
@@ -33,27 +193,103 @@ static int addr_aligned(struct bounce_buffer *state)
 	return 1;
 }
 
+static void bb_add_seg(struct bounce_buffer *state, void *addr, size_t len)
+{
+	state->seg[state->nsegs].addr = addr;
+	state->seg[state->nsegs].len = len;
+	state->nsegs++;
+}
+
+/*
+ * Bounce only the parts of the buffer which share a cache line with other
+ * data. Returns -EAGAIN if there is no aligned middle part to use directly.
+ */
+static int bounce_buffer_start_partial(struct bounce_buffer *state,
+				       size_t alignment)
+{
+	ulong start = (ulong)state->user_buffer;
+	ulong end = start + state->len;
+	ulong body_start = roundup(start, alignment);
+	ulong body_end = rounddown(end, alignment);
+	void *edge;
+
+	if (body_end <= body_start)
+		return -EAGAIN;
+
+	/* The head lives in the first and the tail in the second line */
+	edge = bb_alloc(alignment, 2 * alignment);
+	if (!edge)
+		return -ENOMEM;
+
+	state->edge_buffer = edge;
+	state->head_len = body_start - start;
+	state->tail_len = end - body_end;
+	state->bounce_buffer = (void *)body_start;
+
+	if (state->flags & GEN_BB_READ) {
+		memcpy(edge, state->user_buffer, state->head_len);
+		memcpy(edge + alignment, (void *)body_end, state->tail_len);
+		bb_stats.bytes_copied += state->head_len + state->tail_len;
+	}
+
+	if (state->head_len)
+		bb_add_seg(state, edge, state->head_len);
+	bb_add_seg(state, (void *)body_start, body_end - body_start);
+	if (state->tail_len)
+		bb_add_seg(state, edge + alignment, state->tail_len);
+
+	flush_dcache_range((ulong)edge, (ulong)edge + 2 * alignment);
+	flush_dcache_range(body_start, body_end);
+	bb_stats.partial++;
+
+	return 0;
+}
+
 int bounce_buffer_start_extalign(struct bounce_buffer *state, void *data,
 				 size_t len, unsigned int flags,
 				 size_t alignment,
 				 int (*addr_is_aligned)(struct bounce_buffer *state))
 {
+	int ret;
+
 	state->user_buffer = data;
 	state->bounce_buffer = data;
 	state->len = len;
 	state->len_aligned = roundup(len, alignment);
 	state->flags = flags;
+	state->edge_buffer = NULL;
+	state->head_len = 0;
+	state->tail_len = 0;
+	state->alignment = alignment;
+	state->nsegs = 0;
+	bb_stats.starts++;
 
-	if (!addr_is_aligned(state)) {
-		state->bounce_buffer = memalign(alignment,
-						state->len_aligned);
-		if (!state->bounce_buffer)
+	if (addr_is_aligned(state)) {
+		bb_stats.direct++;
+	} else {
+		if (flags & GEN_BB_PARTIAL) {
+			ret = bounce_buffer_start_partial(state, alignment);
+			if (ret != -EAGAIN) {
+				if (ret)
+					bb_stats.alloc_failures++;
+				return ret;
+			}
+		}
+
+		state->bounce_buffer = bb_alloc(alignment, state->len_aligned);
+		if (!state->bounce_buffer) {
+			bb_stats.alloc_failures++;
 			return -ENOMEM;
+		}
 
-		if (state->flags & GEN_BB_READ)
+		if (state->flags & GEN_BB_READ) {
 			memcpy(state->bounce_buffer, state->user_buffer,
 				state->len);
+			bb_stats.bytes_copied += state->len;
+		}
+		bb_stats.full++;
 	}
+	bb_add_seg(state, state->bounce_buffer, state->len);
 
 	/*
 	 * Flush data to RAM so DMA reads can pick it up,
@@ -74,8 +310,34 @@ int bounce_buffer_start(struct bounce_buffer *state, void *data,
 					    addr_aligned);
 }
 
+static int bounce_buffer_stop_partial(struct bounce_buffer *state)
+{
+	size_t alignment = state->alignment;
+	void *edge = state->edge_buffer;
+	ulong body_start = (ulong)state->bounce_buffer;
+	ulong body_end = (ulong)state->user_buffer + state->len -
+			 state->tail_len;
+
+	if (state->flags & GEN_BB_WRITE) {
+		invalidate_dcache_range((ulong)edge,
+					(ulong)edge + 2 * alignment);
+		invalidate_dcache_range(body_start, body_end);
+		memcpy(state->user_buffer, edge, state->head_len);
+		memcpy((void *)body_end, edge + alignment, state->tail_len);
+		bb_stats.bytes_copied += state->head_len + state->tail_len;
+	}
+
+	bb_free(edge);
+	state->edge_buffer = NULL;
+
+	return 0;
+}
+
 int bounce_buffer_stop(struct bounce_buffer *state)
 {
+	if (state->edge_buffer)
+		return bounce_buffer_stop_partial(state);
+
 	if (state->flags & GEN_BB_WRITE) {
 		/* Invalidate cache so that CPU can see any newly DMA'd data */
 		invalidate_dcache_range((unsigned long)state->bounce_buffer,
@@ -86,10 +348,12 @@ int bounce_buffer_stop(struct bounce_buffer *state)
 	if (state->bounce_buffer == state->user_buffer)
 		return 0;
 
-	if (state->flags & GEN_BB_WRITE)
+	if (state->flags & GEN_BB_WRITE) {
 		memcpy(state->user_buffer, state->bounce_buffer, state->len);
+		bb_stats.bytes_copied += state->len;
+	}
 
-	free(state->bounce_buffer);
+	bb_free(state->bounce_buffer);
 
 	return 0;
 }
@@ -19,6 +19,20 @@
 #include <g_dnl.h>
 #include <usb.h>
 #include <net.h>
+#include <blk.h>
+
+/* Go on receiving while a buffer is being written, until all are full */
+static int dfu_write_idle(void *priv)
+{
+	int *usbctrl_index = priv;
+
+	if (!dfu_write_ready())
+		return 0;
+
+	usb_gadget_handle_interrupts(*usbctrl_index);
+
+	return 1;
+}
 
 int run_usb_dnl_gadget(int usbctrl_index, char *usb_dnl_gadget)
 {
@@ -36,6 +50,7 @@ int run_usb_dnl_gadget(int usbctrl_index, char *usb_dnl_gadget)
 		pr_err("g_dnl_register failed");
 		return CMD_RET_FAILURE;
 	}
+	dfu_set_defer_write(true);
 
 #ifdef CONFIG_DFU_TIMEOUT
 	unsigned long start_time = get_timer(0);
@@ -65,6 +80,13 @@ int run_usb_dnl_gadget(int usbctrl_index, char *usb_dnl_gadget)
 		if (ctrlc())
 			goto exit;
 
+		if (dfu_write_pending()) {
+			blk_set_idle_work(dfu_write_idle, &usbctrl_index);
+			if (dfu_write_queued())
+				pr_err("Deferred dfu_write() failed!");
+			blk_set_idle_work(NULL, NULL);
+		}
+
 		if (dfu_get_defer_flush()) {
 			/*
 			 * Call to usb_gadget_handle_interrupts() is necessary
@@ -105,6 +127,7 @@ int run_usb_dnl_gadget(int usbctrl_index, char *usb_dnl_gadget)
 		usb_gadget_handle_interrupts(usbctrl_index);
 	}
 exit:
+	dfu_set_defer_write(false);
 	g_dnl_unregister();
 	usb_gadget_release(usbctrl_index);
 
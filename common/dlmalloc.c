@@ -17,7 +17,9 @@
 #endif
 
 #include <malloc.h>
+#include <malloc_cache.h>
 #include <asm/io.h>
+#include <linux/bitops.h>
 
 #ifdef DEBUG
 #if __STD_C
@@ -615,8 +617,96 @@ void *sbrk(ptrdiff_t increment)
 	return (void *)old;
 }
 
+#if CONFIG_IS_ENABLED(SYS_MALLOC_LARGE)
+#define MALLOC_LARGE_PAGES	(CONFIG_SYS_MALLOC_LARGE_LEN / malloc_getpagesize)
+
+/*
+ * The heap for large blocks, which takes the place of mmap(). It is tracked
+ * with one bit per page, so that freeing a block cannot fail and nothing
+ * here needs to call malloc()
+ */
+static ulong malloc_large_start;
+static ulong malloc_large_pages;
+static u32 malloc_large_used[DIV_ROUND_UP(MALLOC_LARGE_PAGES, 32)];
+
+static bool malloc_large_page_used(ulong page)
+{
+	return malloc_large_used[page / 32] & BIT(page % 32);
+}
+
+static void malloc_large_set(ulong page, ulong count, bool used)
+{
+	for (; count; page++, count--) {
+		if (used)
+			malloc_large_used[page / 32] |= BIT(page % 32);
+		else
+			malloc_large_used[page / 32] &= ~BIT(page % 32);
+	}
+}
+
+/* Take the heap for large blocks from the top of the malloc() area */
+static ulong malloc_large_init(ulong start, ulong size)
+{
+	ulong len = CONFIG_SYS_MALLOC_LARGE_LEN;
+	ulong base;
+
+	memset(malloc_large_used, '\0', sizeof(malloc_large_used));
+	malloc_large_start = 0;
+	malloc_large_pages = 0;
+	if (size < len * 2)
+		return size;
+	base = ALIGN(start + size - len, malloc_getpagesize);
+	malloc_large_start = base;
+	malloc_large_pages = (start + size - base) / malloc_getpagesize;
+
+	return base - start;
+}
+
+static void *malloc_large_map(size_t size)
+{
+	ulong count = size / malloc_getpagesize;
+	ulong page, run = 0;
+
+	for (page = 0; page < malloc_large_pages; page++) {
+		run = malloc_large_page_used(page) ? 0 : run + 1;
+		if (run == count) {
+			page -= count - 1;
+			malloc_large_set(page, count, true);
+
+			return (void *)(malloc_large_start +
+					page * malloc_getpagesize);
+		}
+	}
+
+	return NULL;
+}
+
+static void malloc_large_unmap(void *ptr, size_t size)
+{
+	ulong page = ((ulong)ptr - malloc_large_start) / malloc_getpagesize;
+
+	malloc_large_set(page, size / malloc_getpagesize, false);
+}
+
+/* Get the longest run of free pages in the heap for large blocks */
+static ulong malloc_large_largest_free(void)
+{
+	ulong page, run = 0, largest = 0;
+
+	for (page = 0; page < malloc_large_pages; page++) {
+		run = malloc_large_page_used(page) ? 0 : run + 1;
+		largest = max(largest, run);
+	}
+
+	return largest * malloc_getpagesize;
+}
+#endif
+
 void mem_malloc_init(ulong start, ulong size)
 {
+#if CONFIG_IS_ENABLED(SYS_MALLOC_LARGE)
+	size = malloc_large_init(start, size);
+#endif
 	mem_malloc_start = start;
 	mem_malloc_end = start + size;
 	mem_malloc_brk = start;
@@ -720,9 +810,9 @@ static struct mallinfo current_mallinfo = {  0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
 
 /* Tracking mmaps */
 
-#ifdef DEBUG
+#if defined(DEBUG) || HAVE_MMAP
 static unsigned int n_mmaps = 0;
-#endif	/* DEBUG */
+#endif	/* DEBUG || HAVE_MMAP */
 static unsigned long mmapped_mem = 0;
 #if HAVE_MMAP
 static unsigned int max_n_mmaps = 0;
@@ -987,10 +1077,6 @@ static mchunkptr mmap_chunk(size) size_t size;
   size_t page_mask = malloc_getpagesize - 1;
   mchunkptr p;
 
-#ifndef MAP_ANONYMOUS
-  static int fd = -1;
-#endif
-
   if(n_mmaps >= n_mmaps_max) return 0; /* too many regions */
 
   /* For mmapped chunks, the overhead is one SIZE_SZ unit larger, because
@@ -998,19 +1084,8 @@ static mchunkptr mmap_chunk(size) size_t size;
    */
   size = (size + SIZE_SZ + page_mask) & ~page_mask;
 
-#ifdef MAP_ANONYMOUS
-  p = (mchunkptr)mmap(0, size, PROT_READ|PROT_WRITE,
-		      MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
-#else /* !MAP_ANONYMOUS */
-  if (fd < 0)
-  {
-    fd = open("/dev/zero", O_RDWR);
-    if(fd < 0) return 0;
-  }
-  p = (mchunkptr)mmap(0, size, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, 0);
-#endif
-
-  if(p == (mchunkptr)-1) return 0;
+  p = (mchunkptr)malloc_large_map(size);
+  if (!p) return 0;
 
   n_mmaps++;
   if (n_mmaps > max_n_mmaps) max_n_mmaps = n_mmaps;
@@ -1040,7 +1115,6 @@ static void munmap_chunk(p) mchunkptr p;
 #endif
 {
   INTERNAL_SIZE_T size = chunksize(p);
-  int ret;
 
   assert (chunk_is_mmapped(p));
   assert(! ((char*)p >= sbrk_base && (char*)p < sbrk_base + sbrked_mem));
@@ -1050,10 +1124,7 @@ static void munmap_chunk(p) mchunkptr p;
   n_mmaps--;
   mmapped_mem -= (size + p->prev_size);
 
-  ret = munmap((char *)p - p->prev_size, size + p->prev_size);
-
-  /* munmap returns non-zero on failure */
-  assert(ret == 0);
+  malloc_large_unmap((char *)p - p->prev_size, size + p->prev_size);
 }
 
 #if HAVE_MREMAP
@@ -1316,6 +1387,13 @@ Void_t* mALLOc(bytes) size_t bytes;
 
   nb = request2size(bytes);  /* padded request size; */
 
+#if HAVE_MMAP
+  /* Keep big blocks out of the main heap unless there is no room for them */
+  if ((unsigned long)nb >= (unsigned long)mmap_threshold &&
+      (victim = mmap_chunk(nb)))
+    return chunk2mem(victim);
+#endif
+
   /* Check for exact match in a bin */
 
   if (is_small_request(nb))  /* Faster version for small requests */
@@ -1505,13 +1583,6 @@ Void_t* mALLOc(bytes) size_t bytes;
   if ( (remainder_size = chunksize(top) - nb) < (long)MINSIZE)
   {
 
-#if HAVE_MMAP
-    /* If big and would otherwise need to extend, try to use mmap instead */
-    if ((unsigned long)nb >= (unsigned long)mmap_threshold &&
-	(victim = mmap_chunk(nb)))
-      return chunk2mem(victim);
-#endif
-
     /* Try to extend */
     malloc_extend_top(nb);
     if ( (remainder_size = chunksize(top) - nb) < (long)MINSIZE)
@@ -1570,9 +1641,14 @@ void fREe(mem) Void_t* mem;
   int       islr;      /* track whether merging with last_remainder */
 
 #if CONFIG_VAL(SYS_MALLOC_F_LEN)
-	/* free() is a no-op - all the memory will be freed on relocation */
-	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT))
+	/*
+	 * Without an arena free() is a no-op - all the memory will be freed
+	 * on relocation
+	 */
+	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT)) {
+		free_simple(mem);
 		return;
+	}
 #endif
 
   if (mem == NULL)                              /* free(0) has no effect */
@@ -1731,6 +1807,8 @@ Void_t* rEALLOc(oldmem, bytes) Void_t* oldmem; size_t bytes;
 
 #if CONFIG_VAL(SYS_MALLOC_F_LEN)
 	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT)) {
+		if (CONFIG_IS_ENABLED(SYS_MALLOC_F_ARENA))
+			return realloc_simple(oldmem, bytes);
 		/* This is harder to support and should not be needed */
 		panic("pre-reloc realloc() is not supported");
 	}
@@ -2143,7 +2221,12 @@ Void_t* cALLOc(n, elem_size) size_t n; size_t elem_size;
 
 
 #if HAVE_MMAP
-    if (chunk_is_mmapped(p)) return mem;
+    /* The heap for large blocks is not cleared when they are freed */
+    if (chunk_is_mmapped(p))
+    {
+      MALLOC_ZERO(mem, sz);
+      return mem;
+    }
 #endif
 
     csz = chunksize(p);
@@ -2332,6 +2415,11 @@ static void malloc_update_mallinfo()
     }
   }
 
+#if CONFIG_IS_ENABLED(SYS_MALLOC_CACHE)
+  /* Objects not in use in a slab are free, as far as callers can tell */
+  avail += malloc_cache_unused();
+#endif
+
   current_mallinfo.ordblks = navail;
   current_mallinfo.uordblks = sbrked_mem - avail;
   current_mallinfo.fordblks = avail;
@@ -2388,6 +2476,40 @@ struct mallinfo mALLINFo()
 }
 #endif	/* DEBUG */
 
+void malloc_get_heap_info(struct malloc_heap_info *info)
+{
+	ulong unused = mem_malloc_end - mem_malloc_brk;
+	mchunkptr p;
+	mbinptr b;
+	int i;
+
+	memset(info, '\0', sizeof(*info));
+	info->size = mem_malloc_end - mem_malloc_start;
+
+	/* The top chunk can grow to the end of the malloc() area */
+	info->free = chunksize(top) + unused;
+	info->largest_free = info->free;
+	for (i = 1; i < NAV; ++i) {
+		b = bin_at(i);
+		for (p = last(b); p != b; p = p->bk) {
+			info->free += chunksize(p);
+			info->free_chunks++;
+			info->largest_free = max(info->largest_free,
+						 (ulong)chunksize(p));
+		}
+	}
+	if (chunksize(top) >= MINSIZE || unused)
+		info->free_chunks++;
+	info->in_use = info->size - info->free;
+
+#if CONFIG_IS_ENABLED(SYS_MALLOC_LARGE)
+	info->large_size = malloc_large_pages * malloc_getpagesize;
+	info->large_in_use = mmapped_mem;
+	info->large_blocks = n_mmaps;
+	info->large_largest_free = malloc_large_largest_free();
+#endif
+}
+
 
 
 
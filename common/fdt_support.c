@@ -9,8 +9,10 @@
 #include <common.h>
 #include <env.h>
 #include <log.h>
+#include <malloc.h>
 #include <mapmem.h>
 #include <net.h>
+#include <sort.h>
 #include <stdio_dev.h>
 #include <linux/ctype.h>
 #include <linux/types.h>
@@ -125,15 +127,428 @@ int fdt_find_or_add_subnode(void *fdt, int parentoffset, const char *name)
 	return offset;
 }
 
+/**
+ * struct fdt_batch_edit - a change recorded in a batch
+ *
+ * @node: Offset of the node in the FDT
+ * @name: Offset of the property name in the batch data
+ * @val: Offset of the value in the batch data
+ * @len: Length of the value in bytes
+ * @nameoff: Offset of the name in the strings block, set on commit
+ * @seq: Position of the change in the order they were recorded
+ * @del: true to delete the property, false to set it
+ * @add: true if the property is new to the node, set on commit
+ */
+struct fdt_batch_edit {
+	int node;
+	int name;
+	int val;
+	int len;
+	int nameoff;
+	int seq;
+	bool del;
+	bool add;
+};
+
+void fdt_batch_init(struct fdt_batch *batch, void *fdt)
+{
+	memset(batch, '\0', sizeof(*batch));
+	batch->fdt = fdt;
+}
+
+void fdt_batch_uninit(struct fdt_batch *batch)
+{
+	free(batch->edits);
+	free(batch->data);
+	fdt_batch_init(batch, batch->fdt);
+}
+
+/* Copy @len bytes into the batch data, returning their offset there */
+static int fdt_batch_store(struct fdt_batch *batch, const void *ptr, int len)
+{
+	int ofs = batch->data_len;
+
+	if (ofs + len > batch->data_max) {
+		int size = max(batch->data_max * 2, ofs + len + 256);
+		char *data;
+
+		data = realloc(batch->data, size);
+		if (!data)
+			return -FDT_ERR_NOSPACE;
+		batch->data = data;
+		batch->data_max = size;
+	}
+	if (len)
+		memcpy(batch->data + ofs, ptr, len);
+	batch->data_len += len;
+
+	return ofs;
+}
+
+static int fdt_batch_add(struct fdt_batch *batch, int nodeoffset,
+			 const char *name, const void *val, int len, bool del)
+{
+	struct fdt_batch_edit *edit;
+	int i, ret;
+
+	if (batch->err)
+		return batch->err;
+	if (!fdt_get_name(batch->fdt, nodeoffset, &ret))
+		goto err;
+	if (len < 0) {
+		ret = -FDT_ERR_BADVALUE;
+		goto err;
+	}
+
+	/* A later change to the same property replaces the earlier one */
+	for (i = 0; i < batch->count; i++) {
+		edit = &batch->edits[i];
+		if (edit->node == nodeoffset &&
+		    !strcmp(batch->data + edit->name, name))
+			break;
+	}
+	if (i == batch->count) {
+		if (batch->count == batch->max) {
+			int num = max(batch->max * 2, 16);
+
+			edit = realloc(batch->edits, num * sizeof(*edit));
+			if (!edit) {
+				ret = -FDT_ERR_NOSPACE;
+				goto err;
+			}
+			batch->edits = edit;
+			batch->max = num;
+		}
+		ret = fdt_batch_store(batch, name, strlen(name) + 1);
+		if (ret < 0)
+			goto err;
+		edit = &batch->edits[batch->count++];
+		edit->node = nodeoffset;
+		edit->name = ret;
+		edit->seq = i;
+	}
+	ret = fdt_batch_store(batch, val, len);
+	if (ret < 0)
+		goto err;
+	edit->val = ret;
+	edit->len = len;
+	edit->del = del;
+
+	return 0;
+err:
+	batch->err = ret;
+
+	return ret;
+}
+
+int fdt_batch_setprop(struct fdt_batch *batch, int nodeoffset,
+		      const char *name, const void *val, int len)
+{
+	return fdt_batch_add(batch, nodeoffset, name, val, len, false);
+}
+
+int fdt_batch_delprop(struct fdt_batch *batch, int nodeoffset,
+		      const char *name)
+{
+	return fdt_batch_add(batch, nodeoffset, name, NULL, 0, true);
+}
+
+static int fdt_batch_cmp(const void *a, const void *b)
+{
+	const struct fdt_batch_edit *ea = a, *eb = b;
+
+	if (ea->node != eb->node)
+		return ea->node - eb->node;
+
+	return ea->seq - eb->seq;
+}
+
+/*
+ * Apply the changes with the usual libfdt calls. Nodes are visited from the
+ * end of the tree backwards so that each change leaves the offsets of the
+ * nodes still to be changed alone.
+ */
+static int fdt_batch_apply_each(struct fdt_batch *batch)
+{
+	struct fdt_batch_edit *edit;
+	int start, end, i, ret;
+	const char *name;
+
+	for (end = batch->count; end > 0; end = start) {
+		for (start = end - 1; start > 0; start--) {
+			if (batch->edits[start - 1].node !=
+			    batch->edits[end - 1].node)
+				break;
+		}
+		for (i = start; i < end; i++) {
+			edit = &batch->edits[i];
+			name = batch->data + edit->name;
+			if (edit->del) {
+				ret = fdt_delprop(batch->fdt, edit->node, name);
+				if (ret == -FDT_ERR_NOTFOUND)
+					ret = 0;
+			} else {
+				ret = fdt_setprop(batch->fdt, edit->node, name,
+						  batch->data + edit->val,
+						  edit->len);
+			}
+			if (ret)
+				return ret;
+		}
+	}
+
+	return 0;
+}
+
+/* Find @s in the strings block, returning its offset or -1 */
+static int fdt_batch_find_string(const char *strtab, int size, const char *s)
+{
+	int len = strlen(s) + 1;
+	const char *p;
+
+	for (p = strtab; p <= strtab + size - len; p++) {
+		if (!memcmp(p, s, len))
+			return p - strtab;
+	}
+
+	return -1;
+}
+
+/*
+ * Work out the size of the blocks after the changes, returning the size of
+ * the structure block, and set up the name offset of each change
+ */
+static int fdt_batch_size(struct fdt_batch *batch, int *strings_sizep)
+{
+	int struct_size = fdt_size_dt_struct(batch->fdt);
+	int strings_size = fdt_size_dt_strings(batch->fdt);
+	const char *strtab = batch->fdt + fdt_off_dt_strings(batch->fdt);
+	const struct fdt_property *prop;
+	struct fdt_batch_edit *edit;
+	const char *name;
+	int i, j, len;
+
+	*strings_sizep = strings_size;
+	for (i = 0; i < batch->count; i++) {
+		edit = &batch->edits[i];
+		name = batch->data + edit->name;
+		edit->nameoff = -1;
+		edit->add = false;
+		prop = fdt_get_property(batch->fdt, edit->node, name, &len);
+		if (prop) {
+			edit->nameoff = fdt32_to_cpu(prop->nameoff);
+			struct_size -= ALIGN(len, FDT_TAGSIZE);
+			if (edit->del)
+				struct_size -= sizeof(*prop);
+			else
+				struct_size += ALIGN(edit->len, FDT_TAGSIZE);
+			continue;
+		} else if (len != -FDT_ERR_NOTFOUND) {
+			return len;
+		} else if (edit->del) {
+			continue;
+		}
+
+		edit->add = true;
+		struct_size += sizeof(*prop) + ALIGN(edit->len, FDT_TAGSIZE);
+		edit->nameoff = fdt_batch_find_string(strtab, strings_size,
+						      name);
+		if (edit->nameoff >= 0)
+			continue;
+
+		/* Names new to the FDT go at the end of the strings block */
+		for (j = 0; j < i; j++) {
+			if (batch->edits[j].nameoff >= strings_size &&
+			    !strcmp(batch->data + batch->edits[j].name, name)) {
+				edit->nameoff = batch->edits[j].nameoff;
+				break;
+			}
+		}
+		if (edit->nameoff < 0) {
+			edit->nameoff = *strings_sizep;
+			*strings_sizep += strlen(name) + 1;
+		}
+	}
+
+	return struct_size;
+}
+
+/* Add a property to the new structure block */
+static char *fdt_batch_put_prop(struct fdt_batch *batch, char *p,
+				struct fdt_batch_edit *edit)
+{
+	struct fdt_property *prop = (struct fdt_property *)p;
+	int len = ALIGN(edit->len, FDT_TAGSIZE);
+
+	prop->tag = cpu_to_fdt32(FDT_PROP);
+	prop->len = cpu_to_fdt32(edit->len);
+	prop->nameoff = cpu_to_fdt32(edit->nameoff);
+	memcpy(prop->data, batch->data + edit->val, edit->len);
+	memset(prop->data + edit->len, '\0', len - edit->len);
+
+	return p + sizeof(*prop) + len;
+}
+
+/*
+ * Write out the changes in a single pass over the structure block. If
+ * @trackp is not NULL, the node it gives the offset of is tracked to its
+ * new place.
+ */
+static int fdt_batch_write(struct fdt_batch *batch, int *trackp)
+{
+	struct fdt_batch_edit *edit, *next, *cur, *cur_end, *end;
+	int struct_off, struct_size, strings_size, old_size;
+	int offset, nextoffset, track, ret, len;
+	void *fdt = batch->fdt;
+	char *buf, *p, *strtab;
+	const char *name;
+	u32 tag;
+
+	ret = batch->err;
+	if (ret || !batch->count)
+		return ret;
+
+	qsort(batch->edits, batch->count, sizeof(*edit), fdt_batch_cmp);
+
+	/* Leave old versions and unusual layouts to libfdt */
+	struct_off = fdt_off_dt_struct(fdt);
+	old_size = fdt_size_dt_strings(fdt);
+	if (fdt_version(fdt) < 17 || fdt_off_mem_rsvmap(fdt) > struct_off ||
+	    struct_off + fdt_size_dt_struct(fdt) > fdt_off_dt_strings(fdt))
+		return fdt_batch_apply_each(batch);
+
+	struct_size = fdt_batch_size(batch, &strings_size);
+	if (struct_size < 0)
+		return struct_size;
+	if (struct_off + struct_size + strings_size > fdt_totalsize(fdt))
+		return -FDT_ERR_NOSPACE;
+
+	buf = malloc(struct_size);
+	if (!buf)
+		return fdt_batch_apply_each(batch);
+
+	p = buf;
+	track = trackp ? *trackp : -1;
+	next = batch->edits;
+	end = next + batch->count;
+	cur = end;
+	cur_end = end;
+	offset = 0;
+	do {
+		tag = fdt_next_tag(fdt, offset, &nextoffset);
+		if (nextoffset < 0) {
+			ret = nextoffset;
+			goto out;
+		}
+		if (tag == FDT_PROP && cur != cur_end) {
+			const struct fdt_property *prop;
+
+			prop = fdt_get_property_by_offset(fdt, offset, &len);
+			name = fdt_string(fdt, fdt32_to_cpu(prop->nameoff));
+			for (edit = cur; edit != cur_end; edit++) {
+				if (!edit->add &&
+				    !strcmp(batch->data + edit->name, name))
+					break;
+			}
+			if (edit != cur_end) {
+				if (!edit->del)
+					p = fdt_batch_put_prop(batch, p, edit);
+				offset = nextoffset;
+				continue;
+			}
+		}
+
+		len = nextoffset - offset;
+		if (p + len > buf + struct_size) {
+			ret = -FDT_ERR_INTERNAL;
+			goto out;
+		}
+		if (tag == FDT_BEGIN_NODE && offset == track)
+			*trackp = p - buf;
+		memcpy(p, fdt_offset_ptr(fdt, offset, len), len);
+		p += len;
+		if (tag == FDT_BEGIN_NODE) {
+			cur = next;
+			while (next != end && next->node == offset)
+				next++;
+			cur_end = next;
+
+			/*
+			 * Like fdt_setprop(), put each new property in front
+			 * of the existing ones
+			 */
+			for (edit = cur_end; edit != cur;) {
+				edit--;
+				if (edit->add)
+					p = fdt_batch_put_prop(batch, p, edit);
+			}
+		}
+		offset = nextoffset;
+	} while (tag != FDT_END);
+
+	if (p != buf + struct_size) {
+		ret = -FDT_ERR_INTERNAL;
+		goto out;
+	}
+
+	/* Move the strings block into place, then the structure block */
+	strtab = fdt + struct_off + struct_size;
+	memmove(strtab, fdt + fdt_off_dt_strings(fdt), old_size);
+	for (edit = batch->edits; edit != end; edit++) {
+		if (!edit->del && edit->nameoff >= old_size)
+			strcpy(strtab + edit->nameoff, batch->data + edit->name);
+	}
+	memcpy(fdt + struct_off, buf, struct_size);
+	fdt_set_size_dt_struct(fdt, struct_size);
+	fdt_set_off_dt_strings(fdt, struct_off + struct_size);
+	fdt_set_size_dt_strings(fdt, strings_size);
+out:
+	free(buf);
+
+	return ret;
+}
+
+int fdt_batch_commit(struct fdt_batch *batch)
+{
+	int ret;
+
+	ret = fdt_batch_write(batch, NULL);
+	batch->count = 0;
+	batch->data_len = 0;
+	batch->err = 0;
+
+	return ret;
+}
+
+int fdt_batch_subnode(struct fdt_batch *batch, int parentoffset,
+		      const char *name)
+{
+	int offset, ret;
+
+	offset = fdt_subnode_offset(batch->fdt, parentoffset, name);
+	if (offset != -FDT_ERR_NOTFOUND)
+		return offset;
+
+	/* Pending changes may move the parent */
+	ret = fdt_batch_write(batch, &parentoffset);
+	batch->count = 0;
+	batch->data_len = 0;
+	batch->err = 0;
+	if (ret)
+		return ret;
+
+	return fdt_add_subnode(batch->fdt, parentoffset, name);
+}
+
 #if defined(CONFIG_OF_STDOUT_VIA_ALIAS) && defined(CONFIG_CONS_INDEX)
-static int fdt_fixup_stdout(void *fdt, int chosenoff)
+static int fdt_fixup_stdout(struct fdt_batch *batch, int chosenoff)
 {
+	void *fdt = batch->fdt;
 	int err;
 	int aliasoff;
 	char sername[9] = { 0 };
 	const void *path;
 	int len;
-	char tmp[256]; /* long enough */
 
 	sprintf(sername, "serial%d", CONFIG_CONS_INDEX - 1);
 
@@ -149,10 +564,9 @@ static int fdt_fixup_stdout(void *fdt, int chosenoff)
 		goto noalias;
 	}
 
-	/* fdt_setprop may break "path" so we copy it to tmp buffer */
-	memcpy(tmp, path, len);
-
-	err = fdt_setprop(fdt, chosenoff, "linux,stdout-path", tmp, len);
+	/* The batch keeps a copy of "path" */
+	err = fdt_batch_setprop(batch, chosenoff, "linux,stdout-path", path,
+				len);
 	if (err < 0)
 		printf("WARNING: could not set linux,stdout-path %s.\n",
 		       fdt_strerror(err));
@@ -166,12 +580,31 @@ noalias:
 	return 0;
 }
 #else
-static int fdt_fixup_stdout(void *fdt, int chosenoff)
+static int fdt_fixup_stdout(struct fdt_batch *batch, int chosenoff)
 {
 	return 0;
 }
 #endif
 
+/* Run a set of fixups as a batch of its own */
+static int fdt_batch_run(void *fdt, int (*fixup)(struct fdt_batch *batch))
+{
+	struct fdt_batch batch;
+	int ret;
+
+	fdt_batch_init(&batch, fdt);
+	ret = fixup(&batch);
+	if (!ret) {
+		ret = fdt_batch_commit(&batch);
+		if (ret)
+			printf("WARNING: could not update FDT %s.\n",
+			       fdt_strerror(ret));
+	}
+	fdt_batch_uninit(&batch);
+
+	return ret;
+}
+
 static inline int fdt_setprop_uxx(void *fdt, int nodeoffset, const char *name,
 				  uint64_t val, int is_u64)
 {
@@ -181,12 +614,12 @@ static inline int fdt_setprop_uxx(void *fdt, int nodeoffset, const char *name,
 		return fdt_setprop_u32(fdt, nodeoffset, name, (uint32_t)val);
 }
 
-int fdt_root(void *fdt)
+int fdt_root_batch(struct fdt_batch *batch)
 {
 	char *serial;
 	int err;
 
-	err = fdt_check_header(fdt);
+	err = fdt_check_header(batch->fdt);
 	if (err < 0) {
 		printf("fdt_root: %s\n", fdt_strerror(err));
 		return err;
@@ -194,9 +627,8 @@ int fdt_root(void *fdt)
 
 	serial = env_get("serial#");
 	if (serial) {
-		err = fdt_setprop(fdt, 0, "serial-number", serial,
-				  strlen(serial) + 1);
-
+		err = fdt_batch_setprop_string(batch, 0, "serial-number",
+					       serial);
 		if (err < 0) {
 			printf("WARNING: could not set serial-number %s.\n",
 			       fdt_strerror(err));
@@ -207,6 +639,11 @@ int fdt_root(void *fdt)
 	return 0;
 }
 
+int fdt_root(void *fdt)
+{
+	return fdt_batch_run(fdt, fdt_root_batch);
+}
+
 int fdt_initrd(void *fdt, ulong initrd_start, ulong initrd_end)
 {
 	int   nodeoffset;
@@ -276,28 +713,31 @@ __weak char *board_fdt_chosen_bootargs(void)
 	return env_get("bootargs");
 }
 
-int fdt_chosen(void *fdt)
+int fdt_chosen_batch(struct fdt_batch *batch)
 {
 	int   nodeoffset;
 	int   err;
 	char  *str;		/* used to set string properties */
 
-	err = fdt_check_header(fdt);
+	err = fdt_check_header(batch->fdt);
 	if (err < 0) {
 		printf("fdt_chosen: %s\n", fdt_strerror(err));
 		return err;
 	}
 
 	/* find or create "/chosen" node. */
-	nodeoffset = fdt_find_or_add_subnode(fdt, 0, "chosen");
-	if (nodeoffset < 0)
+	nodeoffset = fdt_batch_subnode(batch, 0, "chosen");
+	if (nodeoffset < 0) {
+		printf("%s: chosen: %s\n", __func__,
+		       fdt_strerror(nodeoffset));
 		return nodeoffset;
+	}
 
 	str = board_fdt_chosen_bootargs();
 
 	if (str) {
-		err = fdt_setprop(fdt, nodeoffset, "bootargs", str,
-				  strlen(str) + 1);
+		err = fdt_batch_setprop_string(batch, nodeoffset, "bootargs",
+					       str);
 		if (err < 0) {
 			printf("WARNING: could not set bootargs %s.\n",
 			       fdt_strerror(err));
@@ -305,7 +745,12 @@ int fdt_chosen(void *fdt)
 		}
 	}
 
-	return fdt_fixup_stdout(fdt, nodeoffset);
+	return fdt_fixup_stdout(batch, nodeoffset);
+}
+
+int fdt_chosen(void *fdt)
+{
+	return fdt_batch_run(fdt, fdt_chosen_batch);
 }
 
 void do_fixup_by_path(void *fdt, const char *path, const char *prop,
@@ -529,37 +974,28 @@ int fdt_fixup_memory(void *blob, u64 start, u64 size)
 	return fdt_fixup_memory_banks(blob, &start, &size, 1);
 }
 
-void fdt_fixup_ethernet(void *fdt)
+void fdt_fixup_ethernet_batch(struct fdt_batch *batch)
 {
+	void *fdt = batch->fdt;
 	int i = 0, j, prop;
 	char *tmp, *end;
 	char mac[16];
 	const char *path;
 	unsigned char mac_addr[ARP_HLEN];
-	int offset;
+	int aliasoff, nodeoff;
 #ifdef FDT_SEQ_MACADDR_FROM_ENV
-	int nodeoff;
 	const struct fdt_property *fdt_prop;
 #endif
 
-	if (fdt_path_offset(fdt, "/aliases") < 0)
+	aliasoff = fdt_path_offset(fdt, "/aliases");
+	if (aliasoff < 0)
 		return;
 
-	/* Cycle through all aliases */
-	for (prop = 0; ; prop++) {
+	/* Cycle through all aliases, the FDT is not changed until commit */
+	fdt_for_each_property_offset(prop, fdt, aliasoff) {
 		const char *name;
 
-		/* FDT might have been edited, recompute the offset */
-		offset = fdt_first_property_offset(fdt,
-			fdt_path_offset(fdt, "/aliases"));
-		/* Select property number 'prop' */
-		for (j = 0; j < prop; j++)
-			offset = fdt_next_property_offset(fdt, offset);
-
-		if (offset < 0)
-			break;
-
-		path = fdt_getprop_by_offset(fdt, offset, &name, NULL);
+		path = fdt_getprop_by_offset(fdt, prop, &name, NULL);
 		if (!strncmp(name, "ethernet", 8)) {
 			/* Treat plain "ethernet" same as "ethernet0". */
 			if (!strcmp(name, "ethernet")
@@ -580,8 +1016,8 @@ void fdt_fixup_ethernet(void *fdt)
 			} else {
 				continue;
 			}
-#ifdef FDT_SEQ_MACADDR_FROM_ENV
 			nodeoff = fdt_path_offset(fdt, path);
+#ifdef FDT_SEQ_MACADDR_FROM_ENV
 			fdt_prop = fdt_get_property(fdt, nodeoff, "status",
 						    NULL);
 			if (fdt_prop && !strcmp(fdt_prop->data, "disabled"))
@@ -599,14 +1035,32 @@ void fdt_fixup_ethernet(void *fdt)
 					tmp = (*end) ? end + 1 : end;
 			}
 
-			do_fixup_by_path(fdt, path, "mac-address",
-					 &mac_addr, 6, 0);
-			do_fixup_by_path(fdt, path, "local-mac-address",
-					 &mac_addr, 6, 1);
+			if (nodeoff < 0) {
+				printf("Unable to update property %s:mac-address, err=%s\n",
+				       path, fdt_strerror(nodeoff));
+				continue;
+			}
+			if (fdt_get_property(fdt, nodeoff, "mac-address", NULL))
+				fdt_batch_setprop(batch, nodeoff, "mac-address",
+						  mac_addr, ARP_HLEN);
+			fdt_batch_setprop(batch, nodeoff, "local-mac-address",
+					  mac_addr, ARP_HLEN);
 		}
 	}
 }
 
+static int fdt_fixup_ethernet_run(struct fdt_batch *batch)
+{
+	fdt_fixup_ethernet_batch(batch);
+
+	return 0;
+}
+
+void fdt_fixup_ethernet(void *fdt)
+{
+	fdt_batch_run(fdt, fdt_fixup_ethernet_run);
+}
+
 int fdt_record_loadable(void *blob, u32 index, const char *name,
 			uintptr_t load_addr, u32 size, uintptr_t entry_point,
 			const char *type, const char *os, const char *arch)
@@ -2027,6 +2481,8 @@ int fdt_overlay_apply_verbose(void *fdt, void *fdto)
 	has_symbols = err >= 0;
 
 	err = fdt_overlay_apply(fdt, fdto);
+	/* The overlay may have been applied to the control FDT */
+	fdtdec_phandle_cache_reset();
 	if (err < 0) {
 		printf("failed on fdt_overlay_apply(): %s\n",
 				fdt_strerror(err));
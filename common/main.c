@@ -63,6 +63,8 @@ void main_loop(void)
 
 	autoboot_command(s);
 
+	autoboot_console_init();
+
 	cli_loop();
 	panic("No CLI available");
 }
@@ -0,0 +1,154 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Slab caches for objects of a fixed size
+ *
+ * Each slab is a single malloc() block holding a header followed by a number
+ * of objects. Free objects in a slab are kept on a singly linked list through
+ * their first word.
+ */
+
+#define LOG_CATEGORY LOGC_ALLOC
+
+#include <common.h>
+#include <log.h>
+#include <malloc_cache.h>
+#include <asm/global_data.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Objects are aligned in the same way as malloc() blocks */
+#define CACHE_ALIGN	(2 * sizeof(size_t))
+
+/**
+ * struct malloc_slab - A slab of objects
+ *
+ * @sibling: Node in the cache's list of slabs
+ * @free_list: First free object, or NULL if all are in use
+ * @in_use: Number of objects in use
+ * @start: First object
+ * @end: End of the last object
+ */
+struct malloc_slab {
+	struct list_head sibling;
+	void *free_list;
+	uint in_use;
+	char *start;
+	char *end;
+};
+
+static LIST_HEAD(malloc_caches);
+
+static struct malloc_slab *malloc_cache_grow(struct malloc_cache *cache)
+{
+	uint hdr_size = ALIGN(sizeof(struct malloc_slab), CACHE_ALIGN);
+	struct malloc_slab *slab;
+	char *obj;
+
+	if (!cache->per_slab) {
+		cache->size = ALIGN(max_t(uint, cache->size, sizeof(void *)),
+				    CACHE_ALIGN);
+		cache->per_slab = max_t(uint, 1,
+			(CONFIG_SYS_MALLOC_CACHE_SLAB_SIZE - hdr_size) /
+			cache->size);
+		list_add_tail(&cache->sibling, &malloc_caches);
+	}
+
+	slab = malloc(hdr_size + cache->per_slab * cache->size);
+	if (!slab)
+		return NULL;
+	slab->in_use = 0;
+	slab->start = (char *)slab + hdr_size;
+	slab->end = slab->start + cache->per_slab * cache->size;
+
+	/* Link the objects up so they are handed out in address order */
+	slab->free_list = NULL;
+	for (obj = slab->end - cache->size; obj >= slab->start;
+	     obj -= cache->size) {
+		*(void **)obj = slab->free_list;
+		slab->free_list = obj;
+	}
+	list_add(&slab->sibling, &cache->slabs);
+	cache->slab_count++;
+	log_debug("%s: new slab %p\n", cache->name, slab);
+
+	return slab;
+}
+
+void *malloc_cache_alloc(struct malloc_cache *cache)
+{
+	struct malloc_slab *slab;
+	void *obj;
+
+	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT))
+		return calloc(1, cache->size);
+
+	slab = list_first_entry_or_null(&cache->slabs, struct malloc_slab,
+					sibling);
+	if (!slab || !slab->free_list) {
+		slab = malloc_cache_grow(cache);
+		if (!slab)
+			return NULL;
+	}
+	obj = slab->free_list;
+	slab->free_list = *(void **)obj;
+	slab->in_use++;
+	cache->in_use++;
+
+	/* Keep full slabs out of the way at the end of the list */
+	if (!slab->free_list)
+		list_move_tail(&slab->sibling, &cache->slabs);
+	memset(obj, '\0', cache->size);
+
+	return obj;
+}
+
+void malloc_cache_free(struct malloc_cache *cache, void *ptr)
+{
+	struct malloc_slab *slab;
+
+	if (!ptr)
+		return;
+	list_for_each_entry(slab, &cache->slabs, sibling) {
+		if ((char *)ptr < slab->start || (char *)ptr >= slab->end)
+			continue;
+		cache->in_use--;
+		if (!--slab->in_use) {
+			list_del(&slab->sibling);
+			cache->slab_count--;
+			free(slab);
+			return;
+		}
+		if (!slab->free_list)
+			list_move(&slab->sibling, &cache->slabs);
+		*(void **)ptr = slab->free_list;
+		slab->free_list = ptr;
+		return;
+	}
+
+	/* Not from this cache */
+	free(ptr);
+}
+
+ulong malloc_cache_unused(void)
+{
+	struct malloc_cache *cache;
+	ulong unused = 0;
+
+	list_for_each_entry(cache, &malloc_caches, sibling)
+		unused += (cache->slab_count * cache->per_slab -
+			   cache->in_use) * cache->size;
+
+	return unused;
+}
+
+void malloc_cache_info(void)
+{
+	struct malloc_cache *cache;
+
+	printf("%-20s %6s %8s %8s %6s\n", "cache", "size", "in use", "total",
+	       "slabs");
+	list_for_each_entry(cache, &malloc_caches, sibling)
+		printf("%-20s %6x %8x %8x %6x\n", cache->name, cache->size,
+		       cache->in_use, cache->slab_count * cache->per_slab,
+		       cache->slab_count);
+}
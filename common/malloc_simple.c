@@ -16,6 +16,273 @@
 
 DECLARE_GLOBAL_DATA_PTR;
 
+#if CONFIG_IS_ENABLED(SYS_MALLOC_F_ARENA)
+/* Blocks of up to this many words plus two have a free list for their size */
+#define ARENA_SMALL	16
+/* Larger blocks are kept in lists covering a power of two each */
+#define ARENA_CLASSES	(ARENA_SMALL + 8)
+#define ARENA_HDR	sizeof(ulong)
+
+/**
+ * struct arena_blk - a block in the arena
+ *
+ * @size: Size of the block in bytes, including @size
+ * @next: Next free block in the same class, only used while the block is free
+ */
+struct arena_blk {
+	ulong size;
+	struct arena_blk *next;
+};
+
+/**
+ * struct arena - the free lists, kept at the bottom of the pool
+ *
+ * @free: Free blocks of each size class, most recently freed first
+ * @marks: Number of marks from malloc_simple_mark() not yet released
+ */
+struct arena {
+	struct arena_blk *free[ARENA_CLASSES];
+	uint marks;
+};
+
+static struct arena *arena_get(void)
+{
+	struct arena *arena;
+
+	if (gd->malloc_limit < sizeof(*arena))
+		return NULL;
+	arena = map_sysmem(gd->malloc_base, sizeof(*arena));
+
+	/* Set up the free lists whenever the pool is (re)started */
+	if (!gd->malloc_ptr) {
+		memset(arena, '\0', sizeof(*arena));
+		gd->malloc_ptr = sizeof(*arena);
+		gd->malloc_peak = gd->malloc_ptr;
+	}
+
+	return arena;
+}
+
+static ulong arena_size(size_t bytes)
+{
+	return max_t(ulong, ALIGN(bytes + ARENA_HDR, sizeof(ulong)),
+		     sizeof(struct arena_blk));
+}
+
+static int arena_class(ulong size)
+{
+	int cls = size / sizeof(ulong) - 2;
+
+	if (cls < ARENA_SMALL)
+		return cls;
+	cls = ARENA_SMALL + fls(size / (ARENA_SMALL * sizeof(ulong))) - 1;
+
+	return min(cls, ARENA_CLASSES - 1);
+}
+
+static struct arena_blk *arena_blk(ulong addr)
+{
+	return map_sysmem(addr, sizeof(struct arena_blk));
+}
+
+static void arena_set_top(ulong ptr)
+{
+	gd->malloc_ptr = ptr;
+	if (ptr > gd->malloc_peak)
+		gd->malloc_peak = ptr;
+}
+
+/* Lower the top of the pool past any free blocks just below it */
+static void arena_trim(struct arena *arena)
+{
+	struct arena_blk **linkp, *blk;
+	int cls;
+
+	for (cls = 0; cls < ARENA_CLASSES; cls++) {
+		for (linkp = &arena->free[cls]; *linkp; linkp = &blk->next) {
+			blk = *linkp;
+			if (map_to_sysmem(blk) + blk->size ==
+			    gd->malloc_base + gd->malloc_ptr) {
+				*linkp = blk->next;
+				gd->malloc_ptr = map_to_sysmem(blk) -
+					gd->malloc_base;
+				/* The block below may be free too */
+				cls = -1;
+				break;
+			}
+		}
+	}
+}
+
+static void *alloc_simple(size_t bytes, int align)
+{
+	struct arena_blk **linkp, *blk;
+	struct arena *arena;
+	ulong addr, new_ptr, size;
+
+	arena = arena_get();
+	if (!arena)
+		return NULL;
+	size = arena_size(bytes);
+
+	/*
+	 * Reuse a free block if the alignment allows. While there is a mark,
+	 * allocate from the top only, so that releasing the mark frees all
+	 * that was allocated since.
+	 */
+	if (align <= sizeof(ulong) && !arena->marks) {
+		linkp = &arena->free[arena_class(size)];
+		for (; *linkp; linkp = &(*linkp)->next) {
+			blk = *linkp;
+			if (blk->size >= size) {
+				*linkp = blk->next;
+				return (void *)blk + ARENA_HDR;
+			}
+		}
+	}
+
+	addr = ALIGN(gd->malloc_base + gd->malloc_ptr + ARENA_HDR, align) -
+		ARENA_HDR;
+	new_ptr = addr + size - gd->malloc_base;
+	log_debug("size=%zx, ptr=%lx, limit=%lx: ", bytes, new_ptr,
+		  gd->malloc_limit);
+	if (new_ptr > gd->malloc_limit) {
+		log_err("alloc space exhausted\n");
+		return NULL;
+	}
+
+	blk = arena_blk(addr);
+	blk->size = size;
+	arena_set_top(new_ptr);
+
+	return (void *)blk + ARENA_HDR;
+}
+
+void free_simple(void *ptr)
+{
+	struct arena_blk *blk;
+	struct arena *arena;
+	ulong addr;
+
+	if (!ptr)
+		return;
+
+	/* Ignore memory which did not come from the pool */
+	addr = map_to_sysmem(ptr) - ARENA_HDR;
+	if (addr < gd->malloc_base + sizeof(struct arena) ||
+	    addr >= gd->malloc_base + gd->malloc_ptr)
+		return;
+
+	arena = arena_get();
+	blk = arena_blk(addr);
+	if (addr + blk->size == gd->malloc_base + gd->malloc_ptr) {
+		gd->malloc_ptr = addr - gd->malloc_base;
+		arena_trim(arena);
+	} else {
+		blk->next = arena->free[arena_class(blk->size)];
+		arena->free[arena_class(blk->size)] = blk;
+	}
+}
+
+void *realloc_simple(void *ptr, size_t bytes)
+{
+	struct arena_blk *blk;
+	ulong addr, size;
+	void *new;
+
+	if (!ptr)
+		return malloc_simple(bytes);
+
+	addr = map_to_sysmem(ptr) - ARENA_HDR;
+	blk = arena_blk(addr);
+	size = arena_size(bytes);
+	if (size <= blk->size)
+		return ptr;
+
+	/* A block at the top of the pool can just grow */
+	if (addr + blk->size == gd->malloc_base + gd->malloc_ptr &&
+	    addr + size - gd->malloc_base <= gd->malloc_limit) {
+		blk->size = size;
+		arena_set_top(addr + size - gd->malloc_base);
+		return ptr;
+	}
+
+	new = malloc_simple(bytes);
+	if (!new)
+		return NULL;
+	memcpy(new, ptr, blk->size - ARENA_HDR);
+	free_simple(ptr);
+
+	return new;
+}
+
+ulong malloc_simple_mark(void)
+{
+	struct arena *arena;
+
+	arena = arena_get();
+	if (arena)
+		arena->marks++;
+
+	return gd->malloc_ptr;
+}
+
+void malloc_simple_release(ulong mark)
+{
+	struct arena_blk **linkp;
+	struct arena *arena;
+	int cls;
+
+	arena = arena_get();
+	if (!arena)
+		return;
+	if (arena->marks)
+		arena->marks--;
+	if (mark >= gd->malloc_ptr)
+		return;
+
+	gd->malloc_ptr = mark;
+	for (cls = 0; cls < ARENA_CLASSES; cls++) {
+		for (linkp = &arena->free[cls]; *linkp;) {
+			if (map_to_sysmem(*linkp) >= gd->malloc_base + mark)
+				*linkp = (*linkp)->next;
+			else
+				linkp = &(*linkp)->next;
+		}
+	}
+	arena_trim(arena);
+}
+
+/* Work out the number of bytes in the free lists */
+static ulong arena_free_bytes(void)
+{
+	struct arena_blk *blk;
+	struct arena *arena;
+	ulong total = 0;
+	int cls;
+
+	arena = arena_get();
+	if (!arena)
+		return 0;
+	for (cls = 0; cls < ARENA_CLASSES; cls++) {
+		for (blk = arena->free[cls]; blk; blk = blk->next)
+			total += blk->size;
+	}
+
+	return total;
+}
+
+ulong malloc_simple_avail(void)
+{
+	ulong avail;
+
+	if (!arena_get())
+		return 0;
+	avail = ALIGN_DOWN(gd->malloc_limit - gd->malloc_ptr, sizeof(ulong));
+
+	return avail > ARENA_HDR ? avail - ARENA_HDR : 0;
+}
+#else
 static void *alloc_simple(size_t bytes, int align)
 {
 	ulong addr, new_ptr;
@@ -36,6 +303,16 @@ static void *alloc_simple(size_t bytes, int align)
 	return ptr;
 }
 
+void free_simple(void *ptr)
+{
+}
+
+ulong malloc_simple_avail(void)
+{
+	return gd->malloc_limit - gd->malloc_ptr;
+}
+#endif
+
 void *malloc_simple(size_t bytes)
 {
 	void *ptr;
@@ -80,4 +357,8 @@ void malloc_simple_info(void)
 {
 	log_info("malloc_simple: %lx bytes used, %lx remain\n", gd->malloc_ptr,
 		 CONFIG_VAL(SYS_MALLOC_F_LEN) - gd->malloc_ptr);
+#if CONFIG_IS_ENABLED(SYS_MALLOC_F_ARENA)
+	log_info("malloc_simple: %lx bytes free for reuse, %lx used at most\n",
+		 arena_free_bytes(), gd->malloc_peak);
+#endif
 }
@@ -330,6 +330,8 @@ int stdio_add_devices(void)
 		 * non-fatal
 		 */
 		uclass_foreach_dev(dev, uc) {
+			if (device_probe_deferred(dev))
+				continue;
 			ret = device_probe(dev);
 			if (ret)
 				printf("Failed to probe keyboard '%s'\n",
@@ -353,13 +355,14 @@ int stdio_add_devices(void)
 		int ret;
 
 		if (!IS_ENABLED(CONFIG_SYS_CONSOLE_IS_IN_ENV)) {
-			for (ret = uclass_first_device(UCLASS_VIDEO, &vdev);
-			     vdev;
-			     ret = uclass_next_device(&vdev))
-				;
-			if (ret)
-				printf("%s: Video device failed (ret=%d)\n",
-				       __func__, ret);
+			uclass_id_foreach_dev(UCLASS_VIDEO, vdev, uc) {
+				if (device_probe_deferred(vdev))
+					continue;
+				ret = device_probe(vdev);
+				if (ret)
+					printf("%s: Video device failed (ret=%d)\n",
+					       __func__, ret);
+			}
 		}
 		if (IS_ENABLED(CONFIG_SPLASH_SCREEN) &&
 		    IS_ENABLED(CONFIG_CMD_BMP))
@@ -5,4 +5,7 @@
  * Licensed under the GPL-2 or later.
  */
 
-const char const system_map[] = SYSTEM_MAP;
+/* Generated from the first link of U-Boot, see cmd_smap in the Makefile */
+const char system_map[] =
+#include "system_map.inc"
+	"";
@@ -43,6 +43,7 @@
 #include <asm/byteorder.h>
 #include <asm/cache.h>
 #include <asm/processor.h>
+#include <asm/unaligned.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
 #include <linux/delay.h>
@@ -75,6 +76,7 @@ static struct blk_desc usb_dev_desc[USB_MAX_STOR_DEV];
 #endif
 
 struct us_data;
+struct uas_cmd;
 typedef int (*trans_cmnd)(struct scsi_cmd *cb, struct us_data *data);
 typedef int (*trans_reset)(struct us_data *data);
 
@@ -101,6 +103,10 @@ struct us_data {
 	trans_reset	transport_reset;	/* reset routine */
 	trans_cmnd	transport;		/* transport routine */
 	unsigned short	max_xfer_blk;		/* maximum transfer blocks */
+	unsigned char	ep_cmd;			/* UAS command pipe */
+	unsigned char	ep_status;		/* UAS status pipe */
+	unsigned short	num_cmds;		/* UAS commands in flight */
+	struct uas_cmd	*uas_cmds;		/* UAS command slots */
 };
 
 #if !CONFIG_IS_ENABLED(BLK)
@@ -175,6 +181,11 @@ static unsigned int usb_get_max_lun(struct us_data *us)
 {
 	int len;
 	ALLOC_CACHE_ALIGN_BUFFER(unsigned char, result, 1);
+
+	/* Get Max LUN is a Bulk-Only request, only LUN 0 is used with UAS */
+	if (us->protocol == US_PR_UAS)
+		return 0;
+
 	len = usb_control_msg(us->pusb_dev,
 			      usb_rcvctrlpipe(us->pusb_dev, 0),
 			      US_BBB_GET_MAX_LUN,
@@ -939,6 +950,379 @@ do_retry:
 	return USB_STOR_TRANSPORT_FAILED;
 }
 
+/*
+ * USB Attached SCSI (UAS)
+ *
+ * Each command is sent as a Command IU with a tag on the command pipe. With
+ * SuperSpeed bulk streams the data and the Sense (status) IU of a command
+ * are moved on the stream whose ID is the tag, so the requests for them are
+ * queued before the command is sent, and several commands are kept in flight.
+ */
+#define UAS_IU_COMMAND		0x01
+#define UAS_IU_SENSE		0x03
+#define UAS_IU_RESPONSE		0x04
+
+#define UAS_PIPE_ID_CMD		1
+#define UAS_PIPE_ID_STATUS	2
+#define UAS_PIPE_ID_DATA_IN	3
+#define UAS_PIPE_ID_DATA_OUT	4
+
+#define USB_DT_PIPE_USAGE	0x24
+
+#if CONFIG_IS_ENABLED(USB_UAS)
+#define UAS_MAX_CMDS		CONFIG_USB_UAS_MAX_CMDS
+#else
+#define UAS_MAX_CMDS		1
+#endif
+
+struct uas_cmd_iu {
+	__u8 iu_id;
+	__u8 rsvd1;
+	__be16 tag;
+	__u8 prio_attr;
+	__u8 rsvd5;
+	__u8 len;
+	__u8 rsvd7;
+	__u8 lun[8];
+	__u8 cdb[16];
+} __packed;
+
+struct uas_sense_iu {
+	__u8 iu_id;
+	__u8 rsvd1;
+	__be16 tag;
+	__be16 status_qual;
+	__u8 status;
+	__u8 rsvd7[7];
+	__be16 len;
+	__u8 sense[96];
+} __packed;
+
+/**
+ * struct uas_cmd - A UAS command slot, using the tag (and stream) @index + 1
+ *
+ * @cmd_iu:	Command IU sent on the command pipe
+ * @sense_iu:	Sense or Response IU received on the status pipe
+ * @status_req:	Request receiving @sense_iu
+ * @data_req:	Request moving the data of the command, if any
+ * @blocks:	Number of blocks transferred by the command
+ */
+struct uas_cmd {
+	struct uas_cmd_iu cmd_iu __aligned(ARCH_DMA_MINALIGN);
+	struct uas_sense_iu sense_iu __aligned(ARCH_DMA_MINALIGN);
+	struct usb_bulk_req status_req __aligned(ARCH_DMA_MINALIGN);
+	struct usb_bulk_req data_req;
+	unsigned short blocks;
+};
+
+/* Queue the data and status requests of a command and send its Command IU */
+static int usb_stor_UAS_submit(struct us_data *us, int tag,
+			       struct scsi_cmd *srb)
+{
+	struct usb_device *udev = us->pusb_dev;
+	struct uas_cmd *cmd = &us->uas_cmds[tag - 1];
+	int result, actlen;
+
+	memset(&cmd->cmd_iu, '\0', sizeof(cmd->cmd_iu));
+	cmd->cmd_iu.iu_id = UAS_IU_COMMAND;
+	cmd->cmd_iu.tag = cpu_to_be16(tag);
+	cmd->cmd_iu.lun[1] = srb->lun;
+	memcpy(cmd->cmd_iu.cdb, srb->cmd, min_t(int, srb->cmdlen, 16));
+
+	cmd->status_req.pipe = usb_rcvbulkpipe(udev, us->ep_status);
+	cmd->status_req.stream = tag;
+	cmd->status_req.buffer = &cmd->sense_iu;
+	cmd->status_req.length = sizeof(cmd->sense_iu);
+	result = usb_submit_bulk_req(udev, &cmd->status_req);
+	if (result)
+		return result;
+
+	cmd->data_req.length = srb->datalen;
+	if (srb->datalen) {
+		if (US_DIRECTION(srb->cmd[0]))
+			cmd->data_req.pipe = usb_rcvbulkpipe(udev, us->ep_in);
+		else
+			cmd->data_req.pipe = usb_sndbulkpipe(udev, us->ep_out);
+		cmd->data_req.stream = tag;
+		cmd->data_req.buffer = srb->pdata;
+		result = usb_submit_bulk_req(udev, &cmd->data_req);
+		if (result)
+			goto err;
+	}
+
+	result = usb_bulk_msg(udev, usb_sndbulkpipe(udev, us->ep_cmd),
+			      &cmd->cmd_iu, sizeof(cmd->cmd_iu), &actlen,
+			      USB_CNTL_TIMEOUT * 5);
+	if (!result)
+		return 0;
+
+	debug("UAS: sending command %d failed, status %lX\n", tag,
+	      udev->status);
+	/* Nothing will arrive for this tag, so drop its other IUs */
+	if (srb->datalen)
+		usb_cancel_bulk_req(udev, &cmd->data_req);
+err:
+	usb_cancel_bulk_req(udev, &cmd->status_req);
+
+	return result;
+}
+
+/* Wait for a command sent by usb_stor_UAS_submit() and check its status */
+static int usb_stor_UAS_complete(struct us_data *us, int tag,
+				 struct scsi_cmd *srb)
+{
+	struct usb_device *udev = us->pusb_dev;
+	struct uas_cmd *cmd = &us->uas_cmds[tag - 1];
+	struct uas_sense_iu *iu = &cmd->sense_iu;
+	int data_result = 0;
+	int result;
+
+	if (cmd->data_req.length)
+		data_result = usb_wait_bulk_req(udev, &cmd->data_req);
+	result = usb_wait_bulk_req(udev, &cmd->status_req);
+	if (result) {
+		debug("UAS: no status for command %d: %d\n", tag, result);
+		return USB_STOR_TRANSPORT_ERROR;
+	}
+
+	if (be16_to_cpu(iu->tag) != tag) {
+		debug("UAS: status for tag %d instead of %d\n",
+		      be16_to_cpu(iu->tag), tag);
+		return USB_STOR_TRANSPORT_ERROR;
+	}
+	if (iu->iu_id != UAS_IU_SENSE) {
+		debug("UAS: command %d refused, IU %#x\n", tag, iu->iu_id);
+		return USB_STOR_TRANSPORT_FAILED;
+	}
+
+	if (iu->status) {
+		memset(srb->sense_buf, '\0', sizeof(srb->sense_buf));
+		memcpy(srb->sense_buf, iu->sense,
+		       min_t(int, be16_to_cpu(iu->len),
+			     min(sizeof(srb->sense_buf), sizeof(iu->sense))));
+		debug("UAS: command %d status %#x sense %02X %02X %02X\n",
+		      tag, iu->status, srb->sense_buf[2], srb->sense_buf[12],
+		      srb->sense_buf[13]);
+		return USB_STOR_TRANSPORT_FAILED;
+	}
+	if (data_result) {
+		debug("UAS: data of command %d failed: %d\n", tag,
+		      data_result);
+		return USB_STOR_TRANSPORT_FAILED;
+	}
+
+	return USB_STOR_TRANSPORT_GOOD;
+}
+
+static int usb_stor_UAS_transport(struct scsi_cmd *srb, struct us_data *us)
+{
+	if (usb_stor_UAS_submit(us, 1, srb))
+		return USB_STOR_TRANSPORT_ERROR;
+
+	return usb_stor_UAS_complete(us, 1, srb);
+}
+
+/*
+ * Read or write @blkcnt blocks, keeping up to us->num_cmds READ/WRITE(10)
+ * commands in flight. Returns the number of blocks transferred.
+ */
+static lbaint_t usb_stor_UAS_rw(struct us_data *us, struct scsi_cmd *srb,
+				lbaint_t start, lbaint_t blkcnt, void *buffer,
+				unsigned long blksz, bool write)
+{
+	struct scsi_cmd cmd_srb;
+	lbaint_t done = 0, pos;
+	int retry = 2;
+	int i, n, failed, result;
+
+	while (done < blkcnt) {
+		failed = -1;
+		pos = done;
+		for (n = 0; n < us->num_cmds && pos < blkcnt; n++) {
+			struct uas_cmd *cmd = &us->uas_cmds[n];
+
+			cmd->blocks = min_t(lbaint_t, blkcnt - pos,
+					    us->max_xfer_blk);
+			memset(&cmd_srb, '\0', sizeof(cmd_srb));
+			cmd_srb.lun = srb->lun;
+			cmd_srb.cmd[0] = write ? SCSI_WRITE10 : SCSI_READ10;
+			put_unaligned_be32(start + pos, &cmd_srb.cmd[2]);
+			put_unaligned_be16(cmd->blocks, &cmd_srb.cmd[7]);
+			cmd_srb.cmdlen = 10;
+			cmd_srb.pdata = buffer + pos * blksz;
+			cmd_srb.datalen = cmd->blocks * blksz;
+			if (usb_stor_UAS_submit(us, n + 1, &cmd_srb)) {
+				failed = n;
+				break;
+			}
+			pos += cmd->blocks;
+		}
+
+		/* Collect every command sent, also after a failure */
+		for (i = 0; i < n; i++) {
+			result = usb_stor_UAS_complete(us, i + 1, srb);
+			if (result != USB_STOR_TRANSPORT_GOOD && failed < 0)
+				failed = i;
+		}
+		usb_show_progress();
+
+		if (failed < 0) {
+			done = pos;
+			continue;
+		}
+
+		debug("UAS: %s ERROR\n", write ? "Write" : "Read");
+		for (i = 0; i < failed; i++)
+			done += us->uas_cmds[i].blocks;
+		us->flags &= ~USB_READY;
+		if (!retry--)
+			break;
+	}
+
+	return done;
+}
+
+/*
+ * Switch a SuperSpeed device offering UAS over to it: find the UAS alternate
+ * setting and its pipes in the configuration descriptor, select it and set up
+ * bulk streams on the status and data pipes.
+ */
+static int usb_stor_UAS_setup(struct usb_device *dev, struct usb_interface *iface,
+			      struct us_data *ss)
+{
+	struct usb_descriptor_header *head;
+	struct usb_interface_descriptor *if_desc;
+	struct usb_endpoint_descriptor *ep_desc = NULL;
+	unsigned char pipes[UAS_PIPE_ID_DATA_OUT + 1] = { };
+	unsigned int max_streams[UAS_PIPE_ID_DATA_OUT + 1] = { };
+	unsigned int ep_streams = 0;
+	unsigned long stream_pipes[3];
+	unsigned char *buf;
+	int alt = -1;
+	int index, len, num, ret;
+	size_t size;
+
+	if (dev->speed < USB_SPEED_SUPER)
+		return -EPROTONOSUPPORT;
+
+	len = usb_get_configuration_len(dev, dev->configno);
+	if (len < 0)
+		return len;
+	buf = malloc_cache_aligned(len);
+	if (!buf)
+		return -ENOMEM;
+	len = usb_get_configuration_no(dev, dev->configno, buf, len);
+
+	for (index = 0; index + 2 <= len; index += head->bLength) {
+		head = (struct usb_descriptor_header *)&buf[index];
+		if (head->bLength < 2 || index + head->bLength > len)
+			break;
+
+		switch (head->bDescriptorType) {
+		case USB_DT_INTERFACE:
+			if (alt >= 0)
+				goto found;
+			if_desc = (struct usb_interface_descriptor *)head;
+			if (if_desc->bInterfaceNumber ==
+			    iface->desc.bInterfaceNumber &&
+			    if_desc->bInterfaceClass == USB_CLASS_MASS_STORAGE &&
+			    if_desc->bInterfaceSubClass == US_SC_SCSI &&
+			    if_desc->bInterfaceProtocol == US_PR_UAS)
+				alt = if_desc->bAlternateSetting;
+			break;
+		case USB_DT_ENDPOINT:
+			ep_desc = (struct usb_endpoint_descriptor *)head;
+			ep_streams = 0;
+			break;
+		case USB_DT_SS_ENDPOINT_COMP:
+			/* bmAttributes 4:0 is log2 of the streams of bulk eps */
+			ep_streams = 1 << (buf[index + 3] & 0x1f);
+			if (!(buf[index + 3] & 0x1f))
+				ep_streams = 0;
+			break;
+		case USB_DT_PIPE_USAGE:
+			num = buf[index + 2];
+			if (alt < 0 || !ep_desc || num < UAS_PIPE_ID_CMD ||
+			    num > UAS_PIPE_ID_DATA_OUT)
+				break;
+			pipes[num] = ep_desc->bEndpointAddress &
+				     USB_ENDPOINT_NUMBER_MASK;
+			max_streams[num] = ep_streams;
+			break;
+		}
+	}
+found:
+	free(buf);
+
+	if (alt < 0 || !pipes[UAS_PIPE_ID_CMD] || !pipes[UAS_PIPE_ID_STATUS] ||
+	    !pipes[UAS_PIPE_ID_DATA_IN] || !pipes[UAS_PIPE_ID_DATA_OUT]) {
+		debug("UAS: no UAS interface\n");
+		return -ENOENT;
+	}
+
+	num = UAS_MAX_CMDS;
+	for (index = UAS_PIPE_ID_STATUS; index <= UAS_PIPE_ID_DATA_OUT; index++)
+		num = min_t(int, num, max_streams[index]);
+	if (!num) {
+		debug("UAS: device has no bulk streams\n");
+		return -EPROTONOSUPPORT;
+	}
+
+	ss->uas_cmds = malloc_cache_aligned(num * sizeof(struct uas_cmd));
+	if (!ss->uas_cmds)
+		return -ENOMEM;
+	memset(ss->uas_cmds, '\0', num * sizeof(struct uas_cmd));
+
+	ret = usb_set_interface(dev, iface->desc.bInterfaceNumber, alt);
+	if (ret)
+		goto err_free;
+
+	/*
+	 * This must be the last step which can fail: once the endpoints use
+	 * streams, Bulk-Only Transport can no longer run on them.
+	 */
+	stream_pipes[0] = usb_rcvbulkpipe(dev, pipes[UAS_PIPE_ID_STATUS]);
+	stream_pipes[1] = usb_rcvbulkpipe(dev, pipes[UAS_PIPE_ID_DATA_IN]);
+	stream_pipes[2] = usb_sndbulkpipe(dev, pipes[UAS_PIPE_ID_DATA_OUT]);
+	ret = usb_alloc_streams(dev, stream_pipes, ARRAY_SIZE(stream_pipes),
+				num);
+	if (ret < 0) {
+		debug("UAS: cannot allocate streams: %d\n", ret);
+		goto err;
+	}
+	num = min(num, ret);
+
+	ss->num_cmds = num;
+	ss->ep_cmd = pipes[UAS_PIPE_ID_CMD];
+	ss->ep_status = pipes[UAS_PIPE_ID_STATUS];
+	ss->ep_in = pipes[UAS_PIPE_ID_DATA_IN];
+	ss->ep_out = pipes[UAS_PIPE_ID_DATA_OUT];
+	ss->subclass = US_SC_SCSI;
+	ss->protocol = US_PR_UAS;
+	ss->transport = usb_stor_UAS_transport;
+
+	/*
+	 * The 240 block limit of Bulk-Only Transport is for old devices;
+	 * UAS ones take what fits in one transfer of the host controller.
+	 */
+	ss->max_xfer_blk = U16_MAX;
+	if (!usb_get_max_xfer_size(dev, &size) && size / 512 < U16_MAX)
+		ss->max_xfer_blk = size / 512;
+
+	debug("UAS: %d commands in flight, %d blocks each\n", num,
+	      ss->max_xfer_blk);
+
+	return 0;
+err:
+	if (alt)
+		usb_set_interface(dev, iface->desc.bInterfaceNumber, 0);
+err_free:
+	free(ss->uas_cmds);
+	ss->uas_cmds = NULL;
+
+	return ret;
+}
+
 static void usb_stor_set_max_xfer_blk(struct usb_device *udev,
 				      struct us_data *us)
 {
@@ -1001,6 +1385,10 @@ static int usb_request_sense(struct scsi_cmd *srb, struct us_data *ss)
 {
 	char *ptr;
 
+	/* UAS returns the sense data with the status of the failed command */
+	if (ss->protocol == US_PR_UAS)
+		return 0;
+
 	ptr = (char *)srb->pdata;
 	memset(&srb->cmd[0], 0, 12);
 	srb->cmd[0] = SCSI_REQ_SENSE;
@@ -1170,6 +1558,12 @@ static unsigned long usb_stor_read(struct blk_desc *block_dev, lbaint_t blknr,
 	debug("\nusb_read: dev %d startblk " LBAF ", blccnt " LBAF " buffer %lx\n",
 	      block_dev->devnum, start, blks, buf_addr);
 
+	if (CONFIG_IS_ENABLED(USB_UAS) && ss->protocol == US_PR_UAS) {
+		blkcnt = usb_stor_UAS_rw(ss, srb, start, blks, (void *)buffer,
+					 block_dev->blksz, false);
+		goto out;
+	}
+
 	do {
 		/* XXX need some comment here */
 		retry = 2;
@@ -1200,6 +1594,7 @@ retry_it:
 	debug("usb_read: end startblk " LBAF ", blccnt %x buffer %lx\n",
 	      start, smallblks, buf_addr);
 
+out:
 	usb_lock_async(udev, 0);
 	usb_disable_asynch(0); /* asynch transfer allowed */
 	if (blkcnt >= ss->max_xfer_blk)
@@ -1255,6 +1650,12 @@ static unsigned long usb_stor_write(struct blk_desc *block_dev, lbaint_t blknr,
 	debug("\nusb_write: dev %d startblk " LBAF ", blccnt " LBAF " buffer %lx\n",
 	      block_dev->devnum, start, blks, buf_addr);
 
+	if (CONFIG_IS_ENABLED(USB_UAS) && ss->protocol == US_PR_UAS) {
+		blkcnt = usb_stor_UAS_rw(ss, srb, start, blks, (void *)buffer,
+					 block_dev->blksz, true);
+		goto out;
+	}
+
 	do {
 		/* If write fails retry for max retry count else
 		 * return with number of blocks written successfully.
@@ -1287,6 +1688,7 @@ retry_it:
 	debug("usb_write: end startblk " LBAF ", blccnt %x buffer %lx\n",
 	      start, smallblks, buf_addr);
 
+out:
 	usb_lock_async(udev, 0);
 	usb_disable_asynch(0); /* asynch transfer allowed */
 	if (blkcnt >= ss->max_xfer_blk)
@@ -1329,6 +1731,13 @@ int usb_storage_probe(struct usb_device *dev, unsigned int ifnum,
 	ss->subclass = iface->desc.bInterfaceSubClass;
 	ss->protocol = iface->desc.bInterfaceProtocol;
 
+	/* Prefer UAS where the device and host controller can do it */
+	if (CONFIG_IS_ENABLED(USB_UAS) && !usb_stor_UAS_setup(dev, iface, ss)) {
+		debug("USB Attached SCSI\n");
+		dev->privptr = (void *)ss;
+		return 1;
+	}
+
 	/* set the handler pointers based on the protocol */
 	debug("Transport: ");
 	switch (ss->protocol) {
@@ -436,6 +436,128 @@ int blk_get_device(int if_type, int devnum, struct udevice **devp)
 	return device_probe(*devp);
 }
 
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+static int (*blk_idle_func)(void *priv);
+static void *blk_idle_priv;
+
+void blk_set_idle_work(int (*func)(void *priv), void *priv)
+{
+	blk_idle_func = func;
+	blk_idle_priv = priv;
+}
+
+int blk_submit_read(struct blk_desc *block_dev, struct blk_req *req)
+{
+	struct udevice *dev = block_dev->bdev;
+	const struct blk_ops *ops = blk_get_ops(dev);
+	ulong blks_read;
+	int ret;
+
+	req->xfered = 0;
+	req->cur = 0;
+	req->status = -EBUSY;
+	if (ops->submit_read && ops->poll) {
+		ret = ops->submit_read(dev, req);
+		if (ret != -ENOSYS) {
+			if (ret)
+				req->status = ret;
+			return ret;
+		}
+	}
+
+	blks_read = blk_dread(block_dev, req->start, req->blkcnt, req->buffer);
+	if (IS_ERR_VALUE(blks_read)) {
+		req->status = blks_read;
+		return blks_read;
+	}
+	req->xfered = blks_read;
+	req->status = blks_read == req->blkcnt ? 0 : -EIO;
+
+	return 0;
+}
+
+int blk_poll(struct blk_desc *block_dev, struct blk_req *req)
+{
+	struct udevice *dev = block_dev->bdev;
+	const struct blk_ops *ops = blk_get_ops(dev);
+	int ret;
+
+	if (req->status != -EBUSY)
+		return req->status;
+
+	ret = ops->poll(dev, req);
+	if (ret != -EBUSY)
+		req->status = ret;
+
+	return ret;
+}
+
+int blk_wait(struct blk_desc *block_dev, struct blk_req *req)
+{
+	bool idle = true;
+	int ret;
+
+	while ((ret = blk_poll(block_dev, req)) == -EBUSY) {
+		if (idle && blk_idle_func)
+			idle = blk_idle_func(blk_idle_priv);
+	}
+
+	return ret;
+}
+
+/* Read with the idle work running while the data is in flight */
+static ulong blk_dread_overlap(struct blk_desc *block_dev, lbaint_t start,
+			       lbaint_t blkcnt, void *buffer)
+{
+	const struct blk_ops *ops = blk_get_ops(block_dev->bdev);
+	struct blk_req req = {
+		.start = start,
+		.blkcnt = blkcnt,
+		.buffer = buffer,
+		.status = -EBUSY,
+	};
+	int ret;
+
+	ret = ops->submit_read(block_dev->bdev, &req);
+	if (ret == -ENOSYS)
+		return ops->read(block_dev->bdev, start, blkcnt, buffer);
+	if (ret)
+		return ret;
+
+	ret = blk_wait(block_dev, &req);
+	if (ret && !req.xfered)
+		return ret;
+
+	return req.xfered;
+}
+
+/* Write with the idle work running while the data is in flight */
+static ulong blk_dwrite_overlap(struct blk_desc *block_dev, lbaint_t start,
+				lbaint_t blkcnt, const void *buffer)
+{
+	const struct blk_ops *ops = blk_get_ops(block_dev->bdev);
+	struct blk_req req = {
+		.start = start,
+		.blkcnt = blkcnt,
+		.buffer = (void *)buffer,
+		.status = -EBUSY,
+	};
+	int ret;
+
+	ret = ops->submit_write(block_dev->bdev, &req);
+	if (ret == -ENOSYS)
+		return ops->write(block_dev->bdev, start, blkcnt, buffer);
+	if (ret)
+		return ret;
+
+	ret = blk_wait(block_dev, &req);
+	if (ret && !req.xfered)
+		return ret;
+
+	return req.xfered;
+}
+#endif
+
 unsigned long blk_dread(struct blk_desc *block_dev, lbaint_t start,
 			lbaint_t blkcnt, void *buffer)
 {
@@ -449,7 +571,12 @@ unsigned long blk_dread(struct blk_desc *block_dev, lbaint_t start,
 	if (blkcache_read(block_dev->if_type, block_dev->devnum,
 			  start, blkcnt, block_dev->blksz, buffer))
 		return blkcnt;
-	blks_read = ops->read(dev, start, blkcnt, buffer);
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	if (blk_idle_func && ops->submit_read && ops->poll)
+		blks_read = blk_dread_overlap(block_dev, start, blkcnt, buffer);
+	else
+#endif
+		blks_read = ops->read(dev, start, blkcnt, buffer);
 	if (blks_read == blkcnt)
 		blkcache_fill(block_dev->if_type, block_dev->devnum,
 			      start, blkcnt, block_dev->blksz, buffer);
@@ -457,6 +584,37 @@ unsigned long blk_dread(struct blk_desc *block_dev, lbaint_t start,
 	return blks_read;
 }
 
+unsigned long blk_dread_sg(struct blk_desc *block_dev,
+			   const struct blk_sg *sg, int count)
+{
+	struct udevice *dev = block_dev->bdev;
+	const struct blk_ops *ops = blk_get_ops(dev);
+	ulong total = 0, n;
+	int i;
+
+	if (!count)
+		return 0;
+
+	/*
+	 * Vectored reads are used for bulk file data, so they bypass the
+	 * block cache. Writes invalidate the cache, so this stays coherent.
+	 */
+	if (ops->read_sg)
+		return ops->read_sg(dev, sg, count);
+
+	for (i = 0; i < count; i++) {
+		n = blk_dread(block_dev, sg[i].start, sg[i].blkcnt,
+			      sg[i].buffer);
+		if (IS_ERR_VALUE(n))
+			return total ? total : n;
+		total += n;
+		if (n != sg[i].blkcnt)
+			break;
+	}
+
+	return total;
+}
+
 unsigned long blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
 			 lbaint_t blkcnt, const void *buffer)
 {
@@ -467,6 +625,10 @@ unsigned long blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
 		return -ENOSYS;
 
 	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	if (blk_idle_func && ops->submit_write && ops->poll)
+		return blk_dwrite_overlap(block_dev, start, blkcnt, buffer);
+#endif
 	return ops->write(dev, start, blkcnt, buffer);
 }
 
@@ -14,6 +14,7 @@
 #include <errno.h>
 #include <log.h>
 #include <malloc.h>
+#include <malloc_cache.h>
 #include <dm/device.h>
 #include <dm/device-internal.h>
 #include <dm/uclass.h>
@@ -113,6 +114,7 @@ int device_unbind(struct udevice *dev)
 	ret = uclass_unbind_device(dev);
 	if (ret)
 		return log_msg_ret("uc", ret);
+	device_ofnode_hash_del(dev);
 
 	if (dev->parent)
 		list_del(&dev->sibling_node);
@@ -121,7 +123,7 @@ int device_unbind(struct udevice *dev)
 
 	if (dev_get_flags(dev) & DM_FLAG_NAME_ALLOCED)
 		free((char *)dev->name);
-	free(dev);
+	malloc_cache_free(&udevice_cache, dev);
 
 	return 0;
 }
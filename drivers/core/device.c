@@ -17,6 +17,7 @@
 #include <fdtdec.h>
 #include <fdt_support.h>
 #include <malloc.h>
+#include <malloc_cache.h>
 #include <asm/cache.h>
 #include <dm/device.h>
 #include <dm/device-internal.h>
@@ -35,6 +36,38 @@
 
 DECLARE_GLOBAL_DATA_PTR;
 
+MALLOC_CACHE(udevice_cache, sizeof(struct udevice));
+
+#if CONFIG_IS_ENABLED(DM_DEFERRED_PROBE)
+/* Check whether a newly bound device should only be probed on first use */
+static bool device_bind_deferred(struct udevice *dev)
+{
+	const char *list = CONFIG_DM_DEFERRED_PROBE_UCLASSES;
+	const char *name = dev->uclass->uc_drv->name;
+	const char *p;
+	int len;
+
+	/* Devices bound before relocation are bound again afterwards */
+	if (!(gd->flags & GD_FLG_RELOC))
+		return false;
+	if (dev->parent && (dev_get_flags(dev->parent) & DM_FLAG_PROBE_DEFERRED))
+		return true;
+	if (ofnode_valid(dev_ofnode(dev)) &&
+	    ofnode_read_bool(dev_ofnode(dev), "u-boot,deferred-probe"))
+		return true;
+	if (!name)
+		return false;
+
+	len = strlen(name);
+	for (p = list; (p = strstr(p, name)); p += len) {
+		if ((p == list || p[-1] == ' ') && (!p[len] || p[len] == ' '))
+			return true;
+	}
+
+	return false;
+}
+#endif
+
 static int device_bind_common(struct udevice *parent, const struct driver *drv,
 			      const char *name, void *plat,
 			      ulong driver_data, ofnode node,
@@ -60,7 +93,7 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 		return ret;
 	}
 
-	dev = calloc(1, sizeof(struct udevice));
+	dev = malloc_cache_alloc(&udevice_cache);
 	if (!dev)
 		return -ENOMEM;
 
@@ -161,6 +194,7 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 	ret = uclass_bind_device(dev);
 	if (ret)
 		goto fail_uclass_bind;
+	device_ofnode_hash_add(dev);
 
 	/* if we fail to bind we remove device from successors and free it */
 	if (drv->bind) {
@@ -185,6 +219,10 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 		*devp = dev;
 
 	dev_or_flags(dev, DM_FLAG_BOUND);
+#if CONFIG_IS_ENABLED(DM_DEFERRED_PROBE)
+	if (device_bind_deferred(dev))
+		dev_or_flags(dev, DM_FLAG_PROBE_DEFERRED);
+#endif
 
 	return 0;
 
@@ -199,6 +237,7 @@ fail_child_post_bind:
 	}
 
 fail_bind:
+	device_ofnode_hash_del(dev);
 	if (CONFIG_IS_ENABLED(DM_DEVICE_REMOVE)) {
 		if (uclass_unbind_device(dev)) {
 			dm_warn("Failed to unbind dev '%s' on error path\n",
@@ -230,7 +269,7 @@ fail_alloc2:
 fail_alloc1:
 	devres_release_all(dev);
 
-	free(dev);
+	malloc_cache_free(&udevice_cache, dev);
 
 	return ret;
 }
@@ -807,6 +846,121 @@ int device_get_child_by_of_offset(const struct udevice *parent, int node,
 	return device_get_device_tail(dev, ret, devp);
 }
 
+#if CONFIG_IS_ENABLED(DM_OFNODE_HASH)
+/* Number of buckets in the table of devices by node */
+#define OFNODE_HASH_BITS	6
+#define OFNODE_HASH_SIZE	(1 << OFNODE_HASH_BITS)
+
+/*
+ * Devices bound by dm_init_and_scan() in board_init_f() are added here, at a
+ * point where BSS may still overlap the control FDT, so the table is in the
+ * data section. dm_init() empties it before a new tree is set up.
+ */
+static struct hlist_head ofnode_hash[OFNODE_HASH_SIZE] __section(".data");
+
+/* Lookups are only counted after relocation, once BSS can be written */
+static struct device_ofnode_hash_stats ofnode_hash_stats;
+
+static struct hlist_head *ofnode_hash_bucket(ofnode node)
+{
+	/* Node pointers and flat-tree offsets are both at least 4-aligned */
+	u32 key = (ulong)node.of_offset >> 2;
+
+	return &ofnode_hash[(key * 0x9e3779b1) >> (32 - OFNODE_HASH_BITS)];
+}
+
+void device_ofnode_hash_add(struct udevice *dev)
+{
+	struct hlist_head *head;
+	struct hlist_node *pos;
+
+	if (!ofnode_valid(dev_ofnode(dev)) || !hlist_unhashed(&dev->hash_node))
+		return;
+
+	/* Add to the end so that devices using the same node stay in order */
+	head = ofnode_hash_bucket(dev_ofnode(dev));
+	pos = head->first;
+	if (!pos) {
+		hlist_add_head(&dev->hash_node, head);
+	} else {
+		while (pos->next)
+			pos = pos->next;
+		hlist_add_after(pos, &dev->hash_node);
+	}
+}
+
+void device_ofnode_hash_del(struct udevice *dev)
+{
+	if (hlist_unhashed(&dev->hash_node))
+		return;
+	hlist_del_init(&dev->hash_node);
+}
+
+void device_ofnode_hash_reset(void)
+{
+	memset(ofnode_hash, '\0', sizeof(ofnode_hash));
+}
+
+static int device_depth(struct udevice *dev)
+{
+	int depth;
+
+	for (depth = 0; dev->parent; depth++)
+		dev = dev->parent;
+
+	return depth;
+}
+
+struct udevice *device_ofnode_hash_find(ofnode node, enum uclass_id id)
+{
+	struct udevice *dev, *found = NULL;
+	struct hlist_node *pos;
+	int depth, found_depth = 0;
+	ulong compares = 0;
+
+	hlist_for_each_entry(dev, pos, ofnode_hash_bucket(node), hash_node) {
+		compares++;
+		if (!ofnode_equal(dev_ofnode(dev), node))
+			continue;
+		if (id != UCLASS_INVALID) {
+			if (device_get_uclass_id(dev) != id)
+				continue;
+			found = dev;
+			break;
+		}
+
+		/* Match the search from the root, which finds parents first */
+		depth = device_depth(dev);
+		if (!found || depth < found_depth) {
+			found = dev;
+			found_depth = depth;
+		}
+	}
+	if (gd->flags & GD_FLG_RELOC) {
+		ofnode_hash_stats.lookups++;
+		ofnode_hash_stats.compares += compares;
+		if (found)
+			ofnode_hash_stats.found++;
+	}
+
+	return found;
+}
+
+void device_ofnode_hash_get_stats(struct device_ofnode_hash_stats *stats)
+{
+	struct hlist_node *pos;
+	int i;
+
+	*stats = ofnode_hash_stats;
+	stats->buckets = OFNODE_HASH_SIZE;
+	stats->devices = 0;
+	for (i = 0; i < OFNODE_HASH_SIZE; i++) {
+		for (pos = ofnode_hash[i].first; pos; pos = pos->next)
+			stats->devices++;
+	}
+}
+#endif
+
 static struct udevice *_device_find_global_by_ofnode(struct udevice *parent,
 						     ofnode ofnode)
 {
@@ -824,9 +978,17 @@ static struct udevice *_device_find_global_by_ofnode(struct udevice *parent,
 	return NULL;
 }
 
+static struct udevice *device_find_global(ofnode ofnode)
+{
+	if (CONFIG_IS_ENABLED(DM_OFNODE_HASH) && ofnode_valid(ofnode))
+		return device_ofnode_hash_find(ofnode, UCLASS_INVALID);
+
+	return _device_find_global_by_ofnode(gd->dm_root, ofnode);
+}
+
 int device_find_global_by_ofnode(ofnode ofnode, struct udevice **devp)
 {
-	*devp = _device_find_global_by_ofnode(gd->dm_root, ofnode);
+	*devp = device_find_global(ofnode);
 
 	return *devp ? 0 : -ENOENT;
 }
@@ -835,7 +997,7 @@ int device_get_global_by_ofnode(ofnode ofnode, struct udevice **devp)
 {
 	struct udevice *dev;
 
-	dev = _device_find_global_by_ofnode(gd->dm_root, ofnode);
+	dev = device_find_global(ofnode);
 	return device_get_device_tail(dev, dev ? 0 : -ENOENT, devp);
 }
 
@@ -6,6 +6,7 @@
 #include <common.h>
 #include <dm.h>
 #include <mapmem.h>
+#include <dm/device-internal.h>
 #include <dm/root.h>
 #include <dm/util.h>
 #include <dm/uclass-internal.h>
@@ -176,3 +177,19 @@ void dm_dump_static_driver_info(void)
 		       (ulong)map_to_sysmem(entry->plat));
 	}
 }
+
+#if CONFIG_IS_ENABLED(DM_OFNODE_HASH)
+void dm_dump_ofnode_hash(void)
+{
+	struct device_ofnode_hash_stats stats;
+
+	device_ofnode_hash_get_stats(&stats);
+	printf("Devices:  %u in %u buckets\n", stats.devices, stats.buckets);
+	printf("Lookups:  %lu, %lu found\n", stats.lookups, stats.found);
+	printf("Compared: %lu devices", stats.compares);
+	if (stats.lookups)
+		printf(" (%lu per lookup)", stats.compares / stats.lookups);
+	printf(", linear search: up to %lu\n",
+	       stats.lookups * stats.devices);
+}
+#endif
@@ -22,6 +22,7 @@
 #include <common.h>
 #include <log.h>
 #include <malloc.h>
+#include <of_live.h>
 #include <asm/global_data.h>
 #include <linux/bug.h>
 #include <linux/libfdt.h>
@@ -47,6 +48,17 @@ static struct device_node *of_stdout;
 /* pointer to options given after the alias (separated by :) or NULL if none */
 static const char *of_stdout_options;
 
+#if CONFIG_IS_ENABLED(OF_PHANDLE_CACHE)
+#define PHANDLE_CACHE_SIZE	CONFIG_OF_PHANDLE_CACHE_SIZE
+#else
+#define PHANDLE_CACHE_SIZE	0
+#endif
+
+/* node for each phandle of the tree at phandle_cache_root, NULL if none */
+static struct device_node **phandle_cache;
+static uint phandle_cache_size;
+static struct device_node *phandle_cache_root;
+
 /**
  * struct alias_prop - Alias property in 'aliases' node
  *
@@ -123,6 +135,17 @@ int of_simple_size_cells(const struct device_node *np)
 	return 2;
 }
 
+struct property *of_get_properties(const struct device_node *np)
+{
+#if CONFIG_IS_ENABLED(OF_LIVE_LAZY)
+	/* The node is only const to callers, it is allocated at run time */
+	if (np->offset >= 0 && of_live_read_props((struct device_node *)np))
+		return NULL;
+#endif
+
+	return np->properties;
+}
+
 struct property *of_find_property(const struct device_node *np,
 				  const char *name, int *lenp)
 {
@@ -131,7 +154,7 @@ struct property *of_find_property(const struct device_node *np,
 	if (!np)
 		return NULL;
 
-	for (pp = np->properties; pp; pp = pp->next) {
+	for (pp = of_get_properties(np); pp; pp = pp->next) {
 		if (strcmp(pp->name, name) == 0) {
 			if (lenp)
 				*lenp = pp->length;
@@ -179,7 +202,7 @@ const struct property *of_get_first_property(const struct device_node *np)
 	if (!np)
 		return NULL;
 
-	return  np->properties;
+	return of_get_properties(np);
 }
 
 const struct property *of_get_next_property(const struct device_node *np,
@@ -341,7 +364,7 @@ static struct device_node *__of_find_node_by_path(struct device_node *parent,
 }
 
 #define for_each_property_of_node(dn, pp) \
-	for (pp = dn->properties; pp != NULL; pp = pp->next)
+	for (pp = of_get_properties(dn); pp != NULL; pp = pp->next)
 
 struct device_node *of_find_node_opts_by_path(const char *path,
 					      const char **opts)
@@ -446,6 +469,14 @@ struct device_node *of_find_node_by_phandle(phandle handle)
 	if (!handle)
 		return NULL;
 
+	if (CONFIG_IS_ENABLED(OF_PHANDLE_CACHE) &&
+	    phandle_cache_root == gd_of_root() &&
+	    handle < phandle_cache_size) {
+		np = phandle_cache[handle];
+		if (np && np->phandle == handle)
+			return of_node_get(np);
+	}
+
 	for_each_of_allnodes(np)
 		if (np->phandle == handle)
 			break;
@@ -777,6 +808,35 @@ static void of_alias_add(struct alias_prop *ap, struct device_node *np,
 	      ap->alias, ap->stem, ap->id, of_node_full_name(np));
 }
 
+int of_phandle_cache_init(void)
+{
+	struct device_node *np;
+	phandle max = 0;
+
+	if (!CONFIG_IS_ENABLED(OF_PHANDLE_CACHE))
+		return 0;
+
+	free(phandle_cache);
+	phandle_cache_root = NULL;
+	phandle_cache_size = 0;
+
+	for_each_of_allnodes(np)
+		max = max(max, np->phandle);
+	max = min(max, (phandle)PHANDLE_CACHE_SIZE - 1);
+	phandle_cache = calloc(max + 1, sizeof(*phandle_cache));
+	if (!phandle_cache)
+		return -ENOMEM;
+
+	for_each_of_allnodes(np) {
+		if (np->phandle && np->phandle <= max)
+			phandle_cache[np->phandle] = np;
+	}
+	phandle_cache_size = max + 1;
+	phandle_cache_root = gd_of_root();
+
+	return 0;
+}
+
 int of_alias_scan(void)
 {
 	struct property *pp;
@@ -57,8 +57,8 @@ int ofnode_read_u32_index(ofnode node, const char *propname, int index,
 		return of_read_u32_index(ofnode_to_np(node), propname, index,
 					 outp);
 
-	cell = fdt_getprop(gd->fdt_blob, ofnode_to_offset(node), propname,
-			   &len);
+	cell = fdtdec_getprop(gd->fdt_blob, ofnode_to_offset(node), propname,
+			      &len);
 	if (!cell) {
 		debug("(not found)\n");
 		return -EINVAL;
@@ -103,8 +103,8 @@ int ofnode_read_u64(ofnode node, const char *propname, u64 *outp)
 	if (ofnode_is_np(node))
 		return of_read_u64(ofnode_to_np(node), propname, outp);
 
-	cell = fdt_getprop(gd->fdt_blob, ofnode_to_offset(node), propname,
-			   &len);
+	cell = fdtdec_getprop(gd->fdt_blob, ofnode_to_offset(node), propname,
+			      &len);
 	if (!cell || len < sizeof(*cell)) {
 		debug("(not found)\n");
 		return -EINVAL;
@@ -155,8 +155,8 @@ const void *ofnode_read_prop(ofnode node, const char *propname, int *sizep)
 			len = prop->length;
 		}
 	} else {
-		val = fdt_getprop(gd->fdt_blob, ofnode_to_offset(node),
-				  propname, &len);
+		val = fdtdec_getprop(gd->fdt_blob, ofnode_to_offset(node),
+				     propname, &len);
 	}
 	if (!val) {
 		debug("<not found>\n");
@@ -214,7 +214,7 @@ ofnode ofnode_find_subnode(ofnode node, const char *subnode_name)
 		}
 		subnode = np_to_ofnode(np);
 	} else {
-		int ooffset = fdt_subnode_offset(gd->fdt_blob,
+		int ooffset = fdtdec_subnode_offset(gd->fdt_blob,
 				ofnode_to_offset(node), subnode_name);
 		subnode = offset_to_ofnode(ooffset);
 	}
@@ -331,8 +331,8 @@ ofnode ofnode_get_by_phandle(uint phandle)
 	if (of_live_active())
 		node = np_to_ofnode(of_find_node_by_phandle(phandle));
 	else
-		node.of_offset = fdt_node_offset_by_phandle(gd->fdt_blob,
-							    phandle);
+		node.of_offset = fdtdec_node_offset_by_phandle(gd->fdt_blob,
+							       phandle);
 
 	return node;
 }
@@ -549,7 +549,7 @@ ofnode ofnode_path(const char *path)
 	if (of_live_active())
 		return np_to_ofnode(of_find_node_by_path(path));
 	else
-		return offset_to_ofnode(fdt_path_offset(gd->fdt_blob, path));
+		return offset_to_ofnode(fdtdec_path_offset(gd->fdt_blob, path));
 }
 
 const void *ofnode_read_chosen_prop(const char *propname, int *sizep)
@@ -703,8 +703,8 @@ const void *ofnode_get_property(ofnode node, const char *propname, int *lenp)
 	if (ofnode_is_np(node))
 		return of_get_property(ofnode_to_np(node), propname, lenp);
 	else
-		return fdt_getprop(gd->fdt_blob, ofnode_to_offset(node),
-				   propname, lenp);
+		return fdtdec_getprop(gd->fdt_blob, ofnode_to_offset(node),
+				      propname, lenp);
 }
 
 int ofnode_get_first_property(ofnode node, struct ofprop *prop)
@@ -1072,7 +1072,7 @@ int ofnode_write_prop(ofnode node, const char *propname, int len,
 	if (!np)
 		return -EINVAL;
 
-	for (pp = np->properties; pp; pp = pp->next) {
+	for (pp = of_get_properties(np); pp; pp = pp->next) {
 		if (strcmp(pp->name, propname) == 0) {
 			/* Property exists -> change value */
 			pp->value = (void *)value;
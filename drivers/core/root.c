@@ -174,6 +174,7 @@ int dm_init(bool of_live)
 		gd->uclass_root = &DM_UCLASS_ROOT_S_NON_CONST;
 		INIT_LIST_HEAD(DM_UCLASS_ROOT_NON_CONST);
 	}
+	device_ofnode_hash_reset();
 
 	if (IS_ENABLED(CONFIG_NEEDS_MANUAL_RELOC)) {
 		fix_drivers();
@@ -192,8 +193,10 @@ int dm_init(bool of_live)
 					  &DM_ROOT_NON_CONST);
 		if (ret)
 			return ret;
-		if (CONFIG_IS_ENABLED(OF_CONTROL))
+		if (CONFIG_IS_ENABLED(OF_CONTROL)) {
 			dev_set_ofnode(DM_ROOT_NON_CONST, ofnode_root());
+			device_ofnode_hash_add(DM_ROOT_NON_CONST);
+		}
 		ret = device_probe(DM_ROOT_NON_CONST);
 		if (ret)
 			return ret;
@@ -9,10 +9,12 @@
 #define LOG_CATEGORY LOGC_DM
 
 #include <common.h>
+#include <bootstage.h>
 #include <dm.h>
 #include <errno.h>
 #include <log.h>
 #include <malloc.h>
+#include <malloc_cache.h>
 #include <asm/global_data.h>
 #include <dm/device.h>
 #include <dm/device-internal.h>
@@ -23,6 +25,8 @@
 
 DECLARE_GLOBAL_DATA_PTR;
 
+static MALLOC_CACHE(uclass_cache, sizeof(struct uclass));
+
 struct uclass *uclass_find(enum uclass_id key)
 {
 	struct uclass *uc;
@@ -69,7 +73,7 @@ static int uclass_add(enum uclass_id id, struct uclass **ucp)
 		 */
 		return -EPFNOSUPPORT;
 	}
-	uc = calloc(1, sizeof(*uc));
+	uc = malloc_cache_alloc(&uclass_cache);
 	if (!uc)
 		return -ENOMEM;
 	if (uc_drv->priv_auto) {
@@ -103,7 +107,7 @@ fail:
 	}
 	list_del(&uc->sibling_node);
 fail_mem:
-	free(uc);
+	malloc_cache_free(&uclass_cache, uc);
 
 	return ret;
 }
@@ -137,7 +141,7 @@ int uclass_destroy(struct uclass *uc)
 	list_del(&uc->sibling_node);
 	if (uc_drv->priv_auto)
 		free(uclass_get_priv(uc));
-	free(uc);
+	malloc_cache_free(&uclass_cache, uc);
 
 	return 0;
 }
@@ -386,6 +390,13 @@ int uclass_find_device_by_ofnode(enum uclass_id id, ofnode node,
 	if (ret)
 		return ret;
 
+	if (CONFIG_IS_ENABLED(DM_OFNODE_HASH)) {
+		*devp = device_ofnode_hash_find(node, id);
+		if (!*devp)
+			ret = -ENODEV;
+		goto done;
+	}
+
 	uclass_foreach_dev(dev, uc) {
 		log(LOGC_DM, LOGL_DEBUG_CONTENT, "      - checking %s\n",
 		    dev->name);
@@ -454,13 +465,33 @@ int uclass_get_device_by_driver(enum uclass_id id,
 	return -ENODEV;
 }
 
+/* Probe a deferred device, adding the time taken to the bootstage report */
+static int uclass_probe_deferred(struct udevice *dev)
+{
+	static int depth;
+	int ret;
+
+	/* Probing may request other deferred devices, only time the outer one */
+	if (!depth++)
+		bootstage_start(BOOTSTAGE_ID_ACCUM_DEFERRED_PROBE,
+				"deferred_probe");
+	ret = device_probe(dev);
+	if (!--depth)
+		bootstage_accum(BOOTSTAGE_ID_ACCUM_DEFERRED_PROBE);
+
+	return ret;
+}
+
 int uclass_get_device_tail(struct udevice *dev, int ret, struct udevice **devp)
 {
 	if (ret)
 		return ret;
 
 	assert(dev);
-	ret = device_probe(dev);
+	if (device_probe_deferred(dev))
+		ret = uclass_probe_deferred(dev);
+	else
+		ret = device_probe(dev);
 	if (ret)
 		return ret;
 
@@ -15,9 +15,12 @@
 #include <fat.h>
 #include <dfu.h>
 #include <hash.h>
+#include <asm/cache.h>
 #include <linux/list.h>
 #include <linux/compiler.h>
 
+#define DFU_BUF_ALIGN	max(CONFIG_SYS_CACHELINE_SIZE, ARCH_DMA_MINALIGN)
+
 LIST_HEAD(dfu_list);
 static int dfu_alt_num;
 static int alt_num_cnt;
@@ -181,8 +184,53 @@ static unsigned char *dfu_buf;
 static unsigned long dfu_buf_size;
 static enum dfu_device_type dfu_buf_device_type;
 
+/*
+ * Buffers used when writing is deferred (see dfu_set_defer_write()). They
+ * form a ring: dfu_wbuf_queued buffers starting at dfu_wbuf_head are full
+ * and wait to be written, in the order they were filled, and the one after
+ * them is being filled. The first buffer is dfu_buf.
+ */
+static struct {
+	unsigned char *data;
+	long len;
+} dfu_wbufs[CONFIG_DFU_WRITE_BUFS];
+static int dfu_wbuf_count;	/* Number of buffers allocated */
+static int dfu_wbuf_head;	/* Oldest full buffer */
+static int dfu_wbuf_queued;	/* Number of full buffers */
+static struct dfu_entity *dfu_wbuf_dfu;	/* Entity the full buffers are for */
+static bool dfu_wbuf_writing;	/* dfu_write_queued() is writing a buffer */
+static int dfu_wbuf_err;	/* First error from a deferred write */
+static bool dfu_defer_write;
+/* Packet received while all buffers were full and the oldest being written */
+static unsigned char *dfu_wbuf_hold;
+static int dfu_wbuf_hold_size;	/* Size of dfu_wbuf_hold */
+static int dfu_wbuf_held;	/* Bytes held in dfu_wbuf_hold */
+
+static void dfu_wbuf_reset(void)
+{
+	int i;
+
+	for (i = 0; i < dfu_wbuf_count; i++)
+		dfu_wbufs[i].len = 0;
+	dfu_wbuf_head = 0;
+	dfu_wbuf_queued = 0;
+	dfu_wbuf_dfu = NULL;
+	dfu_wbuf_err = 0;
+	dfu_wbuf_held = 0;
+}
+
 unsigned char *dfu_free_buf(void)
 {
+	int i;
+
+	for (i = 1; i < dfu_wbuf_count; i++)
+		free(dfu_wbufs[i].data);
+	dfu_wbuf_count = 0;
+	dfu_wbuf_reset();
+	free(dfu_wbuf_hold);
+	dfu_wbuf_hold = NULL;
+	dfu_wbuf_hold_size = 0;
+
 	free(dfu_buf);
 	dfu_buf = NULL;
 	return dfu_buf;
@@ -214,15 +262,33 @@ unsigned char *dfu_get_buf(struct dfu_entity *dfu)
 	if (dfu->max_buf_size && dfu_buf_size > dfu->max_buf_size)
 		dfu_buf_size = dfu->max_buf_size;
 
-	dfu_buf = memalign(CONFIG_SYS_CACHELINE_SIZE, dfu_buf_size);
+	/* DMA-aligned, so that block drivers need not bounce the data */
+	dfu_buf = memalign(DFU_BUF_ALIGN, dfu_buf_size);
 	if (dfu_buf == NULL)
 		printf("%s: Could not memalign 0x%lx bytes\n",
 		       __func__, dfu_buf_size);
 
+	dfu_wbufs[0].data = dfu_buf;
+	dfu_wbuf_count = dfu_buf ? 1 : 0;
 	dfu_buf_device_type = dfu->dev_type;
 	return dfu_buf;
 }
 
+/* Allocate the remaining write buffers, which only happens while none is full */
+static void dfu_wbuf_alloc(void)
+{
+	unsigned char *buf;
+
+	while (dfu_wbuf_count < CONFIG_DFU_WRITE_BUFS) {
+		buf = memalign(DFU_BUF_ALIGN, dfu_buf_size);
+		if (!buf)
+			break;
+		dfu_wbufs[dfu_wbuf_count].data = buf;
+		dfu_wbufs[dfu_wbuf_count].len = 0;
+		dfu_wbuf_count++;
+	}
+}
+
 static char *dfu_get_hash_algo(void)
 {
 	char *s;
@@ -240,6 +306,27 @@ static char *dfu_get_hash_algo(void)
 	return NULL;
 }
 
+static int dfu_write_buffer_out(struct dfu_entity *dfu, void *buf, long len)
+{
+	long w_size = len;
+	int ret;
+
+	if (dfu_hash_algo)
+		dfu_hash_algo->hash_update(dfu_hash_algo, &dfu->crc,
+					   buf, w_size, 0);
+
+	ret = dfu->write_medium(dfu, dfu->offset, buf, &w_size);
+	if (ret)
+		debug("%s: Write error!\n", __func__);
+
+	/* update offset */
+	dfu->offset += w_size;
+
+	puts("#");
+
+	return ret;
+}
+
 static int dfu_write_buffer_drain(struct dfu_entity *dfu)
 {
 	long w_size;
@@ -250,25 +337,161 @@ static int dfu_write_buffer_drain(struct dfu_entity *dfu)
 	if (w_size == 0)
 		return 0;
 
-	if (dfu_hash_algo)
-		dfu_hash_algo->hash_update(dfu_hash_algo, &dfu->crc,
-					   dfu->i_buf_start, w_size, 0);
-
-	ret = dfu->write_medium(dfu, dfu->offset, dfu->i_buf_start, &w_size);
-	if (ret)
-		debug("%s: Write error!\n", __func__);
+	ret = dfu_write_buffer_out(dfu, dfu->i_buf_start, w_size);
 
 	/* point back */
 	dfu->i_buf = dfu->i_buf_start;
 
-	/* update offset */
-	dfu->offset += w_size;
+	return ret;
+}
 
-	puts("#");
+/* Point the entity at the buffer after the full ones, if there is one */
+static void dfu_wbuf_fill(struct dfu_entity *dfu)
+{
+	unsigned char *buf = NULL;
+
+	if (dfu_wbuf_queued < dfu_wbuf_count)
+		buf = dfu_wbufs[(dfu_wbuf_head + dfu_wbuf_queued) %
+				dfu_wbuf_count].data;
+
+	dfu->i_buf_start = buf;
+	dfu->i_buf = buf;
+	dfu->i_buf_end = buf ? buf + dfu_buf_size : NULL;
+}
+
+int dfu_write_queued(void)
+{
+	struct dfu_entity *dfu = dfu_wbuf_dfu;
+	int head = dfu_wbuf_head;
+	int ret;
+
+	if (!dfu_wbuf_queued || dfu_wbuf_writing)
+		return 0;
+
+	/* The host may go on sending data into the next buffer meanwhile */
+	dfu_wbuf_writing = true;
+	ret = dfu_write_buffer_out(dfu, dfu_wbufs[head].data,
+				   dfu_wbufs[head].len);
+	dfu_wbuf_writing = false;
+
+	/* The transfer was abandoned while writing */
+	if (!dfu_wbuf_queued)
+		return 0;
+
+	dfu_wbufs[head].len = 0;
+	dfu_wbuf_head = (head + 1) % dfu_wbuf_count;
+	dfu_wbuf_queued--;
+	if (!dfu->i_buf_start)
+		dfu_wbuf_fill(dfu);
+	if (dfu_wbuf_held && dfu->i_buf_start) {
+		memcpy(dfu->i_buf, dfu_wbuf_hold, dfu_wbuf_held);
+		dfu->i_buf += dfu_wbuf_held;
+		dfu_wbuf_held = 0;
+	}
+	if (ret && !dfu_wbuf_err)
+		dfu_wbuf_err = ret;
 
 	return ret;
 }
 
+bool dfu_write_pending(void)
+{
+	return dfu_wbuf_queued && !dfu_wbuf_writing;
+}
+
+bool dfu_write_ready(void)
+{
+	return !dfu_wbuf_held && dfu_wbuf_queued < dfu_wbuf_count;
+}
+
+void dfu_set_defer_write(bool defer)
+{
+	if (!defer && dfu_wbuf_queued) {
+		if (dfu_wbuf_dfu)
+			dfu_transaction_cleanup(dfu_wbuf_dfu);
+		dfu_wbuf_reset();
+	}
+	dfu_defer_write = defer;
+}
+
+/*
+ * Hand the filled part of the buffer over to be written later when writing
+ * is deferred, otherwise write it now. This leaves the entity without a
+ * buffer to fill if all of them are full.
+ */
+static int dfu_write_buffer_queue(struct dfu_entity *dfu)
+{
+	if (!dfu_defer_write)
+		return dfu_write_buffer_drain(dfu);
+
+	if (!dfu_wbuf_queued && dfu_wbuf_count < CONFIG_DFU_WRITE_BUFS)
+		dfu_wbuf_alloc();
+	if (dfu_wbuf_count < 2)
+		return dfu_write_buffer_drain(dfu);
+
+	if (dfu->i_buf == dfu->i_buf_start)
+		return 0;
+
+	dfu_wbufs[(dfu_wbuf_head + dfu_wbuf_queued) % dfu_wbuf_count].len =
+		dfu->i_buf - dfu->i_buf_start;
+	dfu_wbuf_queued++;
+	dfu_wbuf_dfu = dfu;
+	dfu_wbuf_fill(dfu);
+
+	return 0;
+}
+
+/* Make sure there is a buffer to fill, writing the oldest full one if not */
+static int dfu_write_buffer_get(struct dfu_entity *dfu)
+{
+	if (dfu->i_buf_start)
+		return 0;
+
+	return dfu_write_queued();
+}
+
+/*
+ * All buffers are full and the oldest one is being written, while the medium
+ * lets USB be serviced. Keep the packet until dfu_write_queued() has written
+ * that buffer and can put the packet at the start of it. dfu_write_ready()
+ * holds off further packets meanwhile.
+ */
+static int dfu_write_buffer_hold(const void *buf, int size)
+{
+	if (size > dfu_buf_size)
+		return -ENOSPC;
+
+	if (size > dfu_wbuf_hold_size) {
+		free(dfu_wbuf_hold);
+		dfu_wbuf_hold = malloc(size);
+		if (!dfu_wbuf_hold) {
+			dfu_wbuf_hold_size = 0;
+			return -ENOMEM;
+		}
+		dfu_wbuf_hold_size = size;
+	}
+	memcpy(dfu_wbuf_hold, buf, size);
+	dfu_wbuf_held = size;
+
+	return 0;
+}
+
+/* Write all buffers, the full ones first */
+static int dfu_write_buffer_flush(struct dfu_entity *dfu)
+{
+	int ret;
+
+	while (dfu_wbuf_queued) {
+		ret = dfu_write_queued();
+		if (ret)
+			return ret;
+	}
+	if (dfu_wbuf_err)
+		return dfu_wbuf_err;
+
+	return dfu_write_buffer_drain(dfu);
+}
+
 void dfu_transaction_cleanup(struct dfu_entity *dfu)
 {
 	/* clear everything */
@@ -281,6 +504,8 @@ void dfu_transaction_cleanup(struct dfu_entity *dfu)
 	dfu->r_left = 0;
 	dfu->b_left = 0;
 	dfu->bad_skip = 0;
+	if (dfu_wbuf_dfu == dfu || !dfu_wbuf_dfu)
+		dfu_wbuf_reset();
 
 	dfu->inited = 0;
 }
@@ -316,7 +541,7 @@ int dfu_flush(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 {
 	int ret = 0;
 
-	ret = dfu_write_buffer_drain(dfu);
+	ret = dfu_write_buffer_flush(dfu);
 	if (ret)
 		return ret;
 
@@ -370,14 +595,28 @@ int dfu_write(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 	/* handle rollover */
 	dfu->i_blk_seq_num = (dfu->i_blk_seq_num + 1) & 0xffff;
 
+	/* a deferred write of earlier data failed */
+	if (dfu_wbuf_err && dfu_wbuf_dfu == dfu) {
+		ret = dfu_wbuf_err;
+		dfu_transaction_cleanup(dfu);
+		dfu_error_callback(dfu, "DFU write error");
+		return ret;
+	}
+
 	/* flush buffer if overflow */
-	if ((dfu->i_buf + size) > dfu->i_buf_end) {
-		ret = dfu_write_buffer_drain(dfu);
-		if (ret) {
-			dfu_transaction_cleanup(dfu);
-			dfu_error_callback(dfu, "DFU write error");
-			return ret;
-		}
+	if (dfu->i_buf_start && (dfu->i_buf + size) > dfu->i_buf_end)
+		ret = dfu_write_buffer_queue(dfu);
+	if (!ret && !dfu->i_buf_start && dfu_wbuf_writing) {
+		ret = dfu_write_buffer_hold(buf, size);
+		if (!ret)
+			return 0;
+	} else if (!ret) {
+		ret = dfu_write_buffer_get(dfu);
+	}
+	if (ret) {
+		dfu_transaction_cleanup(dfu);
+		dfu_error_callback(dfu, "DFU write error");
+		return ret;
 	}
 
 	/* we should be in buffer now (if not then size too large) */
@@ -394,7 +633,7 @@ int dfu_write(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 
 	/* if end or if buffer full flush */
 	if (size == 0 || (dfu->i_buf + size) > dfu->i_buf_end) {
-		ret = dfu_write_buffer_drain(dfu);
+		ret = dfu_write_buffer_queue(dfu);
 		if (ret) {
 			dfu_transaction_cleanup(dfu);
 			dfu_error_callback(dfu, "DFU write error");
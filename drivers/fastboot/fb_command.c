@@ -29,6 +29,22 @@ static u32 fastboot_bytes_received;
  */
 static u32 fastboot_bytes_expected;
 
+enum fb_stream_state {
+	FB_STREAM_OFF,
+	FB_STREAM_ACTIVE,	/* current download is written while it arrives */
+	FB_STREAM_WRITTEN,	/* last download was written successfully */
+};
+
+/**
+ * stream_part - partition downloads are written to, set by "oem stream"
+ */
+static char stream_part[PART_NAME_LEN];
+
+/**
+ * stream_state - state of the download written to stream_part
+ */
+static enum fb_stream_state stream_state;
+
 static void okay(char *, char *);
 static void getvar(char *, char *);
 static void download(char *, char *);
@@ -48,6 +64,9 @@ static void oem_partconf(char *, char *);
 #if CONFIG_IS_ENABLED(FASTBOOT_CMD_OEM_BOOTBUS)
 static void oem_bootbus(char *, char *);
 #endif
+#if CONFIG_IS_ENABLED(FASTBOOT_CMD_OEM_STREAM)
+static void oem_stream(char *, char *);
+#endif
 
 #if CONFIG_IS_ENABLED(FASTBOOT_UUU_SUPPORT)
 static void run_ucmd(char *, char *);
@@ -122,6 +141,12 @@ static const struct {
 		.dispatch = oem_bootbus,
 	},
 #endif
+#if CONFIG_IS_ENABLED(FASTBOOT_CMD_OEM_STREAM)
+	[FASTBOOT_COMMAND_OEM_STREAM] = {
+		.command = "oem stream",
+		.dispatch = oem_stream,
+	},
+#endif
 #if CONFIG_IS_ENABLED(FASTBOOT_UUU_SUPPORT)
 	[FASTBOOT_COMMAND_UCMD] = {
 		.command = "UCmd",
@@ -193,6 +218,23 @@ static void getvar(char *cmd_parameter, char *response)
 	fastboot_getvar(cmd_parameter, response);
 }
 
+static bool stream_armed(void)
+{
+	return CONFIG_IS_ENABLED(FASTBOOT_CMD_OEM_STREAM) && stream_part[0];
+}
+
+/**
+ * fastboot_data_streamed() - check if downloads are written while they arrive
+ *
+ * Return: true if the current download is consumed by
+ * fastboot_data_download() and does not need to stay in fastboot_buf_addr
+ */
+bool fastboot_data_streamed(void)
+{
+	return CONFIG_IS_ENABLED(FASTBOOT_CMD_OEM_STREAM) &&
+	       stream_state == FB_STREAM_ACTIVE;
+}
+
 /**
  * fastboot_download() - Start a download transfer from the client
  *
@@ -207,6 +249,9 @@ static void download(char *cmd_parameter, char *response)
 		fastboot_fail("Expected command parameter", response);
 		return;
 	}
+	if (fastboot_data_streamed())
+		fastboot_mmc_stream_abort();
+	stream_state = FB_STREAM_OFF;
 	fastboot_bytes_received = 0;
 	fastboot_bytes_expected = hextoul(cmd_parameter, &tmp);
 	if (fastboot_bytes_expected == 0) {
@@ -217,11 +262,19 @@ static void download(char *cmd_parameter, char *response)
 	 * Nothing to download yet. Response is of the form:
 	 * [DATA|FAIL]$cmd_parameter
 	 *
-	 * where cmd_parameter is an 8 digit hexadecimal number
+	 * where cmd_parameter is an 8 digit hexadecimal number. A download
+	 * which is written while it arrives does not have to fit the buffer.
 	 */
-	if (fastboot_bytes_expected > fastboot_buf_size) {
+	if (fastboot_bytes_expected > fastboot_buf_size && !stream_armed()) {
 		fastboot_fail(cmd_parameter, response);
 	} else {
+		if (stream_armed()) {
+			if (fastboot_mmc_stream_start(stream_part, response)) {
+				fastboot_bytes_expected = 0;
+				return;
+			}
+			stream_state = FB_STREAM_ACTIVE;
+		}
 		printf("Starting download of %d bytes\n",
 		       fastboot_bytes_expected);
 		fastboot_response("DATA", response, "%s", cmd_parameter);
@@ -238,6 +291,33 @@ u32 fastboot_data_remaining(void)
 	return fastboot_bytes_expected - fastboot_bytes_received;
 }
 
+/**
+ * fastboot_data_buffer() - return where the next received data belongs
+ *
+ * Return: Address in fastboot_buf_addr for the next byte of the download
+ */
+void *fastboot_data_buffer(void)
+{
+	/* Streamed data is consumed at once, so the buffer is reused */
+	if (fastboot_data_streamed())
+		return fastboot_buf_addr;
+
+	return fastboot_buf_addr + fastboot_bytes_received;
+}
+
+/**
+ * fastboot_data_space() - return the space left in the download buffer
+ *
+ * Return: Number of bytes available from fastboot_data_buffer() on
+ */
+u32 fastboot_data_space(void)
+{
+	if (fastboot_data_streamed())
+		return fastboot_buf_size;
+
+	return fastboot_buf_size - fastboot_bytes_received;
+}
+
 /**
  * fastboot_data_download() - Copy image data to fastboot_buf_addr.
  *
@@ -247,7 +327,9 @@ u32 fastboot_data_remaining(void)
  *
  * Copies image data from fastboot_data to fastboot_buf_addr. Writes to
  * response. fastboot_bytes_received is updated to indicate the number
- * of bytes that have been transferred.
+ * of bytes that have been transferred. Data which was received in place,
+ * at fastboot_data_buffer(), is only accounted for and not copied. A
+ * streamed download is written to its partition instead.
  *
  * On completion sets image_size and ${filesize} to the total size of the
  * downloaded image.
@@ -266,9 +348,24 @@ void fastboot_data_download(const void *fastboot_data,
 			      response);
 		return;
 	}
-	/* Download data to fastboot_buf_addr */
-	memcpy(fastboot_buf_addr + fastboot_bytes_received,
-	       fastboot_data, fastboot_data_len);
+	if (fastboot_data_streamed()) {
+		if (fastboot_mmc_stream_write(fastboot_data, fastboot_data_len,
+					      response)) {
+			/* Refuse the rest of this download */
+			stream_state = FB_STREAM_OFF;
+			fastboot_bytes_expected = 0;
+			fastboot_bytes_received = 0;
+			return;
+		}
+	} else if (fastboot_data != fastboot_data_buffer()) {
+		/*
+		 * Download data to fastboot_buf_addr. In-place data may also
+		 * sit a little further on in the buffer after a short
+		 * transfer, so the regions can overlap.
+		 */
+		memmove(fastboot_data_buffer(), fastboot_data,
+			fastboot_data_len);
+	}
 
 	pre_dot_num = fastboot_bytes_received / BYTES_PER_DOT;
 	fastboot_bytes_received += fastboot_data_len;
@@ -294,6 +391,12 @@ void fastboot_data_complete(char *response)
 	/* Download complete. Respond with "OKAY" */
 	fastboot_okay(NULL, response);
 	printf("\ndownloading of %d bytes finished\n", fastboot_bytes_received);
+	if (fastboot_data_streamed()) {
+		if (fastboot_mmc_stream_finish(response))
+			stream_state = FB_STREAM_OFF;
+		else
+			stream_state = FB_STREAM_WRITTEN;
+	}
 	image_size = fastboot_bytes_received;
 	env_set_hex("filesize", image_size);
 	fastboot_bytes_expected = 0;
@@ -308,10 +411,23 @@ void fastboot_data_complete(char *response)
  * @response: Pointer to fastboot response buffer
  *
  * Writes the previously downloaded image to the partition indicated by
- * cmd_parameter. Writes to response.
+ * cmd_parameter. Writes to response. If downloads are streamed, the image
+ * was written already and only the result is reported.
  */
 static void flash(char *cmd_parameter, char *response)
 {
+	if (stream_armed()) {
+		if (stream_state != FB_STREAM_WRITTEN)
+			fastboot_fail("no image was written", response);
+		else if (strcmp(cmd_parameter, stream_part))
+			fastboot_fail("image was written to another partition",
+				      response);
+		else
+			fastboot_okay(NULL, response);
+		stream_state = FB_STREAM_OFF;
+		return;
+	}
+
 #if CONFIG_IS_ENABLED(FASTBOOT_FLASH_MMC)
 	fastboot_mmc_flash_write(cmd_parameter, fastboot_buf_addr, image_size,
 				 response);
@@ -514,3 +630,29 @@ static void oem_bootbus(char *cmd_parameter, char *response)
 		fastboot_okay(NULL, response);
 }
 #endif
+
+#if CONFIG_IS_ENABLED(FASTBOOT_CMD_OEM_STREAM)
+/**
+ * oem_stream() - Execute the OEM stream command
+ *
+ * @cmd_parameter: Pointer to partition name, or NULL to stop streaming
+ * @response: Pointer to fastboot response buffer
+ */
+static void oem_stream(char *cmd_parameter, char *response)
+{
+	if (!cmd_parameter || !*cmd_parameter) {
+		stream_part[0] = '\0';
+		fastboot_okay(NULL, response);
+		return;
+	}
+
+	if (strlen(cmd_parameter) >= sizeof(stream_part)) {
+		fastboot_fail("partition name too long", response);
+		return;
+	}
+
+	strcpy(stream_part, cmd_parameter);
+	printf("Writing downloads to '%s' while they arrive\n", stream_part);
+	fastboot_okay(NULL, response);
+}
+#endif
@@ -633,6 +633,92 @@ void fastboot_mmc_flash_write(const char *cmd, void *download_buffer,
 	}
 }
 
+#if CONFIG_IS_ENABLED(FASTBOOT_CMD_OEM_STREAM)
+static struct fb_mmc_sparse stream_priv;
+static struct sparse_storage stream_storage;
+static struct sparse_stream stream;
+
+/**
+ * fastboot_mmc_stream_start() - Start writing a download to eMMC
+ *
+ * @cmd: Named partition to write image to
+ * @response: Pointer to fastboot response buffer
+ * Return: 0 if OK, -ve on error
+ */
+int fastboot_mmc_stream_start(const char *cmd, char *response)
+{
+	struct blk_desc *dev_desc;
+	struct disk_partition info = {0};
+
+#if CONFIG_IS_ENABLED(FASTBOOT_MMC_USER_SUPPORT)
+	if (strcmp(cmd, CONFIG_FASTBOOT_MMC_USER_NAME) == 0) {
+		dev_desc = fastboot_mmc_get_dev(response);
+		if (!dev_desc)
+			return -ENODEV;
+
+		strlcpy((char *)&info.name, cmd, sizeof(info.name));
+		info.size	= dev_desc->lba;
+		info.blksz	= dev_desc->blksz;
+	}
+#endif
+
+	if (!info.name[0] &&
+	    fastboot_mmc_get_part_info(cmd, &dev_desc, &info, response) < 0)
+		return -ENODEV;
+
+	stream_priv.dev_desc = dev_desc;
+
+	stream_storage.blksz = info.blksz;
+	stream_storage.start = info.start;
+	stream_storage.size = info.size;
+	stream_storage.write = fb_mmc_sparse_write;
+	stream_storage.reserve = fb_mmc_sparse_reserve;
+	stream_storage.mssg = fastboot_fail;
+	stream_storage.priv = &stream_priv;
+
+	if (sparse_stream_start(&stream, &stream_storage, cmd)) {
+		fastboot_fail("cannot allocate stream buffer", response);
+		return -ENOMEM;
+	}
+	printf("Writing download to '%s' at offset " LBAFU "\n", cmd,
+	       info.start);
+
+	return 0;
+}
+
+/**
+ * fastboot_mmc_stream_write() - Write the next part of a download to eMMC
+ *
+ * @data: Pointer to received data
+ * @len: Length of received data
+ * @response: Pointer to fastboot response buffer
+ * Return: 0 if OK, -ve on error, which stops the write
+ */
+int fastboot_mmc_stream_write(const void *data, u32 len, char *response)
+{
+	return sparse_stream_write(&stream, data, len, response);
+}
+
+/**
+ * fastboot_mmc_stream_finish() - Complete writing a download to eMMC
+ *
+ * @response: Pointer to fastboot response buffer
+ * Return: 0 if the whole image was written, -ve on error
+ */
+int fastboot_mmc_stream_finish(char *response)
+{
+	return sparse_stream_finish(&stream, response);
+}
+
+/**
+ * fastboot_mmc_stream_abort() - Stop writing an incomplete download to eMMC
+ */
+void fastboot_mmc_stream_abort(void)
+{
+	sparse_stream_abort(&stream);
+}
+#endif
+
 /**
  * fastboot_mmc_flash_erase() - Erase eMMC for fastboot
  *
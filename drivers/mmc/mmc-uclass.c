@@ -55,6 +55,31 @@ int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd, struct mmc_data *data)
 	return dm_mmc_send_cmd(mmc->dev, cmd, data);
 }
 
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+int mmc_send_cmd_async(struct mmc *mmc, struct mmc_cmd *cmd,
+		       struct mmc_data *data)
+{
+	struct dm_mmc_ops *ops = mmc_get_ops(mmc->dev);
+	int ret;
+
+	if (!ops->send_cmd_async || !ops->poll_data)
+		return -ENOSYS;
+
+	mmmc_trace_before_send(mmc, cmd);
+	ret = ops->send_cmd_async(mmc->dev, cmd, data);
+	mmmc_trace_after_send(mmc, cmd, ret);
+
+	return ret;
+}
+
+int mmc_poll_data(struct mmc *mmc, struct mmc_data *data)
+{
+	struct dm_mmc_ops *ops = mmc_get_ops(mmc->dev);
+
+	return ops->poll_data(mmc->dev, data);
+}
+#endif
+
 static int dm_mmc_set_ios(struct udevice *dev)
 {
 	struct dm_mmc_ops *ops = mmc_get_ops(dev);
@@ -483,11 +508,33 @@ static int mmc_blk_remove(struct udevice *dev)
 }
 #endif
 
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+static int mmc_blk_poll(struct udevice *dev, struct blk_req *req)
+{
+	struct blk_desc *block_dev = dev_get_uclass_plat(dev);
+	struct mmc *mmc = find_mmc_device(block_dev->devnum);
+
+	if (CONFIG_IS_ENABLED(MMC_WRITE) &&
+	    (mmc->async_data.flags & MMC_DATA_WRITE))
+		return mmc_bwrite_poll(dev, req);
+
+	return mmc_bread_poll(dev, req);
+}
+#endif
+
 static const struct blk_ops mmc_blk_ops = {
 	.read	= mmc_bread,
+	.read_sg	= mmc_bread_sg,
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	.submit_read	= mmc_bread_submit,
+	.poll		= mmc_blk_poll,
+#endif
 #if CONFIG_IS_ENABLED(MMC_WRITE)
 	.write	= mmc_bwrite,
 	.erase	= mmc_berase,
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	.submit_write	= mmc_bwrite_submit,
+#endif
 #endif
 	.select_hwpart	= mmc_select_hwpart,
 };
@@ -14,6 +14,7 @@
 #include <dm.h>
 #include <log.h>
 #include <dm/device-internal.h>
+#include <dm/uclass-internal.h>
 #include <errno.h>
 #include <mmc.h>
 #include <part.h>
@@ -395,47 +396,68 @@ int mmc_send_tuning(struct mmc *mmc, u32 opcode, int *cmd_error)
 }
 #endif
 
-static int mmc_read_blocks(struct mmc *mmc, void *dst, lbaint_t start,
-			   lbaint_t blkcnt)
+static void mmc_read_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
+			 lbaint_t start, lbaint_t blkcnt)
 {
-	struct mmc_cmd cmd;
-	struct mmc_data data;
-
 	if (blkcnt > 1)
-		cmd.cmdidx = MMC_CMD_READ_MULTIPLE_BLOCK;
+		cmd->cmdidx = MMC_CMD_READ_MULTIPLE_BLOCK;
 	else
-		cmd.cmdidx = MMC_CMD_READ_SINGLE_BLOCK;
+		cmd->cmdidx = MMC_CMD_READ_SINGLE_BLOCK;
 
 	if (mmc->high_capacity)
-		cmd.cmdarg = start;
+		cmd->cmdarg = start;
 	else
-		cmd.cmdarg = start * mmc->read_bl_len;
-
-	cmd.resp_type = MMC_RSP_R1;
+		cmd->cmdarg = start * mmc->read_bl_len;
 
-	data.dest = dst;
-	data.blocks = blkcnt;
-	data.blocksize = mmc->read_bl_len;
-	data.flags = MMC_DATA_READ;
+	cmd->resp_type = MMC_RSP_R1;
+}
 
-	if (mmc_send_cmd(mmc, &cmd, &data))
-		return 0;
+static int mmc_read_stop(struct mmc *mmc)
+{
+	struct mmc_cmd cmd;
 
-	if (blkcnt > 1) {
-		cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
-		cmd.cmdarg = 0;
-		cmd.resp_type = MMC_RSP_R1b;
-		if (mmc_send_cmd(mmc, &cmd, NULL)) {
+	cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
+	cmd.cmdarg = 0;
+	cmd.resp_type = MMC_RSP_R1b;
+	if (mmc_send_cmd(mmc, &cmd, NULL)) {
 #if !defined(CONFIG_SPL_BUILD) || defined(CONFIG_SPL_LIBCOMMON_SUPPORT)
-			pr_err("mmc fail to send stop cmd\n");
+		pr_err("mmc fail to send stop cmd\n");
 #endif
-			return 0;
-		}
+		return -EIO;
 	}
 
+	return 0;
+}
+
+static int mmc_read_data(struct mmc *mmc, struct mmc_data *data,
+			 lbaint_t start)
+{
+	lbaint_t blkcnt = data->blocks;
+	struct mmc_cmd cmd;
+
+	mmc_read_cmd(mmc, &cmd, start, blkcnt);
+	if (mmc_send_cmd(mmc, &cmd, data))
+		return 0;
+
+	if (blkcnt > 1 && mmc_read_stop(mmc))
+		return 0;
+
 	return blkcnt;
 }
 
+static int mmc_read_blocks(struct mmc *mmc, void *dst, lbaint_t start,
+			   lbaint_t blkcnt)
+{
+	struct mmc_data data;
+
+	data.dest = dst;
+	data.blocks = blkcnt;
+	data.blocksize = mmc->read_bl_len;
+	data.flags = MMC_DATA_READ;
+
+	return mmc_read_data(mmc, &data, start);
+}
+
 #if !CONFIG_IS_ENABLED(DM_MMC)
 static int mmc_get_b_max(struct mmc *mmc, void *dst, lbaint_t blkcnt)
 {
@@ -505,6 +527,171 @@ ulong mmc_bread(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 	return blkcnt;
 }
 
+#if CONFIG_IS_ENABLED(BLK)
+static bool mmc_sg_aligned(const struct blk_sg *sg)
+{
+	return !((ulong)sg->buffer & (ARCH_DMA_MINALIGN - 1));
+}
+
+/*
+ * Count the segments from @sg which can be read with a single command: they
+ * must follow each other on the card and the host has to be able to DMA to
+ * each buffer directly.
+ */
+static int mmc_sg_group(struct mmc *mmc, const struct blk_sg *sg, int count,
+			lbaint_t *blkcnt)
+{
+	lbaint_t cnt = sg[0].blkcnt;
+	uint b_max;
+	int n = 1;
+
+	if (!mmc_sg_aligned(&sg[0]))
+		goto out;
+
+	b_max = mmc_get_b_max(mmc, sg[0].buffer, cnt);
+	while (n < count && n < mmc->cfg->max_segs &&
+	       sg[n].start == sg[n - 1].start + sg[n - 1].blkcnt &&
+	       mmc_sg_aligned(&sg[n]) && cnt + sg[n].blkcnt <= b_max) {
+		cnt += sg[n].blkcnt;
+		n++;
+	}
+out:
+	*blkcnt = cnt;
+
+	return n;
+}
+
+ulong mmc_bread_sg(struct udevice *dev, const struct blk_sg *sg, int count)
+{
+	struct blk_desc *block_dev = dev_get_uclass_plat(dev);
+	struct mmc_data data;
+	lbaint_t cnt, total = 0;
+	struct mmc *mmc;
+	ulong ret;
+	int i, n;
+
+	mmc = find_mmc_device(block_dev->devnum);
+	if (!mmc)
+		return 0;
+
+	if (mmc->cfg->max_segs > 1) {
+		if (CONFIG_IS_ENABLED(MMC_TINY))
+			ret = mmc_switch_part(mmc, block_dev->hwpart);
+		else
+			ret = blk_dselect_hwpart(block_dev, block_dev->hwpart);
+		if (ret || mmc_set_blocklen(mmc, mmc->read_bl_len))
+			return 0;
+	}
+
+	for (i = 0; i < count; i += n) {
+		n = 1;
+		if (mmc->cfg->max_segs > 1)
+			n = mmc_sg_group(mmc, &sg[i], count - i, &cnt);
+
+		if (n == 1) {
+			ret = mmc_bread(dev, sg[i].start, sg[i].blkcnt,
+					sg[i].buffer);
+			total += ret;
+			if (ret != sg[i].blkcnt)
+				break;
+			continue;
+		}
+
+		if (sg[i].start + cnt > block_dev->lba)
+			break;
+
+		data.dest = sg[i].buffer;
+		data.blocks = cnt;
+		data.blocksize = mmc->read_bl_len;
+		data.flags = MMC_DATA_READ | MMC_DATA_SG;
+		data.sg = &sg[i];
+		data.sg_count = n;
+		if (mmc_read_data(mmc, &data, sg[i].start) != cnt) {
+			pr_debug("%s: Failed to read blocks\n", __func__);
+			break;
+		}
+		total += cnt;
+	}
+
+	return total;
+}
+#endif
+
+#if CONFIG_IS_ENABLED(BLK_ASYNC) && CONFIG_IS_ENABLED(DM_MMC)
+/* Start the next part of an asynchronous read, at most b_max blocks */
+static int mmc_bread_start(struct mmc *mmc, struct blk_req *req)
+{
+	struct mmc_data *data = &mmc->async_data;
+	lbaint_t left = req->blkcnt - req->xfered;
+	struct mmc_cmd cmd;
+	void *dst;
+
+	dst = req->buffer + req->xfered * mmc->read_bl_len;
+	req->cur = min_t(lbaint_t, left, mmc_get_b_max(mmc, dst, left));
+
+	mmc_read_cmd(mmc, &cmd, req->start + req->xfered, req->cur);
+	data->dest = dst;
+	data->blocks = req->cur;
+	data->blocksize = mmc->read_bl_len;
+	data->flags = MMC_DATA_READ;
+
+	return mmc_send_cmd_async(mmc, &cmd, data);
+}
+
+int mmc_bread_submit(struct udevice *dev, struct blk_req *req)
+{
+	struct blk_desc *block_dev = dev_get_uclass_plat(dev);
+	struct mmc *mmc;
+	int ret;
+
+	mmc = find_mmc_device(block_dev->devnum);
+	if (!mmc)
+		return -ENODEV;
+	if (!req->blkcnt)
+		return -ENOSYS;
+
+	ret = blk_dselect_hwpart(block_dev, block_dev->hwpart);
+	if (ret < 0)
+		return ret;
+
+	if (req->start + req->blkcnt > block_dev->lba)
+		return -EINVAL;
+
+	if (mmc_set_blocklen(mmc, mmc->read_bl_len))
+		return -EIO;
+
+	return mmc_bread_start(mmc, req);
+}
+
+int mmc_bread_poll(struct udevice *dev, struct blk_req *req)
+{
+	struct blk_desc *block_dev = dev_get_uclass_plat(dev);
+	struct mmc *mmc = find_mmc_device(block_dev->devnum);
+	int ret;
+
+	ret = mmc_poll_data(mmc, &mmc->async_data);
+	if (ret == -EBUSY)
+		return ret;
+	if (ret) {
+		/* Take the card out of the data state, as for a good read */
+		if (req->cur > 1)
+			mmc_read_stop(mmc);
+		return ret;
+	}
+
+	if (req->cur > 1 && mmc_read_stop(mmc))
+		return -EIO;
+
+	req->xfered += req->cur;
+	if (req->xfered == req->blkcnt)
+		return 0;
+
+	ret = mmc_bread_start(mmc, req);
+
+	return ret ? ret : -EBUSY;
+}
+#endif
+
 static int mmc_go_idle(struct mmc *mmc)
 {
 	struct mmc_cmd cmd;
@@ -3019,11 +3206,15 @@ static int mmc_probe(struct bd_info *bis)
 	 * So if we request 0, 1, 3 we will get 0, 1, 2.
 	 */
 	for (i = 0; ; i++) {
-		ret = uclass_get_device_by_seq(UCLASS_MMC, i, &dev);
+		ret = uclass_find_device_by_seq(UCLASS_MMC, i, &dev);
 		if (ret == -ENODEV)
 			break;
+		if (!ret && !device_probe_deferred(dev))
+			device_probe(dev);
 	}
 	uclass_foreach_dev(dev, uc) {
+		if (device_probe_deferred(dev))
+			continue;
 		ret = device_probe(dev);
 		if (ret)
 			pr_err("%s - probe failed: %d\n", dev->name, ret);
@@ -20,6 +20,11 @@ int mmc_set_blocklen(struct mmc *mmc, int len);
 #if CONFIG_IS_ENABLED(BLK)
 ulong mmc_bread(struct udevice *dev, lbaint_t start, lbaint_t blkcnt,
 		void *dst);
+ulong mmc_bread_sg(struct udevice *dev, const struct blk_sg *sg, int count);
+int mmc_bread_submit(struct udevice *dev, struct blk_req *req);
+int mmc_bread_poll(struct udevice *dev, struct blk_req *req);
+int mmc_bwrite_submit(struct udevice *dev, struct blk_req *req);
+int mmc_bwrite_poll(struct udevice *dev, struct blk_req *req);
 #else
 ulong mmc_bread(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 		void *dst);
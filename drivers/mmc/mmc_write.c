@@ -12,6 +12,8 @@
 #include <dm.h>
 #include <part.h>
 #include <div64.h>
+#include <time.h>
+#include <linux/kernel.h>
 #include <linux/math64.h>
 #include "mmc_private.h"
 
@@ -127,6 +129,42 @@ ulong mmc_berase(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt)
 	return blk;
 }
 
+static void mmc_write_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
+			  lbaint_t start, lbaint_t blkcnt)
+{
+	if (blkcnt == 1)
+		cmd->cmdidx = MMC_CMD_WRITE_SINGLE_BLOCK;
+	else
+		cmd->cmdidx = MMC_CMD_WRITE_MULTIPLE_BLOCK;
+
+	if (mmc->high_capacity)
+		cmd->cmdarg = start;
+	else
+		cmd->cmdarg = start * mmc->write_bl_len;
+
+	cmd->resp_type = MMC_RSP_R1;
+}
+
+/*
+ * Stop a multiple block write. Unless @wait_busy is set, this returns as soon
+ * as the card responds and the caller must poll its status until it has
+ * finished programming.
+ */
+static int mmc_write_stop(struct mmc *mmc, bool wait_busy)
+{
+	struct mmc_cmd cmd;
+
+	cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
+	cmd.cmdarg = 0;
+	cmd.resp_type = wait_busy ? MMC_RSP_R1b : MMC_RSP_R1;
+	if (mmc_send_cmd(mmc, &cmd, NULL)) {
+		printf("mmc fail to send stop cmd\n");
+		return -EIO;
+	}
+
+	return 0;
+}
+
 static ulong mmc_write_blocks(struct mmc *mmc, lbaint_t start,
 		lbaint_t blkcnt, const void *src)
 {
@@ -142,17 +180,8 @@ static ulong mmc_write_blocks(struct mmc *mmc, lbaint_t start,
 
 	if (blkcnt == 0)
 		return 0;
-	else if (blkcnt == 1)
-		cmd.cmdidx = MMC_CMD_WRITE_SINGLE_BLOCK;
-	else
-		cmd.cmdidx = MMC_CMD_WRITE_MULTIPLE_BLOCK;
-
-	if (mmc->high_capacity)
-		cmd.cmdarg = start;
-	else
-		cmd.cmdarg = start * mmc->write_bl_len;
 
-	cmd.resp_type = MMC_RSP_R1;
+	mmc_write_cmd(mmc, &cmd, start, blkcnt);
 
 	data.src = src;
 	data.blocks = blkcnt;
@@ -167,15 +196,9 @@ static ulong mmc_write_blocks(struct mmc *mmc, lbaint_t start,
 	/* SPI multiblock writes terminate using a special
 	 * token, not a STOP_TRANSMISSION request.
 	 */
-	if (!mmc_host_is_spi(mmc) && blkcnt > 1) {
-		cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
-		cmd.cmdarg = 0;
-		cmd.resp_type = MMC_RSP_R1b;
-		if (mmc_send_cmd(mmc, &cmd, NULL)) {
-			printf("mmc fail to send stop cmd\n");
-			return 0;
-		}
-	}
+	if (!mmc_host_is_spi(mmc) && blkcnt > 1 &&
+	    mmc_write_stop(mmc, true))
+		return 0;
 
 	/* Waiting for the ready status */
 	if (mmc_poll_for_busy(mmc, timeout_ms))
@@ -222,3 +245,105 @@ ulong mmc_bwrite(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 
 	return blkcnt;
 }
+
+#if CONFIG_IS_ENABLED(BLK_ASYNC) && CONFIG_IS_ENABLED(DM_MMC)
+/* Start the next part of an asynchronous write, at most b_max blocks */
+static int mmc_bwrite_start(struct mmc *mmc, struct blk_req *req)
+{
+	struct mmc_data *data = &mmc->async_data;
+	lbaint_t left = req->blkcnt - req->xfered;
+	struct mmc_cmd cmd;
+
+	req->cur = min_t(lbaint_t, left, mmc->cfg->b_max);
+
+	mmc_write_cmd(mmc, &cmd, req->start + req->xfered, req->cur);
+	data->src = req->buffer + req->xfered * mmc->write_bl_len;
+	data->blocks = req->cur;
+	data->blocksize = mmc->write_bl_len;
+	data->flags = MMC_DATA_WRITE;
+	mmc->async_prg = false;
+
+	return mmc_send_cmd_async(mmc, &cmd, data);
+}
+
+int mmc_bwrite_submit(struct udevice *dev, struct blk_req *req)
+{
+	struct blk_desc *block_dev = dev_get_uclass_plat(dev);
+	struct mmc *mmc;
+	int ret;
+
+	mmc = find_mmc_device(block_dev->devnum);
+	if (!mmc)
+		return -ENODEV;
+	if (!req->blkcnt || mmc_host_is_spi(mmc))
+		return -ENOSYS;
+
+	ret = blk_dselect_hwpart(block_dev, block_dev->hwpart);
+	if (ret < 0)
+		return ret;
+
+	if (req->start + req->blkcnt > block_dev->lba)
+		return -EINVAL;
+
+	if (mmc_set_blocklen(mmc, mmc->write_bl_len))
+		return -EIO;
+
+	return mmc_bwrite_start(mmc, req);
+}
+
+/*
+ * Once the data is sent the card programs it, which can take a while. Check
+ * its state without waiting, so the caller can get on with other work.
+ */
+int mmc_bwrite_poll(struct udevice *dev, struct blk_req *req)
+{
+	struct blk_desc *block_dev = dev_get_uclass_plat(dev);
+	struct mmc *mmc = find_mmc_device(block_dev->devnum);
+	unsigned int status;
+	int ret;
+
+	if (!mmc->async_prg) {
+		ret = mmc_poll_data(mmc, &mmc->async_data);
+		if (ret == -EBUSY)
+			return ret;
+		if (ret) {
+			/* Take the card out of the data state, as on success */
+			if (req->cur > 1)
+				mmc_write_stop(mmc, true);
+			mmc_poll_for_busy(mmc, 1000);
+			return ret;
+		}
+
+		/* The card's busy time is covered by the status checks */
+		if (req->cur > 1 && mmc_write_stop(mmc, false))
+			return -EIO;
+
+		mmc->async_prg = true;
+		mmc->async_prg_start = get_timer(0);
+	}
+
+	ret = mmc_send_status(mmc, &status);
+	if (ret)
+		return ret;
+	if (status & MMC_STATUS_MASK) {
+		printf("Status Error: 0x%08x\n", status);
+		return -ECOMM;
+	}
+	if (!(status & MMC_STATUS_RDY_FOR_DATA) ||
+	    (status & MMC_STATUS_CURR_STATE) == MMC_STATE_PRG) {
+		if (get_timer(mmc->async_prg_start) > 1000) {
+			printf("Timeout waiting card ready\n");
+			return -ETIMEDOUT;
+		}
+		return -EBUSY;
+	}
+
+	req->xfered += req->cur;
+	if (req->xfered == req->blkcnt)
+		return 0;
+
+	ret = mmc_bwrite_start(mmc, req);
+
+	return ret ? ret : -EBUSY;
+}
+#endif
@@ -29,6 +29,7 @@ struct sandbox_mmc_priv {
 	char *buf;
 	int csize;	/* CSIZE value to report */
 	int size;
+	int busy_polls;	/* Polls left before an async transfer completes */
 };
 
 /**
@@ -79,6 +80,18 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 	}
 	case MMC_CMD_READ_SINGLE_BLOCK:
 	case MMC_CMD_READ_MULTIPLE_BLOCK:
+		if (data->flags & MMC_DATA_SG) {
+			const struct blk_sg *sg = data->sg;
+			char *src = &priv->buf[cmd->cmdarg * data->blocksize];
+			int i;
+
+			for (i = 0; i < data->sg_count; i++) {
+				memcpy(sg[i].buffer, src,
+				       sg[i].blkcnt * data->blocksize);
+				src += sg[i].blkcnt * data->blocksize;
+			}
+			break;
+		}
 		memcpy(data->dest, &priv->buf[cmd->cmdarg * data->blocksize],
 		       data->blocks * data->blocksize);
 		break;
@@ -133,10 +146,40 @@ static int sandbox_mmc_get_cd(struct udevice *dev)
 	return 1;
 }
 
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+/* The data is copied straight away but only reported after a few polls */
+static int sandbox_mmc_send_cmd_async(struct udevice *dev,
+				      struct mmc_cmd *cmd,
+				      struct mmc_data *data)
+{
+	struct sandbox_mmc_priv *priv = dev_get_priv(dev);
+
+	priv->busy_polls = 2;
+
+	return sandbox_mmc_send_cmd(dev, cmd, data);
+}
+
+static int sandbox_mmc_poll_data(struct udevice *dev, struct mmc_data *data)
+{
+	struct sandbox_mmc_priv *priv = dev_get_priv(dev);
+
+	if (priv->busy_polls) {
+		priv->busy_polls--;
+		return -EBUSY;
+	}
+
+	return 0;
+}
+#endif
+
 static const struct dm_mmc_ops sandbox_mmc_ops = {
 	.send_cmd = sandbox_mmc_send_cmd,
 	.set_ios = sandbox_mmc_set_ios,
 	.get_cd = sandbox_mmc_get_cd,
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	.send_cmd_async = sandbox_mmc_send_cmd_async,
+	.poll_data = sandbox_mmc_poll_data,
+#endif
 };
 
 static int sandbox_mmc_of_to_plat(struct udevice *dev)
@@ -212,6 +255,7 @@ static int sandbox_mmc_bind(struct udevice *dev)
 	cfg->f_min = 1000000;
 	cfg->f_max = 52000000;
 	cfg->b_max = U32_MAX;
+	cfg->max_segs = 4;
 
 	return mmc_bind(dev, &plat->mmc, cfg);
 }
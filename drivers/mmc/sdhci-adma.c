@@ -61,6 +61,43 @@ void sdhci_prepare_adma_table(struct sdhci_adma_desc *table,
 			  ARCH_DMA_MINALIGN));
 }
 
+/**
+ * sdhci_prepare_adma_table_segs() - Populate the ADMA table from segments
+ *
+ * @table:	Pointer to the ADMA table
+ * @seg:	Buffers to write to or read from, in transfer order
+ * @nsegs:	Number of entries in @seg
+ *
+ * Fill the ADMA table so that the transfer is spread over several buffers,
+ * e.g. the parts of a partially bounced buffer. Each segment must meet the
+ * ADMA address alignment requirement.
+ */
+void sdhci_prepare_adma_table_segs(struct sdhci_adma_desc *table,
+				   const struct bounce_segment *seg, int nsegs)
+{
+	struct sdhci_adma_desc *desc = table;
+	dma_addr_t addr;
+	size_t len, chunk;
+	int i;
+
+	for (i = 0; i < nsegs; i++) {
+		addr = (dma_addr_t)(ulong)seg[i].addr;
+		len = seg[i].len;
+		while (len) {
+			chunk = min_t(size_t, len, ADMA_MAX_LEN);
+			len -= chunk;
+			sdhci_adma_desc(desc, addr, chunk,
+					!len && i == nsegs - 1);
+			addr += chunk;
+			desc++;
+		}
+	}
+
+	flush_cache((dma_addr_t)table,
+		    ROUND((desc - table) * sizeof(struct sdhci_adma_desc),
+			  ARCH_DMA_MINALIGN));
+}
+
 /**
  * sdhci_adma_init() - initialize the ADMA descriptor table
  *
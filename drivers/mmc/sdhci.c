@@ -63,13 +63,124 @@ static void sdhci_transfer_pio(struct sdhci_host *host, struct mmc_data *data)
 	char *offs;
 	for (i = 0; i < data->blocksize; i += 4) {
 		offs = data->dest + i;
-		if (data->flags == MMC_DATA_READ)
+		if (data->flags & MMC_DATA_READ)
 			*(u32 *)offs = sdhci_readl(host, SDHCI_BUFFER);
 		else
 			sdhci_writel(host, *(u32 *)offs, SDHCI_BUFFER);
 	}
 }
 
+#if CONFIG_IS_ENABLED(MMC_SDHCI_ADMA) && defined(CONFIG_BOUNCE_BUFFER)
+/*
+ * The ADMA engine works from a descriptor list, so a buffer which is not
+ * cache-line aligned does not have to be copied as a whole: only its head and
+ * tail are bounced, the aligned middle is used for DMA directly.
+ */
+static bool sdhci_adma_bounce_start(struct sdhci_host *host,
+				    struct mmc_data *data, void *buf,
+				    int trans_bytes)
+{
+	struct bounce_segment seg[BOUNCE_BUFFER_MAX_SEGS];
+	unsigned int flags = GEN_BB_PARTIAL;
+	struct bounce_segment *bseg;
+	int i;
+
+	if (!(((ulong)buf | trans_bytes) & (ARCH_DMA_MINALIGN - 1)))
+		return false;
+
+	/*
+	 * Partial bouncing gives head and tail segments of any length, but
+	 * controllers may need each ADMA segment to be a multiple of 32 bits.
+	 * Bounce the whole buffer in that case.
+	 */
+	if (((ulong)buf | trans_bytes) & 3)
+		flags &= ~GEN_BB_PARTIAL;
+
+	if (data->flags & MMC_DATA_READ)
+		flags |= GEN_BB_WRITE;
+	else
+		flags |= GEN_BB_READ;
+
+	if (bounce_buffer_start(&host->bbstate, buf, trans_bytes, flags))
+		return false;
+	host->bb_active = true;
+
+	/* Bounced segments need the same mapping as any other DMA buffer */
+	for (i = 0; i < host->bbstate.nsegs; i++) {
+		bseg = &host->bbstate.seg[i];
+		seg[i].len = bseg->len;
+		seg[i].addr = (void *)(ulong)dma_map_single(bseg->addr,
+							     bseg->len,
+							     mmc_get_dma_dir(data));
+	}
+	sdhci_prepare_adma_table_segs(host->adma_desc_table, seg,
+				      host->bbstate.nsegs);
+
+	return true;
+}
+
+static bool sdhci_adma_bounce_stop(struct sdhci_host *host)
+{
+	struct bounce_buffer *state = &host->bbstate;
+	int i;
+
+	if (!host->bb_active)
+		return false;
+
+	for (i = 0; i < state->nsegs; i++)
+		dma_unmap_single((ulong)state->seg[i].addr, state->seg[i].len,
+				 state->flags & GEN_BB_WRITE ?
+				 DMA_FROM_DEVICE : DMA_TO_DEVICE);
+	bounce_buffer_stop(state);
+	host->bb_active = false;
+
+	return true;
+}
+#else
+static inline bool sdhci_adma_bounce_start(struct sdhci_host *host,
+					   struct mmc_data *data, void *buf,
+					   int trans_bytes)
+{
+	return false;
+}
+
+static inline bool sdhci_adma_bounce_stop(struct sdhci_host *host)
+{
+	return false;
+}
+#endif
+
+#if CONFIG_IS_ENABLED(MMC_SDHCI_ADMA)
+/* Describe each buffer of a scatter-gather transfer in the ADMA table */
+static void sdhci_adma_map_sg(struct sdhci_host *host, struct mmc_data *data)
+{
+	struct bounce_segment seg[SDHCI_ADMA_MAX_SEGS];
+	const struct blk_sg *sg = data->sg;
+	int i;
+
+	for (i = 0; i < data->sg_count; i++) {
+		seg[i].len = sg[i].blkcnt * data->blocksize;
+		seg[i].addr = (void *)(ulong)dma_map_single(sg[i].buffer,
+							     seg[i].len,
+							     mmc_get_dma_dir(data));
+	}
+
+	sdhci_prepare_adma_table_segs(host->adma_desc_table, seg,
+				      data->sg_count);
+}
+
+static void sdhci_adma_unmap_sg(struct mmc_data *data)
+{
+	const struct blk_sg *sg = data->sg;
+	int i;
+
+	for (i = 0; i < data->sg_count; i++)
+		dma_unmap_single((ulong)sg[i].buffer,
+				 sg[i].blkcnt * data->blocksize,
+				 mmc_get_dma_dir(data));
+}
+#endif
+
 #if (defined(CONFIG_MMC_SDHCI_SDMA) || CONFIG_IS_ENABLED(MMC_SDHCI_ADMA))
 static void sdhci_prepare_dma(struct sdhci_host *host, struct mmc_data *data,
 			      int *is_aligned, int trans_bytes)
@@ -78,7 +189,7 @@ static void sdhci_prepare_dma(struct sdhci_host *host, struct mmc_data *data,
 	unsigned char ctrl;
 	void *buf;
 
-	if (data->flags == MMC_DATA_READ)
+	if (data->flags & MMC_DATA_READ)
 		buf = data->dest;
 	else
 		buf = (void *)data->src;
@@ -96,22 +207,28 @@ static void sdhci_prepare_dma(struct sdhci_host *host, struct mmc_data *data,
 	     (host->quirks & SDHCI_QUIRK_32BIT_DMA_ADDR &&
 	      ((unsigned long)buf & 0x7) != 0x0))) {
 		*is_aligned = 0;
-		if (data->flags != MMC_DATA_READ)
+		if (!(data->flags & MMC_DATA_READ))
 			memcpy(host->align_buffer, buf, trans_bytes);
 		buf = host->align_buffer;
 	}
 
-	host->start_addr = dma_map_single(buf, trans_bytes,
-					  mmc_get_dma_dir(data));
-
 	if (host->flags & USE_SDMA) {
+		host->start_addr = dma_map_single(buf, trans_bytes,
+						  mmc_get_dma_dir(data));
 		dma_addr = dev_phys_to_bus(mmc_to_dev(host->mmc), host->start_addr);
 		sdhci_writel(host, dma_addr, SDHCI_DMA_ADDRESS);
 	}
 #if CONFIG_IS_ENABLED(MMC_SDHCI_ADMA)
 	else if (host->flags & (USE_ADMA | USE_ADMA64)) {
-		sdhci_prepare_adma_table(host->adma_desc_table, data,
-					 host->start_addr);
+		if (data->flags & MMC_DATA_SG) {
+			sdhci_adma_map_sg(host, data);
+		} else if (!sdhci_adma_bounce_start(host, data, buf,
+						    trans_bytes)) {
+			host->start_addr = dma_map_single(buf, trans_bytes,
+							  mmc_get_dma_dir(data));
+			sdhci_prepare_adma_table(host->adma_desc_table, data,
+						 host->start_addr);
+		}
 
 		sdhci_writel(host, lower_32_bits(host->adma_addr),
 			     SDHCI_ADMA_ADDRESS);
@@ -126,6 +243,23 @@ static void sdhci_prepare_dma(struct sdhci_host *host, struct mmc_data *data,
 			      int *is_aligned, int trans_bytes)
 {}
 #endif
+
+static void sdhci_unmap_dma(struct sdhci_host *host, struct mmc_data *data)
+{
+#if CONFIG_IS_ENABLED(MMC_SDHCI_ADMA)
+	if (data->flags & MMC_DATA_SG) {
+		sdhci_adma_unmap_sg(data);
+		return;
+	}
+#endif
+#if (defined(CONFIG_MMC_SDHCI_SDMA) || CONFIG_IS_ENABLED(MMC_SDHCI_ADMA))
+	if (!sdhci_adma_bounce_stop(host))
+		dma_unmap_single(host->start_addr,
+				 data->blocks * data->blocksize,
+				 mmc_get_dma_dir(data));
+#endif
+}
+
 static int sdhci_transfer_data(struct sdhci_host *host, struct mmc_data *data)
 {
 	dma_addr_t start_addr = host->start_addr;
@@ -177,10 +311,7 @@ static int sdhci_transfer_data(struct sdhci_host *host, struct mmc_data *data)
 		}
 	} while (!(stat & SDHCI_INT_DATA_END));
 
-#if (defined(CONFIG_MMC_SDHCI_SDMA) || CONFIG_IS_ENABLED(MMC_SDHCI_ADMA))
-	dma_unmap_single(host->start_addr, data->blocks * data->blocksize,
-			 mmc_get_dma_dir(data));
-#endif
+	sdhci_unmap_dma(host, data);
 
 	return 0;
 }
@@ -196,17 +327,44 @@ static int sdhci_transfer_data(struct sdhci_host *host, struct mmc_data *data)
 #define SDHCI_CMD_DEFAULT_TIMEOUT		100
 #define SDHCI_READ_STATUS_TIMEOUT		1000
 
-#ifdef CONFIG_DM_MMC
-static int sdhci_send_command(struct udevice *dev, struct mmc_cmd *cmd,
-			      struct mmc_data *data)
+#define SDHCI_ASYNC_DATA_TIMEOUT		10000
+
+static int sdhci_finish_command(struct sdhci_host *host, struct mmc_data *data,
+				int ret, int is_aligned, int trans_bytes)
 {
-	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	unsigned int stat;
 
-#else
-static int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
-			      struct mmc_data *data)
+	/* Release the bounce buffer if the transfer did not complete */
+	sdhci_adma_bounce_stop(host);
+
+	if (host->quirks & SDHCI_QUIRK_WAIT_SEND_CMD)
+		udelay(1000);
+
+	stat = sdhci_readl(host, SDHCI_INT_STATUS);
+	sdhci_writel(host, SDHCI_INT_ALL_MASK, SDHCI_INT_STATUS);
+	if (!ret) {
+		if ((host->quirks & SDHCI_QUIRK_32BIT_DMA_ADDR) &&
+				!is_aligned && (data->flags & MMC_DATA_READ))
+			memcpy(data->dest, host->align_buffer, trans_bytes);
+		return 0;
+	}
+
+	sdhci_reset(host, SDHCI_RESET_CMD);
+	sdhci_reset(host, SDHCI_RESET_DATA);
+	if (stat & SDHCI_INT_TIMEOUT)
+		return -ETIMEDOUT;
+	else
+		return -ECOMM;
+}
+
+/*
+ * Send @cmd and, unless @async is set, wait for its data phase to finish.
+ * With @async the DMA transfer is left running and must be completed by
+ * sdhci_poll_data().
+ */
+static int sdhci_issue_command(struct mmc *mmc, struct mmc_cmd *cmd,
+			       struct mmc_data *data, bool async)
 {
-#endif
 	struct sdhci_host *host = mmc->priv;
 	unsigned int stat = 0;
 	int ret = 0;
@@ -278,7 +436,7 @@ static int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
 		if (data->blocks > 1)
 			mode |= SDHCI_TRNS_MULTI;
 
-		if (data->flags == MMC_DATA_READ)
+		if (data->flags & MMC_DATA_READ)
 			mode |= SDHCI_TRNS_READ;
 
 		if (host->flags & USE_DMA) {
@@ -304,6 +462,7 @@ static int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
 			break;
 
 		if (get_timer(start) >= SDHCI_READ_STATUS_TIMEOUT) {
+			sdhci_adma_bounce_stop(host);
 			if (host->quirks & SDHCI_QUIRK_BROKEN_R1B) {
 				return 0;
 			} else {
@@ -320,28 +479,71 @@ static int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
 	} else
 		ret = -1;
 
-	if (!ret && data)
+	if (!ret && data) {
+		if (async) {
+			host->async_start = get_timer(0);
+			return 0;
+		}
 		ret = sdhci_transfer_data(host, data);
+	}
 
-	if (host->quirks & SDHCI_QUIRK_WAIT_SEND_CMD)
-		udelay(1000);
+	return sdhci_finish_command(host, data, ret, is_aligned, trans_bytes);
+}
+
+#ifdef CONFIG_DM_MMC
+static int sdhci_send_command(struct udevice *dev, struct mmc_cmd *cmd,
+			      struct mmc_data *data)
+{
+	return sdhci_issue_command(mmc_get_mmc_dev(dev), cmd, data, false);
+}
+
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+static int sdhci_send_cmd_async(struct udevice *dev, struct mmc_cmd *cmd,
+				struct mmc_data *data)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	struct sdhci_host *host = mmc->priv;
+
+	/* Only ADMA transfers complete without CPU involvement */
+	if (!data || !(host->flags & (USE_ADMA | USE_ADMA64)) ||
+	    (host->flags & USE_SDMA))
+		return -ENOSYS;
+
+	return sdhci_issue_command(mmc, cmd, data, true);
+}
+
+static int sdhci_poll_data(struct udevice *dev, struct mmc_data *data)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	struct sdhci_host *host = mmc->priv;
+	unsigned int stat;
+	int ret;
 
 	stat = sdhci_readl(host, SDHCI_INT_STATUS);
-	sdhci_writel(host, SDHCI_INT_ALL_MASK, SDHCI_INT_STATUS);
-	if (!ret) {
-		if ((host->quirks & SDHCI_QUIRK_32BIT_DMA_ADDR) &&
-				!is_aligned && (data->flags == MMC_DATA_READ))
-			memcpy(data->dest, host->align_buffer, trans_bytes);
-		return 0;
+	if (stat & SDHCI_INT_ERROR) {
+		pr_debug("%s: Error detected in status(0x%X)!\n",
+			 __func__, stat);
+		ret = -EIO;
+	} else if (stat & SDHCI_INT_DATA_END) {
+		sdhci_unmap_dma(host, data);
+		ret = 0;
+	} else if (get_timer(host->async_start) >= SDHCI_ASYNC_DATA_TIMEOUT) {
+		printf("%s: Transfer data timeout\n", __func__);
+		ret = -ETIMEDOUT;
+	} else {
+		return -EBUSY;
 	}
 
-	sdhci_reset(host, SDHCI_RESET_CMD);
-	sdhci_reset(host, SDHCI_RESET_DATA);
-	if (stat & SDHCI_INT_TIMEOUT)
-		return -ETIMEDOUT;
-	else
-		return -ECOMM;
+	return sdhci_finish_command(host, data, ret, 1, 0);
+}
+#endif
+#else
+static int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
+			      struct mmc_data *data)
+{
+	return sdhci_issue_command(mmc, cmd, data, false);
 }
+#endif
 
 #if defined(CONFIG_DM_MMC) && defined(MMC_SUPPORTS_TUNING)
 static int sdhci_execute_tuning(struct udevice *dev, uint opcode)
@@ -808,6 +1010,10 @@ const struct dm_mmc_ops sdhci_ops = {
 	.execute_tuning	= sdhci_execute_tuning,
 #endif
 	.wait_dat0	= sdhci_wait_dat0,
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	.send_cmd_async	= sdhci_send_cmd_async,
+	.poll_data	= sdhci_poll_data,
+#endif
 };
 #else
 static const struct mmc_ops sdhci_ops = {
@@ -966,6 +1172,10 @@ int sdhci_setup_cfg(struct mmc_config *cfg, struct sdhci_host *host,
 		cfg->host_caps |= host->host_caps;
 
 	cfg->b_max = CONFIG_SYS_MMC_MAX_BLK_COUNT;
+#if CONFIG_IS_ENABLED(MMC_SDHCI_ADMA)
+	if (!(host->flags & USE_SDMA))
+		cfg->max_segs = SDHCI_ADMA_MAX_SEGS;
+#endif
 
 	return 0;
 }
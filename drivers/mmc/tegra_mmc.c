@@ -351,7 +351,9 @@ static int tegra_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 		}
 		len = data->blocks * data->blocksize;
 
-		bounce_buffer_start(&bbstate, buf, len, bbflags);
+		ret = bounce_buffer_start(&bbstate, buf, len, bbflags);
+		if (ret)
+			return ret;
 	}
 
 	ret = tegra_mmc_send_cmd_bounced(dev, cmd, data, &bbstate);
@@ -23,6 +23,7 @@
 #include <asm/getopt.h>
 #include <asm/spi.h>
 #include <asm/state.h>
+#include <asm/test.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
 #include <dm/uclass-internal.h>
@@ -94,6 +95,9 @@ struct sandbox_spi_flash {
 	const struct flash_info *data;
 	/* The file on disk to serv up data from */
 	int fd;
+	/* Erases carried out, see sandbox_sf_get_erases() */
+	struct sandbox_sf_erase erases[SANDBOX_SF_MAX_ERASES];
+	int num_erases;
 };
 
 struct sandbox_spi_flash_plat_data {
@@ -111,6 +115,28 @@ void sandbox_sf_set_block_protect(struct udevice *dev, int bp_mask)
 	sbsf->status |= bp_mask << STAT_BP_SHIFT;
 }
 
+int sandbox_sf_get_erases(struct udevice *dev,
+			  const struct sandbox_sf_erase **erasesp)
+{
+	struct sandbox_spi_flash *sbsf = dev_get_priv(dev);
+	int num = sbsf->num_erases;
+
+	*erasesp = sbsf->erases;
+	sbsf->num_erases = 0;
+
+	return num;
+}
+
+static void sandbox_sf_log_erase(struct sandbox_spi_flash *sbsf, uint offset,
+				 uint size)
+{
+	if (sbsf->num_erases < SANDBOX_SF_MAX_ERASES) {
+		sbsf->erases[sbsf->num_erases].offset = offset;
+		sbsf->erases[sbsf->num_erases].size = size;
+	}
+	sbsf->num_erases++;
+}
+
 /**
  * This is a very strange probe function. If it has platform data (which may
  * have come from the device tree) then this function gets the filename and
@@ -230,6 +256,8 @@ static void sandbox_spi_tristate(u8 *buf, uint len)
 	memset(buf, 0xff, len);
 }
 
+int sandbox_erase_part(struct sandbox_spi_flash *sbsf, int size);
+
 /* Figure out what command this stream is telling us to do */
 static int sandbox_sf_process_cmd(struct sandbox_spi_flash *sbsf, const u8 *rx,
 				  u8 *tx)
@@ -270,15 +298,27 @@ static int sandbox_sf_process_cmd(struct sandbox_spi_flash *sbsf, const u8 *rx,
 		sbsf->state = SF_WRITE_STATUS;
 		break;
 	default: {
-		int flags = sbsf->data->flags;
-
 		/* we only support erase here */
 		if (sbsf->cmd == SPINOR_OP_CHIP_ERASE) {
 			sbsf->erase_size = sbsf->data->sector_size *
 				sbsf->data->n_sectors;
-		} else if (sbsf->cmd == SPINOR_OP_BE_4K && (flags & SECT_4K)) {
+			/* No address follows, so erase everything right now */
+			if (!(sbsf->status & STAT_WEL)) {
+				puts("sandbox_sf: write enable not set before erase\n");
+				return -EIO;
+			}
+			sbsf->status &= ~STAT_WEL;
+			if (os_lseek(sbsf->fd, 0, OS_SEEK_SET) < 0 ||
+			    sandbox_erase_part(sbsf, sbsf->erase_size))
+				return -EIO;
+			log_content(" chip erase, size: %u\n", sbsf->erase_size);
+			sandbox_sf_log_erase(sbsf, 0, sbsf->erase_size);
+			break;
+		} else if (sbsf->cmd == SPINOR_OP_BE_4K) {
 			sbsf->erase_size = 4 << 10;
-		} else if (sbsf->cmd == SPINOR_OP_SE && !(flags & SECT_4K)) {
+		} else if (sbsf->cmd == SPINOR_OP_BE_32K) {
+			sbsf->erase_size = 32 << 10;
+		} else if (sbsf->cmd == SPINOR_OP_SE) {
 			sbsf->erase_size = 64 << 10;
 		} else {
 			debug(" cmd unknown: %#x\n", sbsf->cmd);
@@ -484,6 +524,7 @@ static int sandbox_sf_xfer(struct udevice *dev, unsigned int bitlen,
 				log_content("sandbox_sf: Erase failed\n");
 				goto done;
 			}
+			sandbox_sf_log_erase(sbsf, sbsf->off, sbsf->erase_size);
 			goto done;
 		}
 		default:
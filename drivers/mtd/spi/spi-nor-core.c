@@ -44,6 +44,9 @@
 
 #define DEFAULT_READY_WAIT_JIFFIES		(40UL * HZ)
 
+/* Full-chip erase time, scaled by the number of 2 MiB in the flash */
+#define CHIP_ERASE_2MB_READY_WAIT_JIFFIES	(40UL * HZ)
+
 #define ROUND_UP_TO(x, y)	(((x) + (y) - 1) / (y) * (y))
 
 struct sfdp_parameter_header {
@@ -353,6 +356,9 @@ static ssize_t spi_nor_read_data(struct spi_nor *nor, loff_t from, size_t len,
 	size_t remaining = len;
 	int ret;
 
+	if (nor->dirmap.rdesc)
+		return spi_mem_dirmap_read(nor->dirmap.rdesc, from, len, buf);
+
 	spi_nor_setup_op(nor, &op, nor->read_proto);
 
 	/* convert the dummy cycles to the number of bytes */
@@ -781,6 +787,7 @@ static int spi_nor_wait_till_ready_with_timeout(struct spi_nor *nor,
 	timebase = get_timer(0);
 
 	while (get_timer(timebase) < timeout) {
+		WATCHDOG_RESET();
 		ret = spi_nor_ready(nor);
 		if (ret < 0)
 			return ret;
@@ -872,24 +879,52 @@ static int read_bar(struct spi_nor *nor, const struct flash_info *info)
 }
 #endif
 
+/*
+ * Pick the largest erase type which is aligned to @addr and does not go past
+ * the end of the range. Falls back to the regular sector erase, which is what
+ * an unaligned request has always used.
+ */
+static const struct spi_nor_erase_type *
+spi_nor_select_erase_type(struct spi_nor *nor, u32 addr, u32 len)
+{
+	const struct spi_nor_erase_type *erase;
+	int i;
+
+	for (i = 0; i < SNOR_ERASE_TYPE_MAX; i++) {
+		erase = &nor->erase_types[i];
+		if (erase->size && erase->size <= len && !(addr % erase->size))
+			return erase;
+	}
+
+	return NULL;
+}
+
 /*
  * Initiate the erasure of a single sector. Returns the number of bytes erased
  * on success, a negative error code on error.
  */
-static int spi_nor_erase_sector(struct spi_nor *nor, u32 addr)
+static int spi_nor_erase_sector(struct spi_nor *nor, u32 addr, u32 len)
 {
+	const struct spi_nor_erase_type *erase;
 	struct spi_mem_op op =
 		SPI_MEM_OP(SPI_MEM_OP_CMD(nor->erase_opcode, 0),
 			   SPI_MEM_OP_ADDR(nor->addr_width, addr, 0),
 			   SPI_MEM_OP_NO_DUMMY,
 			   SPI_MEM_OP_NO_DATA);
+	u32 erasesize = nor->mtd.erasesize;
 	int ret;
 
-	spi_nor_setup_op(nor, &op, nor->write_proto);
-
 	if (nor->erase)
 		return nor->erase(nor, addr);
 
+	erase = spi_nor_select_erase_type(nor, addr, len);
+	if (erase) {
+		op.cmd.opcode = erase->opcode;
+		erasesize = erase->size;
+	}
+
+	spi_nor_setup_op(nor, &op, nor->write_proto);
+
 	/*
 	 * Default implementation, if driver doesn't have a specialized HW
 	 * control
@@ -898,7 +933,43 @@ static int spi_nor_erase_sector(struct spi_nor *nor, u32 addr)
 	if (ret)
 		return ret;
 
-	return nor->mtd.erasesize;
+	return erasesize;
+}
+
+static bool spi_nor_can_erase_chip(struct spi_nor *nor, u32 addr, u32 len)
+{
+	if (addr || len != nor->mtd.size)
+		return false;
+
+	return !nor->erase && !(nor->flags & SNOR_F_NO_OP_CHIP_ERASE);
+}
+
+/* Erase the whole flash with a single command */
+static int spi_nor_erase_chip(struct spi_nor *nor)
+{
+	struct spi_mem_op op =
+		SPI_MEM_OP(SPI_MEM_OP_CMD(SPINOR_OP_CHIP_ERASE, 0),
+			   SPI_MEM_OP_NO_ADDR,
+			   SPI_MEM_OP_NO_DUMMY,
+			   SPI_MEM_OP_NO_DATA);
+	unsigned long timeout;
+	int ret;
+
+	dev_dbg(nor->dev, "chip erase, %lldKiB\n",
+		(long long)(nor->mtd.size >> 10));
+
+	spi_nor_setup_op(nor, &op, nor->write_proto);
+
+	ret = spi_mem_exec_op(nor->spi, &op);
+	if (ret)
+		return ret;
+
+	/* Scale the timeout linearly with the size of the flash */
+	timeout = max(CHIP_ERASE_2MB_READY_WAIT_JIFFIES,
+		      CHIP_ERASE_2MB_READY_WAIT_JIFFIES *
+		      (unsigned long)(nor->mtd.size / SZ_2M));
+
+	return spi_nor_wait_till_ready_with_timeout(nor, timeout);
 }
 
 /*
@@ -927,6 +998,18 @@ static int spi_nor_erase(struct mtd_info *mtd, struct erase_info *instr)
 	instr->state = MTD_ERASING;
 	addr_known = true;
 
+	if (spi_nor_can_erase_chip(nor, addr, len)) {
+		ret = write_enable(nor);
+		if (ret < 0)
+			goto erase_err;
+
+		ret = spi_nor_erase_chip(nor);
+		if (ret)
+			goto erase_err;
+
+		len = 0;
+	}
+
 	while (len) {
 		WATCHDOG_RESET();
 		if (ctrlc()) {
@@ -943,7 +1026,7 @@ static int spi_nor_erase(struct mtd_info *mtd, struct erase_info *instr)
 		if (ret < 0)
 			goto erase_err;
 
-		ret = spi_nor_erase_sector(nor, addr);
+		ret = spi_nor_erase_sector(nor, addr, len);
 		if (ret < 0)
 			goto erase_err;
 
@@ -2268,12 +2351,16 @@ static int spi_nor_parse_bfpt(struct spi_nor *nor,
 
 		erasesize = 1U << erasesize;
 		opcode = (half >> 8) & 0xff;
+		params->erase_types[i].size = erasesize;
+		params->erase_types[i].opcode = opcode;
 #ifdef CONFIG_SPI_FLASH_USE_4K_SECTORS
 		if (erasesize == SZ_4K) {
 			nor->erase_opcode = opcode;
 			mtd->erasesize = erasesize;
-			break;
+			continue;
 		}
+		if (mtd->erasesize == SZ_4K)
+			continue;
 #endif
 		if (!mtd->erasesize || mtd->erasesize < erasesize) {
 			nor->erase_opcode = opcode;
@@ -2552,6 +2639,12 @@ static int spi_nor_parse_sfdp(struct spi_nor *nor,
 		case SFDP_SECTOR_MAP_ID:
 			dev_info(nor->dev,
 				 "non-uniform erase sector maps are not supported yet.\n");
+			/*
+			 * The erase types may only be valid in some regions, so
+			 * stick to the one sector erase command everywhere.
+			 */
+			memset(params->erase_types, 0,
+			       sizeof(params->erase_types));
 			break;
 
 		case SFDP_SST_ID:
@@ -3658,6 +3751,11 @@ out:
 
 int spi_nor_remove(struct spi_nor *nor)
 {
+	if (nor->dirmap.rdesc) {
+		spi_mem_dirmap_destroy(nor->dirmap.rdesc);
+		nor->dirmap.rdesc = NULL;
+	}
+
 #ifdef CONFIG_SPI_FLASH_SOFT_RESET
 	if (nor->info->flags & SPI_NOR_OCTAL_DTR_READ &&
 	    nor->flags & SNOR_F_SOFT_RESET)
@@ -3698,6 +3796,134 @@ void spi_nor_set_fixups(struct spi_nor *nor)
 #endif
 }
 
+/*
+ * Return the variant of an erase opcode matching the command set of the
+ * sector erase, or 0 when the opcode has no such variant.
+ */
+static u8 spi_nor_erase_type_opcode(struct spi_nor *nor, u8 opcode)
+{
+#ifndef CONFIG_SPI_FLASH_BAR
+	u8 opcode_4b;
+
+	if (nor->erase_opcode != SPINOR_OP_BE_4K_4B &&
+	    nor->erase_opcode != SPINOR_OP_BE_32K_4B &&
+	    nor->erase_opcode != SPINOR_OP_SE_4B)
+		return opcode;
+
+	opcode_4b = spi_nor_convert_3to4_erase(opcode);
+
+	return opcode_4b != opcode ? opcode_4b : 0;
+#else
+	return opcode;
+#endif
+}
+
+static void spi_nor_add_erase_type(struct spi_nor *nor, u32 size, u8 opcode)
+{
+	struct spi_nor_erase_type *types = nor->erase_types;
+	int i, j;
+
+	if (!opcode)
+		return;
+
+	for (i = 0; i < SNOR_ERASE_TYPE_MAX; i++) {
+		if (types[i].size == size)
+			return;
+		if (types[i].size < size)
+			break;
+	}
+	if (i == SNOR_ERASE_TYPE_MAX)
+		return;
+
+	/* Keep the table sorted, largest first */
+	for (j = SNOR_ERASE_TYPE_MAX - 1; j > i; j--)
+		types[j] = types[j - 1];
+	types[i].size = size;
+	types[i].opcode = opcode;
+}
+
+/*
+ * Collect the erase types spi_nor_erase() may use. Requests are a multiple of
+ * the sector size, so only types at least that large are of interest. The
+ * larger ones come from the SFDP Erase Types, or from the sector size of the
+ * flash when 4K sectors are used without SFDP.
+ */
+static void spi_nor_init_erase_types(struct spi_nor *nor,
+				     const struct flash_info *info,
+				     const struct spi_nor_flash_parameter *params)
+{
+	const struct spi_nor_erase_type *erase;
+	bool from_sfdp = false;
+	int i;
+
+	memset(nor->erase_types, 0, sizeof(nor->erase_types));
+
+	/* Non-uniform layouts are handled by the driver's erase hook */
+	if (nor->erase || !nor->mtd.erasesize)
+		return;
+
+	spi_nor_add_erase_type(nor, nor->mtd.erasesize, nor->erase_opcode);
+
+	for (i = 0; i < SNOR_ERASE_TYPE_MAX; i++) {
+		erase = &params->erase_types[i];
+		if (!erase->size)
+			continue;
+
+		from_sfdp = true;
+		if (erase->size > nor->mtd.erasesize)
+			spi_nor_add_erase_type(nor, erase->size,
+					       spi_nor_erase_type_opcode(nor,
+							erase->opcode));
+	}
+
+	if (!from_sfdp && info->sector_size > nor->mtd.erasesize)
+		spi_nor_add_erase_type(nor, info->sector_size,
+				       spi_nor_erase_type_opcode(nor,
+								 SPINOR_OP_SE));
+}
+
+/*
+ * Set up a direct mapping of the whole flash for the read path, so that
+ * controllers exposing the flash through a memory window can serve reads
+ * from it instead of running one operation per chunk.
+ */
+static void spi_nor_create_read_dirmap(struct spi_nor *nor)
+{
+	struct spi_mem_dirmap_info info = {
+		.op_tmpl = SPI_MEM_OP(SPI_MEM_OP_CMD(nor->read_opcode, 0),
+				      SPI_MEM_OP_ADDR(nor->addr_width, 0, 0),
+				      SPI_MEM_OP_DUMMY(nor->read_dummy, 0),
+				      SPI_MEM_OP_DATA_IN(0, NULL, 0)),
+		.offset = 0,
+		.length = nor->mtd.size,
+	};
+	struct spi_mem_op *op = &info.op_tmpl;
+	struct spi_mem_dirmap_desc *desc;
+
+	/* Bank switching changes what the 3-byte addresses refer to */
+	if (IS_ENABLED(CONFIG_SPI_FLASH_BAR))
+		return;
+
+	spi_nor_setup_op(nor, op, nor->read_proto);
+
+	/* convert the dummy cycles to the number of bytes */
+	op->dummy.nbytes = (nor->read_dummy * op->dummy.buswidth) / 8;
+	if (spi_nor_protocol_is_dtr(nor->read_proto))
+		op->dummy.nbytes *= 2;
+
+	/* spi_nor_setup_op() skips the data phase of an empty template */
+	op->data.buswidth = spi_nor_get_protocol_data_nbits(nor->read_proto);
+
+	desc = spi_mem_dirmap_create(nor->spi, &info);
+	if (IS_ERR(desc)) {
+		/* Reads keep going through spi_mem_exec_op() */
+		dev_dbg(nor->dev, "no read dirmap: %ld\n", PTR_ERR(desc));
+		return;
+	}
+
+	nor->dirmap.rdesc = desc;
+}
+
 int spi_nor_scan(struct spi_nor *nor)
 {
 	struct spi_nor_flash_parameter params;
@@ -3864,11 +4090,15 @@ int spi_nor_scan(struct spi_nor *nor)
 		return -EINVAL;
 	}
 
+	spi_nor_init_erase_types(nor, info, &params);
+
 	/* Send all the required SPI flash commands to initialize device */
 	ret = spi_nor_init(nor);
 	if (ret)
 		return ret;
 
+	spi_nor_create_read_dirmap(nor);
+
 	nor->rdsr_dummy = params.rdsr_dummy;
 	nor->rdsr_addr_nbytes = params.rdsr_addr_nbytes;
 	nor->name = info->name;
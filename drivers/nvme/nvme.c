@@ -18,7 +18,7 @@
 #include <linux/compat.h>
 #include "nvme.h"
 
-#define NVME_Q_DEPTH		2
+#define NVME_Q_DEPTH		CONFIG_NVME_QUEUE_DEPTH
 #define NVME_AQ_DEPTH		2
 #define NVME_SQ_SIZE(depth)	(depth * sizeof(struct nvme_command))
 #define NVME_CQ_SIZE(depth)	(depth * sizeof(struct nvme_completion))
@@ -27,6 +27,10 @@
 #define ADMIN_TIMEOUT		60
 #define IO_TIMEOUT		30
 #define MAX_PRP_POOL		512
+#define NVME_SLOT_FREE		((lbaint_t)-1)
+/* PRP lists after those of the I/O queue slots */
+#define NVME_SG_SLOT(dev)	((dev)->q_depth - 1)
+#define NVME_ASYNC_SLOT(dev)	((dev)->q_depth)
 
 enum nvme_queue_id {
 	NVME_ADMIN_Q,
@@ -52,6 +56,9 @@ struct nvme_queue {
 	u16 qid;
 	u8 cq_phase;
 	u8 cqe_seen;
+	u16 busy;	/* commands submitted and not yet completed */
+	/* Command IDs which timed out and may still complete */
+	bool stale[NVME_Q_DEPTH + 1];
 	unsigned long cmdid_data[];
 };
 
@@ -73,12 +80,60 @@ static int nvme_wait_ready(struct nvme_dev *dev, bool enabled)
 	return -ETIME;
 }
 
-static int nvme_setup_prps(struct nvme_dev *dev, u64 *prp2,
+static int nvme_prp_pool_reserve(struct nvme_dev *dev, int nprps,
+				 u32 num_pages)
+{
+	u32 page_size = dev->page_size;
+
+	if (nprps <= dev->prp_entry_num)
+		return 0;
+
+	free(dev->prp_pool);
+	/*
+	 * Always increase in increments of pages.  It doesn't waste
+	 * much memory and reduces the number of allocations.
+	 */
+	dev->prp_pool = memalign(page_size, num_pages * page_size);
+	if (!dev->prp_pool) {
+		printf("Error: malloc prp_pool fail\n");
+		dev->prp_entry_num = 0;
+		return -ENOMEM;
+	}
+	dev->prp_entry_num = (page_size >> 3) * num_pages;
+
+	return 0;
+}
+
+/*
+ * Allocate one PRP list for each I/O command which can be in flight, plus one
+ * each for vectored and asynchronous reads, each large enough for the maximum
+ * transfer size
+ */
+static int nvme_prp_slots_init(struct nvme_dev *dev)
+{
+	u32 page_size = dev->page_size;
+	u32 prps_per_page = page_size >> 3;
+	u32 slots = NVME_ASYNC_SLOT(dev) + 1;
+	u32 nprps, num_pages;
+
+	/* An unaligned buffer touches one more page */
+	nprps = (1U << dev->max_transfer_shift) / page_size + 1;
+	/* The last entry of each list page points to the next one */
+	num_pages = DIV_ROUND_UP(nprps, prps_per_page - 1);
+	if (nvme_prp_pool_reserve(dev, slots * num_pages * prps_per_page,
+				  slots * num_pages))
+		return -ENOMEM;
+	dev->prp_slot_entries = num_pages * prps_per_page;
+
+	return 0;
+}
+
+static int nvme_setup_prps(struct nvme_dev *dev, int slot, u64 *prp2,
 			   int total_len, u64 dma_addr)
 {
 	u32 page_size = dev->page_size;
 	int offset = dma_addr & (page_size - 1);
-	u64 *prp_pool;
+	u64 *prp_list, *prp_pool;
 	int length = total_len;
 	int i, nprps;
 	u32 prps_per_page = page_size >> 3;
@@ -100,48 +155,43 @@ static int nvme_setup_prps(struct nvme_dev *dev, u64 *prp2,
 	}
 
 	nprps = DIV_ROUND_UP(length, page_size);
-	num_pages = DIV_ROUND_UP(nprps, prps_per_page);
-
-	if (nprps > dev->prp_entry_num) {
-		free(dev->prp_pool);
-		/*
-		 * Always increase in increments of pages.  It doesn't waste
-		 * much memory and reduces the number of allocations.
-		 */
-		dev->prp_pool = memalign(page_size, num_pages * page_size);
-		if (!dev->prp_pool) {
-			printf("Error: malloc prp_pool fail\n");
-			return -ENOMEM;
-		}
-		dev->prp_entry_num = prps_per_page * num_pages;
-	}
+	num_pages = DIV_ROUND_UP(nprps, prps_per_page - 1);
+	if (num_pages * prps_per_page > dev->prp_slot_entries)
+		return -EINVAL;
 
-	prp_pool = dev->prp_pool;
+	prp_list = dev->prp_pool + slot * dev->prp_slot_entries;
+	prp_pool = prp_list;
 	i = 0;
 	while (nprps) {
-		if (i == ((page_size >> 3) - 1)) {
-			*(prp_pool + i) = cpu_to_le64((ulong)prp_pool +
-					page_size);
+		if (i == prps_per_page - 1) {
+			*(prp_pool + i) = cpu_to_le64((ulong)(prp_pool +
+					prps_per_page));
 			i = 0;
-			prp_pool += page_size;
+			prp_pool += prps_per_page;
 		}
 		*(prp_pool + i++) = cpu_to_le64(dma_addr);
 		dma_addr += page_size;
 		nprps--;
 	}
-	*prp2 = (ulong)dev->prp_pool;
+	*prp2 = (ulong)prp_list;
 
-	flush_dcache_range((ulong)dev->prp_pool, (ulong)dev->prp_pool +
-			   dev->prp_entry_num * sizeof(u64));
+	flush_dcache_range((ulong)prp_list,
+			   (ulong)prp_list + num_pages * page_size);
 
 	return 0;
 }
 
-static __le16 nvme_get_cmd_id(void)
+/* Pick an ID for a command on the admin queue, avoiding timed-out ones */
+static u16 nvme_get_cmd_id(struct nvme_queue *nvmeq)
 {
-	static unsigned short cmdid;
+	u16 id;
+
+	for (id = 0; id < nvmeq->q_depth; id++) {
+		if (!nvmeq->stale[id])
+			return id;
+	}
 
-	return cpu_to_le16((cmdid < USHRT_MAX) ? cmdid++ : 0);
+	return 0;
 }
 
 static u16 nvme_read_completion_status(struct nvme_queue *nvmeq, u16 index)
@@ -178,50 +228,41 @@ static void nvme_submit_cmd(struct nvme_queue *nvmeq, struct nvme_command *cmd)
 		tail = 0;
 	writel(tail, nvmeq->q_db);
 	nvmeq->sq_tail = tail;
+	nvmeq->busy++;
 }
 
-static int nvme_submit_sync_cmd(struct nvme_queue *nvmeq,
-				struct nvme_command *cmd,
-				u32 *result, unsigned timeout)
+/* Check whether the submission queue has room for another command */
+static bool nvme_queue_full(struct nvme_queue *nvmeq)
+{
+	return nvmeq->busy >= nvmeq->q_depth - 1;
+}
+
+/*
+ * Check whether the command at the head of the completion queue has finished.
+ * Returns -EBUSY if it is still outstanding. @cmd_id, if not NULL, is set to
+ * the ID of the command which completed.
+ */
+static int nvme_poll_cmd(struct nvme_queue *nvmeq, u32 *result, u16 *cmd_id)
 {
 	u16 head = nvmeq->cq_head;
 	u16 phase = nvmeq->cq_phase;
 	u16 status;
-	ulong start_time;
-	ulong timeout_us = timeout * 100000;
+	int ret = 0;
 
-	cmd->common.command_id = nvme_get_cmd_id();
-	nvme_submit_cmd(nvmeq, cmd);
-
-	start_time = timer_get_us();
-
-	for (;;) {
-		status = nvme_read_completion_status(nvmeq, head);
-		if ((status & 0x01) == phase)
-			break;
-		if (timeout_us > 0 && (timer_get_us() - start_time)
-		    >= timeout_us)
-			return -ETIMEDOUT;
-	}
+	status = nvme_read_completion_status(nvmeq, head);
+	if ((status & 0x01) != phase)
+		return -EBUSY;
 
+	if (cmd_id)
+		*cmd_id = le16_to_cpu(readw(&nvmeq->cqes[head].command_id));
 	status >>= 1;
 	if (status) {
 		printf("ERROR: status = %x, phase = %d, head = %d\n",
 		       status, phase, head);
-		status = 0;
-		if (++head == nvmeq->q_depth) {
-			head = 0;
-			phase = !phase;
-		}
-		writel(head, nvmeq->q_db + nvmeq->dev->db_stride);
-		nvmeq->cq_head = head;
-		nvmeq->cq_phase = phase;
-
-		return -EIO;
-	}
-
-	if (result)
+		ret = -EIO;
+	} else if (result) {
 		*result = readl(&(nvmeq->cqes[head].result));
+	}
 
 	if (++head == nvmeq->q_depth) {
 		head = 0;
@@ -230,14 +271,97 @@ static int nvme_submit_sync_cmd(struct nvme_queue *nvmeq,
 	writel(head, nvmeq->q_db + nvmeq->dev->db_stride);
 	nvmeq->cq_head = head;
 	nvmeq->cq_phase = phase;
+	if (nvmeq->busy)
+		nvmeq->busy--;
+
+	return ret;
+}
+
+/*
+ * Check for a completion as nvme_poll_cmd() does, but retire late
+ * completions of commands which timed out instead of returning them
+ */
+static int nvme_poll_live(struct nvme_queue *nvmeq, u32 *result, u16 *cmd_id)
+{
+	u16 id;
+	int ret;
+
+	for (;;) {
+		ret = nvme_poll_cmd(nvmeq, result, &id);
+		if (ret == -EBUSY)
+			return ret;
+		if (id >= ARRAY_SIZE(nvmeq->stale) || !nvmeq->stale[id])
+			break;
+		debug("%s: retired timed-out command %u\n", __func__, id);
+		nvmeq->stale[id] = false;
+	}
+	*cmd_id = id;
+
+	return ret;
+}
+
+/* Wait for the next completion on @nvmeq */
+static int nvme_wait_cmd(struct nvme_queue *nvmeq, u32 *result, u16 *cmd_id,
+			 unsigned timeout)
+{
+	ulong start_time;
+	ulong timeout_us = timeout * 100000;
+	int ret;
+
+	start_time = timer_get_us();
 
-	return status;
+	for (;;) {
+		ret = nvme_poll_live(nvmeq, result, cmd_id);
+		if (ret != -EBUSY)
+			return ret;
+		if (timeout_us > 0 && (timer_get_us() - start_time)
+		    >= timeout_us)
+			return -ETIMEDOUT;
+	}
+}
+
+/*
+ * Send a command with ID @cmd_id and wait for it to complete. If it times
+ * out, the ID is kept in use until the command's completion turns up, since
+ * the controller may still be working on it.
+ */
+static int nvme_submit_sync_cmd(struct nvme_queue *nvmeq,
+				struct nvme_command *cmd, u16 cmd_id,
+				u32 *result, unsigned timeout)
+{
+	ulong start = timer_get_us();
+	u16 id;
+	int ret;
+
+	while (nvmeq->stale[cmd_id] || nvme_queue_full(nvmeq)) {
+		ret = nvme_poll_live(nvmeq, NULL, &id);
+		if (ret != -EBUSY)
+			printf("ERROR: unexpected command id %u\n", id);
+		else if (timer_get_us() - start >= timeout * 100000)
+			return -ETIMEDOUT;
+	}
+
+	cmd->common.command_id = cpu_to_le16(cmd_id);
+	nvme_submit_cmd(nvmeq, cmd);
+
+	for (;;) {
+		ret = nvme_wait_cmd(nvmeq, result, &id, timeout);
+		if (ret == -ETIMEDOUT) {
+			nvmeq->stale[cmd_id] = true;
+			return ret;
+		}
+		if (id == cmd_id)
+			return ret;
+		printf("ERROR: unexpected command id %u\n", id);
+	}
 }
 
 static int nvme_submit_admin_cmd(struct nvme_dev *dev, struct nvme_command *cmd,
 				 u32 *result)
 {
-	return nvme_submit_sync_cmd(dev->queues[NVME_ADMIN_Q], cmd,
+	struct nvme_queue *nvmeq = dev->queues[NVME_ADMIN_Q];
+
+	return nvme_submit_sync_cmd(nvmeq, cmd, nvme_get_cmd_id(nvmeq),
 				    result, ADMIN_TIMEOUT);
 }
 
@@ -344,6 +468,8 @@ static void nvme_init_queue(struct nvme_queue *nvmeq, u16 qid)
 	nvmeq->sq_tail = 0;
 	nvmeq->cq_head = 0;
 	nvmeq->cq_phase = 1;
+	nvmeq->busy = 0;
+	memset(nvmeq->stale, '\0', sizeof(nvmeq->stale));
 	nvmeq->q_db = &dev->dbs[qid * 2 * dev->db_stride];
 	memset((void *)nvmeq->cqes, 0, NVME_CQ_SIZE(nvmeq->q_depth));
 	flush_dcache_range((ulong)nvmeq->cqes,
@@ -634,7 +760,8 @@ static int nvme_get_info_from_identify(struct nvme_dev *dev)
 	memcpy(dev->model, ctrl->mn, sizeof(ctrl->mn));
 	memcpy(dev->firmware_rev, ctrl->fr, sizeof(ctrl->fr));
 	if (ctrl->mdts)
-		dev->max_transfer_shift = (ctrl->mdts + shift);
+		dev->max_transfer_shift = min(ctrl->mdts + shift,
+					      CONFIG_NVME_MAX_TRANSFER_SHIFT);
 	else {
 		/*
 		 * Maximum Data Transfer Size (MDTS) field indicates the maximum
@@ -644,17 +771,12 @@ static int nvme_get_info_from_identify(struct nvme_dev *dev)
 		 * and is reported as a power of two (2^n).
 		 *
 		 * The spec also says: a value of 0h indicates no restrictions
-		 * on transfer size. But in nvme_blk_read/write() below we have
-		 * the following algorithm for maximum number of logic blocks
-		 * per transfer:
-		 *
-		 * u16 lbas = 1 << (dev->max_transfer_shift - ns->lba_shift);
-		 *
-		 * In order for lbas not to overflow, the maximum number is 15
-		 * which means dev->max_transfer_shift = 15 + 9 (ns->lba_shift).
-		 * Let's use 20 which provides 1MB size.
+		 * on transfer size. But the number of logic blocks per command
+		 * is a 16-bit field, and each command in flight needs a PRP
+		 * list which covers the whole transfer, so the size is limited
+		 * by CONFIG_NVME_MAX_TRANSFER_SHIFT.
 		 */
-		dev->max_transfer_shift = 20;
+		dev->max_transfer_shift = CONFIG_NVME_MAX_TRANSFER_SHIFT;
 	}
 
 	free(ctrl);
@@ -732,65 +854,110 @@ static int nvme_blk_probe(struct udevice *udev)
 	return 0;
 }
 
+/*
+ * Split the transfer into commands of the maximum transfer size and keep as
+ * many of them in flight as the I/O queue allows. The command ID of each
+ * command is the index of the PRP list it uses. Slots whose command timed out
+ * are left alone until that command completes, since the controller may still
+ * read their PRP list.
+ */
 static ulong nvme_blk_rw(struct udevice *udev, lbaint_t blknr,
 			 lbaint_t blkcnt, void *buffer, bool read)
 {
 	struct nvme_ns *ns = dev_get_priv(udev);
 	struct nvme_dev *dev = ns->dev;
+	struct nvme_queue *nvmeq = dev->queues[NVME_IO_Q];
 	struct nvme_command c;
 	struct blk_desc *desc = dev_get_uclass_plat(udev);
-	int status;
+	struct nvme_io_stats *stats = read ? &dev->read_stats :
+					     &dev->write_stats;
+	lbaint_t slot_blk[NVME_Q_DEPTH - 1];
+	lbaint_t max_lbas = 1 << (dev->max_transfer_shift - ns->lba_shift);
+	lbaint_t next = 0, done = blkcnt, lbas;
+	int slots = dev->q_depth - 1;
+	int inflight = 0, slot, ret;
+	ulong start = timer_get_us();
+	ulong cmds = 0, addr;
+	u16 cmd_id;
 	u64 prp2;
-	u64 total_len = blkcnt << desc->log2blksz;
-	u64 temp_len = total_len;
-	uintptr_t temp_buffer = (uintptr_t)buffer;
-
-	u64 slba = blknr;
-	u16 lbas = 1 << (dev->max_transfer_shift - ns->lba_shift);
-	u64 total_lbas = blkcnt;
 
 	flush_dcache_range((unsigned long)buffer,
-			   (unsigned long)buffer + total_len);
+			   (unsigned long)buffer +
+			   (blkcnt << desc->log2blksz));
 
+	memset(&c, 0, sizeof(c));
 	c.rw.opcode = read ? nvme_cmd_read : nvme_cmd_write;
-	c.rw.flags = 0;
 	c.rw.nsid = cpu_to_le32(ns->ns_id);
-	c.rw.control = 0;
-	c.rw.dsmgmt = 0;
-	c.rw.reftag = 0;
-	c.rw.apptag = 0;
-	c.rw.appmask = 0;
-	c.rw.metadata = 0;
-
-	while (total_lbas) {
-		if (total_lbas < lbas) {
-			lbas = (u16)total_lbas;
-			total_lbas = 0;
-		} else {
-			total_lbas -= lbas;
+
+	for (slot = 0; slot < slots; slot++)
+		slot_blk[slot] = NVME_SLOT_FREE;
+
+	while (next < blkcnt || inflight) {
+		/* Fill the queue, unless a command failed */
+		while (next < blkcnt && !nvme_queue_full(nvmeq) &&
+		       done == blkcnt) {
+			for (slot = 0; slot < slots; slot++) {
+				if (slot_blk[slot] == NVME_SLOT_FREE &&
+				    !nvmeq->stale[slot])
+					break;
+			}
+			if (slot == slots) {
+				if (!inflight)
+					done = next;
+				break;
+			}
+			lbas = min(max_lbas, blkcnt - next);
+			addr = (ulong)buffer + (next << ns->lba_shift);
+			if (nvme_setup_prps(dev, slot, &prp2,
+					    lbas << ns->lba_shift, addr)) {
+				done = next;
+				break;
+			}
+			c.rw.command_id = cpu_to_le16(slot);
+			c.rw.slba = cpu_to_le64(blknr + next);
+			c.rw.length = cpu_to_le16(lbas - 1);
+			c.rw.prp1 = cpu_to_le64(addr);
+			c.rw.prp2 = cpu_to_le64(prp2);
+			nvme_submit_cmd(nvmeq, &c);
+			slot_blk[slot] = next;
+			next += lbas;
+			inflight++;
+			cmds++;
 		}
+		if (!inflight)
+			break;
 
-		if (nvme_setup_prps(dev, &prp2,
-				    lbas << ns->lba_shift, temp_buffer))
-			return -EIO;
-		c.rw.slba = cpu_to_le64(slba);
-		slba += lbas;
-		c.rw.length = cpu_to_le16(lbas - 1);
-		c.rw.prp1 = cpu_to_le64(temp_buffer);
-		c.rw.prp2 = cpu_to_le64(prp2);
-		status = nvme_submit_sync_cmd(dev->queues[NVME_IO_Q],
-				&c, NULL, IO_TIMEOUT);
-		if (status)
+		ret = nvme_wait_cmd(nvmeq, NULL, &cmd_id, IO_TIMEOUT);
+		if (ret == -ETIMEDOUT) {
+			/* Nothing from the oldest command onwards is known */
+			for (slot = 0; slot < slots; slot++) {
+				if (slot_blk[slot] != NVME_SLOT_FREE) {
+					done = min(done, slot_blk[slot]);
+					nvmeq->stale[slot] = true;
+				}
+			}
 			break;
-		temp_len -= (u32)lbas << ns->lba_shift;
-		temp_buffer += lbas << ns->lba_shift;
+		}
+		if (cmd_id >= slots || slot_blk[cmd_id] == NVME_SLOT_FREE) {
+			printf("ERROR: unexpected command id %u\n", cmd_id);
+			continue;
+		}
+		if (ret)
+			done = min(done, slot_blk[cmd_id]);
+		slot_blk[cmd_id] = NVME_SLOT_FREE;
+		inflight--;
 	}
 
 	if (read)
 		invalidate_dcache_range((unsigned long)buffer,
-					(unsigned long)buffer + total_len);
+					(unsigned long)buffer +
+					(blkcnt << desc->log2blksz));
 
-	return (total_len - temp_len) >> desc->log2blksz;
+	stats->cmds += cmds;
+	stats->bytes += (u64)done << desc->log2blksz;
+	stats->time_us += timer_get_us() - start;
+
+	return done;
 }
 
 static ulong nvme_blk_read(struct udevice *udev, lbaint_t blknr,
@@ -799,6 +966,249 @@ static ulong nvme_blk_read(struct udevice *udev, lbaint_t blknr,
 	return nvme_blk_rw(udev, blknr, blkcnt, buffer, true);
 }
 
+/* First page of @sg[i] which is not covered by PRP1 */
+static ulong nvme_sg_first_page(const struct blk_sg *sg, int i, u32 page_size)
+{
+	return i ? (ulong)sg[i].buffer :
+		   ALIGN((ulong)sg[0].buffer + 1, page_size);
+}
+
+/*
+ * Describe a run of buffers with one PRP list. Every buffer but the first
+ * must start on a page boundary and every buffer but the last must end on
+ * one, so that the list only holds whole pages.
+ */
+static int nvme_setup_prps_sg(struct nvme_ns *ns, u64 *prp2,
+			      const struct blk_sg *sg, int count)
+{
+	struct nvme_dev *dev = ns->dev;
+	u32 page_size = dev->page_size;
+	u32 prps_per_page = page_size >> 3;
+	u32 num_pages;
+	u64 *prp_list, *prp_pool;
+	ulong addr, end;
+	int i, nprps = 0, left;
+
+	for (i = 0; i < count; i++) {
+		addr = nvme_sg_first_page(sg, i, page_size);
+		end = (ulong)sg[i].buffer + (sg[i].blkcnt << ns->lba_shift);
+		if (end > addr)
+			nprps += DIV_ROUND_UP(end - addr, page_size);
+	}
+
+	if (nprps == 1) {
+		/* Only the second buffer's single page is left */
+		*prp2 = nvme_sg_first_page(sg, count - 1, page_size);
+		return 0;
+	}
+
+	/* The last entry of each list page points to the next one */
+	num_pages = DIV_ROUND_UP(nprps, prps_per_page - 1);
+	if (num_pages * prps_per_page > dev->prp_slot_entries)
+		return -EINVAL;
+
+	prp_list = dev->prp_pool + NVME_SG_SLOT(dev) * dev->prp_slot_entries;
+	prp_pool = prp_list;
+	left = nprps;
+	nprps = 0;
+	for (i = 0; i < count; i++) {
+		end = (ulong)sg[i].buffer + (sg[i].blkcnt << ns->lba_shift);
+		for (addr = nvme_sg_first_page(sg, i, page_size); addr < end;
+		     addr += page_size) {
+			if (nprps == prps_per_page - 1 && left > 1) {
+				prp_pool[nprps] = cpu_to_le64((ulong)(prp_pool +
+							prps_per_page));
+				prp_pool += prps_per_page;
+				nprps = 0;
+			}
+			prp_pool[nprps++] = cpu_to_le64(addr);
+			left--;
+		}
+	}
+	*prp2 = (ulong)prp_list;
+
+	flush_dcache_range((ulong)prp_list,
+			   (ulong)prp_list + num_pages * page_size);
+
+	return 0;
+}
+
+/* Count the segments from @sg which one read command can transfer */
+static int nvme_sg_group(struct nvme_ns *ns, const struct blk_sg *sg,
+			 int count, lbaint_t *blkcnt)
+{
+	struct nvme_dev *dev = ns->dev;
+	ulong page_mask = dev->page_size - 1;
+	lbaint_t max = 1 << (dev->max_transfer_shift - ns->lba_shift);
+	lbaint_t cnt = sg[0].blkcnt;
+	int n = 1;
+
+	while (n < count &&
+	       sg[n].start == sg[n - 1].start + sg[n - 1].blkcnt &&
+	       !(((ulong)sg[n - 1].buffer +
+		  (sg[n - 1].blkcnt << ns->lba_shift)) & page_mask) &&
+	       !((ulong)sg[n].buffer & page_mask) &&
+	       cnt + sg[n].blkcnt <= max) {
+		cnt += sg[n].blkcnt;
+		n++;
+	}
+	*blkcnt = cnt;
+
+	return n;
+}
+
+static ulong nvme_blk_read_sg(struct udevice *udev, const struct blk_sg *sg,
+			      int count)
+{
+	struct nvme_ns *ns = dev_get_priv(udev);
+	struct nvme_dev *dev = ns->dev;
+	struct nvme_io_stats *stats = &dev->read_stats;
+	struct nvme_command c;
+	lbaint_t cnt, total = 0;
+	ulong ret, start;
+	u64 prp2;
+	int i, j, n, status;
+
+	memset(&c, 0, sizeof(c));
+	c.rw.opcode = nvme_cmd_read;
+	c.rw.nsid = cpu_to_le32(ns->ns_id);
+
+	for (i = 0; i < count; i += n) {
+		n = nvme_sg_group(ns, &sg[i], count - i, &cnt);
+		if (n == 1) {
+			ret = nvme_blk_rw(udev, sg[i].start, sg[i].blkcnt,
+					  sg[i].buffer, true);
+			total += ret;
+			if (ret != sg[i].blkcnt)
+				break;
+			continue;
+		}
+
+		if (nvme_setup_prps_sg(ns, &prp2, &sg[i], n))
+			break;
+		for (j = i; j < i + n; j++)
+			flush_dcache_range((ulong)sg[j].buffer,
+					   (ulong)sg[j].buffer +
+					   (sg[j].blkcnt << ns->lba_shift));
+
+		c.rw.slba = cpu_to_le64(sg[i].start);
+		c.rw.length = cpu_to_le16(cnt - 1);
+		c.rw.prp1 = cpu_to_le64((ulong)sg[i].buffer);
+		c.rw.prp2 = cpu_to_le64(prp2);
+		start = timer_get_us();
+		status = nvme_submit_sync_cmd(dev->queues[NVME_IO_Q], &c,
+					      NVME_SG_SLOT(dev), NULL,
+					      IO_TIMEOUT);
+		stats->cmds++;
+		stats->time_us += timer_get_us() - start;
+
+		for (j = i; j < i + n; j++)
+			invalidate_dcache_range((ulong)sg[j].buffer,
+						(ulong)sg[j].buffer +
+						(sg[j].blkcnt << ns->lba_shift));
+		if (status)
+			break;
+		stats->bytes += (u64)cnt << ns->lba_shift;
+		total += cnt;
+	}
+
+	return total;
+}
+
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+/* Queue the next chunk of @req, limited by the maximum transfer size */
+static int nvme_blk_start(struct nvme_ns *ns, struct blk_req *req)
+{
+	struct nvme_dev *dev = ns->dev;
+	struct nvme_queue *nvmeq = dev->queues[NVME_IO_Q];
+	struct nvme_command c;
+	lbaint_t lbas = 1 << (dev->max_transfer_shift - ns->lba_shift);
+	ulong buffer = (ulong)req->buffer + (req->xfered << ns->lba_shift);
+	u64 prp2;
+
+	/* The slot's last command timed out and may still be running */
+	if (nvmeq->stale[NVME_ASYNC_SLOT(dev)] || nvme_queue_full(nvmeq))
+		return -EAGAIN;
+
+	lbas = min(lbas, req->blkcnt - req->xfered);
+	if (nvme_setup_prps(dev, NVME_ASYNC_SLOT(dev), &prp2,
+			    lbas << ns->lba_shift, buffer))
+		return -EIO;
+
+	memset(&c, 0, sizeof(c));
+	c.rw.opcode = nvme_cmd_read;
+	c.rw.nsid = cpu_to_le32(ns->ns_id);
+	c.rw.slba = cpu_to_le64(req->start + req->xfered);
+	c.rw.length = cpu_to_le16(lbas - 1);
+	c.rw.prp1 = cpu_to_le64(buffer);
+	c.rw.prp2 = cpu_to_le64(prp2);
+	c.common.command_id = cpu_to_le16(NVME_ASYNC_SLOT(dev));
+	nvme_submit_cmd(nvmeq, &c);
+	req->cur = lbas;
+	ns->async_start = timer_get_us();
+	dev->read_stats.cmds++;
+
+	return 0;
+}
+
+static void nvme_blk_req_done(struct nvme_ns *ns, struct blk_req *req)
+{
+	ulong buffer = (ulong)req->buffer;
+
+	invalidate_dcache_range(buffer,
+				buffer + (req->blkcnt << ns->lba_shift));
+}
+
+static int nvme_blk_submit(struct udevice *udev, struct blk_req *req)
+{
+	struct nvme_ns *ns = dev_get_priv(udev);
+	ulong buffer = (ulong)req->buffer;
+	int ret;
+
+	flush_dcache_range(buffer, buffer + (req->blkcnt << ns->lba_shift));
+
+	ret = nvme_blk_start(ns, req);
+
+	/* Fall back to a synchronous read if the slot is not free */
+	return ret == -EAGAIN ? -ENOSYS : ret;
+}
+
+static int nvme_blk_poll(struct udevice *udev, struct blk_req *req)
+{
+	struct nvme_ns *ns = dev_get_priv(udev);
+	struct nvme_dev *dev = ns->dev;
+	struct nvme_queue *nvmeq = dev->queues[NVME_IO_Q];
+	struct nvme_io_stats *stats = &dev->read_stats;
+	u16 cmd_id;
+	int ret;
+
+	ret = nvme_poll_live(nvmeq, NULL, &cmd_id);
+	if (ret != -EBUSY && cmd_id != NVME_ASYNC_SLOT(dev)) {
+		printf("ERROR: unexpected command id %u\n", cmd_id);
+		ret = -EBUSY;
+	}
+	if (ret == -EBUSY) {
+		if (timer_get_us() - ns->async_start < IO_TIMEOUT * 100000)
+			return -EBUSY;
+		nvmeq->stale[NVME_ASYNC_SLOT(dev)] = true;
+		ret = -ETIMEDOUT;
+	}
+	stats->time_us += timer_get_us() - ns->async_start;
+	if (!ret) {
+		stats->bytes += (u64)req->cur << ns->lba_shift;
+		req->xfered += req->cur;
+		if (req->xfered < req->blkcnt) {
+			ret = nvme_blk_start(ns, req);
+			if (!ret)
+				return -EBUSY;
+		}
+	}
+	nvme_blk_req_done(ns, req);
+
+	return ret;
+}
+#endif
+
 static ulong nvme_blk_write(struct udevice *udev, lbaint_t blknr,
 			    lbaint_t blkcnt, const void *buffer)
 {
@@ -807,7 +1217,12 @@ static ulong nvme_blk_write(struct udevice *udev, lbaint_t blknr,
 
 static const struct blk_ops nvme_blk_ops = {
 	.read	= nvme_blk_read,
+	.read_sg	= nvme_blk_read_sg,
 	.write	= nvme_blk_write,
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	.submit_read	= nvme_blk_submit,
+	.poll	= nvme_blk_poll,
+#endif
 };
 
 U_BOOT_DRIVER(nvme_blk) = {
@@ -870,6 +1285,7 @@ static int nvme_probe(struct udevice *udev)
 		goto free_nvme;
 	}
 	ndev->prp_entry_num = MAX_PRP_POOL >> 3;
+	ndev->prp_slot_entries = ndev->prp_entry_num;
 
 	ret = nvme_setup_io_queues(ndev);
 	if (ret)
@@ -877,6 +1293,12 @@ static int nvme_probe(struct udevice *udev)
 
 	nvme_get_info_from_identify(ndev);
 
+	ret = nvme_prp_slots_init(ndev);
+	if (ret) {
+		printf("Error: %s: Out of memory!\n", udev->name);
+		goto free_queue;
+	}
+
 	/* Create a blk device for each namespace */
 
 	id = memalign(ndev->page_size, sizeof(struct nvme_id_ns));
@@ -8,6 +8,7 @@
 #define __DRIVER_NVME_H__
 
 #include <asm/io.h>
+#include <nvme.h>
 
 struct nvme_id_power_state {
 	__le16			max_power;	/* centiwatts */
@@ -618,7 +619,10 @@ struct nvme_dev {
 	u8 vwc;
 	u64 *prp_pool;
 	u32 prp_entry_num;
+	u32 prp_slot_entries;	/* PRP entries for each command in flight */
 	u32 nn;
+	struct nvme_io_stats read_stats;
+	struct nvme_io_stats write_stats;
 };
 
 /*
@@ -633,6 +637,7 @@ struct nvme_ns {
 	int devnum;
 	int lba_shift;
 	u8 flbas;
+	ulong async_start;	/* Start time of the async read in flight */
 };
 
 #endif /* __DRIVER_NVME_H__ */
@@ -9,6 +9,7 @@
 #include <errno.h>
 #include <memalign.h>
 #include <nvme.h>
+#include <linux/math64.h>
 #include "nvme.h"
 
 static void print_optional_admin_cmd(u16 oacs, int devnum)
@@ -144,3 +145,34 @@ free_ctrl:
 	free(ctrl);
 	return ret;
 }
+
+static void print_io_stats(const char *name, struct nvme_io_stats *stats)
+{
+	printf("%-6s %llu commands, ", name, stats->cmds);
+	print_size(stats->bytes, "");
+	printf(" in %llu ms", div_u64(stats->time_us, 1000));
+	if (stats->time_us) {
+		printf(": %llu IOPS, ",
+		       div64_u64(stats->cmds * 1000000, stats->time_us));
+		print_size(div64_u64(stats->bytes * 1000000, stats->time_us),
+			   "/s");
+	}
+	puts("\n");
+}
+
+int nvme_print_stats(struct udevice *udev, bool reset)
+{
+	struct nvme_ns *ns = dev_get_priv(udev);
+	struct nvme_dev *dev = ns->dev;
+
+	printf("Queue depth %d, max transfer ", dev->q_depth);
+	print_size(1ULL << dev->max_transfer_shift, "\n");
+	print_io_stats("read:", &dev->read_stats);
+	print_io_stats("write:", &dev->write_stats);
+	if (reset) {
+		memset(&dev->read_stats, '\0', sizeof(dev->read_stats));
+		memset(&dev->write_stats, '\0', sizeof(dev->write_stats));
+	}
+
+	return 0;
+}
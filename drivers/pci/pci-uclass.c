@@ -1898,15 +1898,16 @@ U_BOOT_DRIVER(pci_generic_drv) = {
 int pci_init(void)
 {
 	struct udevice *bus;
+	struct uclass *uc;
 
 	/*
 	 * Enumerate all known controller devices. Enumeration has the side-
 	 * effect of probing them, so PCIe devices will be enumerated too.
+	 * Controllers not needed to boot are left until they are used.
 	 */
-	for (uclass_first_device_check(UCLASS_PCI, &bus);
-	     bus;
-	     uclass_next_device_check(&bus)) {
-		;
+	uclass_id_foreach_dev(UCLASS_PCI, bus, uc) {
+		if (!device_probe_deferred(bus))
+			device_probe(bus);
 	}
 
 	return 0;
@@ -320,6 +320,57 @@ static bool cadence_spi_mem_supports_op(struct spi_slave *slave,
 		return spi_mem_default_supports_op(slave, op);
 }
 
+static int cadence_spi_mem_dirmap_create(struct spi_mem_dirmap_desc *desc)
+{
+	struct udevice *bus = desc->slave->dev->parent;
+	struct cadence_spi_plat *plat = dev_get_plat(bus);
+
+	/* Only reads are served from the memory window */
+	if (!plat->use_dac_mode ||
+	    desc->info.op_tmpl.data.dir != SPI_MEM_DATA_IN)
+		return -EOPNOTSUPP;
+
+	if (!cadence_spi_mem_supports_op(desc->slave, &desc->info.op_tmpl))
+		return -EOPNOTSUPP;
+
+	return 0;
+}
+
+static ssize_t cadence_spi_mem_dirmap_read(struct spi_mem_dirmap_desc *desc,
+					   u64 offs, size_t len, void *buf)
+{
+	struct udevice *bus = desc->slave->dev->parent;
+	struct cadence_spi_plat *plat = dev_get_plat(bus);
+	struct cadence_spi_priv *priv = dev_get_priv(bus);
+	struct spi_mem_op op = desc->info.op_tmpl;
+	u64 from = desc->info.offset + offs;
+	int err;
+
+	/*
+	 * Stop at the end of the AHB window so that everything below it is
+	 * copied straight from the window; the rest is read indirectly.
+	 */
+	if (from < plat->ahbsize)
+		len = min_t(u64, len, plat->ahbsize - from);
+	len = min_t(size_t, len, UINT_MAX);
+
+	op.addr.val = from;
+	op.data.nbytes = len;
+	op.data.buf.in = buf;
+
+	cadence_qspi_apb_chipselect(priv->regbase,
+				    spi_chip_select(desc->slave->dev),
+				    plat->is_decoded_cs);
+
+	err = cadence_qspi_apb_read_setup(plat, &op);
+	if (!err)
+		err = cadence_qspi_apb_read_execute(plat, &op);
+	if (err)
+		return err;
+
+	return len;
+}
+
 static int cadence_spi_of_to_plat(struct udevice *bus)
 {
 	struct cadence_spi_plat *plat = dev_get_plat(bus);
@@ -377,6 +428,8 @@ static int cadence_spi_of_to_plat(struct udevice *bus)
 static const struct spi_controller_mem_ops cadence_spi_mem_ops = {
 	.exec_op = cadence_spi_mem_exec_op,
 	.supports_op = cadence_spi_mem_supports_op,
+	.dirmap_create = cadence_spi_mem_dirmap_create,
+	.dirmap_read = cadence_spi_mem_dirmap_read,
 };
 
 static const struct dm_spi_ops cadence_spi_ops = {
@@ -882,7 +882,7 @@ int cadence_qspi_apb_read_execute(struct cadence_spi_plat *plat,
 	void *buf = op->data.buf.in;
 	size_t len = op->data.nbytes;
 
-	if (plat->use_dac_mode && (from + len < plat->ahbsize)) {
+	if (plat->use_dac_mode && (from + len <= plat->ahbsize)) {
 		if (len < 256 ||
 		    dma_memcpy(buf, plat->ahbbase + from, len) < 0) {
 			memcpy_fromio(buf, plat->ahbbase + from, len);
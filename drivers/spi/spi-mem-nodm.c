@@ -7,6 +7,7 @@
 #include <malloc.h>
 #include <spi.h>
 #include <spi-mem.h>
+#include <linux/err.h>
 
 int spi_mem_exec_op(struct spi_slave *slave,
 		    const struct spi_mem_op *op)
@@ -169,3 +170,77 @@ bool spi_mem_supports_op(struct spi_slave *slave, const struct spi_mem_op *op)
 
 	return true;
 }
+
+/*
+ * Without driver model there are no controller hooks, so a direct mapping
+ * always falls back to issuing regular operations.
+ */
+struct spi_mem_dirmap_desc *
+spi_mem_dirmap_create(struct spi_slave *slave,
+		      const struct spi_mem_dirmap_info *info)
+{
+	struct spi_mem_dirmap_desc *desc;
+
+	if (!info->op_tmpl.addr.nbytes || info->op_tmpl.addr.nbytes > 8 ||
+	    info->op_tmpl.data.dir == SPI_MEM_NO_DATA)
+		return ERR_PTR(-EINVAL);
+
+	if (!spi_mem_supports_op(slave, &info->op_tmpl))
+		return ERR_PTR(-EOPNOTSUPP);
+
+	desc = calloc(1, sizeof(*desc));
+	if (!desc)
+		return ERR_PTR(-ENOMEM);
+
+	desc->slave = slave;
+	desc->info = *info;
+	desc->nodirmap = true;
+
+	return desc;
+}
+
+void spi_mem_dirmap_destroy(struct spi_mem_dirmap_desc *desc)
+{
+	free(desc);
+}
+
+static ssize_t spi_mem_no_dirmap_xfer(struct spi_mem_dirmap_desc *desc,
+				      u64 offs, size_t len, void *buf)
+{
+	struct spi_mem_op op = desc->info.op_tmpl;
+	int ret;
+
+	if (!len)
+		return 0;
+
+	op.addr.val = desc->info.offset + offs;
+	op.data.buf.in = buf;
+	op.data.nbytes = len;
+	ret = spi_mem_adjust_op_size(desc->slave, &op);
+	if (ret)
+		return ret;
+
+	ret = spi_mem_exec_op(desc->slave, &op);
+	if (ret)
+		return ret;
+
+	return op.data.nbytes;
+}
+
+ssize_t spi_mem_dirmap_read(struct spi_mem_dirmap_desc *desc,
+			    u64 offs, size_t len, void *buf)
+{
+	if (desc->info.op_tmpl.data.dir != SPI_MEM_DATA_IN)
+		return -EINVAL;
+
+	return spi_mem_no_dirmap_xfer(desc, offs, len, buf);
+}
+
+ssize_t spi_mem_dirmap_write(struct spi_mem_dirmap_desc *desc,
+			     u64 offs, size_t len, const void *buf)
+{
+	if (desc->info.op_tmpl.data.dir != SPI_MEM_DATA_OUT)
+		return -EINVAL;
+
+	return spi_mem_no_dirmap_xfer(desc, offs, len, (void *)buf);
+}
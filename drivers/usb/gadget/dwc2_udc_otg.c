@@ -24,6 +24,7 @@
 #include <log.h>
 #include <malloc.h>
 #include <reset.h>
+#include <wait_bit.h>
 #include <dm/device_compat.h>
 #include <dm/devres.h>
 #include <linux/bug.h>
@@ -738,7 +739,7 @@ static void dwc2_free_request(struct usb_ep *ep, struct usb_request *_req)
 static int dwc2_dequeue(struct usb_ep *_ep, struct usb_request *_req)
 {
 	struct dwc2_ep *ep;
-	struct dwc2_request *req;
+	struct dwc2_request *req, *next;
 	unsigned long flags = 0;
 
 	debug("%s: %p\n", __func__, _ep);
@@ -759,6 +760,23 @@ static int dwc2_dequeue(struct usb_ep *_ep, struct usb_request *_req)
 		return -EINVAL;
 	}
 
+	/*
+	 * The request at the head of the queue may already be armed, so its
+	 * DMA must be stopped before the buffer goes back to the gadget. The
+	 * next request is started as complete_rx() would do.
+	 */
+	if (req->queue.prev == &ep->queue) {
+		dwc2_udc_ep_abort(ep);
+		if (!list_is_last(&req->queue, &ep->queue)) {
+			next = list_entry(req->queue.next, struct dwc2_request,
+					  queue);
+			if (ep_is_in(ep))
+				setdma_tx(ep, next);
+			else
+				setdma_rx(ep, next);
+		}
+	}
+
 	done(ep, req, -ECONNRESET);
 
 	spin_unlock_irqrestore(&ep->dev->lock, flags);
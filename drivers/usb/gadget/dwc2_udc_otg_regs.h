@@ -170,6 +170,8 @@ struct dwc2_usbotg_reg {
 /* DWC2_UDC_OTG_DCTL device control register */
 #define NORMAL_OPERATION		(0x1<<0)
 #define SOFT_DISCONNECT		(0x1<<1)
+#define SET_GLOBAL_OUT_NAK		(0x1<<9)
+#define CLEAR_GLOBAL_OUT_NAK		(0x1<<10)
 
 /* DWC2_UDC_OTG_DAINT device all endpoint interrupt register */
 #define DAINT_OUT_BIT			(16)
@@ -252,9 +252,23 @@ static void complete_rx(struct dwc2_udc *dev, u8 ep_num)
 			/* packet will be completed in complete_tx() */
 			dev->ep0state = WAIT_FOR_IN_COMPLETE;
 		} else {
+			struct dwc2_request *next = NULL;
+
+			/*
+			 * Start the next queued request before completing
+			 * this one, so the endpoint keeps receiving while the
+			 * gadget driver handles the data. Requests queued by
+			 * the completion callback are started below.
+			 */
+			if (!list_is_last(&req->queue, &ep->queue)) {
+				next = list_entry(req->queue.next,
+						  struct dwc2_request, queue);
+				setdma_rx(ep, next);
+			}
+
 			done(ep, req, 0);
 
-			if (!list_empty(&ep->queue)) {
+			if (!next && !list_empty(&ep->queue)) {
 				req = list_entry(ep->queue.next,
 					struct dwc2_request, queue);
 				debug_cond(DEBUG_OUT_EP != 0,
@@ -973,6 +987,45 @@ static void dwc2_udc_set_nak(struct dwc2_ep *ep)
 	return;
 }
 
+/*
+ * Stop a transfer which is in progress, so the controller no longer
+ * accesses the buffer of the request at the head of the queue
+ */
+static void dwc2_udc_ep_abort(struct dwc2_ep *ep)
+{
+	u8 ep_num = ep_index(ep);
+	u32 ep_ctrl;
+
+	if (ep_is_in(ep)) {
+		ep_ctrl = readl(&reg->in_endp[ep_num].diepctl);
+		if (!(ep_ctrl & DEPCTL_EPENA))
+			return;
+		writel(ep_ctrl | DEPCTL_SNAK, &reg->in_endp[ep_num].diepctl);
+		writel(ep_ctrl | DEPCTL_SNAK | DEPCTL_EPDIS,
+		       &reg->in_endp[ep_num].diepctl);
+		if (wait_for_bit_le32(&reg->in_endp[ep_num].diepint, EPDISBLD,
+				      true, 10, false))
+			debug("%s: ep%d-in not disabled\n", __func__, ep_num);
+		writel(EPDISBLD, &reg->in_endp[ep_num].diepint);
+		return;
+	}
+
+	ep_ctrl = readl(&reg->out_endp[ep_num].doepctl);
+	if (!(ep_ctrl & DEPCTL_EPENA))
+		return;
+
+	/* An OUT endpoint can only be disabled under global OUT NAK */
+	writel(readl(&reg->dctl) | SET_GLOBAL_OUT_NAK, &reg->dctl);
+	if (wait_for_bit_le32(&reg->gintsts, INT_GOUTNakEff, true, 10, false))
+		debug("%s: global OUT NAK not effective\n", __func__);
+	writel(ep_ctrl | DEPCTL_SNAK | DEPCTL_EPDIS,
+	       &reg->out_endp[ep_num].doepctl);
+	if (wait_for_bit_le32(&reg->out_endp[ep_num].doepint, EPDISBLD, true,
+			      10, false))
+		debug("%s: ep%d-out not disabled\n", __func__, ep_num);
+	writel(EPDISBLD, &reg->out_endp[ep_num].doepint);
+	writel(readl(&reg->dctl) | CLEAR_GLOBAL_OUT_NAK, &reg->dctl);
+}
 
 static void dwc2_udc_ep_set_stall(struct dwc2_ep *ep)
 {
@@ -17,6 +17,9 @@
 #include <fastboot.h>
 #include <log.h>
 #include <malloc.h>
+#include <asm/cache.h>
+#include <linux/bug.h>
+#include <linux/sizes.h>
 #include <linux/usb/ch9.h>
 #include <linux/usb/gadget.h>
 #include <linux/usb/composite.h>
@@ -38,12 +41,26 @@
  * that expect bulk OUT requests to be divisible by maxpacket size.
  */
 
+#if CONFIG_FASTBOOT_USB_DL_REQS
+#define FASTBOOT_DL_REQ_SIZE		CONFIG_FASTBOOT_USB_DL_REQ_SIZE
+#else
+#define FASTBOOT_DL_REQ_SIZE		SZ_4K
+#endif
+
 struct f_fastboot {
 	struct usb_function usb_function;
 
 	/* IN/OUT EP's and corresponding requests */
 	struct usb_ep *in_ep, *out_ep;
 	struct usb_request *in_req, *out_req;
+
+	/* Requests receiving a download in place, see fastboot_dl_start() */
+	struct usb_request *dl_req[CONFIG_FASTBOOT_USB_DL_REQS];
+	unsigned long dl_busy;		/* bitmap of queued dl_req[] */
+	void *dl_base;			/* start of the download in the buffer */
+	u32 dl_space;			/* buffer space from dl_base on */
+	u32 dl_offset;			/* offset from dl_base for next dl_req */
+	u32 dl_pending;			/* bytes the queued dl_req[] can take */
 };
 
 static char fb_ext_prop_name[] = "DeviceInterfaceGUID";
@@ -193,6 +210,7 @@ static struct usb_gadget_strings *fastboot_strings[] = {
 };
 
 static void rx_handler_command(struct usb_ep *ep, struct usb_request *req);
+static void rx_handler_dl_direct(struct usb_ep *ep, struct usb_request *req);
 
 static void fastboot_complete(struct usb_ep *ep, struct usb_request *req)
 {
@@ -278,9 +296,19 @@ static void fastboot_disable(struct usb_function *f)
 {
 	struct f_fastboot *f_fb = func_to_fastboot(f);
 
+	int i;
+
 	usb_ep_disable(f_fb->out_ep);
 	usb_ep_disable(f_fb->in_ep);
 
+	for (i = 0; i < CONFIG_FASTBOOT_USB_DL_REQS; i++) {
+		if (f_fb->dl_req[i]) {
+			usb_ep_free_request(f_fb->out_ep, f_fb->dl_req[i]);
+			f_fb->dl_req[i] = NULL;
+		}
+	}
+	f_fb->dl_busy = 0;
+
 	if (f_fb->out_req) {
 		free(f_fb->out_req->buf);
 		usb_ep_free_request(f_fb->out_ep, f_fb->out_req);
@@ -315,7 +343,7 @@ static struct usb_request *fastboot_start_ep(struct usb_ep *ep)
 static int fastboot_set_alt(struct usb_function *f,
 			    unsigned interface, unsigned alt)
 {
-	int ret;
+	int i, ret;
 	struct usb_composite_dev *cdev = f->config->cdev;
 	struct usb_gadget *gadget = cdev->gadget;
 	struct f_fastboot *f_fb = func_to_fastboot(f);
@@ -339,6 +367,17 @@ static int fastboot_set_alt(struct usb_function *f,
 	}
 	f_fb->out_req->complete = rx_handler_command;
 
+	for (i = 0; i < CONFIG_FASTBOOT_USB_DL_REQS; i++) {
+		/* The buffer is set to the download area when queued */
+		f_fb->dl_req[i] = usb_ep_alloc_request(f_fb->out_ep, 0);
+		if (!f_fb->dl_req[i]) {
+			puts("failed to alloc download req\n");
+			ret = -EINVAL;
+			goto err;
+		}
+		f_fb->dl_req[i]->complete = rx_handler_dl_direct;
+	}
+
 	d = fb_ep_desc(gadget, &fs_ep_in, &hs_ep_in, &ss_ep_in);
 	ret = usb_ep_enable(f_fb->in_ep, d);
 	if (ret) {
@@ -464,6 +503,10 @@ static void rx_handler_dl_image(struct usb_ep *ep, struct usb_request *req)
 
 	fastboot_data_download(buffer, transfer_size, response);
 	if (response[0]) {
+		/* The download is cancelled, go back to receiving commands */
+		req->complete = rx_handler_command;
+		req->length = EP_BUFFER_SIZE;
+
 		fastboot_tx_write_str(response);
 	} else if (!fastboot_data_remaining()) {
 		fastboot_data_complete(response);
@@ -483,6 +526,162 @@ static void rx_handler_dl_image(struct usb_ep *ep, struct usb_request *req)
 	usb_ep_queue(ep, req, 0);
 }
 
+static unsigned int fastboot_dl_align(struct usb_ep *ep)
+{
+	/* Whole packets, and whole cache lines for the DMA maintenance */
+	return max_t(unsigned int, usb_endpoint_maxp(ep->desc),
+		     ARCH_DMA_MINALIGN);
+}
+
+/*
+ * A streamed download is consumed as it arrives, so the requests can go
+ * round the buffer again, as long as the ones still queued stay clear.
+ */
+static bool fastboot_dl_can_wrap(void)
+{
+	return fastboot_data_streamed() &&
+	       fastboot_func->dl_space >=
+	       2 * CONFIG_FASTBOOT_USB_DL_REQS * FASTBOOT_DL_REQ_SIZE;
+}
+
+/**
+ * fastboot_dl_queue() - queue a download request at the next buffer offset
+ *
+ * @ep: OUT endpoint
+ * @idx: Index of an idle request in dl_req[]
+ * Return: 0 if queued or if the queued requests already cover the rest of
+ * the download, -ve on error
+ */
+static int fastboot_dl_queue(struct usb_ep *ep, int idx)
+{
+	struct f_fastboot *f_fb = fastboot_func;
+	struct usb_request *req = f_fb->dl_req[idx];
+	u32 left = fastboot_data_remaining();
+	u32 len;
+	int ret;
+
+	if (left <= f_fb->dl_pending)
+		return 0;
+
+	len = min_t(u32, left - f_fb->dl_pending, FASTBOOT_DL_REQ_SIZE);
+	len = roundup(len, fastboot_dl_align(ep));
+	if (f_fb->dl_offset + len > f_fb->dl_space) {
+		/* Otherwise only possible once a short transfer left a gap */
+		if (!fastboot_dl_can_wrap())
+			return -ENOSPC;
+		f_fb->dl_offset = 0;
+	}
+
+	req->buf = f_fb->dl_base + f_fb->dl_offset;
+	req->length = len;
+	req->actual = 0;
+	f_fb->dl_busy |= BIT(idx);
+	ret = usb_ep_queue(ep, req, 0);
+	if (ret) {
+		f_fb->dl_busy &= ~BIT(idx);
+		return ret;
+	}
+	f_fb->dl_offset += len;
+	f_fb->dl_pending += len;
+
+	return 0;
+}
+
+/**
+ * fastboot_dl_start() - receive the announced download in place
+ *
+ * Queues the download requests, each pointing at its part of the download
+ * buffer, so the controller fills the buffer directly.
+ *
+ * @ep: OUT endpoint
+ * Return: true if the download is received in place, false if it has to
+ * go through the command request
+ */
+static bool fastboot_dl_start(struct usb_ep *ep)
+{
+	struct f_fastboot *f_fb = fastboot_func;
+	u32 size = fastboot_data_remaining();
+	int i;
+
+	BUILD_BUG_ON(!IS_ALIGNED(FASTBOOT_DL_REQ_SIZE, SZ_4K));
+
+	f_fb->dl_base = fastboot_data_buffer();
+	f_fb->dl_space = fastboot_data_space();
+	if (!IS_ALIGNED((ulong)f_fb->dl_base, ARCH_DMA_MINALIGN))
+		return false;
+	if (roundup(size, fastboot_dl_align(ep)) > f_fb->dl_space &&
+	    !fastboot_dl_can_wrap())
+		return false;
+
+	f_fb->dl_offset = 0;
+	f_fb->dl_pending = 0;
+	for (i = 0; i < CONFIG_FASTBOOT_USB_DL_REQS; i++) {
+		if (fastboot_dl_queue(ep, i))
+			break;
+	}
+
+	return f_fb->dl_busy != 0;
+}
+
+static void fastboot_dl_stop(struct usb_ep *ep)
+{
+	struct f_fastboot *f_fb = fastboot_func;
+	int i;
+
+	for (i = 0; i < CONFIG_FASTBOOT_USB_DL_REQS; i++) {
+		if (f_fb->dl_busy & BIT(i))
+			usb_ep_dequeue(ep, f_fb->dl_req[i]);
+	}
+	f_fb->dl_busy = 0;
+	f_fb->dl_pending = 0;
+}
+
+static void rx_handler_dl_direct(struct usb_ep *ep, struct usb_request *req)
+{
+	struct f_fastboot *f_fb = fastboot_func;
+	char response[FASTBOOT_RESPONSE_LEN] = {0};
+	unsigned int transfer_size = fastboot_data_remaining();
+	struct usb_request *cmd_req = f_fb->out_req;
+	int idx;
+
+	for (idx = 0; idx < CONFIG_FASTBOOT_USB_DL_REQS; idx++) {
+		if (f_fb->dl_req[idx] == req)
+			break;
+	}
+	if (!(f_fb->dl_busy & BIT(idx)))
+		return;
+	f_fb->dl_busy &= ~BIT(idx);
+	f_fb->dl_pending -= req->length;
+
+	if (req->status != 0) {
+		if (req->status != -ECONNRESET && req->status != -ESHUTDOWN)
+			printf("Bad status: %d\n", req->status);
+		return;
+	}
+
+	if (req->actual < transfer_size)
+		transfer_size = req->actual;
+
+	/* The data is normally in place already and only accounted for */
+	fastboot_data_download(req->buf, transfer_size, response);
+	if (!response[0] && fastboot_data_remaining()) {
+		if (!fastboot_dl_queue(ep, idx))
+			return;
+		fastboot_fail("cannot queue download request", response);
+	}
+	if (!response[0])
+		fastboot_data_complete(response);
+
+	/* Go back to receiving commands */
+	fastboot_dl_stop(ep);
+	cmd_req->complete = rx_handler_command;
+	cmd_req->length = EP_BUFFER_SIZE;
+	cmd_req->actual = 0;
+	usb_ep_queue(ep, cmd_req, 0);
+
+	fastboot_tx_write_str(response);
+}
+
 static void do_exit_on_complete(struct usb_ep *ep, struct usb_request *req)
 {
 	g_dnl_trigger_detach();
@@ -524,6 +723,13 @@ static void rx_handler_command(struct usb_ep *ep, struct usb_request *req)
 	}
 
 	if (!strncmp("DATA", response, 4)) {
+		if (fastboot_dl_start(ep)) {
+			/* This request stays idle until the download is done */
+			fastboot_tx_write_str(response);
+			*cmdbuf = '\0';
+			req->actual = 0;
+			return;
+		}
 		req->complete = rx_handler_dl_image;
 		req->length = rx_bytes_expected(ep);
 	}
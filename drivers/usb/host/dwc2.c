@@ -5,6 +5,7 @@
  */
 
 #include <common.h>
+#include <bouncebuf.h>
 #include <clk.h>
 #include <cpu_func.h>
 #include <dm.h>
@@ -861,6 +862,9 @@ static int transfer_chunk(struct dwc2_hc_regs *hc_regs, void *aligned_buffer,
 {
 	int ret = 0;
 	uint32_t sub;
+#ifdef CONFIG_BOUNCE_BUFFER
+	struct bounce_buffer bbstate;
+#endif
 
 	debug("%s: chunk: pid %d xfer_len %u pkts %u\n", __func__,
 	      *pid, xfer_len, num_packets);
@@ -870,6 +874,19 @@ static int transfer_chunk(struct dwc2_hc_regs *hc_regs, void *aligned_buffer,
 	       (*pid << DWC2_HCTSIZ_PID_OFFSET),
 	       &hc_regs->hctsiz);
 
+#ifdef CONFIG_BOUNCE_BUFFER
+	/*
+	 * DMA straight to/from the caller's buffer when it is suitably
+	 * aligned, otherwise use a pooled bounce buffer.
+	 */
+	if (xfer_len) {
+		ret = bounce_buffer_start(&bbstate, buffer, xfer_len,
+					  in ? GEN_BB_WRITE : GEN_BB_READ);
+		if (ret)
+			return ret;
+		aligned_buffer = bbstate.bounce_buffer;
+	}
+#else
 	if (xfer_len) {
 		if (in) {
 			invalidate_dcache_range(
@@ -884,6 +901,7 @@ static int transfer_chunk(struct dwc2_hc_regs *hc_regs, void *aligned_buffer,
 					roundup(xfer_len, ARCH_DMA_MINALIGN));
 		}
 	}
+#endif
 
 	writel(phys_to_bus((unsigned long)aligned_buffer), &hc_regs->hcdma);
 
@@ -899,6 +917,15 @@ static int transfer_chunk(struct dwc2_hc_regs *hc_regs, void *aligned_buffer,
 			DWC2_HCCHAR_CHEN);
 
 	ret = wait_for_chhltd(hc_regs, &sub, pid);
+#ifdef CONFIG_BOUNCE_BUFFER
+	if (xfer_len)
+		bounce_buffer_stop(&bbstate);
+	if (ret < 0)
+		return ret;
+
+	if (in)
+		xfer_len -= sub;
+#else
 	if (ret < 0)
 		return ret;
 
@@ -911,6 +938,7 @@ static int transfer_chunk(struct dwc2_hc_regs *hc_regs, void *aligned_buffer,
 
 		memcpy(buffer, aligned_buffer, xfer_len);
 	}
+#endif
 	*actual_len = xfer_len;
 
 	return ret;
@@ -7,6 +7,7 @@
  * All rights reserved.
  */
 #include <common.h>
+#include <bouncebuf.h>
 #include <cpu_func.h>
 #include <dm.h>
 #include <errno.h>
@@ -384,6 +385,10 @@ ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 	int timeout;
 	int ret = 0;
 	struct ehci_ctrl *ctrl = ehci_get_ctrl(dev);
+#ifdef CONFIG_BOUNCE_BUFFER
+	struct bounce_buffer bbstate;
+	bool bounced = false;
+#endif
 
 	debug("dev=%p, pipe=%lx, buffer=%p, length=%d, req=%p\n", dev, pipe,
 	      buffer, length, req);
@@ -394,6 +399,24 @@ ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 		      le16_to_cpu(req->value), le16_to_cpu(req->value),
 		      le16_to_cpu(req->index));
 
+#ifdef CONFIG_BOUNCE_BUFFER
+	/*
+	 * Cache maintenance on a misaligned buffer would also hit the data
+	 * around it, so move such transfers through a bounce buffer. Aligned
+	 * buffers are used directly.
+	 */
+	if (buffer && length > 0) {
+		if (bounce_buffer_start(&bbstate, buffer, length,
+					usb_pipein(pipe) ? GEN_BB_WRITE :
+					GEN_BB_READ)) {
+			printf("unable to allocate bounce buffer\n");
+			return -1;
+		}
+		buffer = bbstate.bounce_buffer;
+		bounced = true;
+	}
+#endif
+
 #define PKT_ALIGN	512
 	/*
 	 * The USB transfer is split into qTD transfers. Eeach qTD transfer is
@@ -456,6 +479,10 @@ ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 	qtd = memalign(USB_DMA_MINALIGN, qtd_count * sizeof(struct qTD));
 	if (qtd == NULL) {
 		printf("unable to allocate TDs\n");
+#ifdef CONFIG_BOUNCE_BUFFER
+		if (bounced)
+			bounce_buffer_stop(&bbstate);
+#endif
 		return -1;
 	}
 
@@ -667,9 +694,16 @@ ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 	 * dangerous operation, it's responsibility of the calling
 	 * code to make sure enough space is reserved.
 	 */
+#ifdef CONFIG_BOUNCE_BUFFER
+	if (bounced) {
+		bounce_buffer_stop(&bbstate);
+		bounced = false;
+	}
+#else
 	if (buffer != NULL && length > 0)
 		invalidate_dcache_range((unsigned long)buffer,
 			ALIGN((unsigned long)buffer + length, ARCH_DMA_MINALIGN));
+#endif
 
 	/* Check that the TD processing happened */
 	if (QT_TOKEN_GET_STATUS(token) & QT_TOKEN_STATUS_ACTIVE)
@@ -721,6 +755,10 @@ ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 	return (dev->status != USB_ST_NOT_PROC) ? 0 : -1;
 
 fail:
+#ifdef CONFIG_BOUNCE_BUFFER
+	if (bounced)
+		bounce_buffer_stop(&bbstate);
+#endif
 	free(qtd);
 	return -1;
 }
@@ -173,6 +173,51 @@ int usb_get_max_xfer_size(struct usb_device *udev, size_t *size)
 	return ops->get_max_xfer_size(bus, size);
 }
 
+int usb_alloc_streams(struct usb_device *udev, unsigned long *pipes,
+		      int num_pipes, unsigned int num_streams)
+{
+	struct udevice *bus = udev->controller_dev;
+	struct dm_usb_ops *ops = usb_get_ops(bus);
+
+	if (!ops->alloc_streams)
+		return -ENOSYS;
+
+	return ops->alloc_streams(bus, udev, pipes, num_pipes, num_streams);
+}
+
+int usb_submit_bulk_req(struct usb_device *udev, struct usb_bulk_req *req)
+{
+	struct udevice *bus = udev->controller_dev;
+	struct dm_usb_ops *ops = usb_get_ops(bus);
+
+	if (!ops->submit_bulk_req)
+		return -ENOSYS;
+
+	return ops->submit_bulk_req(bus, udev, req);
+}
+
+int usb_wait_bulk_req(struct usb_device *udev, struct usb_bulk_req *req)
+{
+	struct udevice *bus = udev->controller_dev;
+	struct dm_usb_ops *ops = usb_get_ops(bus);
+
+	if (!ops->wait_bulk_req)
+		return -ENOSYS;
+
+	return ops->wait_bulk_req(bus, udev, req);
+}
+
+int usb_cancel_bulk_req(struct usb_device *udev, struct usb_bulk_req *req)
+{
+	struct udevice *bus = udev->controller_dev;
+	struct dm_usb_ops *ops = usb_get_ops(bus);
+
+	if (!ops->cancel_bulk_req)
+		return -ENOSYS;
+
+	return ops->cancel_bulk_req(bus, udev, req);
+}
+
 int usb_stop(void)
 {
 	struct udevice *bus;
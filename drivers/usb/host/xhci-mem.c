@@ -151,9 +151,11 @@ static void xhci_free_virt_devices(struct xhci_ctrl *ctrl)
 
 		ctrl->dcbaa->dev_context_ptrs[slot_id] = 0;
 
-		for (i = 0; i < 31; ++i)
+		for (i = 0; i < 31; ++i) {
 			if (virt_dev->eps[i].ring)
 				xhci_ring_free(virt_dev->eps[i].ring);
+			xhci_free_streams(&virt_dev->eps[i]);
+		}
 
 		if (virt_dev->in_ctx)
 			xhci_free_container_ctx(virt_dev->in_ctx);
@@ -203,6 +205,40 @@ static void *xhci_malloc(unsigned int size)
 	return ptr;
 }
 
+/**
+ * Allocate a primary stream context array
+ *
+ * @param num_streams	number of entries, including the reserved stream 0
+ * Return: pointer to the zeroed array
+ */
+struct xhci_stream_ctx *xhci_stream_ctx_alloc(unsigned int num_streams)
+{
+	return xhci_malloc(num_streams * sizeof(struct xhci_stream_ctx));
+}
+
+/**
+ * Free the stream context array and stream rings of an endpoint
+ *
+ * @param ep	endpoint whose streams are to be freed
+ * Return: none
+ */
+void xhci_free_streams(struct xhci_virt_ep *ep)
+{
+	unsigned int i;
+
+	if (!ep->stream_rings)
+		return;
+
+	for (i = 1; i <= ep->num_streams; i++)
+		if (ep->stream_rings[i])
+			xhci_ring_free(ep->stream_rings[i]);
+	free(ep->stream_rings);
+	free(ep->stream_ctx);
+	ep->stream_rings = NULL;
+	ep->stream_ctx = NULL;
+	ep->num_streams = 0;
+}
+
 /**
  * Make the prev segment point to the next segment.
  * Change the last TRB in the prev segment to be a Link TRB which points to the
@@ -265,26 +265,23 @@ static int prepare_ring(struct xhci_ctrl *ctrl, struct xhci_ring *ep_ring,
  * Check to make sure there's room on the command ring for one command TRB.
  *
  * @param ctrl		Host controller data structure
- * @param ptr		Pointer address to write in the first two fields (opt.)
+ * @param val_64	Bus address to write in the first two fields (opt.)
+ * @param field2	Value for the third field, e.g. a stream ID (opt.)
  * @param slot_id	Slot ID to encode in the flags field (opt.)
  * @param ep_index	Endpoint index to encode in the flags field (opt.)
  * @param cmd		Command type to enqueue
  * Return: none
  */
-void xhci_queue_command(struct xhci_ctrl *ctrl, u8 *ptr, u32 slot_id,
-			u32 ep_index, trb_type cmd)
+static void queue_command(struct xhci_ctrl *ctrl, u64 val_64, u32 field2,
+			  u32 slot_id, u32 ep_index, trb_type cmd)
 {
 	u32 fields[4];
-	u64 val_64 = 0;
 
 	BUG_ON(prepare_ring(ctrl, ctrl->cmd_ring, EP_STATE_RUNNING));
 
-	if (ptr)
-		val_64 = xhci_virt_to_bus(ctrl, ptr);
-
 	fields[0] = lower_32_bits(val_64);
 	fields[1] = upper_32_bits(val_64);
-	fields[2] = 0;
+	fields[2] = field2;
 	fields[3] = TRB_TYPE(cmd) | SLOT_ID_FOR_TRB(slot_id) |
 		    ctrl->cmd_ring->cycle_state;
 
@@ -301,6 +298,27 @@ void xhci_queue_command(struct xhci_ctrl *ctrl, u8 *ptr, u32 slot_id,
 	xhci_writel(&ctrl->dba->doorbell[0], DB_VALUE_HOST);
 }
 
+/**
+ * Queue a command TRB on the command ring.
+ *
+ * @param ctrl		Host controller data structure
+ * @param ptr		Pointer address to write in the first two fields (opt.)
+ * @param slot_id	Slot ID to encode in the flags field (opt.)
+ * @param ep_index	Endpoint index to encode in the flags field (opt.)
+ * @param cmd		Command type to enqueue
+ * Return: none
+ */
+void xhci_queue_command(struct xhci_ctrl *ctrl, u8 *ptr, u32 slot_id,
+			u32 ep_index, trb_type cmd)
+{
+	u64 val_64 = 0;
+
+	if (ptr)
+		val_64 = xhci_virt_to_bus(ctrl, ptr);
+
+	queue_command(ctrl, val_64, 0, slot_id, ep_index, cmd);
+}
+
 /*
  * For xHCI 1.0 host controllers, TD size is the number of max packet sized
  * packets remaining in the TD (*not* including this TRB).
@@ -359,12 +377,13 @@ static u32 xhci_td_remainder(struct xhci_ctrl *ctrl, int transferred,
  *
  * @param udev		pointer to the USB device structure
  * @param ep_index	index of the endpoint
+ * @param stream	stream ID the TRBs are queued on, 0 for none
  * @param start_cycle	cycle flag of the first TRB
  * @param start_trb	pionter to the first TRB
  * Return: none
  */
 static void giveback_first_trb(struct usb_device *udev, int ep_index,
-				int start_cycle,
+				unsigned int stream, int start_cycle,
 				struct xhci_generic_trb *start_trb)
 {
 	struct xhci_ctrl *ctrl = xhci_get_ctrl(udev);
@@ -382,7 +401,7 @@ static void giveback_first_trb(struct usb_device *udev, int ep_index,
 
 	/* Ringing EP doorbell here */
 	xhci_writel(&ctrl->dba->doorbell[udev->slot_id],
-				DB_VALUE(ep_index, 0));
+				DB_VALUE(ep_index, stream));
 
 	return;
 }
@@ -430,9 +449,128 @@ static int event_ready(struct xhci_ctrl *ctrl)
 	return 1;
 }
 
+/**
+ * Checks whether a TRB bus address lies on a ring.
+ *
+ * @param ctrl	Host controller data structure
+ * @param ring	pointer to the ring
+ * @param addr	bus address of the TRB
+ * Return: true if the TRB belongs to the ring
+ */
+static bool ring_has_trb(struct xhci_ctrl *ctrl, struct xhci_ring *ring,
+			 u64 addr)
+{
+	struct xhci_segment *seg = ring->first_seg;
+	u64 start;
+
+	do {
+		start = xhci_virt_to_bus(ctrl, seg->trbs);
+		if (addr >= start && addr < start + SEGMENT_SIZE)
+			return true;
+		seg = seg->next;
+	} while (seg && seg != ring->first_seg);
+
+	return false;
+}
+
+/**
+ * Hands a transfer event to the queued bulk request it belongs to, if any.
+ * Requests on one ring complete in order, so the oldest request on the ring
+ * of the event's TRB is the one the event is for. Acknowledges the event if
+ * it was consumed.
+ *
+ * @param ctrl	Host controller data structure
+ * @param event	Transfer event TRB
+ * Return: true if the event was for a queued bulk request
+ */
+static bool bulk_req_event(struct xhci_ctrl *ctrl, union xhci_trb *event)
+{
+	u64 addr = le64_to_cpu(event->trans_event.buffer);
+	u32 len = le32_to_cpu(event->trans_event.transfer_len);
+	struct usb_bulk_req *req;
+	bool found = false;
+
+	list_for_each_entry(req, &ctrl->bulk_reqs, node) {
+		if (ring_has_trb(ctrl, req->hcpriv, addr)) {
+			found = true;
+			break;
+		}
+	}
+	if (!found)
+		return false;
+
+	switch (GET_COMP_CODE(len)) {
+	case COMP_STOP:
+	case COMP_STOP_INVAL:
+		/* The endpoint was stopped by abort_bulk_reqs() */
+		xhci_acknowledge_event(ctrl);
+		return true;
+	}
+
+	if (addr != xhci_virt_to_bus(ctrl, req->hclast)) {
+		/* Short packet part way through the TD, last TRB to follow */
+		req->actual -= (int)EVENT_TRB_LEN(len);
+		xhci_acknowledge_event(ctrl);
+		return true;
+	}
+
+	req->actual = min(req->length, req->actual - (int)EVENT_TRB_LEN(len));
+	switch (GET_COMP_CODE(len)) {
+	case COMP_SUCCESS:
+	case COMP_SHORT_TX:
+		req->status = 0;
+		break;
+	case COMP_STALL:
+		req->status = -EPIPE;
+		break;
+	case COMP_BABBLE:
+		req->status = -EOVERFLOW;
+		break;
+	default:
+		req->status = -EIO;
+	}
+	list_del(&req->node);
+	xhci_acknowledge_event(ctrl);
+	xhci_inval_cache((uintptr_t)req->buffer, req->length);
+
+	return true;
+}
+
+/**
+ * Reports and acknowledges an event nobody is waiting for.
+ *
+ * @param ctrl	Host controller data structure
+ * @param event	Event TRB
+ * Return: none
+ */
+static void discard_event(struct xhci_ctrl *ctrl, union xhci_trb *event)
+{
+	trb_type type = TRB_FIELD_TO_TYPE(le32_to_cpu(event->event_cmd.flags));
+
+	if (type == TRB_PORT_STATUS)
+	/* TODO: remove this once enumeration has been reworked */
+		/*
+		 * Port status change events always have a
+		 * successful completion code
+		 */
+		BUG_ON(GET_COMP_CODE(
+			le32_to_cpu(event->generic.field[2])) !=
+							COMP_SUCCESS);
+	else
+		printf("Unexpected XHCI event TRB, skipping... "
+			"(%08x %08x %08x %08x)\n",
+			le32_to_cpu(event->generic.field[0]),
+			le32_to_cpu(event->generic.field[1]),
+			le32_to_cpu(event->generic.field[2]),
+			le32_to_cpu(event->generic.field[3]));
+
+	xhci_acknowledge_event(ctrl);
+}
+
 /**
  * Waits for a specific type of event and returns it. Discards unexpected
- * events. Caller *must* call xhci_acknowledge_event() after it is finished
+ * events, after passing transfer events of queued bulk requests on to them.
+ * Caller *must* call xhci_acknowledge_event() after it is finished
  * processing the event, and must not access the returned pointer afterwards.
  *
  * @param ctrl		Host controller data structure
@@ -451,27 +589,13 @@ union xhci_trb *xhci_wait_for_event(struct xhci_ctrl *ctrl, trb_type expected)
 			continue;
 
 		type = TRB_FIELD_TO_TYPE(le32_to_cpu(event->event_cmd.flags));
+		if (type == TRB_TRANSFER && bulk_req_event(ctrl, event))
+			continue;
+
 		if (type == expected)
 			return event;
 
-		if (type == TRB_PORT_STATUS)
-		/* TODO: remove this once enumeration has been reworked */
-			/*
-			 * Port status change events always have a
-			 * successful completion code
-			 */
-			BUG_ON(GET_COMP_CODE(
-				le32_to_cpu(event->generic.field[2])) !=
-								COMP_SUCCESS);
-		else
-			printf("Unexpected XHCI event TRB, skipping... "
-				"(%08x %08x %08x %08x)\n",
-				le32_to_cpu(event->generic.field[0]),
-				le32_to_cpu(event->generic.field[1]),
-				le32_to_cpu(event->generic.field[2]),
-				le32_to_cpu(event->generic.field[3]));
-
-		xhci_acknowledge_event(ctrl);
+		discard_event(ctrl, event);
 	} while (get_timer(ts) < XHCI_TIMEOUT);
 
 	if (expected == TRB_TRANSFER)
@@ -551,16 +675,20 @@ static void record_transfer_result(struct usb_device *udev,
 
 /**** Bulk and Control transfer methods ****/
 /**
- * Queues up the BULK Request
+ * Queues the TRBs of a BULK transfer and rings the doorbell
  *
  * @param udev		pointer to the USB device structure
  * @param pipe		contains the DIR_IN or OUT , devnum
+ * @param ring		transfer ring of the endpoint or stream
+ * @param stream	stream ID of @ring, 0 for none
  * @param length	length of the buffer
  * @param buffer	buffer to be read/written based on the request
- * Return: returns 0 if successful else -1 on failure
+ * @param last_trb	returns the last TRB of the TD
+ * Return: returns 0 if successful else error code on failure
  */
-int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
-			int length, void *buffer)
+static int queue_bulk_tx(struct usb_device *udev, unsigned long pipe,
+			 struct xhci_ring *ring, unsigned int stream,
+			 int length, void *buffer, void **last_trb)
 {
 	int num_trbs = 0;
 	struct xhci_generic_trb *start_trb;
@@ -573,8 +701,6 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 	int ep_index;
 	struct xhci_virt_device *virt_dev;
 	struct xhci_ep_ctx *ep_ctx;
-	struct xhci_ring *ring;		/* EP transfer ring */
-	union xhci_trb *event;
 
 	int running_total, trb_buff_len;
 	bool more_trbs_coming = true;
@@ -584,12 +710,10 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 	u32 trb_fields[4];
 	u64 val_64 = xhci_virt_to_bus(ctrl, buffer);
 	void *last_transfer_trb_addr;
-	int available_length;
 
 	debug("dev=%p, pipe=%lx, buffer=%p, length=%d\n",
 		udev, pipe, buffer, length);
 
-	available_length = length;
 	ep_index = usb_pipe_ep_index(pipe);
 	virt_dev = ctrl->devs[slot_id];
 
@@ -598,7 +722,6 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 
 	ep_ctx = xhci_get_ep_ctx(ctrl, virt_dev->out_ctx, ep_index);
 
-	ring = virt_dev->eps[ep_index].ring;
 	/*
 	 * How much data is (potentially) left before the 64KB boundary?
 	 * XHCI Spec puts restriction( TABLE 49 and 6.4.1 section of XHCI Spec)
@@ -625,8 +748,9 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 
 	/*
 	 * XXX: Calling routine prepare_ring() called in place of
-	 * prepare_trasfer() as there in 'Linux' since we are not
-	 * maintaining multiple TDs/transfer at the same time.
+	 * prepare_trasfer() as there in 'Linux'. xhci_bulk_req_submit() may
+	 * queue several TDs on a ring, the caller has to keep the TRBs in
+	 * flight within one segment.
 	 */
 	ret = prepare_ring(ctrl, ring,
 			   le32_to_cpu(ep_ctx->ep_info) & EP_STATE_MASK);
@@ -714,7 +838,43 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 		trb_buff_len = min((length - running_total), TRB_MAX_BUFF_SIZE);
 	} while (running_total < length);
 
-	giveback_first_trb(udev, ep_index, start_cycle, start_trb);
+	giveback_first_trb(udev, ep_index, stream, start_cycle, start_trb);
+	*last_trb = last_transfer_trb_addr;
+
+	return 0;
+}
+
+/**
+ * Queues up the BULK Request and waits for it to complete
+ *
+ * @param udev		pointer to the USB device structure
+ * @param pipe		contains the DIR_IN or OUT , devnum
+ * @param length	length of the buffer
+ * @param buffer	buffer to be read/written based on the request
+ * Return: returns 0 if successful else -1 on failure
+ */
+int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
+			int length, void *buffer)
+{
+	struct xhci_ctrl *ctrl = xhci_get_ctrl(udev);
+	int slot_id = udev->slot_id;
+	int ep_index = usb_pipe_ep_index(pipe);
+	union xhci_trb *event;
+	void *last_transfer_trb_addr;
+	int available_length = length;
+	u32 field;
+	int ret;
+
+	/* Once switched to streams, the endpoint ring is no longer used */
+	if (ctrl->devs[slot_id]->eps[ep_index].num_streams) {
+		debug("XHCI bulk transfer on a streams endpoint\n");
+		return -EINVAL;
+	}
+
+	ret = queue_bulk_tx(udev, pipe, ctrl->devs[slot_id]->eps[ep_index].ring,
+			    0, length, buffer, &last_transfer_trb_addr);
+	if (ret < 0)
+		return ret;
 
 again:
 	event = xhci_wait_for_event(ctrl, TRB_TRANSFER);
@@ -745,6 +905,148 @@ again:
 	return (udev->status != USB_ST_NOT_PROC) ? 0 : -1;
 }
 
+/*
+ * Stops an endpoint which has queued bulk requests and throws them away,
+ * moving the xHC's dequeue pointer of each of their rings (or streams) to
+ * our enqueue pointer. The requests complete with -ETIMEDOUT. If @only is
+ * given, just that request is thrown away, with -ECONNRESET, and the
+ * streams of the others are started again.
+ */
+static void abort_bulk_reqs(struct usb_device *udev, int ep_index,
+			    struct usb_bulk_req *only)
+{
+	struct xhci_ctrl *ctrl = xhci_get_ctrl(udev);
+	struct usb_bulk_req *req, *next;
+	struct xhci_ring *ring;
+	union xhci_trb *event;
+	u64 deq;
+
+	xhci_queue_command(ctrl, NULL, udev->slot_id, ep_index, TRB_STOP_RING);
+	event = xhci_wait_for_event(ctrl, TRB_COMPLETION);
+	BUG_ON(TRB_TO_SLOT_ID(le32_to_cpu(event->event_cmd.flags))
+		!= udev->slot_id);
+	xhci_acknowledge_event(ctrl);
+
+	list_for_each_entry_safe(req, next, &ctrl->bulk_reqs, node) {
+		if (usb_pipedevice(req->pipe) != udev->devnum ||
+		    usb_pipe_ep_index(req->pipe) != ep_index)
+			continue;
+		if (only && req != only) {
+			xhci_writel(&ctrl->dba->doorbell[udev->slot_id],
+				    DB_VALUE(ep_index, req->stream));
+			continue;
+		}
+
+		ring = req->hcpriv;
+		deq = xhci_virt_to_bus(ctrl, ring->enqueue) | ring->cycle_state;
+		if (req->stream)
+			deq |= SCT_FOR_CTX(SCT_PRI_TR);
+		queue_command(ctrl, deq, STREAM_ID_FOR_TRB(req->stream),
+			      udev->slot_id, ep_index, TRB_SET_DEQ);
+		event = xhci_wait_for_event(ctrl, TRB_COMPLETION);
+		BUG_ON(TRB_TO_SLOT_ID(le32_to_cpu(event->event_cmd.flags))
+			!= udev->slot_id);
+		xhci_acknowledge_event(ctrl);
+
+		list_del(&req->node);
+		req->actual = 0;
+		req->status = only ? -ECONNRESET : -ETIMEDOUT;
+	}
+}
+
+/**
+ * Queues up a BULK Request without waiting for it
+ *
+ * @param udev	pointer to the USB device structure
+ * @param req	request to queue, on the stream given by req->stream
+ * Return: returns 0 if successful else error code on failure
+ */
+int xhci_bulk_req_submit(struct usb_device *udev, struct usb_bulk_req *req)
+{
+	struct xhci_ctrl *ctrl = xhci_get_ctrl(udev);
+	struct xhci_virt_ep *ep;
+	struct xhci_ring *ring;
+	int ret;
+
+	if (usb_pipetype(req->pipe) != PIPE_BULK)
+		return -EINVAL;
+
+	ep = &ctrl->devs[udev->slot_id]->eps[usb_pipe_ep_index(req->pipe)];
+	if (req->stream) {
+		if (req->stream > ep->num_streams)
+			return -EINVAL;
+		ring = ep->stream_rings[req->stream];
+	} else {
+		/* The endpoint ring is not live once streams are set up */
+		if (ep->num_streams)
+			return -EINVAL;
+		ring = ep->ring;
+	}
+
+	ret = queue_bulk_tx(udev, req->pipe, ring, req->stream, req->length,
+			    req->buffer, &req->hclast);
+	if (ret < 0)
+		return ret;
+
+	req->hcpriv = ring;
+	req->actual = req->length;
+	req->status = -EINPROGRESS;
+	list_add_tail(&req->node, &ctrl->bulk_reqs);
+
+	return 0;
+}
+
+/**
+ * Waits for a queued BULK Request, completing any others on the way
+ *
+ * @param udev	pointer to the USB device structure
+ * @param req	request to wait for
+ * Return: returns 0 if successful else error code on failure
+ */
+int xhci_bulk_req_wait(struct usb_device *udev, struct usb_bulk_req *req)
+{
+	struct xhci_ctrl *ctrl = xhci_get_ctrl(udev);
+	unsigned long ts = get_timer(0);
+	union xhci_trb *event;
+	trb_type type;
+
+	while (req->status == -EINPROGRESS) {
+		if (get_timer(ts) >= XHCI_TIMEOUT) {
+			debug("XHCI bulk request timed out, aborting...\n");
+			abort_bulk_reqs(udev, usb_pipe_ep_index(req->pipe),
+					NULL);
+			break;
+		}
+
+		if (!event_ready(ctrl))
+			continue;
+
+		event = ctrl->event_ring->dequeue;
+		type = TRB_FIELD_TO_TYPE(le32_to_cpu(event->event_cmd.flags));
+		if (type != TRB_TRANSFER || !bulk_req_event(ctrl, event))
+			discard_event(ctrl, event);
+	}
+
+	return req->status;
+}
+
+/**
+ * Throws away a queued BULK Request which has not completed
+ *
+ * @param udev	pointer to the USB device structure
+ * @param req	request to cancel
+ * Return: returns 0 if cancelled, or the status if it had already completed
+ */
+int xhci_bulk_req_cancel(struct usb_device *udev, struct usb_bulk_req *req)
+{
+	if (req->status != -EINPROGRESS)
+		return req->status;
+
+	abort_bulk_reqs(udev, usb_pipe_ep_index(req->pipe), req);
+
+	return 0;
+}
+
 /**
  * Queues up the Control Transfer Request
  *
@@ -916,7 +1218,7 @@ int xhci_ctrl_tx(struct usb_device *udev, unsigned long pipe,
 
 	queue_trb(ctrl, ep_ring, false, trb_fields);
 
-	giveback_first_trb(udev, ep_index, start_cycle, start_trb);
+	giveback_first_trb(udev, ep_index, 0, start_cycle, start_trb);
 
 	event = xhci_wait_for_event(ctrl, TRB_TRANSFER);
 	if (!event)
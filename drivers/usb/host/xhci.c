@@ -36,6 +36,7 @@
 #include <linux/delay.h>
 #include <linux/errno.h>
 #include <linux/iopoll.h>
+#include <linux/log2.h>
 
 #ifndef CONFIG_USB_MAX_CONTROLLER_COUNT
 #define CONFIG_USB_MAX_CONTROLLER_COUNT 1
@@ -1218,6 +1219,7 @@ static int xhci_lowlevel_init(struct xhci_ctrl *ctrl)
 	xhci_writel(&hcor->or_config, val);
 
 	/* initializing xhci data structures */
+	INIT_LIST_HEAD(&ctrl->bulk_reqs);
 	if (xhci_mem_init(ctrl, hccr, hcor) < 0)
 		return -ENOMEM;
 
@@ -1491,6 +1493,108 @@ static int xhci_get_max_xfer_size(struct udevice *dev, size_t *size)
 	return 0;
 }
 
+static int xhci_alloc_streams(struct udevice *dev, struct usb_device *udev,
+			      unsigned long *pipes, int num_pipes,
+			      unsigned int num_streams)
+{
+	struct xhci_ctrl *ctrl = dev_get_priv(dev);
+	struct xhci_virt_device *virt_dev = ctrl->devs[udev->slot_id];
+	struct xhci_container_ctx *out_ctx = virt_dev->out_ctx;
+	struct xhci_container_ctx *in_ctx = virt_dev->in_ctx;
+	struct xhci_input_control_ctx *ctrl_ctx;
+	struct xhci_ep_ctx *ep_ctx;
+	struct xhci_virt_ep *ep;
+	struct xhci_ring *ring;
+	u32 hcc = xhci_readl(&ctrl->hccr->cr_hccparams);
+	unsigned int size, stream;
+	u32 ep_flags = 0;
+	int ep_index;
+	int i, ret;
+
+	debug("%s: dev='%s', udev=%p\n", __func__, dev->name, udev);
+
+	if (!HCC_HAS_PSA(hcc) || !num_streams)
+		return -ENOSYS;
+
+	/*
+	 * Use a linear primary stream array. Its size is a power of two of
+	 * at least 4 entries, and stream 0 is reserved.
+	 */
+	size = roundup_pow_of_two(max(num_streams + 1, 4U));
+	size = min(size, (unsigned int)HCC_MAX_PSA(hcc));
+
+	xhci_inval_cache((uintptr_t)out_ctx->bytes, out_ctx->size);
+	xhci_slot_copy(ctrl, in_ctx, out_ctx);
+
+	for (i = 0; i < num_pipes; i++) {
+		ep_index = usb_pipe_ep_index(pipes[i]);
+		ep = &virt_dev->eps[ep_index];
+
+		xhci_free_streams(ep);
+		ep->stream_ctx = xhci_stream_ctx_alloc(size);
+		ep->stream_rings = calloc(size, sizeof(struct xhci_ring *));
+		if (!ep->stream_rings) {
+			ret = -ENOMEM;
+			goto err;
+		}
+		ep->num_streams = size - 1;
+
+		for (stream = 1; stream < size; stream++) {
+			ring = xhci_ring_alloc(ctrl, 1, true);
+			ep->stream_rings[stream] = ring;
+			ep->stream_ctx[stream].stream_ring = cpu_to_le64(
+				xhci_virt_to_bus(ctrl, ring->enqueue) |
+				ring->cycle_state | SCT_FOR_CTX(SCT_PRI_TR));
+		}
+		xhci_flush_cache((uintptr_t)ep->stream_ctx,
+				 size * sizeof(struct xhci_stream_ctx));
+
+		xhci_endpoint_copy(ctrl, in_ctx, out_ctx, ep_index);
+		ep_ctx = xhci_get_ep_ctx(ctrl, in_ctx, ep_index);
+		ep_ctx->ep_info &= cpu_to_le32(~EP_MAXPSTREAMS_MASK);
+		ep_ctx->ep_info |= cpu_to_le32(EP_MAXPSTREAMS(ilog2(size) - 1) |
+					       EP_HAS_LSA);
+		ep_ctx->deq = cpu_to_le64(xhci_virt_to_bus(ctrl,
+							   ep->stream_ctx));
+		ep_flags |= 1 << (ep_index + 1);
+	}
+
+	/* Drop and re-add the endpoints to switch them over to streams */
+	ctrl_ctx = xhci_get_input_control_ctx(in_ctx);
+	ctrl_ctx->add_flags = cpu_to_le32(SLOT_FLAG | ep_flags);
+	ctrl_ctx->drop_flags = cpu_to_le32(ep_flags);
+
+	ret = xhci_configure_endpoints(udev, false);
+	if (ret)
+		goto err;
+
+	return size - 1;
+err:
+	for (i = 0; i < num_pipes; i++)
+		xhci_free_streams(&virt_dev->eps[usb_pipe_ep_index(pipes[i])]);
+
+	return ret;
+}
+
+static int xhci_submit_bulk_req(struct udevice *dev, struct usb_device *udev,
+				struct usb_bulk_req *req)
+{
+	debug("%s: dev='%s', udev=%p\n", __func__, dev->name, udev);
+	return xhci_bulk_req_submit(udev, req);
+}
+
+static int xhci_wait_bulk_req(struct udevice *dev, struct usb_device *udev,
+			      struct usb_bulk_req *req)
+{
+	return xhci_bulk_req_wait(udev, req);
+}
+
+static int xhci_cancel_bulk_req(struct udevice *dev, struct usb_device *udev,
+				struct usb_bulk_req *req)
+{
+	return xhci_bulk_req_cancel(udev, req);
+}
+
 int xhci_register(struct udevice *dev, struct xhci_hccr *hccr,
 		  struct xhci_hcor *hcor)
 {
@@ -1545,6 +1649,10 @@ struct dm_usb_ops xhci_usb_ops = {
 	.alloc_device = xhci_alloc_device,
 	.update_hub_device = xhci_update_hub_device,
 	.get_max_xfer_size  = xhci_get_max_xfer_size,
+	.alloc_streams = xhci_alloc_streams,
+	.submit_bulk_req = xhci_submit_bulk_req,
+	.wait_bulk_req = xhci_wait_bulk_req,
+	.cancel_bulk_req = xhci_cancel_bulk_req,
 };
 
 #endif
@@ -23,6 +23,7 @@
 #include <malloc.h>
 #include <virtio_types.h>
 #include <virtio.h>
+#include <virtio_ring.h>
 #include <dm/lists.h>
 #include <linux/bug.h>
 
@@ -338,7 +339,8 @@ static int virtio_uclass_child_pre_probe(struct udevice *vdev)
 	/* Transport features always preserved to pass to finalize_features */
 	for (i = VIRTIO_TRANSPORT_F_START; i < VIRTIO_TRANSPORT_F_END; i++)
 		if ((device_features & (1ULL << i)) &&
-		    (i == VIRTIO_F_VERSION_1))
+		    (i == VIRTIO_F_VERSION_1 ||
+		     i == VIRTIO_RING_F_INDIRECT_DESC))
 			__virtio_set_bit(vdev->parent, i);
 
 	debug("(%s) final negotiated features supported %016llx\n",
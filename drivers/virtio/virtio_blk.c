@@ -15,6 +15,11 @@
 
 struct virtio_blk_priv {
 	struct virtqueue *vq;
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	/* Header and status of the asynchronous request in flight */
+	struct virtio_blk_outhdr async_hdr;
+	u8 async_status;
+#endif
 };
 
 static ulong virtio_blk_do_req(struct udevice *dev, u64 sector,
@@ -62,6 +67,154 @@ static ulong virtio_blk_read(struct udevice *dev, lbaint_t start,
 				 VIRTIO_BLK_T_IN);
 }
 
+/* Requests queued before the device is kicked in a vectored read */
+#define VIRTIO_BLK_SG_BATCH	8
+/* Data buffers per request in a vectored read */
+#define VIRTIO_BLK_SG_MAX_SEGS	16
+/* Largest number of blocks whose length fits in a descriptor */
+#define VIRTIO_BLK_SEG_MAX_BLKS	(U32_MAX / 512)
+
+/*
+ * Each run of segments which follow each other on the disk becomes one
+ * request with a descriptor per buffer. As many requests as fit in the ring
+ * are queued before the device is kicked once and all of them are reaped.
+ */
+static ulong virtio_blk_read_sg(struct udevice *dev, const struct blk_sg *sg,
+				int count)
+{
+	struct virtio_blk_priv *priv = dev_get_priv(dev);
+	struct virtio_blk_outhdr out_hdr[VIRTIO_BLK_SG_BATCH];
+	u8 status[VIRTIO_BLK_SG_BATCH];
+	lbaint_t blocks[VIRTIO_BLK_SG_BATCH];
+	struct virtio_sg *sgs[VIRTIO_BLK_SG_MAX_SEGS + 2];
+	struct virtio_sg data_sg[VIRTIO_BLK_SG_MAX_SEGS];
+	struct virtio_sg hdr_sg, status_sg;
+	ulong total = 0;
+	int i, n, nreq, req, max;
+	int ret;
+
+	for (i = 0; i < count; i++) {
+		if (sg[i].blkcnt > VIRTIO_BLK_SEG_MAX_BLKS)
+			return -EINVAL;
+	}
+
+	i = 0;
+	while (i < count) {
+		for (nreq = 0; nreq < VIRTIO_BLK_SG_BATCH && i < count;
+		     nreq++) {
+			/* An indirect chain only takes one ring entry */
+			if (priv->vq->indirect)
+				max = priv->vq->num_free ?
+				      VIRTQUEUE_MAX_INDIRECT - 2 : 0;
+			else
+				max = min_t(int, VIRTIO_BLK_SG_MAX_SEGS,
+					    (int)priv->vq->num_free - 2);
+			if (max < 1)
+				break;
+
+			out_hdr[nreq].type = cpu_to_virtio32(dev,
+							     VIRTIO_BLK_T_IN);
+			out_hdr[nreq].ioprio = 0;
+			out_hdr[nreq].sector = cpu_to_virtio64(dev,
+							       sg[i].start);
+			hdr_sg.addr = &out_hdr[nreq];
+			hdr_sg.length = sizeof(out_hdr[nreq]);
+			sgs[0] = &hdr_sg;
+
+			blocks[nreq] = 0;
+			for (n = 0; n < max && i + n < count; n++) {
+				if (n && sg[i + n].start !=
+				    sg[i + n - 1].start + sg[i + n - 1].blkcnt)
+					break;
+				data_sg[n].addr = sg[i + n].buffer;
+				data_sg[n].length = sg[i + n].blkcnt * 512;
+				sgs[n + 1] = &data_sg[n];
+				blocks[nreq] += sg[i + n].blkcnt;
+			}
+
+			status[nreq] = VIRTIO_BLK_S_IOERR;
+			status_sg.addr = &status[nreq];
+			status_sg.length = sizeof(status[nreq]);
+			sgs[n + 1] = &status_sg;
+
+			ret = virtqueue_add(priv->vq, sgs, 1, n + 1);
+			if (ret)
+				break;
+			i += n;
+		}
+
+		if (!nreq)
+			return total ? total : -EIO;
+
+		virtqueue_kick(priv->vq);
+
+		for (req = 0; req < nreq; req++) {
+			while (!virtqueue_get_buf(priv->vq, NULL))
+				;
+		}
+
+		for (req = 0; req < nreq; req++) {
+			if (status[req] != VIRTIO_BLK_S_OK)
+				return total;
+			total += blocks[req];
+		}
+	}
+
+	return total;
+}
+
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+/*
+ * Queue the next part of an asynchronous read. Each part is limited to what
+ * fits in a single descriptor, so virtio_blk_poll() queues the rest.
+ */
+static int virtio_blk_submit(struct udevice *dev, struct blk_req *req)
+{
+	struct virtio_blk_priv *priv = dev_get_priv(dev);
+	lbaint_t blkcnt = min_t(lbaint_t, req->blkcnt - req->xfered,
+				VIRTIO_BLK_SEG_MAX_BLKS);
+	struct virtio_sg hdr_sg = { &priv->async_hdr, sizeof(priv->async_hdr) };
+	struct virtio_sg data_sg = { req->buffer + req->xfered * 512,
+				     blkcnt * 512 };
+	struct virtio_sg status_sg = { &priv->async_status,
+				       sizeof(priv->async_status) };
+	struct virtio_sg *sgs[] = { &hdr_sg, &data_sg, &status_sg };
+	int ret;
+
+	priv->async_hdr.type = cpu_to_virtio32(dev, VIRTIO_BLK_T_IN);
+	priv->async_hdr.ioprio = 0;
+	priv->async_hdr.sector = cpu_to_virtio64(dev,
+						 req->start + req->xfered);
+	priv->async_status = VIRTIO_BLK_S_IOERR;
+
+	ret = virtqueue_add(priv->vq, sgs, 1, 2);
+	if (ret)
+		return ret;
+	req->cur = blkcnt;
+	virtqueue_kick(priv->vq);
+
+	return 0;
+}
+
+static int virtio_blk_poll(struct udevice *dev, struct blk_req *req)
+{
+	struct virtio_blk_priv *priv = dev_get_priv(dev);
+	int ret;
+
+	if (!virtqueue_get_buf(priv->vq, NULL))
+		return -EBUSY;
+	if (priv->async_status != VIRTIO_BLK_S_OK)
+		return -EIO;
+	req->xfered += req->cur;
+	if (req->xfered < req->blkcnt) {
+		ret = virtio_blk_submit(dev, req);
+		return ret ? ret : -EBUSY;
+	}
+
+	return 0;
+}
+#endif
+
 static ulong virtio_blk_write(struct udevice *dev, lbaint_t start,
 			      lbaint_t blkcnt, const void *buffer)
 {
@@ -124,7 +277,12 @@ static int virtio_blk_probe(struct udevice *dev)
 
 static const struct blk_ops virtio_blk_ops = {
 	.read	= virtio_blk_read,
+	.read_sg	= virtio_blk_read_sg,
 	.write	= virtio_blk_write,
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	.submit_read	= virtio_blk_submit,
+	.poll	= virtio_blk_poll,
+#endif
 };
 
 U_BOOT_DRIVER(virtio_blk) = {
@@ -7,6 +7,7 @@
 #include <common.h>
 #include <dm.h>
 #include <net.h>
+#include <time.h>
 #include <virtio_types.h>
 #include <virtio.h>
 #include <virtio_ring.h>
@@ -21,6 +22,12 @@
  */
 #define VIRTIO_NET_RX_BUF_SIZE	1526
 
+/* Amount of packets which can be queued for sending at once */
+#define VIRTIO_NET_NUM_TX_BUFS	8
+
+/* How long to wait for the remaining buffers of a merged packet */
+#define VIRTIO_NET_MERGE_TIMEOUT_MS	10
+
 struct virtio_net_priv {
 	union {
 		struct virtqueue *vqs[2];
@@ -31,39 +38,61 @@ struct virtio_net_priv {
 	};
 
 	char rx_buff[VIRTIO_NET_NUM_RX_BUFS][VIRTIO_NET_RX_BUF_SIZE];
+	/* Packet spread over several buffers, and the first of them */
+	char rx_merge[PKTSIZE_ALIGN];
+	void *rx_merge_buf;
+	/* Buffers of a dropped packet which the device has not returned yet */
+	int rx_drop;
+	struct virtio_net_hdr_v1 tx_hdr[VIRTIO_NET_NUM_TX_BUFS];
+	char tx_buff[VIRTIO_NET_NUM_TX_BUFS][PKTSIZE_ALIGN];
+	bool tx_busy[VIRTIO_NET_NUM_TX_BUFS];
 	bool rx_running;
+	bool mrg_rxbuf;
 	int net_hdr_len;
 };
 
 /*
- * For simplicity, the driver only negotiates the VIRTIO_NET_F_MAC feature.
- * For the VIRTIO_NET_F_STATUS feature, we don't negotiate it, hence per spec
- * we should assume the link is always active.
+ * For simplicity, the driver only negotiates the VIRTIO_NET_F_MAC and
+ * VIRTIO_NET_F_MRG_RXBUF features. For the VIRTIO_NET_F_STATUS feature, we
+ * don't negotiate it, hence per spec we should assume the link is always
+ * active.
  */
 static const u32 feature[] = {
-	VIRTIO_NET_F_MAC
+	VIRTIO_NET_F_MAC,
+	VIRTIO_NET_F_MRG_RXBUF,
 };
 
 static const u32 feature_legacy[] = {
-	VIRTIO_NET_F_MAC
+	VIRTIO_NET_F_MAC,
+	VIRTIO_NET_F_MRG_RXBUF,
 };
 
+static void virtio_net_add_rx_buf(struct virtio_net_priv *priv, void *buf)
+{
+	struct virtio_sg sg = { buf, VIRTIO_NET_RX_BUF_SIZE };
+	struct virtio_sg *sgs[] = { &sg };
+
+	virtqueue_add(priv->rx_vq, sgs, 0, 1);
+}
+
+/* Mark the transmit buffers which the device has finished with as free */
+static void virtio_net_reclaim_tx(struct virtio_net_priv *priv)
+{
+	struct virtio_net_hdr_v1 *hdr;
+
+	while ((hdr = virtqueue_get_buf(priv->tx_vq, NULL)))
+		priv->tx_busy[hdr - priv->tx_hdr] = false;
+}
+
 static int virtio_net_start(struct udevice *dev)
 {
 	struct virtio_net_priv *priv = dev_get_priv(dev);
-	struct virtio_sg sg;
-	struct virtio_sg *sgs[] = { &sg };
 	int i;
 
 	if (!priv->rx_running) {
-		/* receive buffer length is always 1526 */
-		sg.length = VIRTIO_NET_RX_BUF_SIZE;
-
 		/* setup the receive buffer address */
-		for (i = 0; i < VIRTIO_NET_NUM_RX_BUFS; i++) {
-			sg.addr = priv->rx_buff[i];
-			virtqueue_add(priv->rx_vq, sgs, 0, 1);
-		}
+		for (i = 0; i < VIRTIO_NET_NUM_RX_BUFS; i++)
+			virtio_net_add_rx_buf(priv, priv->rx_buff[i]);
 
 		virtqueue_kick(priv->rx_vq);
 
@@ -74,48 +103,121 @@ static int virtio_net_start(struct udevice *dev)
 	return 0;
 }
 
+/*
+ * The packet is copied to a transmit buffer so that the device can work on
+ * it while the network stack carries on. Completed buffers are reclaimed
+ * when the next packet is sent.
+ */
 static int virtio_net_send(struct udevice *dev, void *packet, int length)
 {
 	struct virtio_net_priv *priv = dev_get_priv(dev);
-	struct virtio_net_hdr hdr;
-	struct virtio_net_hdr_v1 hdr_v1;
 	struct virtio_sg hdr_sg;
-	struct virtio_sg data_sg = { packet, length };
+	struct virtio_sg data_sg;
 	struct virtio_sg *sgs[] = { &hdr_sg, &data_sg };
-	int ret;
+	int i, ret;
 
-	if (priv->net_hdr_len == sizeof(struct virtio_net_hdr))
-		hdr_sg.addr = &hdr;
-	else
-		hdr_sg.addr = &hdr_v1;
-	hdr_sg.length = priv->net_hdr_len;
+	if (length > PKTSIZE_ALIGN)
+		return -EINVAL;
+
+	for (;;) {
+		virtio_net_reclaim_tx(priv);
+		for (i = 0; i < VIRTIO_NET_NUM_TX_BUFS; i++)
+			if (!priv->tx_busy[i])
+				break;
+		if (i < VIRTIO_NET_NUM_TX_BUFS)
+			break;
+	}
 
+	hdr_sg.addr = &priv->tx_hdr[i];
+	hdr_sg.length = priv->net_hdr_len;
 	memset(hdr_sg.addr, 0, priv->net_hdr_len);
+	data_sg.addr = priv->tx_buff[i];
+	data_sg.length = length;
+	memcpy(data_sg.addr, packet, length);
 
 	ret = virtqueue_add(priv->tx_vq, sgs, 2, 0);
 	if (ret)
 		return ret;
+	priv->tx_busy[i] = true;
 
 	virtqueue_kick(priv->tx_vq);
 
-	while (1) {
-		if (virtqueue_get_buf(priv->tx_vq, NULL))
+	return 0;
+}
+
+/*
+ * With VIRTIO_NET_F_MRG_RXBUF the device may spread a packet over several
+ * receive buffers. Only the first one has a header. Copy the packet into a
+ * single buffer for the network stack.
+ */
+static int virtio_net_recv_merged(struct udevice *dev, void *buf,
+				  unsigned int len, int num_bufs,
+				  uchar **packetp)
+{
+	struct virtio_net_priv *priv = dev_get_priv(dev);
+	ulong start = get_timer(0);
+	unsigned int size;
+	void *next;
+
+	size = len - priv->net_hdr_len;
+	if (size <= sizeof(priv->rx_merge))
+		memcpy(priv->rx_merge, buf + priv->net_hdr_len, size);
+	while (num_bufs > 1) {
+		next = virtqueue_get_buf(priv->rx_vq, &len);
+		if (!next) {
+			if (get_timer(start) < VIRTIO_NET_MERGE_TIMEOUT_MS)
+				continue;
 			break;
+		}
+		if (size + len <= sizeof(priv->rx_merge))
+			memcpy(priv->rx_merge + size, next, len);
+		size += len;
+		virtio_net_add_rx_buf(priv, next);
+		num_bufs--;
 	}
 
-	return 0;
+	if (num_bufs > 1 || size > sizeof(priv->rx_merge)) {
+		debug("%s: dropping packet of %u bytes\n", __func__, size);
+		/* The rest of the packet must not be taken as new packets */
+		priv->rx_drop = num_bufs - 1;
+		virtio_net_add_rx_buf(priv, buf);
+		return -EAGAIN;
+	}
+
+	priv->rx_merge_buf = buf;
+	*packetp = (uchar *)priv->rx_merge;
+
+	return size;
 }
 
 static int virtio_net_recv(struct udevice *dev, int flags, uchar **packetp)
 {
 	struct virtio_net_priv *priv = dev_get_priv(dev);
+	struct virtio_net_hdr_v1 *hdr;
 	unsigned int len;
 	void *buf;
+	int num_bufs;
+
+	for (; priv->rx_drop; priv->rx_drop--) {
+		buf = virtqueue_get_buf(priv->rx_vq, &len);
+		if (!buf)
+			return -EAGAIN;
+		virtio_net_add_rx_buf(priv, buf);
+	}
 
 	buf = virtqueue_get_buf(priv->rx_vq, &len);
 	if (!buf)
 		return -EAGAIN;
 
+	/* num_buffers is at the same place in the legacy header */
+	if (priv->mrg_rxbuf) {
+		hdr = buf;
+		num_bufs = virtio16_to_cpu(dev, hdr->num_buffers);
+		if (num_bufs > 1)
+			return virtio_net_recv_merged(dev, buf, len, num_bufs,
+						      packetp);
+	}
+
 	*packetp = buf + priv->net_hdr_len;
 	return len - priv->net_hdr_len;
 }
@@ -123,12 +225,15 @@ static int virtio_net_recv(struct udevice *dev, int flags, uchar **packetp)
 static int virtio_net_free_pkt(struct udevice *dev, uchar *packet, int length)
 {
 	struct virtio_net_priv *priv = dev_get_priv(dev);
-	void *buf = packet - priv->net_hdr_len;
-	struct virtio_sg sg = { buf, VIRTIO_NET_RX_BUF_SIZE };
-	struct virtio_sg *sgs[] = { &sg };
+	void *buf;
+
+	if (packet == (uchar *)priv->rx_merge)
+		buf = priv->rx_merge_buf;
+	else
+		buf = packet - priv->net_hdr_len;
 
 	/* Put the buffer back to the rx ring */
-	virtqueue_add(priv->rx_vq, sgs, 0, 1);
+	virtio_net_add_rx_buf(priv, buf);
 
 	return 0;
 }
@@ -208,7 +313,8 @@ static int virtio_net_probe(struct udevice *dev)
 	 * VIRTIO_NET_F_MRG_RXBUF was negotiated. Without that feature
 	 * the structure was 2 bytes shorter.
 	 */
-	if (uc_priv->legacy)
+	priv->mrg_rxbuf = virtio_has_feature(dev, VIRTIO_NET_F_MRG_RXBUF);
+	if (uc_priv->legacy && !priv->mrg_rxbuf)
 		priv->net_hdr_len = sizeof(struct virtio_net_hdr);
 	else
 		priv->net_hdr_len = sizeof(struct virtio_net_hdr_v1);
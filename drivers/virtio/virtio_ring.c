@@ -19,18 +19,33 @@
 int virtqueue_add(struct virtqueue *vq, struct virtio_sg *sgs[],
 		  unsigned int out_sgs, unsigned int in_sgs)
 {
-	struct vring_desc *desc;
+	struct vring_desc *desc = NULL;
 	unsigned int total_sg = out_sgs + in_sgs;
 	unsigned int i, n, avail, descs_used, uninitialized_var(prev);
+	bool indirect = false;
 	int head;
 
 	WARN_ON(total_sg == 0);
 
 	head = vq->free_head;
 
-	desc = vq->vring.desc;
-	i = head;
-	descs_used = total_sg;
+	/*
+	 * A chain of several buffers takes a single ring entry if possible,
+	 * using the indirect table set aside for its head
+	 */
+	if (vq->indirect && total_sg > 1 && total_sg <= VIRTQUEUE_MAX_INDIRECT &&
+	    vq->num_free)
+		desc = vq->indirect_desc + head * VIRTQUEUE_MAX_INDIRECT;
+
+	if (desc) {
+		indirect = true;
+		i = 0;
+		descs_used = 1;
+	} else {
+		desc = vq->vring.desc;
+		i = head;
+		descs_used = total_sg;
+	}
 
 	if (vq->num_free < descs_used) {
 		debug("Can't add buf len %i - avail = %i\n",
@@ -70,6 +85,17 @@ int virtqueue_add(struct virtqueue *vq, struct virtio_sg *sgs[],
 	/* Last one doesn't continue */
 	desc[prev].flags &= cpu_to_virtio16(vq->vdev, ~VRING_DESC_F_NEXT);
 
+	if (indirect) {
+		/* Now that the indirect table is filled in, point to it */
+		vq->vring.desc[head].flags = cpu_to_virtio16(vq->vdev,
+						VRING_DESC_F_INDIRECT);
+		vq->vring.desc[head].addr = cpu_to_virtio64(vq->vdev,
+						(u64)(uintptr_t)desc);
+		vq->vring.desc[head].len = cpu_to_virtio32(vq->vdev,
+						total_sg * sizeof(*desc));
+		i = virtio16_to_cpu(vq->vdev, vq->vring.desc[head].next);
+	}
+
 	/* We're using some buffers from the free list. */
 	vq->num_free -= descs_used;
 
@@ -139,6 +165,11 @@ static void detach_buf(struct virtqueue *vq, unsigned int head)
 	unsigned int i;
 	__virtio16 nextflag = cpu_to_virtio16(vq->vdev, VRING_DESC_F_NEXT);
 
+	/* An indirect table only takes the head entry and stays with it */
+	if (vq->vring.desc[head].flags &
+	    cpu_to_virtio16(vq->vdev, VRING_DESC_F_INDIRECT))
+		vq->vring.desc[head].flags = 0;
+
 	/* Put back on free list: unmap first-level descriptors and find end */
 	i = head;
 
@@ -162,8 +193,10 @@ static inline bool more_used(const struct virtqueue *vq)
 
 void *virtqueue_get_buf(struct virtqueue *vq, unsigned int *len)
 {
+	struct vring_desc *desc;
 	unsigned int i;
 	u16 last_used;
+	void *buf;
 
 	if (!more_used(vq)) {
 		debug("(%s.%d): No more buffers in queue\n",
@@ -189,6 +222,12 @@ void *virtqueue_get_buf(struct virtqueue *vq, unsigned int *len)
 		return NULL;
 	}
 
+	/* Return the first buffer of the chain, even if it is indirect */
+	desc = &vq->vring.desc[i];
+	if (desc->flags & cpu_to_virtio16(vq->vdev, VRING_DESC_F_INDIRECT))
+		desc = (void *)(uintptr_t)virtio64_to_cpu(vq->vdev, desc->addr);
+	buf = (void *)(uintptr_t)virtio64_to_cpu(vq->vdev, desc->addr);
+
 	detach_buf(vq, i);
 	vq->last_used_idx++;
 	/*
@@ -200,8 +239,7 @@ void *virtqueue_get_buf(struct virtqueue *vq, unsigned int *len)
 		virtio_store_mb(&vring_used_event(&vq->vring),
 				cpu_to_virtio16(vq->vdev, vq->last_used_idx));
 
-	return (void *)(uintptr_t)virtio64_to_cpu(vq->vdev,
-						  vq->vring.desc[i].addr);
+	return buf;
 }
 
 static struct virtqueue *__vring_new_virtqueue(unsigned int index,
@@ -228,6 +266,23 @@ static struct virtqueue *__vring_new_virtqueue(unsigned int index,
 	list_add_tail(&vq->list, &uc_priv->vqs);
 
 	vq->event = virtio_has_feature(vdev, VIRTIO_RING_F_EVENT_IDX);
+	vq->indirect = virtio_has_feature(vdev, VIRTIO_RING_F_INDIRECT_DESC);
+	vq->indirect_desc = NULL;
+	if (vq->indirect) {
+		struct vring_desc *desc;
+		unsigned int n = vring.num * VIRTQUEUE_MAX_INDIRECT;
+
+		/* Each head has its own table, linked up once here */
+		desc = memalign(VRING_DESC_ALIGN_SIZE, n * sizeof(*desc));
+		if (desc) {
+			for (i = 0; i < n; i++)
+				desc[i].next = cpu_to_virtio16(vdev, (i + 1) %
+						VIRTQUEUE_MAX_INDIRECT);
+			vq->indirect_desc = desc;
+		} else {
+			vq->indirect = false;
+		}
+	}
 
 	/* Tell other side not to bother us */
 	vq->avail_flags_shadow |= VRING_AVAIL_F_NO_INTERRUPT;
@@ -290,6 +345,7 @@ struct virtqueue *vring_create_virtqueue(unsigned int index, unsigned int num,
 
 void vring_del_virtqueue(struct virtqueue *vq)
 {
+	free(vq->indirect_desc);
 	free(vq->vring.desc);
 	list_del(&vq->list);
 	free(vq);
@@ -47,6 +47,11 @@ void ext4fs_set_blk_dev(struct blk_desc *rbdd, struct disk_partition *info)
 		get_fs()->dev_desc->log2blksz;
 }
 
+void ext4fs_sg_init(struct fs_sg_list *list)
+{
+	fs_sg_init(list, get_fs()->dev_desc, part_info);
+}
+
 int ext4fs_devread(lbaint_t sector, int byte_offset, int byte_len,
 		   char *buffer)
 {
@@ -24,6 +24,7 @@
 #include <blk.h>
 #include <ext_common.h>
 #include <ext4fs.h>
+#include <fs_internal.h>
 #include "ext4_common.h"
 #include <div64.h>
 #include <malloc.h>
@@ -68,8 +69,11 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 	char *start_buf = buf;
 	short status;
 	struct ext_block_cache cache;
+	struct fs_sg_list sgl;
 
 	ext_cache_init(&cache);
+	/* Extents are collected so that a fragmented file is read at once */
+	ext4fs_sg_init(&sgl);
 
 	/* Adjust len so it we can't read past the end of the file. */
 	if (len + pos > filesize)
@@ -117,7 +121,8 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 					delayed_extent += blockend;
 					delayed_next += blockend >> log2blksz;
 				} else {	/* spill */
-					status = ext4fs_devread(delayed_start,
+					status = fs_devread_sg(&sgl,
+							delayed_start,
 							delayed_skipfirst,
 							delayed_extent,
 							delayed_buf);
@@ -147,10 +152,10 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 			int n_left;
 			if (previous_block_number != -1) {
 				/* spill */
-				status = ext4fs_devread(delayed_start,
-							delayed_skipfirst,
-							delayed_extent,
-							delayed_buf);
+				status = fs_devread_sg(&sgl, delayed_start,
+						       delayed_skipfirst,
+						       delayed_extent,
+						       delayed_buf);
 				if (status == 0) {
 					ext_cache_fini(&cache);
 					return -1;
@@ -168,15 +173,19 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 	}
 	if (previous_block_number != -1) {
 		/* spill */
-		status = ext4fs_devread(delayed_start,
-					delayed_skipfirst, delayed_extent,
-					delayed_buf);
+		status = fs_devread_sg(&sgl, delayed_start,
+				       delayed_skipfirst, delayed_extent,
+				       delayed_buf);
 		if (status == 0) {
 			ext_cache_fini(&cache);
 			return -1;
 		}
 		previous_block_number = -1;
 	}
+	if (!fs_sg_flush(&sgl)) {
+		ext_cache_fini(&cache);
+		return -1;
+	}
 
 	*actread  = len;
 	ext_cache_fini(&cache);
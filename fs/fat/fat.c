@@ -14,6 +14,7 @@
 #include <exports.h>
 #include <fat.h>
 #include <fs.h>
+#include <fs_internal.h>
 #include <log.h>
 #include <asm/byteorder.h>
 #include <part.h>
@@ -304,6 +305,28 @@ get_cluster(fsdata *mydata, __u32 clustnum, __u8 *buffer, unsigned long size)
 	return 0;
 }
 
+/*
+ * Like get_cluster(), but whole sectors read into an aligned buffer are only
+ * added to @list. They are read by the next fs_sg_flush().
+ */
+static int get_cluster_sg(fsdata *mydata, struct fs_sg_list *list,
+			  __u32 clustnum, __u8 *buffer, unsigned long size)
+{
+	if (!clustnum || size > INT_MAX || size % mydata->sect_size ||
+	    (ulong)buffer & (ARCH_DMA_MINALIGN - 1)) {
+		if (!fs_sg_flush(list))
+			return -1;
+		return get_cluster(mydata, clustnum, buffer, size);
+	}
+
+	debug("gcs - clustnum: %d, size: %lu\n", clustnum, size);
+	if (!fs_devread_sg(list, clust_to_sect(mydata, clustnum), 0, size,
+			   (char *)buffer))
+		return -1;
+
+	return 0;
+}
+
 /**
  * get_contents() - read from file
  *
@@ -326,6 +349,7 @@ static int get_contents(fsdata *mydata, dir_entry *dentptr, loff_t pos,
 	unsigned int bytesperclust = mydata->clust_size * mydata->sect_size;
 	__u32 curclust = START(dentptr);
 	__u32 endclust, newclust;
+	struct fs_sg_list sgl;
 	loff_t actsize;
 
 	*gotsize = 0;
@@ -392,6 +416,8 @@ static int get_contents(fsdata *mydata, dir_entry *dentptr, loff_t pos,
 		}
 	}
 
+	/* Cluster runs are collected so that a fragmented file is read at once */
+	fs_sg_init(&sgl, cur_dev, &cur_part_info);
 	actsize = bytesperclust;
 	endclust = curclust;
 
@@ -412,14 +438,16 @@ static int get_contents(fsdata *mydata, dir_entry *dentptr, loff_t pos,
 
 		/* get remaining bytes */
 		actsize = filesize;
-		if (get_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
+		if (get_cluster_sg(mydata, &sgl, curclust, buffer,
+				   (int)actsize) != 0 || !fs_sg_flush(&sgl)) {
 			printf("Error reading cluster\n");
 			return -1;
 		}
 		*gotsize += actsize;
 		return 0;
 getit:
-		if (get_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
+		if (get_cluster_sg(mydata, &sgl, curclust, buffer,
+				   (int)actsize) != 0) {
 			printf("Error reading cluster\n");
 			return -1;
 		}
@@ -6,17 +6,20 @@
 #define LOG_CATEGORY LOGC_CORE
 
 #include <command.h>
+#include <blk.h>
 #include <config.h>
 #include <errno.h>
 #include <common.h>
 #include <env.h>
 #include <lmb.h>
 #include <log.h>
+#include <malloc.h>
 #include <mapmem.h>
 #include <part.h>
 #include <ext4fs.h>
 #include <fat.h>
 #include <fs.h>
+#include <hash.h>
 #include <sandboxfs.h>
 #include <ubifs_uboot.h>
 #include <btrfs.h>
@@ -24,6 +27,7 @@
 #include <asm/io.h>
 #include <div64.h>
 #include <linux/math64.h>
+#include <linux/sizes.h>
 #include <efi_loader.h>
 #include <squashfs.h>
 
@@ -144,6 +148,11 @@ struct fstype_info {
 	 * filesystem.
 	 */
 	bool null_dev_desc_ok;
+	/*
+	 * Can .read() start at any offset without walking the file from its
+	 * start? Loading with a hash only reads such files in chunks.
+	 */
+	bool fast_seek;
 	int (*probe)(struct blk_desc *fs_dev_desc,
 		     struct disk_partition *fs_partition);
 	int (*ls)(const char *dirname);
@@ -208,6 +217,7 @@ static struct fstype_info fstypes[] = {
 		.fstype = FS_TYPE_EXT,
 		.name = "ext4",
 		.null_dev_desc_ok = false,
+		.fast_seek = true,
 		.probe = ext4fs_probe,
 		.close = ext4fs_close,
 		.ls = ext4fs_ls,
@@ -232,6 +242,7 @@ static struct fstype_info fstypes[] = {
 		.fstype = FS_TYPE_SANDBOX,
 		.name = "sandbox",
 		.null_dev_desc_ok = true,
+		.fast_seek = true,
 		.probe = sandbox_fs_set_blk_dev,
 		.close = sandbox_fs_close,
 		.ls = sandbox_fs_ls,
@@ -515,11 +526,12 @@ static int fs_read_lmb_check(const char *filename, ulong addr, loff_t offset,
 	lmb_init_and_reserve(&lmb, gd->bd, (void *)gd->fdt_blob);
 	lmb_dump_all(&lmb);
 
-	if (lmb_alloc_addr(&lmb, addr, read_len) == addr)
-		return 0;
+	ret = lmb_alloc_addr(&lmb, addr, read_len) == addr ? 0 : -ENOSPC;
+	lmb_uninit(&lmb);
+	if (ret)
+		log_err("** Reading file would overwrite reserved memory **\n");
 
-	log_err("** Reading file would overwrite reserved memory **\n");
-	return -ENOSPC;
+	return ret;
 }
 #endif
 
@@ -693,6 +705,126 @@ int do_size(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[],
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(HASH)
+/* Bytes read per filesystem call when hashing a file while it is loaded */
+#define FS_LOAD_CHUNK		SZ_1M
+/* Bytes hashed each time the block layer waits for a transfer */
+#define FS_LOAD_HASH_SLICE	SZ_64K
+
+/**
+ * struct fs_load_hash - State of a hash calculated while loading a file
+ *
+ * @algo:	Hash algorithm
+ * @ctx:	Hash context
+ * @addr:	Address of the next byte to hash
+ * @end:	End address of the data loaded so far
+ * @ret:	0, or the first error reported by the hash algorithm
+ */
+struct fs_load_hash {
+	struct hash_algo *algo;
+	void *ctx;
+	ulong addr;
+	ulong end;
+	int ret;
+};
+
+/* Hash a slice of the data loaded so far, returning 1 if more is left */
+static int fs_load_hash_step(void *priv)
+{
+	struct fs_load_hash *lh = priv;
+	ulong len = min_t(ulong, lh->end - lh->addr, FS_LOAD_HASH_SLICE);
+	void *buf;
+	int ret;
+
+	if (!len || lh->ret)
+		return 0;
+
+	buf = map_sysmem(lh->addr, len);
+	ret = lh->algo->hash_update(lh->algo, lh->ctx, buf, len, 0);
+	unmap_sysmem(buf);
+	if (ret)
+		lh->ret = ret;
+	lh->addr += len;
+
+	return lh->addr < lh->end;
+}
+
+/*
+ * Load a file in chunks and hash each chunk while the next one is being
+ * read. Block devices which support asynchronous reads run the hashing while
+ * their transfers are in flight, others simply alternate reading and hashing.
+ *
+ * Each chunk is a separate filesystem read, so this is only done on
+ * filesystems which can seek cheaply. Others read the file in one go and hash
+ * it afterwards, since re-reading the cluster chain or block list for each
+ * chunk would cost more than the overlap gains.
+ */
+static int fs_load_hashed(const char *ifname, const char *dev_part,
+			  int fstype, const char *filename, ulong addr,
+			  loff_t pos, loff_t bytes, const char *algo_name,
+			  u8 *output, int *digest_size, loff_t *len_read)
+{
+	struct fs_load_hash lh;
+	loff_t size, done = 0, chunk, max_chunk, actread;
+	int ret;
+
+	ret = hash_progressive_lookup_algo(algo_name, &lh.algo);
+	if (ret) {
+		log_err("Unknown hash algorithm '%s'\n", algo_name);
+		return ret;
+	}
+
+	max_chunk = fs_get_info(fs_type)->fast_seek ? FS_LOAD_CHUNK : 0;
+	ret = fs_size(filename, &size);
+	if (ret)
+		return ret;
+	if (pos > size)
+		return -EINVAL;
+	if (!bytes || bytes > size - pos)
+		bytes = size - pos;
+	if (!max_chunk)
+		max_chunk = bytes;
+
+	ret = lh.algo->hash_init(lh.algo, &lh.ctx);
+	if (ret)
+		return ret;
+	lh.addr = addr;
+	lh.end = addr;
+	lh.ret = 0;
+
+	blk_set_idle_work(fs_load_hash_step, &lh);
+	while (done < bytes) {
+		chunk = min_t(loff_t, bytes - done, max_chunk);
+		ret = fs_set_blk_dev(ifname, dev_part, fstype);
+		if (!ret)
+			ret = _fs_read(filename, addr + done, pos + done, chunk,
+				       1, &actread);
+		if (ret)
+			break;
+		done += actread;
+		lh.end = addr + done;
+		if (actread < chunk)
+			break;
+	}
+	blk_set_idle_work(NULL, NULL);
+
+	/* Hash whatever the reads did not leave time for */
+	while (fs_load_hash_step(&lh))
+		;
+	if (!ret)
+		ret = lh.ret;
+	if (!ret) {
+		*digest_size = lh.algo->digest_size;
+		ret = lh.algo->hash_finish(lh.algo, lh.ctx, output,
+					   lh.algo->digest_size);
+	} else
+		free(lh.ctx);
+	*len_read = done;
+
+	return ret;
+}
+#endif
+
 int do_load(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[],
 	    int fstype)
 {
@@ -705,7 +837,15 @@ int do_load(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[],
 	int ret;
 	unsigned long time;
 	char *ep;
-
+	const char *algo_name = NULL;
+	u8 output[HASH_MAX_DIGEST_SIZE];
+	int digest_size = 0;
+
+	if (CONFIG_IS_ENABLED(HASH) && argc >= 3 && !strcmp(argv[1], "-h")) {
+		algo_name = argv[2];
+		argc -= 2;
+		argv += 2;
+	}
 	if (argc < 2)
 		return CMD_RET_USAGE;
 	if (argc > 7)
@@ -746,7 +886,15 @@ int do_load(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[],
 		pos = 0;
 
 	time = get_timer(0);
-	ret = _fs_read(filename, addr, pos, bytes, 1, &len_read);
+#if CONFIG_IS_ENABLED(HASH)
+	if (algo_name)
+		ret = fs_load_hashed(argv[1], (argc >= 3) ? argv[2] : NULL,
+				     fstype, filename, addr, pos, bytes,
+				     algo_name, output, &digest_size,
+				     &len_read);
+	else
+#endif
+		ret = _fs_read(filename, addr, pos, bytes, 1, &len_read);
 	time = get_timer(time);
 	if (ret < 0) {
 		log_err("Failed to load '%s'\n", filename);
@@ -765,6 +913,15 @@ int do_load(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[],
 		puts(")");
 	}
 	puts("\n");
+	if (digest_size) {
+		int i;
+
+		printf("%s for %08lx ... %08lx ==> ", algo_name, addr,
+		       addr + (ulong)len_read - 1);
+		for (i = 0; i < digest_size; i++)
+			printf("%02x", output[i]);
+		puts("\n");
+	}
 
 	env_set_hex("fileaddr", addr);
 	env_set_hex("filesize", len_read);
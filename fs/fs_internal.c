@@ -10,6 +10,7 @@
 #include <common.h>
 #include <blk.h>
 #include <compiler.h>
+#include <fs_internal.h>
 #include <log.h>
 #include <part.h>
 #include <memalign.h>
@@ -94,3 +95,76 @@ int fs_devread(struct blk_desc *blk, struct disk_partition *partition,
 	}
 	return 1;
 }
+
+void fs_sg_init(struct fs_sg_list *list, struct blk_desc *blk,
+		struct disk_partition *partition)
+{
+	list->blk = blk;
+	list->partition = partition;
+	list->count = 0;
+}
+
+int fs_sg_flush(struct fs_sg_list *list)
+{
+	lbaint_t total = 0;
+	ulong ret;
+	int i;
+
+	if (!list->count)
+		return 1;
+
+	for (i = 0; i < list->count; i++)
+		total += list->sg[i].blkcnt;
+
+	ret = blk_dread_sg(list->blk, list->sg, list->count);
+	list->count = 0;
+	if (ret != total) {
+		log_err(" ** %s read error **\n", __func__);
+		return 0;
+	}
+
+	return 1;
+}
+
+int fs_devread_sg(struct fs_sg_list *list, lbaint_t sector, int byte_offset,
+		  int byte_len, char *buf)
+{
+	struct blk_desc *blk = list->blk;
+	struct blk_sg *last;
+	lbaint_t start, blkcnt;
+
+	if (!blk || !byte_len || ((byte_offset | byte_len) & (blk->blksz - 1)) ||
+	    ((ulong)buf & (ARCH_DMA_MINALIGN - 1))) {
+		if (!fs_sg_flush(list))
+			return 0;
+		return fs_devread(blk, list->partition, sector, byte_offset,
+				  byte_len, buf);
+	}
+
+	start = sector + (byte_offset >> blk->log2blksz);
+	blkcnt = byte_len >> blk->log2blksz;
+	if (start + blkcnt > list->partition->size) {
+		log_err("%s read outside partition " LBAFU "\n", __func__,
+			sector);
+		return 0;
+	}
+	start += list->partition->start;
+
+	/* Extend the previous segment if this read carries straight on */
+	last = list->count ? &list->sg[list->count - 1] : NULL;
+	if (last && last->start + last->blkcnt == start &&
+	    (char *)last->buffer + (last->blkcnt << blk->log2blksz) == buf) {
+		last->blkcnt += blkcnt;
+		return 1;
+	}
+
+	if (list->count == FS_SG_MAX && !fs_sg_flush(list))
+		return 0;
+
+	list->sg[list->count].start = start;
+	list->sg[list->count].blkcnt = blkcnt;
+	list->sg[list->count].buffer = buf;
+	list->count++;
+
+	return 1;
+}
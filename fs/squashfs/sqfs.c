@@ -1313,7 +1313,8 @@ int sqfs_read(const char *filename, void *buf, loff_t offset, loff_t len,
 	char *dir = NULL, *fragment_block, *datablock = NULL, *data_buffer = NULL;
 	char *fragment = NULL, *file = NULL, *resolved, *data;
 	u64 start, n_blks, table_size, data_offset, table_offset, sparse_size;
-	int ret, j, i_number, datablk_count = 0;
+	u64 window_start = 0, window_end = 0;
+	int ret, i, j, i_number, datablk_count = 0;
 	struct squashfs_super_block *sblk = ctxt.sblk;
 	struct squashfs_fragment_block_entry frag_entry;
 	struct squashfs_file_info finfo = {0};
@@ -1437,41 +1438,53 @@ int sqfs_read(const char *filename, void *buf, loff_t offset, loff_t len,
 			ret = -ENOMEM;
 			goto out;
 		}
+
+		/*
+		 * The data blocks of a file follow each other on the disk, so
+		 * several of them are read with one request.
+		 */
+		data_buffer = malloc_cache_aligned(SQFS_READ_WINDOW *
+				get_unaligned_le32(&sblk->block_size) +
+				ctxt.cur_dev->blksz);
+		if (!data_buffer) {
+			ret = -ENOMEM;
+			goto out;
+		}
 	}
 
 	for (j = 0; j < datablk_count; j++) {
-		start = data_offset / ctxt.cur_dev->blksz;
 		table_size = SQFS_BLOCK_SIZE(finfo.blk_sizes[j]);
-		table_offset = data_offset - (start * ctxt.cur_dev->blksz);
-		n_blks = DIV_ROUND_UP(table_size + table_offset,
-				      ctxt.cur_dev->blksz);
 
 		/* Don't load any data for sparse blocks */
 		if (finfo.blk_sizes[j] == 0) {
-			n_blks = 0;
-			table_offset = 0;
-			data_buffer = NULL;
 			data = NULL;
 		} else {
-			data_buffer = malloc_cache_aligned(n_blks * ctxt.cur_dev->blksz);
-
-			if (!data_buffer) {
-				ret = -ENOMEM;
-				goto out;
-			}
-
-			ret = sqfs_disk_read(start, n_blks, data_buffer);
-			if (ret < 0) {
-				/*
-				 * Possible causes: too many data blocks or too large
-				 * SquashFS block size. Tip: re-compile the SquashFS
-				 * image with mksquashfs's -b <block_size> option.
-				 */
-				printf("Error: too many data blocks to be read.\n");
-				goto out;
+			if (data_offset + table_size > window_end) {
+				start = data_offset / ctxt.cur_dev->blksz;
+				window_start = start * ctxt.cur_dev->blksz;
+				window_end = data_offset;
+				for (i = j; i < datablk_count &&
+				     i < j + SQFS_READ_WINDOW &&
+				     (u64)i * get_unaligned_le32(&sblk->block_size) < len;
+				     i++)
+					window_end +=
+						SQFS_BLOCK_SIZE(finfo.blk_sizes[i]);
+				n_blks = DIV_ROUND_UP(window_end - window_start,
+						      ctxt.cur_dev->blksz);
+
+				ret = sqfs_disk_read(start, n_blks, data_buffer);
+				if (ret < 0) {
+					/*
+					 * Possible causes: too many data blocks or too large
+					 * SquashFS block size. Tip: re-compile the SquashFS
+					 * image with mksquashfs's -b <block_size> option.
+					 */
+					printf("Error: too many data blocks to be read.\n");
+					goto out;
+				}
 			}
 
-			data = data_buffer + table_offset;
+			data = data_buffer + (data_offset - window_start);
 		}
 
 		/* Load the data */
@@ -1501,9 +1514,6 @@ int sqfs_read(const char *filename, void *buf, loff_t offset, loff_t len,
 		}
 
 		data_offset += table_size;
-		if (data_buffer)
-			free(data_buffer);
-		data_buffer = NULL;
 		if (*actread >= len)
 			break;
 	}
@@ -308,6 +308,13 @@ struct global_data {
 	 * @malloc_ptr: current address of early malloc()
 	 */
 	unsigned long malloc_ptr;
+#if CONFIG_IS_ENABLED(SYS_MALLOC_F_ARENA)
+	/**
+	 * @malloc_peak: highest value of @malloc_ptr since early malloc()
+	 * was set up
+	 */
+	unsigned long malloc_peak;
+#endif
 #endif
 #ifdef CONFIG_PCI
 	/**
@@ -68,6 +68,26 @@ const char *bootdelay_process(void);
  * @cmd: Command to run
  */
 void autoboot_command(const char *cmd);
+
+/**
+ * autoboot_defer_console() - check whether console set-up can be skipped
+ *
+ * With CONFIG_AUTOBOOT_FAST, this returns true if bootcmd will be run
+ * without delay and no key is waiting on the serial port. The result of the
+ * first call is kept, so that board_init_r() takes the same decision for the
+ * stdio devices and the console.
+ *
+ * Return: true to skip setting up stdio devices and the console
+ */
+bool autoboot_defer_console(void);
+
+/**
+ * autoboot_console_init() - set up the console if this was skipped
+ *
+ * Add the stdio devices and set up the console if autoboot_defer_console()
+ * returned true. Call this before showing the command prompt.
+ */
+void autoboot_console_init(void);
 #else
 static inline const char *bootdelay_process(void)
 {
@@ -77,6 +97,15 @@ static inline const char *bootdelay_process(void)
 static inline void autoboot_command(const char *s)
 {
 }
+
+static inline bool autoboot_defer_console(void)
+{
+	return false;
+}
+
+static inline void autoboot_console_init(void)
+{
+}
 #endif
 
 #endif
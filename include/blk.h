@@ -115,6 +115,19 @@ struct blk_desc {
 #endif
 };
 
+/**
+ * struct blk_sg - One segment of a vectored block request
+ *
+ * @start:	Start block number (0=first)
+ * @blkcnt:	Number of blocks
+ * @buffer:	Memory to transfer to or from
+ */
+struct blk_sg {
+	lbaint_t start;
+	lbaint_t blkcnt;
+	void *buffer;
+};
+
 #define BLOCK_CNT(size, blk_desc) (PAD_COUNT(size, blk_desc->blksz))
 #define PAD_TO_BLOCKSIZE(size, blk_desc) \
 	(PAD_SIZE(size, blk_desc->blksz))
@@ -213,6 +226,25 @@ static inline void blkcache_invalidate(int iftype, int dev) {}
 #if CONFIG_IS_ENABLED(BLK)
 struct udevice;
 
+/**
+ * struct blk_req - An asynchronous block read or write
+ *
+ * @start:	Start block number to transfer (0=first)
+ * @blkcnt:	Number of blocks to transfer
+ * @buffer:	Destination buffer for data read, or source of data written
+ * @xfered:	Number of blocks transferred so far, updated by the driver
+ * @cur:	Number of blocks in the transfer in flight, for driver use
+ * @status:	-EBUSY while the request is in flight, then 0 or -ve error
+ */
+struct blk_req {
+	lbaint_t start;
+	lbaint_t blkcnt;
+	void *buffer;
+	lbaint_t xfered;
+	lbaint_t cur;
+	int status;
+};
+
 /* Operations on block devices */
 struct blk_ops {
 	/**
@@ -228,6 +260,63 @@ struct blk_ops {
 	unsigned long (*read)(struct udevice *dev, lbaint_t start,
 			      lbaint_t blkcnt, void *buffer);
 
+	/**
+	 * read_sg() - read a list of block ranges from a block device
+	 *
+	 * This is optional. Drivers which can describe several buffers in
+	 * one request (e.g. with a DMA descriptor list) implement it so that
+	 * fragmented reads need fewer commands. Segments are read in order.
+	 *
+	 * @dev:	Device to read from
+	 * @sg:	List of block ranges and their destination buffers
+	 * @count:	Number of entries in @sg
+	 * @return number of blocks read from the leading segments, or -ve
+	 * error number (see the IS_ERR_VALUE() macro
+	 */
+	unsigned long (*read_sg)(struct udevice *dev, const struct blk_sg *sg,
+				 int count);
+
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	/**
+	 * submit_read() - start reading from a block device
+	 *
+	 * This is optional. It starts the transfer and returns without
+	 * waiting for the data. Only one request can be in flight on a device
+	 * and no other operation may be used on it until poll() reports that
+	 * the request is done.
+	 *
+	 * @dev:	Device to read from
+	 * @req:	Request to start, which must stay valid until it is done
+	 * @return 0 if started, -ENOSYS if this request cannot be handled
+	 * asynchronously, other -ve error number on failure
+	 */
+	int (*submit_read)(struct udevice *dev, struct blk_req *req);
+
+	/**
+	 * submit_write() - start writing to a block device
+	 *
+	 * This is optional and works like submit_read(). The data is only
+	 * on the medium once poll() reports that the request is done.
+	 *
+	 * @dev:	Device to write to
+	 * @req:	Request to start, which must stay valid until it is done
+	 * @return 0 if started, -ENOSYS if this request cannot be handled
+	 * asynchronously, other -ve error number on failure
+	 */
+	int (*submit_write)(struct udevice *dev, struct blk_req *req);
+
+	/**
+	 * poll() - check the progress of a request started by submit_read()
+	 * or submit_write()
+	 *
+	 * @dev:	Device the request was submitted to
+	 * @req:	Request to check
+	 * @return -EBUSY while the request is in flight, 0 once all blocks
+	 * have been transferred, other -ve error number on failure
+	 */
+	int (*poll)(struct udevice *dev, struct blk_req *req);
+#endif
+
 	/**
 	 * write() - write to a block device
 	 *
@@ -288,6 +377,72 @@ unsigned long blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
 unsigned long blk_derase(struct blk_desc *block_dev, lbaint_t start,
 			 lbaint_t blkcnt);
 
+/**
+ * blk_dread_sg() - read a list of block ranges
+ *
+ * Uses the driver's read_sg() operation if there is one, otherwise reads
+ * each segment with blk_dread(). Reading stops at the first segment which
+ * cannot be read completely.
+ *
+ * @block_dev:	Block device to read from
+ * @sg:		List of block ranges and their destination buffers
+ * @count:	Number of entries in @sg
+ * Return: total number of blocks read, or -ve error number
+ */
+unsigned long blk_dread_sg(struct blk_desc *block_dev,
+			   const struct blk_sg *sg, int count);
+
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+/**
+ * blk_submit_read() - start an asynchronous read
+ *
+ * Devices without native support read the data synchronously here, so the
+ * request is then already done.
+ *
+ * @block_dev:	Block device to read from
+ * @req:	Request with @start, @blkcnt and @buffer filled in
+ * Return: 0 if OK, -ve on error
+ */
+int blk_submit_read(struct blk_desc *block_dev, struct blk_req *req);
+
+/**
+ * blk_poll() - check whether an asynchronous read is done
+ *
+ * @block_dev:	Block device the request was submitted to
+ * @req:	Request to check
+ * Return: -EBUSY while in flight, 0 when done, other -ve on error
+ */
+int blk_poll(struct blk_desc *block_dev, struct blk_req *req);
+
+/**
+ * blk_wait() - wait for an asynchronous read to finish
+ *
+ * The idle work set by blk_set_idle_work() is run while waiting.
+ *
+ * @block_dev:	Block device the request was submitted to
+ * @req:	Request to wait for
+ * Return: 0 if all blocks were read, -ve on error
+ */
+int blk_wait(struct blk_desc *block_dev, struct blk_req *req);
+
+/**
+ * blk_set_idle_work() - set work to do while waiting for block transfers
+ *
+ * While this is set, blk_dread() and blk_dwrite() start transfers
+ * asynchronously where the driver supports it and call @func whenever the
+ * transfer is still in flight, so that CPU work overlaps with the I/O.
+ *
+ * @func:	Function doing a small piece of work, returning non-zero if
+ *		there is more to do. NULL to clear
+ * @priv:	Argument for @func
+ */
+void blk_set_idle_work(int (*func)(void *priv), void *priv);
+#else
+static inline void blk_set_idle_work(int (*func)(void *priv), void *priv)
+{
+}
+#endif
+
 /**
  * blk_find_device() - Find a block device
  *
@@ -444,6 +599,7 @@ struct blk_desc *blk_get_by_device(struct udevice *dev);
 
 #else
 #include <errno.h>
+#include <linux/err.h>
 /*
  * These functions should take struct udevice instead of struct blk_desc,
  * but this is convenient for migration to driver model. Add a 'd' prefix
@@ -485,6 +641,29 @@ static inline ulong blk_derase(struct blk_desc *block_dev, lbaint_t start,
 	return block_dev->block_erase(block_dev, start, blkcnt);
 }
 
+static inline ulong blk_dread_sg(struct blk_desc *block_dev,
+				 const struct blk_sg *sg, int count)
+{
+	ulong total = 0, n;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		n = blk_dread(block_dev, sg[i].start, sg[i].blkcnt,
+			      sg[i].buffer);
+		if (IS_ERR_VALUE(n))
+			return total ? total : n;
+		total += n;
+		if (n != sg[i].blkcnt)
+			break;
+	}
+
+	return total;
+}
+
+static inline void blk_set_idle_work(int (*func)(void *priv), void *priv)
+{
+}
+
 /**
  * struct blk_driver - Driver for block interface types
  *
@@ -19,6 +19,9 @@ enum bootstage_flags {
 	BOOTSTAGEF_ALLOC	= 1 << 1,	/* Allocate an id */
 };
 
+/* Longest name recorded for an initcall, including the terminator */
+#define BOOTSTAGE_INITCALL_NAME_LEN	32
+
 /* bootstate sub-IDs used for kernel and ramdisk ranges */
 enum {
 	BOOTSTAGE_SUB_FORMAT,
@@ -207,6 +210,7 @@ enum bootstage_id {
 	BOOTSTAGE_ID_ACCUM_FSP_M,
 	BOOTSTAGE_ID_ACCUM_FSP_S,
 	BOOTSTAGE_ID_ACCUM_MMAP_SPI,
+	BOOTSTAGE_ID_ACCUM_DEFERRED_PROBE,
 
 	/* a few spare for the user, from here */
 	BOOTSTAGE_ID_USER,
@@ -312,6 +316,26 @@ uint32_t bootstage_start(enum bootstage_id id, const char *name);
  */
 uint32_t bootstage_accum(enum bootstage_id id);
 
+/**
+ * bootstage_initcall_start() - Get the start time of an initcall
+ *
+ * Return: current time in microseconds, or 0 if bootstage is not set up yet,
+ *	in which case the initcall is not timed
+ */
+uint32_t bootstage_initcall_start(void);
+
+/**
+ * bootstage_initcall_end() - Record the time taken by an initcall
+ *
+ * This adds an accumulated-time record named after the function, so that it
+ * appears in the bootstage report and device tree alongside other activities.
+ * Nothing is recorded if @start_us is 0 or the record table is full.
+ *
+ * @func:	Link-time address of the initcall
+ * @start_us:	Value returned by bootstage_initcall_start() before the call
+ */
+void bootstage_initcall_end(ulong func, uint32_t start_us);
+
 /* Print a report about boot time */
 void bootstage_report(void);
 
@@ -411,6 +435,15 @@ static inline uint32_t bootstage_accum(enum bootstage_id id)
 	return 0;
 }
 
+static inline uint32_t bootstage_initcall_start(void)
+{
+	return 0;
+}
+
+static inline void bootstage_initcall_end(ulong func, uint32_t start_us)
+{
+}
+
 static inline int bootstage_stash(void *base, int size)
 {
 	return 0;	/* Pretend to succeed */
@@ -35,6 +35,32 @@
  * used directly) upon stop() call.
  */
 #define GEN_BB_RW	(GEN_BB_READ | GEN_BB_WRITE)
+/*
+ * GEN_BB_PARTIAL -- Only bounce the misaligned head and tail of the buffer.
+ * The cache-aligned middle part of the user buffer is used for DMA directly,
+ * so the transfer is described by up to BOUNCE_BUFFER_MAX_SEGS segments (see
+ * struct bounce_buffer). This is only usable by callers whose DMA engine can
+ * handle a list of buffers, e.g. a scatter-gather descriptor table. If the
+ * buffer is too small to have an aligned middle part, the whole buffer is
+ * bounced as usual. The head and tail segments may have any length, so
+ * callers whose DMA engine needs e.g. 32-bit multiples must check that the
+ * buffer address and length meet this before using GEN_BB_PARTIAL.
+ */
+#define GEN_BB_PARTIAL	(1 << 2)
+
+/* Maximum number of segments a bounce buffer session may be split into */
+#define BOUNCE_BUFFER_MAX_SEGS	3
+
+/**
+ * struct bounce_segment - One DMA-able piece of a bounce buffer session
+ *
+ * @addr:	Address to use for DMA
+ * @len:	Number of bytes to transfer to/from @addr
+ */
+struct bounce_segment {
+	void *addr;
+	size_t len;
+};
 
 struct bounce_buffer {
 	/* Copy of data parameter passed to start() */
@@ -51,6 +77,44 @@ struct bounce_buffer {
 	size_t len_aligned;
 	/* Copy of flags parameter passed to start() */
 	unsigned int flags;
+	/*
+	 * Segments to use for DMA. Without GEN_BB_PARTIAL there is exactly one
+	 * segment covering .bounce_buffer. With GEN_BB_PARTIAL the bounced
+	 * head and tail (if any) surround the aligned middle of .user_buffer.
+	 */
+	struct bounce_segment seg[BOUNCE_BUFFER_MAX_SEGS];
+	/* Number of valid entries in .seg */
+	int nsegs;
+	/* Aligned buffer holding the bounced head and tail (GEN_BB_PARTIAL) */
+	void *edge_buffer;
+	/* Length of the bounced head and tail (GEN_BB_PARTIAL) */
+	size_t head_len;
+	size_t tail_len;
+	/* Alignment the session was started with */
+	size_t alignment;
+};
+
+/**
+ * struct bounce_buffer_stats - Bounce buffer usage counters
+ *
+ * @starts:		Number of sessions started
+ * @direct:		Sessions which used the user buffer directly
+ * @full:		Sessions which bounced the whole buffer
+ * @partial:		Sessions which bounced only the head and/or tail
+ * @pool_hits:		Bounce buffers served from the pool
+ * @pool_misses:	Bounce buffers which had to be allocated
+ * @alloc_failures:	Sessions which failed due to lack of memory
+ * @bytes_copied:	Total number of bytes copied to/from bounce buffers
+ */
+struct bounce_buffer_stats {
+	ulong starts;
+	ulong direct;
+	ulong full;
+	ulong partial;
+	ulong pool_hits;
+	ulong pool_misses;
+	ulong alloc_failures;
+	u64 bytes_copied;
 };
 
 /**
@@ -83,4 +147,28 @@ int bounce_buffer_start_extalign(struct bounce_buffer *state, void *data,
  */
 int bounce_buffer_stop(struct bounce_buffer *state);
 
+/**
+ * bounce_buffer_get_stats() -- Get the bounce buffer usage counters
+ * stats:	returns a copy of the counters
+ */
+void bounce_buffer_get_stats(struct bounce_buffer_stats *stats);
+
+/**
+ * bounce_buffer_reset_stats() -- Reset the bounce buffer usage counters
+ */
+void bounce_buffer_reset_stats(void);
+
+/**
+ * bounce_buffer_pool_info() -- Get the state of the bounce buffer pool
+ * count:	returns the number of buffers currently held by the pool
+ * size:	returns the total size of the buffers held by the pool
+ * Return: number of pool slots, 0 if the pool is disabled
+ */
+int bounce_buffer_pool_info(int *count, size_t *size);
+
+/**
+ * bounce_buffer_pool_release() -- Free all idle buffers held by the pool
+ */
+void bounce_buffer_pool_release(void);
+
 #endif
@@ -417,6 +417,46 @@ static inline void dfu_set_defer_flush(struct dfu_entity *dfu)
 	dfu_defer_flush = dfu;
 }
 
+/**
+ * dfu_set_defer_write() - defer writing full buffers to the medium
+ *
+ * While this is set, dfu_write() hands a full buffer over to be written by
+ * dfu_write_queued() and goes on with the next of CONFIG_DFU_WRITE_BUFS
+ * buffers. It only writes synchronously when all of them are full.
+ * Clearing it drops data which has not been written.
+ *
+ * @defer:	true to defer writes
+ */
+void dfu_set_defer_write(bool defer);
+
+/**
+ * dfu_write_pending() - check whether full buffers wait to be written
+ *
+ * Return:	true if dfu_write_queued() has work to do
+ */
+bool dfu_write_pending(void);
+
+/**
+ * dfu_write_ready() - check whether dfu_write() can take more data
+ *
+ * This is false while all buffers are full, so that dfu_write() would have
+ * to write one synchronously, and while dfu_write() holds a packet which came
+ * in during dfu_write_queued().
+ *
+ * Return:	true if there is a buffer to fill
+ */
+bool dfu_write_ready(void);
+
+/**
+ * dfu_write_queued() - write the oldest full buffer to the medium
+ *
+ * An error is also reported by the following dfu_write() or dfu_flush() of
+ * the entity.
+ *
+ * Return:	0 on success, a negative error code otherwise
+ */
+int dfu_write_queued(void);
+
 /**
  * dfu_write_from_mem_addr() - write data from memory to DFU managed medium
  *
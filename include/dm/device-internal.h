@@ -12,10 +12,15 @@
 
 #include <linker_lists.h>
 #include <dm/ofnode.h>
+#include <dm/uclass-id.h>
 
 struct device_node;
+struct malloc_cache;
 struct udevice;
 
+/* Cache used to allocate struct udevice */
+extern struct malloc_cache udevice_cache;
+
 /*
  * These two macros DM_DEVICE_INST and DM_DEVICE_REF are only allowed in code
  * generated by dtoc, because the ordering is important and if other instances
@@ -275,6 +280,79 @@ static inline int device_chld_remove(struct udevice *dev, struct driver *drv,
 }
 #endif
 
+/**
+ * struct device_ofnode_hash_stats - Statistics for finding devices by node
+ *
+ * @devices: Number of devices in the table
+ * @buckets: Number of buckets in the table
+ * @lookups: Number of lookups made through the table after relocation
+ * @found: Number of those lookups which found a device
+ * @compares: Number of devices whose node was compared during those lookups
+ */
+struct device_ofnode_hash_stats {
+	uint devices;
+	uint buckets;
+	ulong lookups;
+	ulong found;
+	ulong compares;
+};
+
+/**
+ * device_ofnode_hash_find() - Find a device by its node using the table
+ *
+ * If several devices use the node, the first one bound in the uclass is
+ * returned or, for UCLASS_INVALID, the one nearest to the root.
+ *
+ * This is only available with CONFIG_DM_OFNODE_HASH
+ *
+ * @node: Node to look for
+ * @id: Uclass the device must belong to, or UCLASS_INVALID for any
+ * Return: device found, or NULL if none
+ */
+struct udevice *device_ofnode_hash_find(ofnode node, enum uclass_id id);
+
+/**
+ * device_ofnode_hash_get_stats() - Get statistics for the table
+ *
+ * This is only available with CONFIG_DM_OFNODE_HASH
+ *
+ * @stats: Returns the statistics
+ */
+void device_ofnode_hash_get_stats(struct device_ofnode_hash_stats *stats);
+
+#if CONFIG_IS_ENABLED(DM_OFNODE_HASH)
+/**
+ * device_ofnode_hash_add() - Add a device to the table of devices by node
+ *
+ * Nothing is done if the device has no valid node
+ *
+ * @dev: Device to add
+ */
+void device_ofnode_hash_add(struct udevice *dev);
+
+/**
+ * device_ofnode_hash_del() - Remove a device from the table of devices by node
+ *
+ * Nothing is done if the device is not in the table
+ *
+ * @dev: Device to remove
+ */
+void device_ofnode_hash_del(struct udevice *dev);
+
+/**
+ * device_ofnode_hash_reset() - Empty the table of devices by node
+ *
+ * This is called when a new driver model tree is set up, since the devices
+ * in the table may belong to an old tree which was dropped without unbinding
+ * its devices (e.g. the pre-relocation tree)
+ */
+void device_ofnode_hash_reset(void);
+#else
+static inline void device_ofnode_hash_add(struct udevice *dev) {}
+static inline void device_ofnode_hash_del(struct udevice *dev) {}
+static inline void device_ofnode_hash_reset(void) {}
+#endif
+
 /**
  * dev_set_priv() - Set the private data for a device
  *
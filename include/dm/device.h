@@ -80,6 +80,12 @@ struct driver_info;
  */
 #define DM_FLAG_VITAL			(1 << 14)
 
+/*
+ * Device is not needed to boot, so init code that probes all devices of a
+ * uclass skips it. It is probed on first use instead.
+ */
+#define DM_FLAG_PROBE_DEFERRED		(1 << 15)
+
 /*
  * One or multiple of these flags are passed to device_remove() so that
  * a selective device removal as specified by the remove-stage and the
@@ -155,6 +161,8 @@ enum {
  * (do not access outside driver model)
  * @node_: Reference to device tree node for this device (do not access outside
  *	driver model)
+ * @hash_node: Links the device into the table used to find it by its node
+ *	(do not access outside driver model)
  * @devres_head: List of memory allocations associated with this device.
  *		When CONFIG_DEVRES is enabled, devm_kmalloc() and friends will
  *		add to this list. Memory so-allocated will be freed
@@ -184,6 +192,9 @@ struct udevice {
 #if CONFIG_IS_ENABLED(OF_REAL)
 	ofnode node_;
 #endif
+#if CONFIG_IS_ENABLED(DM_OFNODE_HASH)
+	struct hlist_node hash_node;
+#endif
 #ifdef CONFIG_DEVRES
 	struct list_head devres_head;
 #endif
@@ -253,6 +264,24 @@ static inline ofnode dev_ofnode(const struct udevice *dev)
 /* Returns non-zero if the device is active (probed and not removed) */
 #define device_active(dev)	(dev_get_flags(dev) & DM_FLAG_ACTIVATED)
 
+/**
+ * device_probe_deferred() - Check if probing a device should wait
+ *
+ * Init code which probes all devices of a uclass should skip devices for
+ * which this returns true. They are probed when first requested instead,
+ * see CONFIG_DM_DEFERRED_PROBE.
+ *
+ * @dev:	device to check
+ * Return: true if @dev is marked for deferred probing and not yet probed
+ */
+static inline bool device_probe_deferred(const struct udevice *dev)
+{
+	return CONFIG_IS_ENABLED(DM_DEFERRED_PROBE) &&
+		(dev_get_flags(dev) &
+		 (DM_FLAG_PROBE_DEFERRED | DM_FLAG_ACTIVATED)) ==
+		DM_FLAG_PROBE_DEFERRED;
+}
+
 #if CONFIG_IS_ENABLED(DM_DMA)
 #define dev_set_dma_offset(_dev, _offset)	_dev->dma_offset = _offset
 #define dev_get_dma_offset(_dev)		_dev->dma_offset
@@ -39,6 +39,8 @@ struct property {
  * @parent: Pointer to parent node, or NULL if this is the root node
  * @child: Pointer to head of child node list, or NULL if no children
  * @sibling: Pointer to the next sibling node, or NULL if this is the last
+ * @offset: Offset of the node in the flat tree if its properties have not
+ *	been read from there yet, else -1 (only with CONFIG_OF_LIVE_LAZY)
  */
 struct device_node {
 	const char *name;
@@ -50,6 +52,9 @@ struct device_node {
 	struct device_node *parent;
 	struct device_node *child;
 	struct device_node *sibling;
+#if CONFIG_IS_ENABLED(OF_LIVE_LAZY)
+	int offset;
+#endif
 };
 
 #define OF_MAX_PHANDLE_ARGS 16
@@ -103,6 +103,17 @@ struct property *of_find_property(const struct device_node *np,
 const void *of_get_property(const struct device_node *np, const char *name,
 			    int *lenp);
 
+/**
+ * of_get_properties() - get the list of properties of a node
+ *
+ * Use this rather than accessing np->properties, since with
+ * CONFIG_OF_LIVE_LAZY the list is only set up when first needed.
+ *
+ * @np: Pointer to device node
+ * Return: pointer to the first property, or NULL if none
+ */
+struct property *of_get_properties(const struct device_node *np);
+
 /**
  * of_get_first_property()- get to the pointer of the first property
  *
@@ -473,6 +484,17 @@ int of_count_phandle_with_args(const struct device_node *np,
 			       const char *list_name, const char *cells_name,
 			       int cells_count);
 
+/**
+ * of_phandle_cache_init() - Build the phandle table for the live tree
+ *
+ * This records the node for each phandle in the current live tree, so that
+ * of_find_node_by_phandle() does not need to scan the tree. It does nothing
+ * unless CONFIG_OF_PHANDLE_CACHE is enabled.
+ *
+ * Return: 0 if OK, -ENOMEM if not enough memory
+ */
+int of_phandle_cache_init(void);
+
 /**
  * of_alias_scan() - Scan all properties of the 'aliases' node
  *
@@ -39,6 +39,16 @@ static inline void dm_dump_devres(void)
 }
 #endif
 
+#if CONFIG_IS_ENABLED(DM_OFNODE_HASH)
+/* Dump out statistics for finding devices by their devicetree node */
+void dm_dump_ofnode_hash(void);
+#else
+static inline void dm_dump_ofnode_hash(void)
+{
+	puts("Not available\n");
+}
+#endif
+
 /* Dump out a list of drivers */
 void dm_dump_drivers(void);
 
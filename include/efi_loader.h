@@ -886,12 +886,18 @@ struct efi_image_regions {
  * @owner:	Signature owner
  * @data:	Pointer to signature data
  * @size:	Size of signature data
+ * @cert:	Parsed x509 certificate, filled in on first use, or an error
+ *		pointer if @data could not be parsed
+ * @cert_hash:	sha256 hash of the TBSCertificate of @cert, filled in on
+ *		first use
  */
 struct efi_sig_data {
 	struct efi_sig_data *next;
 	efi_guid_t owner;
 	void *data;
 	size_t size;
+	struct x509_certificate *cert;
+	void *cert_hash;
 };
 
 /**
@@ -902,11 +908,14 @@ struct efi_sig_data {
  * @next:		Pointer to next entry
  * @sig_type:		Signature type
  * @sig_data_list:	Pointer to signature list
+ * @refcnt:		Number of users of a cached store, only used in the
+ *			first entry; 0 if the store is not cached
  */
 struct efi_signature_store {
 	struct efi_signature_store *next;
 	efi_guid_t sig_type;
 	struct efi_sig_data *sig_data_list;
+	int refcnt;
 };
 
 struct x509_certificate;
@@ -937,6 +946,25 @@ struct efi_signature_store *efi_build_signature_store(void *sig_list,
 						      efi_uintn_t size);
 struct efi_signature_store *efi_sigstore_parse_sigdb(u16 *name);
 
+#if IS_ENABLED(CONFIG_EFI_SIGSTORE_CACHE)
+/**
+ * efi_sigstore_cache_invalidate() - drop a cached signature database
+ *
+ * This must be called whenever a variable is changed, so that the next
+ * efi_sigstore_parse_sigdb() reads it again. Variables which are not
+ * signature databases are ignored.
+ *
+ * @name:	Variable's name
+ * @vendor:	Variable's vendor GUID
+ */
+void efi_sigstore_cache_invalidate(const u16 *name, const efi_guid_t *vendor);
+#else
+static inline void efi_sigstore_cache_invalidate(const u16 *name,
+						 const efi_guid_t *vendor)
+{
+}
+#endif
+
 bool efi_secure_boot_enabled(void);
 
 bool efi_capsule_auth_enabled(void);
@@ -44,6 +44,9 @@ enum {
 #if CONFIG_IS_ENABLED(FASTBOOT_CMD_OEM_BOOTBUS)
 	FASTBOOT_COMMAND_OEM_BOOTBUS,
 #endif
+#if CONFIG_IS_ENABLED(FASTBOOT_CMD_OEM_STREAM)
+	FASTBOOT_COMMAND_OEM_STREAM,
+#endif
 #if CONFIG_IS_ENABLED(FASTBOOT_UUU_SUPPORT)
 	FASTBOOT_COMMAND_ACMD,
 	FASTBOOT_COMMAND_UCMD,
@@ -150,6 +153,31 @@ int fastboot_handle_command(char *cmd_string, char *response);
  */
 u32 fastboot_data_remaining(void);
 
+/**
+ * fastboot_data_streamed() - check if downloads are written while they arrive
+ *
+ * Return: true if the current download is consumed by
+ * fastboot_data_download() and does not need to stay in the download buffer
+ */
+bool fastboot_data_streamed(void);
+
+/**
+ * fastboot_data_buffer() - return where the next received data belongs
+ *
+ * Transports which can receive straight into the download buffer use this
+ * to find the destination of their next transfer.
+ *
+ * Return: Address in fastboot_buf_addr for the next byte of the download
+ */
+void *fastboot_data_buffer(void);
+
+/**
+ * fastboot_data_space() - return the space left in the download buffer
+ *
+ * Return: Number of bytes available from fastboot_data_buffer() on
+ */
+u32 fastboot_data_space(void);
+
 /**
  * fastboot_data_download() - Copy image data to fastboot_buf_addr.
  *
@@ -159,7 +187,8 @@ u32 fastboot_data_remaining(void);
  *
  * Copies image data from fastboot_data to fastboot_buf_addr. Writes to
  * response. fastboot_bytes_received is updated to indicate the number
- * of bytes that have been transferred.
+ * of bytes that have been transferred. Data which was received in place,
+ * at fastboot_data_buffer(), is only accounted for and not copied.
  */
 void fastboot_data_download(const void *fastboot_data,
 			    unsigned int fastboot_data_len, char *response);
@@ -39,4 +39,38 @@ void fastboot_mmc_flash_write(const char *cmd, void *download_buffer,
  * @response: Pointer to fastboot response buffer
  */
 void fastboot_mmc_erase(const char *cmd, char *response);
+
+/**
+ * fastboot_mmc_stream_start() - Start writing a download to eMMC
+ *
+ * The download is written while it arrives, see fastboot_mmc_stream_write().
+ *
+ * @cmd: Named partition to write image to
+ * @response: Pointer to fastboot response buffer
+ * Return: 0 if OK, -ve on error
+ */
+int fastboot_mmc_stream_start(const char *cmd, char *response);
+
+/**
+ * fastboot_mmc_stream_write() - Write the next part of a download to eMMC
+ *
+ * @data: Pointer to received data
+ * @len: Length of received data
+ * @response: Pointer to fastboot response buffer
+ * Return: 0 if OK, -ve on error, which stops the write
+ */
+int fastboot_mmc_stream_write(const void *data, u32 len, char *response);
+
+/**
+ * fastboot_mmc_stream_finish() - Complete writing a download to eMMC
+ *
+ * @response: Pointer to fastboot response buffer
+ * Return: 0 if the whole image was written, -ve on error
+ */
+int fastboot_mmc_stream_finish(char *response);
+
+/**
+ * fastboot_mmc_stream_abort() - Stop writing an incomplete download to eMMC
+ */
+void fastboot_mmc_stream_abort(void);
 #endif
@@ -59,6 +59,169 @@ int fdt_chosen(void *fdt);
  */
 int fdt_initrd(void *fdt, ulong initrd_start, ulong initrd_end);
 
+struct fdt_batch_edit;
+
+/**
+ * struct fdt_batch - a set of property changes to apply to an FDT in one go
+ *
+ * Each call to fdt_setprop() moves the rest of the blob up or down to make
+ * room for the new value, so fixing up many properties of a large tree
+ * copies it many times over. A batch records the changes instead and then
+ * writes them all out with a single pass over the structure block.
+ *
+ * Changes refer to nodes by their offset, so the FDT must not be changed
+ * other than through the batch until fdt_batch_commit() has been called.
+ *
+ * @fdt: FDT to change
+ * @edits: Changes recorded so far
+ * @count: Number of entries in @edits
+ * @max: Number of entries allocated in @edits
+ * @data: Names and values of the changes
+ * @data_len: Number of bytes used in @data
+ * @data_max: Number of bytes allocated in @data
+ * @err: First error seen while recording changes, -FDT_ERR_... or 0
+ */
+struct fdt_batch {
+	void *fdt;
+	struct fdt_batch_edit *edits;
+	int count;
+	int max;
+	char *data;
+	int data_len;
+	int data_max;
+	int err;
+};
+
+/**
+ * fdt_batch_init() - Start a batch of changes to an FDT
+ *
+ * @batch: Batch to set up
+ * @fdt: FDT to change, which must be writable
+ */
+void fdt_batch_init(struct fdt_batch *batch, void *fdt);
+
+/**
+ * fdt_batch_uninit() - Free the memory used by a batch
+ *
+ * Any changes not yet committed are dropped.
+ *
+ * @batch: Batch to free
+ */
+void fdt_batch_uninit(struct fdt_batch *batch);
+
+/**
+ * fdt_batch_setprop() - Record a new value for a property
+ *
+ * The property is created if it does not exist. Setting the same property
+ * twice keeps the last value. The value is copied, so it need not remain
+ * valid after this call.
+ *
+ * @batch: Batch to add to
+ * @nodeoffset: Offset of the node in the FDT
+ * @name: Name of the property
+ * @val: Value of the property
+ * @len: Length of @val in bytes
+ * Return: 0 if ok, or -FDT_ERR_... on error, which is also returned by
+ *	fdt_batch_commit()
+ */
+int fdt_batch_setprop(struct fdt_batch *batch, int nodeoffset,
+		      const char *name, const void *val, int len);
+
+static inline int fdt_batch_setprop_u32(struct fdt_batch *batch,
+					int nodeoffset, const char *name,
+					u32 val)
+{
+	fdt32_t tmp = cpu_to_fdt32(val);
+
+	return fdt_batch_setprop(batch, nodeoffset, name, &tmp, sizeof(tmp));
+}
+
+static inline int fdt_batch_setprop_u64(struct fdt_batch *batch,
+					int nodeoffset, const char *name,
+					u64 val)
+{
+	fdt64_t tmp = cpu_to_fdt64(val);
+
+	return fdt_batch_setprop(batch, nodeoffset, name, &tmp, sizeof(tmp));
+}
+
+static inline int fdt_batch_setprop_string(struct fdt_batch *batch,
+					   int nodeoffset, const char *name,
+					   const char *str)
+{
+	return fdt_batch_setprop(batch, nodeoffset, name, str,
+				 strlen(str) + 1);
+}
+
+/**
+ * fdt_batch_delprop() - Record the removal of a property
+ *
+ * Nothing happens if the property does not exist.
+ *
+ * @batch: Batch to add to
+ * @nodeoffset: Offset of the node in the FDT
+ * @name: Name of the property
+ * Return: 0 if ok, or -FDT_ERR_... on error
+ */
+int fdt_batch_delprop(struct fdt_batch *batch, int nodeoffset,
+		      const char *name);
+
+/**
+ * fdt_batch_subnode() - Find or add a subnode of a node
+ *
+ * Adding a node moves the nodes after it, so any changes recorded so far
+ * are committed first in that case.
+ *
+ * @batch: Batch in use
+ * @parentoffset: Offset of the parent node
+ * @name: Name of the subnode
+ * Return: offset of the subnode, or -FDT_ERR_... on error
+ */
+int fdt_batch_subnode(struct fdt_batch *batch, int parentoffset,
+		      const char *name);
+
+/**
+ * fdt_batch_commit() - Write the recorded changes to the FDT
+ *
+ * The size of the structure and strings blocks is worked out up front and
+ * the changes are then applied with a single rewrite of the blob. The
+ * batch is left empty and may be used for further changes.
+ *
+ * @batch: Batch to commit
+ * Return: 0 if ok, -FDT_ERR_NOSPACE if the FDT is too small to hold the
+ *	changes, or other -FDT_ERR_... on error
+ */
+int fdt_batch_commit(struct fdt_batch *batch);
+
+/**
+ * fdt_root_batch() - Add data to the root of the FDT, using a batch
+ *
+ * See fdt_root()
+ *
+ * @batch: Batch to record the changes in
+ * Return: 0 if ok, or -FDT_ERR_... on error
+ */
+int fdt_root_batch(struct fdt_batch *batch);
+
+/**
+ * fdt_chosen_batch() - Add chosen data to the FDT, using a batch
+ *
+ * See fdt_chosen()
+ *
+ * @batch: Batch to record the changes in
+ * Return: 0 if ok, or -FDT_ERR_... on error
+ */
+int fdt_chosen_batch(struct fdt_batch *batch);
+
+/**
+ * fdt_fixup_ethernet_batch() - Set the MAC addresses of ethernet nodes
+ *
+ * See fdt_fixup_ethernet()
+ *
+ * @batch: Batch to record the changes in
+ */
+void fdt_fixup_ethernet_batch(struct fdt_batch *batch);
+
 void do_fixup_by_path(void *fdt, const char *path, const char *prop,
 		      const void *val, int len, int create);
 void do_fixup_by_path_u32(void *fdt, const char *path, const char *prop,
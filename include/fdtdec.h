@@ -695,6 +695,115 @@ int fdtdec_get_chosen_node(const void *blob, const char *name);
  */
 const char *fdtdec_get_compatible(enum fdt_compat_id id);
 
+/**
+ * fdtdec_node_offset_by_phandle() - find the node with a given phandle
+ *
+ * This is the same as fdt_node_offset_by_phandle() but uses the phandle
+ * cache for the control FDT if CONFIG_OF_PHANDLE_CACHE is enabled.
+ *
+ * @blob:	FDT blob
+ * @phandle:	phandle to look for
+ * Return: node offset if found, -ve error code on error
+ */
+int fdtdec_node_offset_by_phandle(const void *blob, uint phandle);
+
+/**
+ * fdtdec_phandle_cache_reset() - drop the phandle cache for the control FDT
+ *
+ * Call this after the control FDT has been changed in place. The cache is
+ * rebuilt on the next lookup. Stale entries are detected anyway, but phandles
+ * added to the tree are otherwise only found by scanning it.
+ */
+#if CONFIG_IS_ENABLED(OF_PHANDLE_CACHE)
+void fdtdec_phandle_cache_reset(void);
+#else
+static inline void fdtdec_phandle_cache_reset(void)
+{
+}
+#endif
+
+/**
+ * fdtdec_getprop() - get the value of a property
+ *
+ * This is the same as fdt_getprop() but uses the node index for the control
+ * FDT if CONFIG_OF_FLAT_INDEX is enabled.
+ *
+ * @blob:	FDT blob
+ * @node:	node offset
+ * @name:	name of the property to find
+ * @lenp:	returns the length of the property value, or -ve error code if
+ *		not found (may be NULL)
+ * Return: pointer to the property value, or NULL if not found
+ */
+const void *fdtdec_getprop(const void *blob, int node, const char *name,
+			   int *lenp);
+
+/**
+ * fdtdec_subnode_offset_namelen() - find a subnode of a node
+ *
+ * This is the same as fdt_subnode_offset_namelen() but uses the node index
+ * for the control FDT if CONFIG_OF_FLAT_INDEX is enabled.
+ *
+ * @blob:	FDT blob
+ * @parent:	offset of the parent node
+ * @name:	name of the subnode, with or without its unit address
+ * @namelen:	number of characters of @name to use
+ * Return: offset of the subnode, or -ve error code if not found
+ */
+int fdtdec_subnode_offset_namelen(const void *blob, int parent,
+				  const char *name, int namelen);
+
+/**
+ * fdtdec_subnode_offset() - find a subnode of a node
+ *
+ * This is the same as fdt_subnode_offset() but uses the node index for the
+ * control FDT if CONFIG_OF_FLAT_INDEX is enabled.
+ *
+ * @blob:	FDT blob
+ * @parent:	offset of the parent node
+ * @name:	name of the subnode, with or without its unit address
+ * Return: offset of the subnode, or -ve error code if not found
+ */
+int fdtdec_subnode_offset(const void *blob, int parent, const char *name);
+
+/**
+ * fdtdec_path_offset() - find a node by its path or alias
+ *
+ * This is the same as fdt_path_offset() but uses the node index for the
+ * control FDT if CONFIG_OF_FLAT_INDEX is enabled.
+ *
+ * @blob:	FDT blob
+ * @path:	full path of the node, or an alias optionally followed by a path
+ * Return: offset of the node, or -ve error code if not found
+ */
+int fdtdec_path_offset(const void *blob, const char *path);
+
+/**
+ * fdtdec_index_reset() - drop the node index for the control FDT
+ *
+ * The index is rebuilt on the next lookup. libfdt drops it anyway when it
+ * changes the structure of the control FDT (see fdtdec_index_changed()), so
+ * this is only needed when the tree is changed by other means.
+ */
+#if CONFIG_IS_ENABLED(OF_FLAT_INDEX)
+void fdtdec_index_reset(void);
+#else
+static inline void fdtdec_index_reset(void)
+{
+}
+#endif
+
+/**
+ * fdtdec_index_changed() - note that the structure of a tree is changing
+ *
+ * This is called by libfdt before it adds, removes or renames a node or
+ * property, since that moves the offsets held by the index. It drops the
+ * index if it is for @blob.
+ *
+ * @blob:	FDT blob which is being changed
+ */
+void fdtdec_index_changed(const void *blob);
+
 /* Look up a phandle and follow it to its node. Then return the offset
  * of that node.
  *
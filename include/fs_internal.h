@@ -13,4 +13,53 @@
 int fs_devread(struct blk_desc *, struct disk_partition *, lbaint_t, int, int,
 	       char *);
 
+/* Number of segments collected before a vectored read is issued */
+#define FS_SG_MAX	16
+
+/**
+ * struct fs_sg_list - Reads collected for one vectored block request
+ *
+ * @blk:	Block device to read from
+ * @partition:	Partition the sector numbers are relative to
+ * @sg:		Collected segments, with absolute block numbers
+ * @count:	Number of entries in @sg
+ */
+struct fs_sg_list {
+	struct blk_desc *blk;
+	struct disk_partition *partition;
+	struct blk_sg sg[FS_SG_MAX];
+	int count;
+};
+
+/**
+ * fs_sg_init() - Prepare an empty list of reads
+ *
+ * @list:	List to set up
+ * @blk:	Block device to read from
+ * @partition:	Partition the sector numbers are relative to
+ */
+void fs_sg_init(struct fs_sg_list *list, struct blk_desc *blk,
+		struct disk_partition *partition);
+
+/**
+ * fs_devread_sg() - Read from a partition, possibly deferred
+ *
+ * Takes the same arguments as fs_devread(). Reads of whole blocks into a
+ * cache-aligned buffer are added to @list and issued together by a later
+ * call, anything else is read at once. The data is only valid once
+ * fs_sg_flush() has succeeded.
+ *
+ * Return: 1 if OK, 0 on error
+ */
+int fs_devread_sg(struct fs_sg_list *list, lbaint_t sector, int byte_offset,
+		  int byte_len, char *buf);
+
+/**
+ * fs_sg_flush() - Issue the reads collected in a list
+ *
+ * @list:	List of reads, empty afterwards
+ * Return: 1 if OK, 0 on error
+ */
+int fs_sg_flush(struct fs_sg_list *list);
+
 #endif /* __U_BOOT_FS_INTERNAL_H__ */
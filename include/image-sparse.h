@@ -40,3 +40,90 @@ static inline int is_sparse_image(void *buf)
 
 int write_sparse_image(struct sparse_storage *info, const char *part_name,
 		       void *data, char *response);
+
+/**
+ * struct sparse_stream - An image written to storage while it arrives
+ *
+ * Holds the parser state between calls to sparse_stream_write(), so that
+ * sparse and raw images can be written in pieces of any size.
+ *
+ * @info:		Storage the image is written to
+ * @part_name:		Name of the partition, for messages
+ * @state:		Part of the image expected next (enum sparse_stream_state)
+ * @hdr:		Header bytes collected so far
+ * @hdr_len:		Number of valid bytes in @hdr
+ * @skip:		Bytes still to be skipped before parsing goes on
+ * @left:		Bytes left in the payload of the current chunk
+ * @header:		Sparse image header, once complete
+ * @chunk:		Header of the current chunk
+ * @chunks:		Number of chunks processed
+ * @total_blocks:	Sparse blocks processed
+ * @bytes_written:	Bytes written to storage
+ * @blk:		Next block to write
+ * @buf:		Staging buffer collecting whole blocks
+ * @buf_size:		Size of @buf in bytes
+ * @buf_len:		Number of valid bytes in @buf
+ */
+struct sparse_stream {
+	struct sparse_storage	*info;
+	const char	*part_name;
+	int		state;
+	u8		hdr[sizeof(sparse_header_t)];
+	unsigned int	hdr_len;
+	unsigned int	skip;
+	u64		left;
+	sparse_header_t	header;
+	chunk_header_t	chunk;
+	u32		chunks;
+	u32		total_blocks;
+	u64		bytes_written;
+	lbaint_t	blk;
+	u8		*buf;
+	size_t		buf_size;
+	size_t		buf_len;
+};
+
+/**
+ * sparse_stream_start() - Start writing an image in pieces
+ *
+ * Whether the image is sparse or raw is decided once its first bytes have
+ * arrived. A raw image is written from the start of the partition.
+ *
+ * @ss: Stream state to set up
+ * @info: Storage to write to
+ * @part_name: Name of the partition, for messages
+ * Return: 0 if OK, -ENOMEM if the staging buffer cannot be allocated
+ */
+int sparse_stream_start(struct sparse_stream *ss, struct sparse_storage *info,
+			const char *part_name);
+
+/**
+ * sparse_stream_write() - Write the next piece of an image
+ *
+ * @ss: Stream state
+ * @data: Next bytes of the image
+ * @len: Number of bytes at @data
+ * @response: Buffer for an error message
+ * Return: 0 if OK, -ve on error, in which case the stream is stopped
+ */
+int sparse_stream_write(struct sparse_stream *ss, const void *data,
+			size_t len, char *response);
+
+/**
+ * sparse_stream_finish() - Write what is left of an image and check it
+ *
+ * Writes any partial block of a raw image padded with zeroes and checks
+ * that a sparse image was complete. The stream is stopped afterwards.
+ *
+ * @ss: Stream state
+ * @response: Buffer for an error message
+ * Return: 0 if OK, -ve on error
+ */
+int sparse_stream_finish(struct sparse_stream *ss, char *response);
+
+/**
+ * sparse_stream_abort() - Stop writing an image
+ *
+ * @ss: Stream state
+ */
+void sparse_stream_abort(struct sparse_stream *ss);
@@ -8,6 +8,7 @@
 
 typedef int (*init_fnc_t)(void);
 
+#include <bootstage.h>
 #include <log.h>
 #ifdef CONFIG_EFI_APP
 #include <efi.h>
@@ -25,6 +26,7 @@ static inline int initcall_run_list(const init_fnc_t init_sequence[])
 
 	for (init_fnc_ptr = init_sequence; *init_fnc_ptr; ++init_fnc_ptr) {
 		unsigned long reloc_ofs = 0;
+		uint32_t start_us = 0;
 		int ret;
 
 		/*
@@ -43,7 +45,12 @@ static inline int initcall_run_list(const init_fnc_t init_sequence[])
 		else
 			debug("initcall: %p\n", (char *)*init_fnc_ptr - reloc_ofs);
 
+		if (CONFIG_IS_ENABLED(BOOTSTAGE_INITCALL))
+			start_us = bootstage_initcall_start();
 		ret = (*init_fnc_ptr)();
+		if (CONFIG_IS_ENABLED(BOOTSTAGE_INITCALL))
+			bootstage_initcall_end((ulong)*init_fnc_ptr - reloc_ofs,
+					       start_us);
 		if (ret) {
 			printf("initcall sequence %p failed at call %p (err=%d)\n",
 			       init_sequence,
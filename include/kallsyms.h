@@ -0,0 +1,20 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Helper functions for working with the builtin symbol table
+ */
+
+#ifndef __KALLSYMS_H
+#define __KALLSYMS_H
+
+/**
+ * symbol_lookup() - Find the symbol containing an address
+ *
+ * This needs CONFIG_KALLSYMS, which links the symbol table into U-Boot.
+ *
+ * @addr:	Link-time address to look up
+ * @caddr:	Returns the address of the symbol found, or 0 if none
+ * Return: name of the symbol at or below @addr, or NULL if none
+ */
+const char *symbol_lookup(unsigned long addr, unsigned long *caddr);
+
+#endif
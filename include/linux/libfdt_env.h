@@ -29,5 +29,12 @@ typedef __be64 unaligned_fdt64_t __aligned(4);
 
 #define strtoul(cp, endp, base)	simple_strtoul(cp, endp, base)
 
+/* U-Boot: drop the index of the control FDT when its structure changes */
+#if CONFIG_IS_ENABLED(OF_FLAT_INDEX)
+void fdtdec_index_changed(const void *blob);
+
+#define FDT_STRUCT_CHANGED(fdt)	fdtdec_index_changed(fdt)
+#endif
+
 #endif /* LIBFDT_ENV_H */
 #endif
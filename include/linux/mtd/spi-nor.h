@@ -420,6 +420,19 @@ enum spi_nor_pp_command_index {
 	SNOR_CMD_PP_MAX
 };
 
+#define SNOR_ERASE_TYPE_MAX	4
+
+/**
+ * struct spi_nor_erase_type - Structure to describe a SPI NOR erase type
+ * @size:	the size of the sector/block erased by the erase type, 0 if
+ *		the erase type is not supported
+ * @opcode:	the SPI command op code to erase the sector/block
+ */
+struct spi_nor_erase_type {
+	u32	size;
+	u8	opcode;
+};
+
 struct spi_nor_flash_parameter {
 	u64				size;
 	u32				page_size;
@@ -429,6 +442,7 @@ struct spi_nor_flash_parameter {
 	struct spi_nor_hwcaps		hwcaps;
 	struct spi_nor_read_command	reads[SNOR_CMD_READ_MAX];
 	struct spi_nor_pp_command	page_programs[SNOR_CMD_PP_MAX];
+	struct spi_nor_erase_type	erase_types[SNOR_ERASE_TYPE_MAX];
 
 	int (*quad_enable)(struct spi_nor *nor);
 };
@@ -449,6 +463,8 @@ enum spi_nor_cmd_ext {
 	SPI_NOR_EXT_HEX,
 };
 
+struct spi_mem_dirmap_desc;
+
 /**
  * struct flash_info - Forward declaration of a structure used internally by
  *		       spi_nor_scan()
@@ -476,6 +492,9 @@ struct spi_flash {
  * @page_size:		the page size of the SPI NOR
  * @addr_width:		number of address bytes
  * @erase_opcode:	the opcode for erasing a sector
+ * @erase_types:	erase types usable on the whole flash, largest first.
+ *			spi_nor_erase() picks the largest one that fits each
+ *			part of a request; unused entries have a zero size
  * @read_opcode:	the read opcode
  * @read_dummy:		the dummy needed by the read operation
  * @program_opcode:	the program opcode
@@ -493,6 +512,9 @@ struct spi_flash {
  * @cmd_buf:		used by the write_reg
  * @cmd_ext_type:	the command opcode extension for DTR mode.
  * @fixups:		flash-specific fixup hooks.
+ * @dirmap:		pre-allocated dirmap descriptors
+ * @dirmap.rdesc:	direct mapping used by the read path, NULL when reads
+ *			are issued as individual spi-mem operations
  * @prepare:		[OPTIONAL] do some preparations for the
  *			read/write/erase/lock/unlock operations
  * @unprepare:		[OPTIONAL] do some post work after the
@@ -522,6 +544,7 @@ struct spi_nor {
 	u32			page_size;
 	u8			addr_width;
 	u8			erase_opcode;
+	struct spi_nor_erase_type erase_types[SNOR_ERASE_TYPE_MAX];
 	u8			read_opcode;
 	u8			read_dummy;
 	u8			program_opcode;
@@ -540,6 +563,9 @@ struct spi_nor {
 	u8			cmd_buf[SPI_NOR_MAX_CMD_SIZE];
 	enum spi_nor_cmd_ext	cmd_ext_type;
 	struct spi_nor_fixups	*fixups;
+	struct {
+		struct spi_mem_dirmap_desc *rdesc;
+	} dirmap;
 
 	int (*setup)(struct spi_nor *nor, const struct flash_info *info,
 		     const struct spi_nor_flash_parameter *params);
@@ -40,7 +40,9 @@ struct lmb_property {
  *
  * @cnt: Number of regions.
  * @max: Size of the region array, max value of cnt.
- * @region: Array of the region properties
+ * @region: Array of the region properties, sorted by address
+ * @alloced: true if @region was allocated with malloc() to hold more regions
+ *	than fit in struct lmb (LMB_DYNAMIC_REGIONS only)
  */
 struct lmb_region {
 	unsigned long cnt;
@@ -50,6 +52,9 @@ struct lmb_region {
 #else
 	struct lmb_property *region;
 #endif
+#if IS_ENABLED(CONFIG_LMB_DYNAMIC_REGIONS)
+	bool alloced;
+#endif
 };
 
 /**
@@ -75,6 +80,18 @@ struct lmb {
 };
 
 void lmb_init(struct lmb *lmb);
+
+/**
+ * lmb_uninit() - Free any memory used to hold the regions of an lmb
+ *
+ * With LMB_DYNAMIC_REGIONS the region arrays are allocated with malloc() when
+ * they need to grow. Call this when the lmb is no longer needed, or before
+ * calling lmb_init() on it again. It is safe to call on an lmb that is
+ * cleared to zero.
+ *
+ * @lmb:	the logical memory block struct
+ */
+void lmb_uninit(struct lmb *lmb);
 void lmb_init_and_reserve(struct lmb *lmb, struct bd_info *bd, void *fdt_blob);
 void lmb_init_and_reserve_range(struct lmb *lmb, phys_addr_t base,
 				phys_size_t size, void *fdt_blob);
@@ -474,6 +474,15 @@ do {                                                                          \
 ***/
 #undef	HAVE_MMAP	/* Not available for U-Boot */
 
+/*
+  U-Boot has no mmap() but with SYS_MALLOC_LARGE very large blocks are
+  "mapped" from a heap of their own in the same way.
+*/
+#if CONFIG_IS_ENABLED(SYS_MALLOC_LARGE)
+#define HAVE_MMAP 1
+#define DEFAULT_MMAP_THRESHOLD	CONFIG_SYS_MALLOC_LARGE_THRESHOLD
+#endif
+
 /*
   Define HAVE_MREMAP to make realloc() use mremap() to re-allocate
   large blocks.  This is currently only possible on Linux with
@@ -491,6 +500,7 @@ do {                                                                          \
 ***/
 #undef	HAVE_MREMAP	/* Not available for U-Boot */
 
+/***
 #ifdef HAVE_MMAP
 
 #include <unistd.h>
@@ -501,7 +511,8 @@ do {                                                                          \
 #define MAP_ANONYMOUS MAP_ANON
 #endif
 
-#endif /* HAVE_MMAP */
+#endif
+***/
 
 /*
   Access to system page size. To the extent possible, this malloc
@@ -887,9 +898,12 @@ void malloc_simple_info(void);
 #define malloc malloc_simple
 #define realloc realloc_simple
 #define memalign memalign_simple
+#if CONFIG_IS_ENABLED(SYS_MALLOC_F_ARENA)
+#define free(ptr) free_simple(ptr)
+#else
 static inline void free(void *ptr) {}
+#endif
 void *calloc(size_t nmemb, size_t size);
-void *realloc_simple(void *ptr, size_t size);
 #else
 
 # ifdef USE_DL_PREFIX
@@ -940,6 +954,61 @@ int initf_malloc(void);
 void *malloc_simple(size_t size);
 void *memalign_simple(size_t alignment, size_t bytes);
 
+/**
+ * free_simple() - Free memory from the simple malloc() pool
+ *
+ * This only has an effect with SYS_MALLOC_F_ARENA. Memory which did not come
+ * from the pool is ignored.
+ *
+ * @ptr: Memory to free, or NULL
+ */
+void free_simple(void *ptr);
+
+/**
+ * realloc_simple() - Change the size of memory from the simple malloc() pool
+ *
+ * This needs SYS_MALLOC_F_ARENA. A block at the top of the pool is grown in
+ * place.
+ *
+ * @ptr: Memory to resize, or NULL to allocate new memory
+ * @size: New size in bytes
+ * Return: pointer to the memory, or NULL if there is not enough space, in
+ *	which case @ptr is left alone
+ */
+void *realloc_simple(void *ptr, size_t size);
+
+/**
+ * malloc_simple_mark() - Record the current top of the simple malloc() pool
+ *
+ * This needs SYS_MALLOC_F_ARENA.
+ *
+ * Return: mark to pass to malloc_simple_release()
+ */
+ulong malloc_simple_mark(void);
+
+/**
+ * malloc_simple_release() - Free everything allocated since a mark
+ *
+ * This frees all memory allocated from the simple malloc() pool since @mark
+ * was obtained, whether or not it has been freed already. Until then the
+ * free lists are not used, so all of it lies above @mark. The caller must
+ * be sure that none of it is still in use.
+ *
+ * @mark: Value returned by malloc_simple_mark()
+ */
+void malloc_simple_release(ulong mark);
+
+/**
+ * malloc_simple_avail() - Get the largest block malloc_simple() can provide
+ *
+ * This is the space left at the top of the simple malloc() pool, less the
+ * block header with SYS_MALLOC_F_ARENA. Blocks in the free lists are not
+ * counted.
+ *
+ * Return: number of bytes which can be allocated in one block
+ */
+ulong malloc_simple_avail(void);
+
 #pragma GCC visibility push(hidden)
 # if __STD_C
 
@@ -983,6 +1052,42 @@ extern ulong mem_malloc_brk;
 
 void mem_malloc_init(ulong start, ulong size);
 
+/**
+ * struct malloc_heap_info - Usage of the malloc() heaps
+ *
+ * Sizes include the overhead of each chunk.
+ *
+ * @size: Size of the main heap
+ * @in_use: Bytes allocated from the main heap
+ * @free: Bytes free in the main heap
+ * @free_chunks: Number of free chunks in the main heap
+ * @largest_free: Largest block that can be allocated from the main heap
+ * @large_size: Size of the heap for large blocks (0 if none)
+ * @large_in_use: Bytes allocated from the heap for large blocks
+ * @large_blocks: Number of blocks allocated from the heap for large blocks
+ * @large_largest_free: Largest free area in the heap for large blocks
+ */
+struct malloc_heap_info {
+	ulong size;
+	ulong in_use;
+	ulong free;
+	uint free_chunks;
+	ulong largest_free;
+	ulong large_size;
+	ulong large_in_use;
+	uint large_blocks;
+	ulong large_largest_free;
+};
+
+/**
+ * malloc_get_heap_info() - Get the usage of the malloc() heaps
+ *
+ * This walks the free lists of the main heap, so takes a little while.
+ *
+ * @info: Returns the usage of the heaps
+ */
+void malloc_get_heap_info(struct malloc_heap_info *info);
+
 #ifdef __cplusplus
 };  /* end of extern "C" */
 #endif
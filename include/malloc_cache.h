@@ -0,0 +1,120 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Slab caches for objects of a fixed size
+ */
+
+#ifndef __MALLOC_CACHE_H
+#define __MALLOC_CACHE_H
+
+#include <malloc.h>
+#include <linux/list.h>
+
+#if CONFIG_IS_ENABLED(SYS_MALLOC_CACHE)
+
+/**
+ * struct malloc_cache - A cache of objects of the same size
+ *
+ * Objects are allocated from slabs of CONFIG_SYS_MALLOC_CACHE_SLAB_SIZE bytes
+ * obtained with malloc(). Slabs with free objects are kept at the start of
+ * the list, so allocation only has to look at the first one.
+ *
+ * @name: Name of the cache, for the 'malloc info' command
+ * @size: Size of each object in bytes
+ * @per_slab: Number of objects in each slab, set up on first use
+ * @in_use: Number of objects allocated
+ * @slab_count: Number of slabs
+ * @slabs: List of slabs (struct malloc_slab)
+ * @sibling: Node in the list of all caches
+ */
+struct malloc_cache {
+	const char *name;
+	uint size;
+	uint per_slab;
+	uint in_use;
+	uint slab_count;
+	struct list_head slabs;
+	struct list_head sibling;
+};
+
+/**
+ * MALLOC_CACHE() - Declare a cache of objects
+ *
+ * @_var: Name of the variable holding the cache
+ * @_size: Size of each object in bytes
+ */
+#define MALLOC_CACHE(_var, _size)					\
+	struct malloc_cache _var = {					\
+		.name = #_var,						\
+		.size = _size,						\
+		.slabs = LIST_HEAD_INIT(_var.slabs),			\
+		.sibling = LIST_HEAD_INIT(_var.sibling),		\
+	}
+
+/**
+ * malloc_cache_alloc() - Allocate an object from a cache
+ *
+ * Before relocation this uses calloc() instead, since the slabs would never
+ * be freed.
+ *
+ * @cache: Cache to use
+ * Return: pointer to the object, cleared to zero, or NULL if out of memory
+ */
+void *malloc_cache_alloc(struct malloc_cache *cache);
+
+/**
+ * malloc_cache_free() - Free an object allocated from a cache
+ *
+ * Objects which are not in any slab of the cache, e.g. those allocated
+ * before relocation, are passed to free(). A slab is freed as soon as none
+ * of its objects are in use.
+ *
+ * @cache: Cache the object was allocated from
+ * @ptr: Object to free, or NULL to do nothing
+ */
+void malloc_cache_free(struct malloc_cache *cache, void *ptr);
+
+/**
+ * malloc_cache_unused() - Get the space not in use in all caches
+ *
+ * Return: total size of the free objects in all slabs, in bytes
+ */
+ulong malloc_cache_unused(void);
+
+/**
+ * malloc_cache_info() - Show the usage of each cache
+ */
+void malloc_cache_info(void);
+
+#else
+
+struct malloc_cache {
+	uint size;
+};
+
+#define MALLOC_CACHE(_var, _size)					\
+	struct malloc_cache _var = {					\
+		.size = _size,						\
+	}
+
+static inline void *malloc_cache_alloc(struct malloc_cache *cache)
+{
+	return calloc(1, cache->size);
+}
+
+static inline void malloc_cache_free(struct malloc_cache *cache, void *ptr)
+{
+	free(ptr);
+}
+
+static inline ulong malloc_cache_unused(void)
+{
+	return 0;
+}
+
+static inline void malloc_cache_info(void)
+{
+}
+
+#endif
+
+#endif
@@ -88,6 +88,7 @@ struct bd_info;
 
 #define MMC_DATA_READ		1
 #define MMC_DATA_WRITE		2
+#define MMC_DATA_SG		4	/* Buffers are given by sg/sg_count */
 
 #define MMC_CMD_GO_IDLE_STATE		0
 #define MMC_CMD_SEND_OP_COND		1
@@ -420,6 +421,8 @@ struct mmc_data {
 	uint flags;
 	uint blocks;
 	uint blocksize;
+	const struct blk_sg *sg;	/* Only valid with MMC_DATA_SG */
+	uint sg_count;
 };
 
 /* forward decl. */
@@ -454,6 +457,34 @@ struct dm_mmc_ops {
 	int (*send_cmd)(struct udevice *dev, struct mmc_cmd *cmd,
 			struct mmc_data *data);
 
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	/**
+	 * send_cmd_async() - Send a data command without waiting for the data
+	 *
+	 * This is optional. It returns once the command has been accepted;
+	 * the data is then transferred by DMA until poll_data() reports that
+	 * it is done.
+	 *
+	 * @dev:	Device to receive the command
+	 * @cmd:	Command to send
+	 * @data:	Data to transfer, which must stay valid until it is done
+	 * @return 0 if OK, -ENOSYS if the transfer cannot be done
+	 * asynchronously, other -ve on error
+	 */
+	int (*send_cmd_async)(struct udevice *dev, struct mmc_cmd *cmd,
+			      struct mmc_data *data);
+
+	/**
+	 * poll_data() - Check the data transfer started by send_cmd_async()
+	 *
+	 * @dev:	Device to check
+	 * @data:	Data passed to send_cmd_async()
+	 * @return -EBUSY while the transfer is in flight, 0 when it is done,
+	 * other -ve on error
+	 */
+	int (*poll_data)(struct udevice *dev, struct mmc_data *data);
+#endif
+
 	/**
 	 * set_ios() - Set the I/O speed/width for an MMC device
 	 *
@@ -551,6 +582,9 @@ int mmc_deferred_probe(struct mmc *mmc);
 int mmc_reinit(struct mmc *mmc);
 int mmc_get_b_max(struct mmc *mmc, void *dst, lbaint_t blkcnt);
 int mmc_hs400_prepare_ddr(struct mmc *mmc);
+int mmc_send_cmd_async(struct mmc *mmc, struct mmc_cmd *cmd,
+		       struct mmc_data *data);
+int mmc_poll_data(struct mmc *mmc, struct mmc_data *data);
 #else
 struct mmc_ops {
 	int (*send_cmd)(struct mmc *mmc,
@@ -579,6 +613,7 @@ struct mmc_config {
 	uint f_min;
 	uint f_max;
 	uint b_max;
+	uint max_segs;		/* Buffers per transfer, 0/1 if no SG support */
 	unsigned char part_type;
 #ifdef CONFIG_MMC_PWRSEQ
 	struct udevice *pwr_dev;
@@ -728,6 +763,11 @@ struct mmc {
 	u8 hs400_tuning;
 
 	enum bus_mode user_speed_mode; /* input speed mode from user */
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	struct mmc_data async_data;	/* Data of the transfer in flight */
+	bool async_prg;		/* Card is programming an async write */
+	ulong async_prg_start;	/* Time the card started programming */
+#endif
 };
 
 #if CONFIG_IS_ENABLED(DM_MMC)
@@ -9,6 +9,19 @@
 
 struct nvme_dev;
 
+/**
+ * struct nvme_io_stats - I/O statistics of an NVMe controller
+ *
+ * @cmds:	Number of commands sent
+ * @bytes:	Number of bytes transferred
+ * @time_us:	Time spent waiting for transfers, in microseconds
+ */
+struct nvme_io_stats {
+	u64 cmds;
+	u64 bytes;
+	u64 time_us;
+};
+
 /**
  * nvme_identify - identify controller or namespace capabilities and status
  *
@@ -90,4 +103,16 @@ int nvme_print_info(struct udevice *udev);
  */
 int nvme_get_namespace_id(struct udevice *udev, u32 *ns_id, u8 *eui64);
 
+/**
+ * nvme_print_stats - print the I/O statistics of an NVMe controller
+ *
+ * This prints the number of commands and bytes transferred, with the
+ * achieved IOPS and throughput, for reads and writes.
+ *
+ * @udev:	NVMe block device
+ * @reset:	true to reset the statistics after printing them
+ * @return:	0 on success, -ve on error
+ */
+int nvme_print_stats(struct udevice *udev, bool reset);
+
 #endif /* __NVME_H__ */
@@ -20,4 +20,26 @@ struct device_node;
  */
 int of_live_build(const void *fdt_blob, struct device_node **rootp);
 
+/**
+ * of_live_read_props() - set up the properties of a node of the live tree
+ *
+ * With CONFIG_OF_LIVE_LAZY this is called when the properties of a node are
+ * first needed, to read them from the flat tree the live tree was built
+ * from. Nothing is done if that has already happened.
+ *
+ * @np: Node to update
+ * Return: 0 if OK, -ENOMEM if out of memory
+ */
+int of_live_read_props(struct device_node *np);
+
+/**
+ * of_live_free() - free a live tree
+ *
+ * This frees a tree created by of_live_build(), including the properties read
+ * for its nodes. Nothing must use the tree afterwards.
+ *
+ * @root: Root node of the tree to free
+ */
+void of_live_free(struct device_node *root);
+
 #endif
@@ -9,6 +9,7 @@
 #ifndef __SDHCI_HW_H
 #define __SDHCI_HW_H
 
+#include <bouncebuf.h>
 #include <linux/bitops.h>
 #include <linux/types.h>
 #include <asm/io.h>
@@ -280,8 +281,16 @@ struct sdhci_ops {
 #else
 #define ADMA_DESC_LEN	8
 #endif
-#define ADMA_TABLE_NO_ENTRIES (CONFIG_SYS_MMC_MAX_BLK_COUNT * \
-			       MMC_MAX_BLOCK_LEN) / ADMA_MAX_LEN
+/* Maximum number of buffers in one scatter-gather transfer */
+#define SDHCI_ADMA_MAX_SEGS	16
+/*
+ * Each buffer of a transfer may need one entry more than the division gives:
+ * scatter-gather segments, or the bounced head and tail of a partially
+ * bounced buffer.
+ */
+#define ADMA_TABLE_NO_ENTRIES ((CONFIG_SYS_MMC_MAX_BLK_COUNT * \
+			       MMC_MAX_BLOCK_LEN) / ADMA_MAX_LEN + \
+			       SDHCI_ADMA_MAX_SEGS)
 
 #define ADMA_TABLE_SZ (ADMA_TABLE_NO_ENTRIES * ADMA_DESC_LEN)
 
@@ -328,6 +337,7 @@ struct sdhci_host {
 	void *align_buffer;
 	bool force_align_buffer;
 	dma_addr_t start_addr;
+	ulong async_start;		/* Start time of an async transfer */
 	int flags;
 #define USE_SDMA	(0x1 << 0)
 #define USE_ADMA	(0x1 << 1)
@@ -336,6 +346,10 @@ struct sdhci_host {
 	dma_addr_t adma_addr;
 #if CONFIG_IS_ENABLED(MMC_SDHCI_ADMA)
 	struct sdhci_adma_desc *adma_desc_table;
+#ifdef CONFIG_BOUNCE_BUFFER
+	struct bounce_buffer bbstate;	/* Misaligned ADMA transfer */
+	bool bb_active;
+#endif
 #endif
 };
 
@@ -510,5 +524,7 @@ extern const struct dm_mmc_ops sdhci_ops;
 struct sdhci_adma_desc *sdhci_adma_init(void);
 void sdhci_prepare_adma_table(struct sdhci_adma_desc *table,
 			      struct mmc_data *data, dma_addr_t addr);
+void sdhci_prepare_adma_table_segs(struct sdhci_adma_desc *table,
+				   const struct bounce_segment *seg, int nsegs);
 
 #endif /* __SDHCI_HW_H */
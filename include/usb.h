@@ -14,6 +14,7 @@
 #include <fdtdec.h>
 #include <usb_defs.h>
 #include <linux/usb/ch9.h>
+#include <linux/list.h>
 #include <asm/cache.h>
 #include <part.h>
 
@@ -156,6 +157,36 @@ struct usb_device {
 
 struct int_queue;
 
+/**
+ * struct usb_bulk_req - A bulk transfer queued without waiting for it
+ *
+ * This is used by class drivers which keep several transfers in flight, such
+ * as UAS, where each command has its own data and status transfers on a bulk
+ * stream. Fill in the first fields, submit it with usb_submit_bulk_req() and
+ * collect it with usb_wait_bulk_req(), or drop it with usb_cancel_bulk_req().
+ *
+ * @pipe:	Bulk pipe to transfer on
+ * @stream:	Stream ID to use, or 0 if the endpoint has no streams
+ * @buffer:	Data buffer, which must be DMA-aligned
+ * @length:	Number of bytes to transfer
+ * @actual:	Number of bytes transferred, once completed
+ * @status:	-EINPROGRESS while queued, then 0 or -ve error
+ * @node:	Entry in the host controller's list of queued requests
+ * @hcpriv:	Private to the host controller driver
+ * @hclast:	Private to the host controller driver
+ */
+struct usb_bulk_req {
+	unsigned long pipe;
+	unsigned int stream;
+	void *buffer;
+	int length;
+	int actual;
+	int status;
+	struct list_head node;
+	void *hcpriv;
+	void *hclast;
+};
+
 /*
  * You can initialize platform's USB host or device
  * ports by passing this enum as an argument to
@@ -271,6 +302,11 @@ int usb_int_msg(struct usb_device *dev, unsigned long pipe,
 		void *buffer, int transfer_len, int interval, bool nonblock);
 int usb_lock_async(struct usb_device *dev, int lock);
 int usb_disable_asynch(int disable);
+int usb_alloc_streams(struct usb_device *dev, unsigned long *pipes,
+		      int num_pipes, unsigned int num_streams);
+int usb_submit_bulk_req(struct usb_device *dev, struct usb_bulk_req *req);
+int usb_wait_bulk_req(struct usb_device *dev, struct usb_bulk_req *req);
+int usb_cancel_bulk_req(struct usb_device *dev, struct usb_bulk_req *req);
 int usb_maxpacket(struct usb_device *dev, unsigned long pipe);
 int usb_get_configuration_no(struct usb_device *dev, int cfgno,
 			unsigned char *buffer, int length);
@@ -802,6 +838,52 @@ struct dm_usb_ops {
 	 * driver to do just that.
 	 */
 	int (*lock_async)(struct udevice *udev, int lock);
+
+	/**
+	 * alloc_streams() - Set up bulk streams on a set of endpoints
+	 *
+	 * Streams are allocated on all endpoints in one go, since a device
+	 * class such as UAS uses the same stream IDs on each of them.
+	 *
+	 * @pipes:	Bulk pipes of the endpoints to set up
+	 * @num_pipes:	Number of entries in @pipes
+	 * @num_streams: Number of streams wanted, not counting stream 0
+	 * @return number of usable streams (numbered from 1), or -ve on error
+	 */
+	int (*alloc_streams)(struct udevice *bus, struct usb_device *udev,
+			     unsigned long *pipes, int num_pipes,
+			     unsigned int num_streams);
+
+	/**
+	 * submit_bulk_req() - Queue a bulk transfer and return at once
+	 *
+	 * @req:	Request to queue, see struct usb_bulk_req
+	 * @return 0 if queued, -ve on error
+	 */
+	int (*submit_bulk_req)(struct udevice *bus, struct usb_device *udev,
+			       struct usb_bulk_req *req);
+
+	/**
+	 * wait_bulk_req() - Wait for a queued bulk transfer to complete
+	 *
+	 * Other queued requests which complete meanwhile are updated too.
+	 *
+	 * @req:	Request to wait for
+	 * @return 0 if the transfer completed without error, -ve on error
+	 */
+	int (*wait_bulk_req)(struct udevice *bus, struct usb_device *udev,
+			     struct usb_bulk_req *req);
+
+	/**
+	 * cancel_bulk_req() - Throw away a queued bulk transfer
+	 *
+	 * Other queued requests on the same endpoint carry on.
+	 *
+	 * @req:	Request to cancel, which then has status -ECONNRESET
+	 * @return 0 if cancelled, else the status of the completed request
+	 */
+	int (*cancel_bulk_req)(struct udevice *bus, struct usb_device *udev,
+			       struct usb_bulk_req *req);
 };
 
 #define usb_get_ops(dev)	((struct dm_usb_ops *)(dev)->driver->ops)
@@ -141,6 +141,8 @@ struct xhci_hccr {
 #define HCC_NSS(p)		((p) & (1 << 7))
 /* Max size for Primary Stream Arrays - 2^(n+1), where n is bits 12:15 */
 #define HCC_MAX_PSA(p)		(1 << ((((p) >> 12) & 0xf) + 1))
+/* true: HC supports stream arrays at all (MaxPSASize is not 0) */
+#define HCC_HAS_PSA(p)		(((p) >> 12) & 0xf)
 /* Extended Capabilities pointer from PCI base - section 5.3.6 */
 #define HCC_EXT_CAPS(p)		XHCI_HCC_EXT_CAPS(p)
 
@@ -667,6 +669,24 @@ struct xhci_ep_ctx {
 #define EP_BPKTS(p)	(((p) & 0x7f) << 0)
 #define EP_BBM(p)	(((p) & 0x1) << 11)
 
+/**
+ * struct xhci_stream_ctx
+ * Stream context; see section 6.2.4.1.
+ *
+ * @stream_ring:	64-bit stream ring address, cycle state and stream
+ *			context type.
+ */
+struct xhci_stream_ctx {
+	__le64	stream_ring;
+	/* offset 0x8 - 0xf reserved for HC internal use */
+	__le32	reserved[2];
+};
+
+/* Stream Context Types - section 6.4.1 - bits 3:1 of stream ctx deq ptr */
+#define SCT_FOR_CTX(p)		(((p) & 0x7) << 1)
+/* Primary stream array type, dequeue pointer is to a transfer ring */
+#define SCT_PRI_TR		1
+
 /**
  * struct xhci_input_control_context
  * Input control context; see section 6.2.5.
@@ -1051,6 +1071,10 @@ struct xhci_scratchpad {
 
 struct xhci_virt_ep {
 	struct xhci_ring		*ring;
+	/* Primary stream array and rings, if streams are set up */
+	struct xhci_stream_ctx		*stream_ctx;
+	struct xhci_ring		**stream_rings;
+	unsigned int			num_streams;
 	unsigned int			ep_state;
 #define SET_DEQ_PENDING		(1 << 0)
 #define EP_HALTED		(1 << 1)	/* For stall handling */
@@ -1215,6 +1239,8 @@ struct xhci_ctrl {
 	struct xhci_scratchpad *scratchpad;
 	struct xhci_virt_device *devs[MAX_HC_SLOTS];
 	int rootdev;
+	/* Bulk requests queued by xhci_bulk_req_submit(), oldest first */
+	struct list_head bulk_reqs;
 	u16 hci_version;
 	u32 quirks;
 #define XHCI_MTK_HOST		BIT(0)
@@ -1251,12 +1277,17 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 		 int length, void *buffer);
 int xhci_ctrl_tx(struct usb_device *udev, unsigned long pipe,
 		 struct devrequest *req, int length, void *buffer);
+int xhci_bulk_req_submit(struct usb_device *udev, struct usb_bulk_req *req);
+int xhci_bulk_req_wait(struct usb_device *udev, struct usb_bulk_req *req);
+int xhci_bulk_req_cancel(struct usb_device *udev, struct usb_bulk_req *req);
 int xhci_check_maxpacket(struct usb_device *udev);
 void xhci_flush_cache(uintptr_t addr, u32 type_len);
 void xhci_inval_cache(uintptr_t addr, u32 type_len);
 void xhci_cleanup(struct xhci_ctrl *ctrl);
 struct xhci_ring *xhci_ring_alloc(struct xhci_ctrl *ctrl, unsigned int num_segs,
 				  bool link_trbs);
+struct xhci_stream_ctx *xhci_stream_ctx_alloc(unsigned int num_streams);
+void xhci_free_streams(struct xhci_virt_ep *ep);
 int xhci_alloc_virt_device(struct xhci_ctrl *ctrl, unsigned int slot_id);
 int xhci_mem_init(struct xhci_ctrl *ctrl, struct xhci_hccr *hccr,
 		  struct xhci_hcor *hcor);
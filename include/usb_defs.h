@@ -45,6 +45,7 @@
 #define US_PR_CB               1		/* Control/Bulk w/o interrupt */
 #define US_PR_CBI              0		/* Control/Bulk/Interrupt */
 #define US_PR_BULK             0x50		/* bulk only */
+#define US_PR_UAS              0x62		/* USB Attached SCSI */
 
 /* USB types */
 #define USB_TYPE_STANDARD   (0x00 << 5)
@@ -34,6 +34,9 @@
 /* We support indirect buffer descriptors */
 #define VIRTIO_RING_F_INDIRECT_DESC	28
 
+/* Longest chain which is put into an indirect table, others use the ring */
+#define VIRTQUEUE_MAX_INDIRECT		8
+
 /*
  * The Guest publishes the used index for which it expects an interrupt
  * at the end of the avail ring. Host should ignore the avail->flags field.
@@ -90,6 +93,8 @@ struct vring {
  * @num_free: number of elements we expect to be able to fit
  * @vring: actual memory layout for this queue
  * @event: host publishes avail event idx
+ * @indirect: chains of several buffers may use indirect descriptors
+ * @indirect_desc: indirect tables, VIRTQUEUE_MAX_INDIRECT entries per head
  * @free_head: head of free buffer list
  * @num_added: number we've added since last sync
  * @last_used_idx: last used index we've seen
@@ -103,6 +108,8 @@ struct virtqueue {
 	unsigned int num_free;
 	struct vring vring;
 	bool event;
+	bool indirect;
+	struct vring_desc *indirect_desc;
 	unsigned int free_head;
 	unsigned int num_added;
 	u16 last_used_idx;
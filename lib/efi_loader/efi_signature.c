@@ -146,6 +146,63 @@ static bool efi_hash_regions(struct image_region *regs, int count,
 	return true;
 }
 
+/**
+ * efi_sig_data_get_cert - get the x509 certificate held in a signature
+ * @sig_data:	Signature data
+ *
+ * The certificate is parsed on first use and kept in @sig_data until the
+ * signature store is freed.
+ *
+ * Return:	Pointer to certificate, NULL if it cannot be parsed
+ */
+static struct x509_certificate *
+efi_sig_data_get_cert(struct efi_sig_data *sig_data)
+{
+	if (!sig_data->cert) {
+		sig_data->cert = x509_cert_parse(sig_data->data,
+						 sig_data->size);
+		if (!sig_data->cert)
+			sig_data->cert = ERR_PTR(-EINVAL);
+	}
+	if (IS_ERR(sig_data->cert)) {
+		EFI_PRINT("Cannot parse x509 certificate\n");
+		return NULL;
+	}
+
+	return sig_data->cert;
+}
+
+/**
+ * efi_sig_data_get_cert_hash - get the hash of a certificate's TBSCertificate
+ * @sig_data:	Signature data holding an x509 certificate
+ *
+ * The hash is calculated on first use and kept in @sig_data until the
+ * signature store is freed.
+ *
+ * Return:	Pointer to sha256 hash value, NULL on error
+ */
+static void *efi_sig_data_get_cert_hash(struct efi_sig_data *sig_data)
+{
+	struct x509_certificate *cert;
+	struct image_region reg[1];
+
+	if (sig_data->cert_hash)
+		return sig_data->cert_hash;
+
+	cert = efi_sig_data_get_cert(sig_data);
+	if (!cert)
+		return NULL;
+
+	reg[0].data = cert->tbs;
+	reg[0].size = cert->tbs_size;
+	if (!efi_hash_regions(reg, 1, &sig_data->cert_hash, NULL)) {
+		free(sig_data->cert_hash);
+		sig_data->cert_hash = NULL;
+	}
+
+	return sig_data->cert_hash;
+}
+
 /**
  * hash_algo_supported - check if the requested hash algorithm is supported
  * @guid: guid of the algorithm
@@ -232,16 +289,13 @@ bool efi_signature_lookup_digest(struct efi_image_regions *regs,
 			if (sig_data->size == size &&
 			    !memcmp(sig_data->data, hash, size)) {
 				found = true;
-				free(hash);
 				goto out;
 			}
 		}
-
-		free(hash);
-		hash = NULL;
 	}
 
 out:
+	free(hash);
 	EFI_PRINT("%s: Exit, found: %d\n", __func__, found);
 	return found;
 }
@@ -262,7 +316,7 @@ static bool efi_lookup_certificate(struct x509_certificate *cert,
 	struct efi_signature_store *siglist;
 	struct efi_sig_data *sig_data;
 	struct image_region reg[1];
-	void *hash = NULL, *hash_tmp = NULL;
+	void *hash = NULL, *hash_tmp;
 	size_t size = 0;
 	bool found = false;
 
@@ -289,22 +343,12 @@ static bool efi_lookup_certificate(struct x509_certificate *cert,
 
 		for (sig_data = siglist->sig_data_list; sig_data;
 		     sig_data = sig_data->next) {
-			struct x509_certificate *cert_tmp;
-
-			cert_tmp = x509_cert_parse(sig_data->data,
-						   sig_data->size);
-			if (IS_ERR_OR_NULL(cert_tmp))
+			hash_tmp = efi_sig_data_get_cert_hash(sig_data);
+			if (!hash_tmp)
 				continue;
 
 			EFI_PRINT("%s: against %s\n", __func__,
-				  cert_tmp->subject);
-			reg[0].data = cert_tmp->tbs;
-			reg[0].size = cert_tmp->tbs_size;
-			if (!efi_hash_regions(reg, 1, &hash_tmp, NULL))
-				goto out;
-
-			x509_free_certificate(cert_tmp);
-
+				  sig_data->cert->subject);
 			if (!memcmp(hash, hash_tmp, size)) {
 				found = true;
 				goto out;
@@ -313,7 +357,6 @@ static bool efi_lookup_certificate(struct x509_certificate *cert,
 	}
 out:
 	free(hash);
-	free(hash_tmp);
 
 	EFI_PRINT("%s: Exit, found: %d\n", __func__, found);
 	return found;
@@ -327,6 +370,7 @@ out:
  *
  * Determine if certificate pointed to by @signer may be verified
  * by one of certificates in signature database pointed to by @db.
+ * The certificate returned in @root belongs to @db and must not be freed.
  *
  * Return:	true if certificate is verified, false otherwise.
  */
@@ -352,11 +396,9 @@ static bool efi_verify_certificate(struct x509_certificate *signer,
 
 		for (sig_data = siglist->sig_data_list; sig_data;
 		     sig_data = sig_data->next) {
-			cert = x509_cert_parse(sig_data->data, sig_data->size);
-			if (IS_ERR_OR_NULL(cert)) {
-				EFI_PRINT("Cannot parse x509 certificate\n");
+			cert = efi_sig_data_get_cert(sig_data);
+			if (!cert)
 				continue;
-			}
 
 			ret = public_key_verify_signature(cert->pub,
 							  signer->sig);
@@ -364,11 +406,8 @@ static bool efi_verify_certificate(struct x509_certificate *signer,
 				verified = true;
 				if (root)
 					*root = cert;
-				else
-					x509_free_certificate(cert);
 				goto out;
 			}
-			x509_free_certificate(cert);
 		}
 	}
 
@@ -410,16 +449,17 @@ static bool efi_signature_check_revocation(struct pkcs7_signed_info *sinfo,
 		goto out;
 
 	EFI_PRINT("Checking revocation against %s\n", cert->subject);
+
+	/* calculate hash of TBSCertificate */
+	reg[0].data = cert->tbs;
+	reg[0].size = cert->tbs_size;
+	if (!efi_hash_regions(reg, 1, &hash, &size))
+		goto out;
+
 	for (siglist = dbx; siglist; siglist = siglist->next) {
 		if (guidcmp(&siglist->sig_type, &efi_guid_cert_x509_sha256))
 			continue;
 
-		/* calculate hash of TBSCertificate */
-		reg[0].data = cert->tbs;
-		reg[0].size = cert->tbs_size;
-		if (!efi_hash_regions(reg, 1, &hash, &size))
-			goto out;
-
 		for (sig_data = siglist->sig_data_list; sig_data;
 		     sig_data = sig_data->next) {
 			/*
@@ -449,13 +489,11 @@ static bool efi_signature_check_revocation(struct pkcs7_signed_info *sinfo,
 			 */
 
 			revoked = true;
-			free(hash);
 			goto out;
 		}
-		free(hash);
-		hash = NULL;
 	}
 out:
+	free(hash);
 	EFI_PRINT("%s: Exit, revoked: %d\n", __func__, revoked);
 	return !revoked;
 }
@@ -528,7 +566,6 @@ bool efi_signature_verify(struct efi_image_regions *regs,
 
 			check = efi_signature_check_revocation(sinfo, root,
 							       dbx);
-			x509_free_certificate(root);
 			if (check)
 				break;
 		}
@@ -582,18 +619,25 @@ out:
  *
  * Feee all the memories held in signature store and itself,
  * which were allocated by efi_sigstore_parse_sigdb().
+ * A cached store is only freed once its last user has released it.
  */
 void efi_sigstore_free(struct efi_signature_store *sigstore)
 {
 	struct efi_signature_store *sigstore_next;
 	struct efi_sig_data *sig_data, *sig_data_next;
 
+	if (sigstore && sigstore->refcnt && --sigstore->refcnt)
+		return;
+
 	while (sigstore) {
 		sigstore_next = sigstore->next;
 
 		sig_data = sigstore->sig_data_list;
 		while (sig_data) {
 			sig_data_next = sig_data->next;
+			if (!IS_ERR_OR_NULL(sig_data->cert))
+				x509_free_certificate(sig_data->cert);
+			free(sig_data->cert_hash);
 			free(sig_data->data);
 			free(sig_data);
 			sig_data = sig_data_next;
@@ -674,8 +718,7 @@ efi_sigstore_parse_siglist(struct efi_signature_list *esl)
 			goto err;
 		}
 
-		sig_data = calloc(esl->signature_size
-					- sizeof(esd->signature_owner), 1);
+		sig_data = calloc(sizeof(*sig_data), 1);
 		if (!sig_data) {
 			EFI_PRINT("Out of memory\n");
 			goto err;
@@ -768,12 +811,91 @@ err:
 	return NULL;
 }
 
+/**
+ * struct efi_sigstore_cache - a cached signature database
+ *
+ * @store:	Signature store built from the variable, NULL if the
+ *		variable does not exist
+ * @hash:	sha256 hash of the variable's value when @store was built
+ * @valid:	true if the variable has not been set since it was read
+ */
+struct efi_sigstore_cache {
+	struct efi_signature_store *store;
+	u8 hash[SHA256_SUM_LEN];
+	bool valid;
+};
+
+static struct efi_sigstore_cache sigstore_cache[EFI_AUTH_VAR_DBR + 1];
+
+#if IS_ENABLED(CONFIG_EFI_SIGSTORE_CACHE)
+void efi_sigstore_cache_invalidate(const u16 *name, const efi_guid_t *vendor)
+{
+	enum efi_auth_var_type type;
+
+	type = efi_auth_var_get_type(name, vendor);
+	if (type >= EFI_AUTH_VAR_PK)
+		sigstore_cache[type].valid = false;
+}
+#endif
+
+/**
+ * efi_sigstore_cache_get - get a signature database from the cache
+ * @name:	Variable's name
+ * @vendor:	Variable's vendor GUID
+ *
+ * The variable is only read again if it has been set since the store was
+ * built, and only parsed again if its value has changed.
+ *
+ * Return:	Pointer to signature store on success, NULL on error
+ */
+static struct efi_signature_store *
+efi_sigstore_cache_get(u16 *name, const efi_guid_t *vendor)
+{
+	struct efi_sigstore_cache *cache;
+	struct efi_signature_store *store;
+	u8 hash[SHA256_SUM_LEN];
+	efi_uintn_t db_size;
+	void *db;
+
+	cache = &sigstore_cache[efi_auth_var_get_type(name, vendor)];
+	if (!cache->valid) {
+		db = efi_get_var(name, vendor, &db_size);
+		if (db)
+			sha256_csum_wd(db, db_size, hash, CHUNKSZ_SHA256);
+		if (!db || !cache->store || memcmp(hash, cache->hash,
+						   sizeof(hash))) {
+			efi_sigstore_free(cache->store);
+			cache->store = NULL;
+		}
+		if (db && !cache->store) {
+			store = efi_build_signature_store(db, db_size);
+			if (!store)
+				return NULL;
+			store->refcnt = 1;
+			cache->store = store;
+			memcpy(cache->hash, hash, sizeof(hash));
+		} else {
+			free(db);
+		}
+		cache->valid = true;
+	}
+
+	if (!cache->store) {
+		EFI_PRINT("variable, %ls, not found\n", name);
+		return calloc(sizeof(struct efi_signature_store), 1);
+	}
+	cache->store->refcnt++;
+
+	return cache->store;
+}
+
 /**
  * efi_sigstore_parse_sigdb - parse a signature database variable
  * @name:	Variable's name
  *
  * Read in a value of signature database variable pointed to by
  * @name, parse it and instantiate a signature store structure.
+ * The store must be released with efi_sigstore_free().
  *
  * Return:	Pointer to signature store on success, NULL on error
  */
@@ -784,6 +906,10 @@ struct efi_signature_store *efi_sigstore_parse_sigdb(u16 *name)
 	efi_uintn_t db_size;
 
 	vendor = efi_auth_var_get_guid(name);
+	if (IS_ENABLED(CONFIG_EFI_SIGSTORE_CACHE) &&
+	    efi_auth_var_get_type(name, vendor) >= EFI_AUTH_VAR_PK)
+		return efi_sigstore_cache_get(name, vendor);
+
 	db = efi_get_var(name, vendor, &db_size);
 	if (!db) {
 		EFI_PRINT("variable, %ls, not found\n", name);
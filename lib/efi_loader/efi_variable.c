@@ -325,6 +325,7 @@ efi_status_t efi_set_variable_int(const u16 *variable_name,
 				      data_size, data, 0, NULL, time);
 	}
 	efi_var_mem_del(var);
+	efi_sigstore_cache_invalidate(variable_name, vendor);
 
 	if (ret != EFI_SUCCESS)
 		return ret;
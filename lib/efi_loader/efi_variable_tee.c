@@ -575,6 +575,7 @@ efi_status_t efi_set_variable_int(const u16 *variable_name,
 	ret = mm_communicate(comm_buf, payload_size);
 	if (ret != EFI_SUCCESS)
 		alt_ret = ret;
+	efi_sigstore_cache_invalidate(variable_name, vendor);
 
 	if (ro && !(var_property.property & VAR_CHECK_VARIABLE_PROPERTY_READ_ONLY)) {
 		var_property.revision = VAR_CHECK_VARIABLE_PROPERTY_REVISION;
@@ -24,6 +24,7 @@
 #include <asm/global_data.h>
 #include <asm/sections.h>
 #include <linux/ctype.h>
+#include <linux/log2.h>
 #include <linux/lzo.h>
 #include <linux/ioport.h>
 
@@ -108,7 +109,7 @@ fdt_addr_t fdtdec_get_addr_size_fixed(const void *blob, int node,
 
 	debug("%s: %s: ", __func__, prop_name);
 
-	prop = fdt_getprop(blob, node, prop_name, &len);
+	prop = fdtdec_getprop(blob, node, prop_name, &len);
 	if (!prop) {
 		debug("(not found)\n");
 		return FDT_ADDR_T_NONE;
@@ -208,7 +209,7 @@ int fdtdec_get_pci_vendev(const void *blob, int node, u16 *vendor, u16 *device)
 	const char *list, *end;
 	int len;
 
-	list = fdt_getprop(blob, node, "compatible", &len);
+	list = fdtdec_getprop(blob, node, "compatible", &len);
 	if (!list)
 		return -ENOENT;
 
@@ -269,7 +270,7 @@ int fdtdec_get_pci_bus_range(const void *blob, int node,
 	const u32 *values;
 	int len;
 
-	values = fdt_getprop(blob, node, "bus-range", &len);
+	values = fdtdec_getprop(blob, node, "bus-range", &len);
 	if (!values || len < sizeof(*values) * 2)
 		return -EINVAL;
 
@@ -285,7 +286,7 @@ uint64_t fdtdec_get_uint64(const void *blob, int node, const char *prop_name,
 	const unaligned_fdt64_t *cell64;
 	int length;
 
-	cell64 = fdt_getprop(blob, node, prop_name, &length);
+	cell64 = fdtdec_getprop(blob, node, prop_name, &length);
 	if (!cell64 || length < sizeof(*cell64))
 		return default_val;
 
@@ -303,7 +304,7 @@ int fdtdec_get_is_enabled(const void *blob, int node)
 	 *
 	 * http://www.mail-archive.com/u-boot@lists.denx.de/msg71598.html
 	 */
-	cell = fdt_getprop(blob, node, "status", NULL);
+	cell = fdtdec_getprop(blob, node, "status", NULL);
 	if (cell)
 		return strcmp(cell, "okay") == 0;
 	return 1;
@@ -351,7 +352,7 @@ int fdtdec_next_alias(const void *blob, const char *name, enum fdt_compat_id id,
 	/* snprintf() is not available */
 	assert(strlen(name) < MAX_STR_LEN);
 	sprintf(str, "%.*s%d", MAX_STR_LEN, name, *upto);
-	node = fdt_path_offset(blob, str);
+	node = fdtdec_path_offset(blob, str);
 	if (node < 0)
 		return node;
 	err = fdt_node_check_compatible(blob, node, compat_names[id]);
@@ -386,7 +387,7 @@ int fdtdec_add_aliases_for_id(const void *blob, const char *name,
 	int i, j;
 
 	/* find the alias node if present */
-	alias_node = fdt_path_offset(blob, "/aliases");
+	alias_node = fdtdec_path_offset(blob, "/aliases");
 
 	/*
 	 * start with nothing, and we can assume that the root node can't
@@ -417,7 +418,7 @@ int fdtdec_add_aliases_for_id(const void *blob, const char *name,
 		prop = fdt_get_property_by_offset(blob, offset, NULL);
 		path = fdt_string(blob, fdt32_to_cpu(prop->nameoff));
 		if (prop->len && 0 == strncmp(path, name, name_len))
-			node = fdt_path_offset(blob, prop->data);
+			node = fdtdec_path_offset(blob, prop->data);
 		if (node <= 0)
 			continue;
 
@@ -500,7 +501,7 @@ int fdtdec_get_alias_seq(const void *blob, const char *base, int offset,
 	find_name = fdt_get_name(blob, offset, &find_namelen);
 	debug("Looking for '%s' at %d, name %s\n", base, offset, find_name);
 
-	aliases = fdt_path_offset(blob, "/aliases");
+	aliases = fdtdec_path_offset(blob, "/aliases");
 	for (prop_offset = fdt_first_property_offset(blob, aliases);
 	     prop_offset > 0;
 	     prop_offset = fdt_next_property_offset(blob, prop_offset)) {
@@ -525,7 +526,8 @@ int fdtdec_get_alias_seq(const void *blob, const char *base, int offset,
 		 */
 		if (IS_ENABLED(CONFIG_PHANDLE_CHECK_SEQ)) {
 			if (fdt_get_phandle(blob, offset) !=
-			    fdt_get_phandle(blob, fdt_path_offset(blob, prop)))
+			    fdt_get_phandle(blob,
+					    fdtdec_path_offset(blob, prop)))
 				continue;
 		}
 
@@ -550,7 +552,7 @@ int fdtdec_get_alias_highest_id(const void *blob, const char *base)
 
 	debug("Looking for highest alias id for '%s'\n", base);
 
-	aliases = fdt_path_offset(blob, "/aliases");
+	aliases = fdtdec_path_offset(blob, "/aliases");
 	for (prop_offset = fdt_first_property_offset(blob, aliases);
 	     prop_offset > 0;
 	     prop_offset = fdt_next_property_offset(blob, prop_offset)) {
@@ -580,8 +582,8 @@ const char *fdtdec_get_chosen_prop(const void *blob, const char *name)
 
 	if (!blob)
 		return NULL;
-	chosen_node = fdt_path_offset(blob, "/chosen");
-	return fdt_getprop(blob, chosen_node, name, NULL);
+	chosen_node = fdtdec_path_offset(blob, "/chosen");
+	return fdtdec_getprop(blob, chosen_node, name, NULL);
 }
 
 int fdtdec_get_chosen_node(const void *blob, const char *name)
@@ -591,7 +593,7 @@ int fdtdec_get_chosen_node(const void *blob, const char *name)
 	prop = fdtdec_get_chosen_prop(blob, name);
 	if (!prop)
 		return -FDT_ERR_NOTFOUND;
-	return fdt_path_offset(blob, prop);
+	return fdtdec_path_offset(blob, prop);
 }
 
 int fdtdec_check_fdt(void)
@@ -633,17 +635,391 @@ int fdtdec_prepare_fdt(void)
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(OF_PHANDLE_CACHE)
+/*
+ * Node offset + 1 for each phandle of the control FDT, 0 if not known. The
+ * table is filled in by the first phandle lookup, which is normally made by
+ * a pre-relocation driver (clocks, pinctrl) at a point where BSS may still
+ * overlap the control FDT itself.
+ */
+static struct {
+	const void *blob;
+	int offset[CONFIG_OF_PHANDLE_CACHE_SIZE];
+} phandle_cache __section(".data");
+
+static void fdtdec_phandle_cache_build(const void *blob)
+{
+	uint32_t phandle;
+	int offset;
+
+	memset(&phandle_cache, '\0', sizeof(phandle_cache));
+	for (offset = fdt_next_node(blob, -1, NULL); offset >= 0;
+	     offset = fdt_next_node(blob, offset, NULL)) {
+		phandle = fdt_get_phandle(blob, offset);
+		if (phandle && phandle < ARRAY_SIZE(phandle_cache.offset))
+			phandle_cache.offset[phandle] = offset + 1;
+	}
+	phandle_cache.blob = blob;
+}
+
+/* Look up a phandle in the cache, returns -1 if it is not there */
+static int fdtdec_phandle_cache_lookup(const void *blob, uint phandle)
+{
+	int offset;
+
+	if (blob != phandle_cache.blob)
+		fdtdec_phandle_cache_build(blob);
+	offset = phandle_cache.offset[phandle] - 1;
+
+	/* The tree may have changed since, e.g. by applying an overlay */
+	if (offset >= 0 && fdt_get_phandle(blob, offset) != phandle) {
+		fdtdec_phandle_cache_build(blob);
+		offset = phandle_cache.offset[phandle] - 1;
+	}
+
+	return offset;
+}
+
+void fdtdec_phandle_cache_reset(void)
+{
+	phandle_cache.blob = NULL;
+}
+#endif
+
+int fdtdec_node_offset_by_phandle(const void *blob, uint phandle)
+{
+#if CONFIG_IS_ENABLED(OF_PHANDLE_CACHE)
+	if (blob == gd->fdt_blob && phandle &&
+	    phandle < ARRAY_SIZE(phandle_cache.offset)) {
+		int offset = fdtdec_phandle_cache_lookup(blob, phandle);
+
+		if (offset >= 0)
+			return offset;
+	}
+#endif
+
+	return fdt_node_offset_by_phandle(blob, phandle);
+}
+
+#if CONFIG_IS_ENABLED(OF_FLAT_INDEX)
+/* Deepest node nesting which can be indexed */
+#define FDT_INDEX_MAX_DEPTH	32
+
+/**
+ * struct fdt_index_ent - Entry in the index of the control FDT
+ *
+ * Entries are hashed by @parent and the name of the node or property, which
+ * for nodes is the name without the unit address. The name is always checked
+ * against the tree when looking up an entry.
+ *
+ * @parent: Offset of the node containing the node or property
+ * @offset: Offset of the node or property, 0 if the slot is empty
+ */
+struct fdt_index_ent {
+	u32 parent;
+	u32 offset;
+};
+
+/*
+ * Index of the nodes and properties of the control FDT. It is normally built
+ * by the first lookup in board_init_f() and with OF_SEPARATE the control FDT
+ * lies where BSS starts until relocation, so this must be in .data.
+ *
+ * @blob: FDT which is indexed, NULL if none
+ * @size_struct: Size of the structure block when indexed
+ * @size_strings: Size of the strings block when indexed
+ * @ent: Hash table, NULL if it could not be built for @blob
+ * @mask: Number of entries in @ent - 1
+ * @full_malloc: true if @ent was allocated from the full malloc() heap
+ */
+static struct {
+	const void *blob;
+	int size_struct;
+	int size_strings;
+	struct fdt_index_ent *ent;
+	uint mask;
+	bool full_malloc;
+} fdt_index __section(".data");
+
+static uint fdt_index_hash(uint parent, const char *name, int len)
+{
+	uint hash = parent * 0x9e3779b1;
+
+	while (len--)
+		hash = (hash ^ *name++) * 0x01000193;
+
+	return hash ^ (hash >> 16);
+}
+
+static int fdt_index_basename_len(const char *name, int len)
+{
+	const char *at = memchr(name, '@', len);
+
+	return at ? at - name : len;
+}
+
+static void fdt_index_add(struct fdt_index_ent *ent, uint mask, uint parent,
+			  uint offset, const char *name, int len)
+{
+	uint slot = fdt_index_hash(parent, name, len) & mask;
+
+	while (ent[slot].offset)
+		slot = (slot + 1) & mask;
+	ent[slot].parent = parent;
+	ent[slot].offset = offset;
+}
+
+/*
+ * Walk the tree, adding each node and property to @ent if not NULL. Returns
+ * the number of entries, or -ve on error.
+ */
+static int fdt_index_walk(const void *blob, struct fdt_index_ent *ent,
+			  uint mask)
+{
+	int parent[FDT_INDEX_MAX_DEPTH];
+	int offset, next, depth = -1;
+	int count = 0;
+	const char *name;
+	uint32_t tag;
+	int len;
+
+	for (offset = 0;; offset = next) {
+		tag = fdt_next_tag(blob, offset, &next);
+		if (tag == FDT_END)
+			return next < 0 ? next : count;
+
+		switch (tag) {
+		case FDT_BEGIN_NODE:
+			if (depth >= 0) {
+				if (ent) {
+					name = fdt_get_name(blob, offset, &len);
+					len = fdt_index_basename_len(name, len);
+					fdt_index_add(ent, mask, parent[depth],
+						      offset, name, len);
+				}
+				count++;
+			}
+			if (++depth == FDT_INDEX_MAX_DEPTH)
+				return -FDT_ERR_BADSTRUCTURE;
+			parent[depth] = offset;
+			break;
+		case FDT_END_NODE:
+			if (--depth < -1)
+				return -FDT_ERR_BADSTRUCTURE;
+			break;
+		case FDT_PROP:
+			if (depth < 0)
+				return -FDT_ERR_BADSTRUCTURE;
+			if (ent) {
+				fdt_getprop_by_offset(blob, offset, &name,
+						      NULL);
+				fdt_index_add(ent, mask, parent[depth], offset,
+					      name, strlen(name));
+			}
+			count++;
+			break;
+		}
+	}
+}
+
+static int fdt_index_build(const void *blob)
+{
+	bool full_malloc = gd->flags & GD_FLG_FULL_MALLOC_INIT;
+	struct fdt_index_ent *ent;
+	uint size;
+	int count;
+
+	fdtdec_index_reset();
+	fdt_index.blob = blob;
+	fdt_index.size_struct = fdt_size_dt_struct(blob);
+	fdt_index.size_strings = fdt_size_dt_strings(blob);
+	fdt_index.full_malloc = full_malloc;
+
+	count = fdt_index_walk(blob, NULL, 0);
+	if (count <= 0)
+		return -EINVAL;
+
+	/* Keep the table at most three-quarters full */
+	size = roundup_pow_of_two(count + count / 3 + 1);
+#if CONFIG_VAL(SYS_MALLOC_F_LEN)
+	/* Leave most of the early heap for the devices */
+	if (!full_malloc &&
+	    size * sizeof(*ent) > (gd->malloc_limit - gd->malloc_ptr) / 4)
+		return -ENOSPC;
+#endif
+	ent = calloc(size, sizeof(*ent));
+	if (!ent)
+		return -ENOMEM;
+	fdt_index_walk(blob, ent, size - 1);
+	fdt_index.ent = ent;
+	fdt_index.mask = size - 1;
+
+	return 0;
+}
+
+/* Check whether lookups in @blob can use the index, building it if needed */
+static bool fdt_index_ready(const void *blob)
+{
+	if (!blob || blob != gd->fdt_blob)
+		return false;
+
+	/*
+	 * libfdt drops the index when it changes the structure of the tree
+	 * (see fdtdec_index_changed()). The size check catches a new tree
+	 * copied over the old one.
+	 */
+	if (blob == fdt_index.blob &&
+	    fdt_size_dt_struct(blob) == fdt_index.size_struct &&
+	    fdt_size_dt_strings(blob) == fdt_index.size_strings) {
+		/* Try again once there is more memory */
+		if (fdt_index.ent || fdt_index.full_malloc ||
+		    !(gd->flags & GD_FLG_FULL_MALLOC_INIT))
+			return fdt_index.ent;
+	}
+
+	return !fdt_index_build(blob);
+}
+
+static bool fdt_index_nodename_eq(const void *blob, int offset,
+				  const char *name, int len)
+{
+	const char *p;
+	int olen;
+
+	p = fdt_get_name(blob, offset, &olen);
+	if (!p || olen < len || memcmp(p, name, len))
+		return false;
+
+	return !p[len] || (p[len] == '@' && !memchr(name, '@', len));
+}
+
+void fdtdec_index_reset(void)
+{
+	if (fdt_index.full_malloc)
+		free(fdt_index.ent);
+	memset(&fdt_index, '\0', sizeof(fdt_index));
+}
+
+void fdtdec_index_changed(const void *blob)
+{
+	if (blob == fdt_index.blob)
+		fdtdec_index_reset();
+}
+#endif
+
+const void *fdtdec_getprop(const void *blob, int node, const char *name,
+			   int *lenp)
+{
+#if CONFIG_IS_ENABLED(OF_FLAT_INDEX)
+	if (node >= 0 && fdt_index_ready(blob)) {
+		const struct fdt_index_ent *ent = fdt_index.ent;
+		uint slot = fdt_index_hash(node, name, strlen(name));
+		const char *pname;
+		const void *val;
+
+		for (slot &= fdt_index.mask; ent[slot].offset;
+		     slot = (slot + 1) & fdt_index.mask) {
+			if (ent[slot].parent != node)
+				continue;
+			val = fdt_getprop_by_offset(blob, ent[slot].offset,
+						    &pname, lenp);
+			if (val && !strcmp(pname, name))
+				return val;
+		}
+		if (lenp)
+			*lenp = -FDT_ERR_NOTFOUND;
+
+		return NULL;
+	}
+#endif
+
+	return fdt_getprop(blob, node, name, lenp);
+}
+
+int fdtdec_subnode_offset_namelen(const void *blob, int parent,
+				  const char *name, int namelen)
+{
+#if CONFIG_IS_ENABLED(OF_FLAT_INDEX)
+	if (parent >= 0 && fdt_index_ready(blob)) {
+		const struct fdt_index_ent *ent = fdt_index.ent;
+		uint slot;
+
+		slot = fdt_index_hash(parent, name,
+				      fdt_index_basename_len(name, namelen));
+		for (slot &= fdt_index.mask; ent[slot].offset;
+		     slot = (slot + 1) & fdt_index.mask) {
+			if (ent[slot].parent == parent &&
+			    fdt_index_nodename_eq(blob, ent[slot].offset, name,
+						  namelen))
+				return ent[slot].offset;
+		}
+
+		return -FDT_ERR_NOTFOUND;
+	}
+#endif
+
+	return fdt_subnode_offset_namelen(blob, parent, name, namelen);
+}
+
+int fdtdec_subnode_offset(const void *blob, int parent, const char *name)
+{
+	return fdtdec_subnode_offset_namelen(blob, parent, name, strlen(name));
+}
+
+int fdtdec_path_offset(const void *blob, const char *path)
+{
+#if CONFIG_IS_ENABLED(OF_FLAT_INDEX)
+	const char *end = path + strlen(path);
+	const char *p = path, *q;
+	int offset = 0;
+
+	if (!fdt_index_ready(blob))
+		return fdt_path_offset(blob, path);
+
+	/* This follows fdt_path_offset_namelen() */
+	if (*path != '/') {
+		q = strchr(path, '/');
+		if (!q)
+			q = end;
+		p = fdt_get_alias_namelen(blob, p, q - p);
+		if (!p)
+			return -FDT_ERR_BADPATH;
+		offset = fdtdec_path_offset(blob, p);
+		p = q;
+	}
+
+	while (p < end) {
+		while (*p == '/') {
+			p++;
+			if (p == end)
+				return offset;
+		}
+		q = strchr(p, '/');
+		if (!q)
+			q = end;
+		offset = fdtdec_subnode_offset_namelen(blob, offset, p, q - p);
+		if (offset < 0)
+			return offset;
+		p = q;
+	}
+
+	return offset;
+#else
+	return fdt_path_offset(blob, path);
+#endif
+}
+
 int fdtdec_lookup_phandle(const void *blob, int node, const char *prop_name)
 {
 	const u32 *phandle;
 	int lookup;
 
 	debug("%s: %s\n", __func__, prop_name);
-	phandle = fdt_getprop(blob, node, prop_name, NULL);
+	phandle = fdtdec_getprop(blob, node, prop_name, NULL);
 	if (!phandle)
 		return -FDT_ERR_NOTFOUND;
 
-	lookup = fdt_node_offset_by_phandle(blob, fdt32_to_cpu(*phandle));
+	lookup = fdtdec_node_offset_by_phandle(blob, fdt32_to_cpu(*phandle));
 	return lookup;
 }
 
@@ -666,7 +1042,7 @@ static const void *get_prop_check_min_len(const void *blob, int node,
 	int len;
 
 	debug("%s: %s\n", __func__, prop_name);
-	cell = fdt_getprop(blob, node, prop_name, &len);
+	cell = fdtdec_getprop(blob, node, prop_name, &len);
 	if (!cell)
 		*err = -FDT_ERR_NOTFOUND;
 	else if (len < min_len)
@@ -702,7 +1078,7 @@ int fdtdec_get_int_array_count(const void *blob, int node,
 	int i;
 
 	debug("%s: %s\n", __func__, prop_name);
-	cell = fdt_getprop(blob, node, prop_name, &len);
+	cell = fdtdec_getprop(blob, node, prop_name, &len);
 	if (!cell)
 		return -FDT_ERR_NOTFOUND;
 	elems = len / sizeof(u32);
@@ -731,7 +1107,7 @@ int fdtdec_get_bool(const void *blob, int node, const char *prop_name)
 	int len;
 
 	debug("%s: %s\n", __func__, prop_name);
-	cell = fdt_getprop(blob, node, prop_name, &len);
+	cell = fdtdec_getprop(blob, node, prop_name, &len);
 	return cell != NULL;
 }
 
@@ -748,7 +1124,7 @@ int fdtdec_parse_phandle_with_args(const void *blob, int src_node,
 	int phandle;
 
 	/* Retrieve the phandle list property */
-	list = fdt_getprop(blob, src_node, list_name, &size);
+	list = fdtdec_getprop(blob, src_node, list_name, &size);
 	if (!list)
 		return -ENOENT;
 	list_end = list + size / sizeof(*list);
@@ -774,8 +1150,8 @@ int fdtdec_parse_phandle_with_args(const void *blob, int src_node,
 			 * below.
 			 */
 			if (cells_name || cur_index == index) {
-				node = fdt_node_offset_by_phandle(blob,
-								  phandle);
+				node = fdtdec_node_offset_by_phandle(blob,
+								     phandle);
 				if (node < 0) {
 					debug("%s: could not find phandle\n",
 					      fdt_get_name(blob, src_node,
@@ -951,7 +1327,7 @@ static int decode_timing_property(const void *blob, int node, const char *name,
 	int length, ret = 0;
 	const u32 *prop;
 
-	prop = fdt_getprop(blob, node, name, &length);
+	prop = fdtdec_getprop(blob, node, name, &length);
 	if (!prop) {
 		debug("%s: could not find property %s\n",
 		      fdt_get_name(blob, node, NULL), name);
@@ -976,7 +1352,7 @@ int fdtdec_decode_display_timing(const void *blob, int parent, int index,
 	u32 val = 0;
 	int ret = 0;
 
-	timings_node = fdt_subnode_offset(blob, parent, "display-timings");
+	timings_node = fdtdec_subnode_offset(blob, parent, "display-timings");
 	if (timings_node < 0)
 		return timings_node;
 
@@ -1312,7 +1688,7 @@ int fdtdec_add_reserved_memory(void *blob, const char *basename,
 	char name[64];
 
 	/* create an empty /reserved-memory node if one doesn't exist */
-	parent = fdt_path_offset(blob, "/reserved-memory");
+	parent = fdtdec_path_offset(blob, "/reserved-memory");
 	if (parent < 0) {
 		parent = fdtdec_init_reserved_memory(blob);
 		if (parent < 0)
@@ -1449,11 +1825,11 @@ int fdtdec_get_carveout(const void *blob, const char *node,
 	int offset, len;
 	fdt_size_t size;
 
-	offset = fdt_path_offset(blob, node);
+	offset = fdtdec_path_offset(blob, node);
 	if (offset < 0)
 		return offset;
 
-	prop = fdt_getprop(blob, offset, prop_name, &len);
+	prop = fdtdec_getprop(blob, offset, prop_name, &len);
 	if (!prop) {
 		debug("failed to get %s for %s\n", prop_name, node);
 		return -FDT_ERR_NOTFOUND;
@@ -1471,7 +1847,7 @@ int fdtdec_get_carveout(const void *blob, const char *node,
 
 	phandle = fdt32_to_cpu(prop[index]);
 
-	offset = fdt_node_offset_by_phandle(blob, phandle);
+	offset = fdtdec_node_offset_by_phandle(blob, phandle);
 	if (offset < 0) {
 		debug("failed to find node for phandle %u\n", phandle);
 		return offset;
@@ -1485,7 +1861,7 @@ int fdtdec_get_carveout(const void *blob, const char *node,
 		const char *start, *end, *ptr;
 		unsigned int count = 0;
 
-		prop = fdt_getprop(blob, offset, "compatible", &len);
+		prop = fdtdec_getprop(blob, offset, "compatible", &len);
 		if (!prop)
 			goto skip_compat;
 
@@ -1556,7 +1932,7 @@ int fdtdec_set_carveout(void *blob, const char *node, const char *prop_name,
 		return err;
 	}
 
-	offset = fdt_path_offset(blob, node);
+	offset = fdtdec_path_offset(blob, node);
 	if (offset < 0) {
 		debug("failed to find offset for node %s: %d\n", node, offset);
 		return offset;
@@ -1564,7 +1940,7 @@ int fdtdec_set_carveout(void *blob, const char *node, const char *prop_name,
 
 	value = cpu_to_fdt32(phandle);
 
-	if (!fdt_getprop(blob, offset, prop_name, &len)) {
+	if (!fdtdec_getprop(blob, offset, prop_name, &len)) {
 		if (len == -FDT_ERR_NOTFOUND)
 			len = 0;
 		else
@@ -1728,13 +2104,13 @@ int fdtdec_decode_ram_size(const void *blob, const char *area, int board_id,
 	debug("%s: board_id=%d\n", __func__, board_id);
 	if (!area)
 		area = "/memory";
-	node = fdt_path_offset(blob, area);
+	node = fdtdec_path_offset(blob, area);
 	if (node < 0) {
 		debug("No %s node found\n", area);
 		return -ENOENT;
 	}
 
-	cell = fdt_getprop(blob, node, "reg", &len);
+	cell = fdtdec_getprop(blob, node, "reg", &len);
 	if (!cell) {
 		debug("No reg property found\n");
 		return -ENOENT;
@@ -1757,7 +2133,7 @@ int fdtdec_decode_ram_size(const void *blob, const char *area, int board_id,
 			/* Found matching mask */
 			debug("Found matching mask %d\n", match_mask);
 			node = child;
-			cell = fdt_getprop(blob, node, "reg", &len);
+			cell = fdtdec_getprop(blob, node, "reg", &len);
 			if (!cell) {
 				debug("No memory-banks property found\n");
 				return -EINVAL;
@@ -316,3 +316,414 @@ int write_sparse_image(struct sparse_storage *info,
 
 	return 0;
 }
+
+enum sparse_stream_state {
+	SPARSE_STREAM_FILE_HDR,		/* sparse header or start of raw image */
+	SPARSE_STREAM_CHUNK_HDR,
+	SPARSE_STREAM_RAW_DATA,		/* payload of a raw chunk */
+	SPARSE_STREAM_FILL_VAL,		/* payload of a fill chunk */
+	SPARSE_STREAM_IMAGE,		/* a raw, not sparse, image */
+	SPARSE_STREAM_DONE,		/* all chunks seen */
+	SPARSE_STREAM_STOPPED,
+};
+
+int sparse_stream_start(struct sparse_stream *ss, struct sparse_storage *info,
+			const char *part_name)
+{
+	memset(ss, '\0', sizeof(*ss));
+	ss->info = info;
+	ss->part_name = part_name;
+	ss->blk = info->start;
+	ss->state = SPARSE_STREAM_FILE_HDR;
+	if (!info->mssg)
+		info->mssg = default_log;
+
+	/* Whole blocks only, so that a full buffer can always be written */
+	ss->buf_size = max_t(size_t, CONFIG_IMAGE_SPARSE_FILLBUF_SIZE /
+			     info->blksz, 1) * info->blksz;
+	ss->buf = memalign(ARCH_DMA_MINALIGN,
+			   ROUNDUP(ss->buf_size, ARCH_DMA_MINALIGN));
+	if (!ss->buf) {
+		ss->state = SPARSE_STREAM_STOPPED;
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+void sparse_stream_abort(struct sparse_stream *ss)
+{
+	free(ss->buf);
+	ss->buf = NULL;
+	ss->state = SPARSE_STREAM_STOPPED;
+}
+
+static int sparse_stream_put(struct sparse_stream *ss, lbaint_t blkcnt,
+			     const void *data, char *response)
+{
+	struct sparse_storage *info = ss->info;
+	lbaint_t blks;
+
+	if (ss->blk + blkcnt > info->start + info->size) {
+		printf("%s: Request would exceed partition size!\n", __func__);
+		info->mssg("Request would exceed partition size!", response);
+		return -ENOSPC;
+	}
+
+	/* blks might be > blkcnt (eg. NAND bad-blocks) */
+	blks = info->write(info, ss->blk, blkcnt, data);
+	if (IS_ERR_VALUE(blks) || blks < blkcnt) {
+		printf("%s: Write failed, block #" LBAFU " [" LBAFU "]\n",
+		       __func__, ss->blk, blkcnt);
+		info->mssg("flash write failure", response);
+		return -EIO;
+	}
+	ss->blk += blks;
+	ss->bytes_written += (u64)blkcnt * info->blksz;
+
+	return 0;
+}
+
+/* Write the whole blocks in the staging buffer, keeping a partial one */
+static int sparse_stream_flush(struct sparse_stream *ss, char *response)
+{
+	lbaint_t blksz = ss->info->blksz;
+	size_t len = ss->buf_len / blksz * blksz;
+	int ret;
+
+	if (!len)
+		return 0;
+
+	ret = sparse_stream_put(ss, len / blksz, ss->buf, response);
+	if (ret)
+		return ret;
+	memmove(ss->buf, ss->buf + len, ss->buf_len - len);
+	ss->buf_len -= len;
+
+	return 0;
+}
+
+/* Pass image data on to storage, without a copy if it is suitably aligned */
+static int sparse_stream_data(struct sparse_stream *ss, const u8 *data,
+			      size_t len, char *response)
+{
+	lbaint_t blksz = ss->info->blksz;
+	size_t n;
+	int ret;
+
+	while (len) {
+		if (!ss->buf_len && len >= blksz &&
+		    (CONFIG_IS_ENABLED(SYS_DCACHE_OFF) ||
+		     IS_ALIGNED((ulong)data, ARCH_DMA_MINALIGN))) {
+			n = len / blksz;
+			ret = sparse_stream_put(ss, n, data, response);
+			n *= blksz;
+		} else {
+			n = min(len, ss->buf_size - ss->buf_len);
+			memcpy(ss->buf + ss->buf_len, data, n);
+			ss->buf_len += n;
+			ret = 0;
+			if (ss->buf_len == ss->buf_size)
+				ret = sparse_stream_flush(ss, response);
+		}
+		if (ret)
+			return ret;
+		data += n;
+		len -= n;
+	}
+
+	return 0;
+}
+
+static size_t sparse_stream_collect(struct sparse_stream *ss, const u8 *data,
+				    size_t len, unsigned int want)
+{
+	size_t n = min(len, (size_t)(want - ss->hdr_len));
+
+	memcpy(ss->hdr + ss->hdr_len, data, n);
+	ss->hdr_len += n;
+
+	return n;
+}
+
+static void sparse_stream_next_chunk(struct sparse_stream *ss)
+{
+	ss->chunks++;
+	if (ss->chunks == ss->header.total_chunks)
+		ss->state = SPARSE_STREAM_DONE;
+	else
+		ss->state = SPARSE_STREAM_CHUNK_HDR;
+}
+
+static int sparse_stream_header(struct sparse_stream *ss, char *response)
+{
+	struct sparse_storage *info = ss->info;
+	sparse_header_t *hdr = &ss->header;
+	unsigned int offset;
+
+	memcpy(hdr, ss->hdr, sizeof(*hdr));
+	ss->hdr_len = 0;
+
+	if (!is_sparse_image(hdr)) {
+		puts("Flashing Raw Image\n");
+		ss->state = SPARSE_STREAM_IMAGE;
+		return sparse_stream_data(ss, (u8 *)hdr, sizeof(*hdr),
+					  response);
+	}
+
+	div_u64_rem(hdr->blk_sz, info->blksz, &offset);
+	if (offset) {
+		printf("%s: Sparse image block size issue [%u]\n",
+		       __func__, hdr->blk_sz);
+		info->mssg("sparse image block size issue", response);
+		return -EINVAL;
+	}
+	if (hdr->file_hdr_sz < sizeof(sparse_header_t) ||
+	    hdr->chunk_hdr_sz < sizeof(chunk_header_t)) {
+		info->mssg("Bogus sparse image header", response);
+		return -EINVAL;
+	}
+
+	puts("Flashing Sparse Image\n");
+	ss->skip = hdr->file_hdr_sz - sizeof(sparse_header_t);
+	ss->chunks = 0;
+	ss->state = SPARSE_STREAM_CHUNK_HDR;
+	if (!hdr->total_chunks)
+		ss->state = SPARSE_STREAM_DONE;
+
+	return 0;
+}
+
+static int sparse_stream_chunk(struct sparse_stream *ss, char *response)
+{
+	struct sparse_storage *info = ss->info;
+	chunk_header_t *chunk = &ss->chunk;
+	u32 hdr_sz = ss->header.chunk_hdr_sz;
+	u64 chunk_data_sz;
+	lbaint_t blkcnt;
+	int ret;
+
+	memcpy(chunk, ss->hdr, sizeof(*chunk));
+	ss->hdr_len = 0;
+	ss->skip = hdr_sz - sizeof(chunk_header_t);
+
+	if (chunk->chunk_type != CHUNK_TYPE_RAW) {
+		debug("=== Chunk Header ===\n");
+		debug("chunk_type: 0x%x\n", chunk->chunk_type);
+		debug("chunk_data_sz: 0x%x\n", chunk->chunk_sz);
+		debug("total_size: 0x%x\n", chunk->total_sz);
+	}
+
+	if (chunk->total_sz < hdr_sz) {
+		info->mssg("Bogus chunk size", response);
+		return -EINVAL;
+	}
+
+	chunk_data_sz = ((u64)ss->header.blk_sz) * chunk->chunk_sz;
+	blkcnt = DIV_ROUND_UP_ULL(chunk_data_sz, info->blksz);
+	switch (chunk->chunk_type) {
+	case CHUNK_TYPE_RAW:
+		if (chunk->total_sz != hdr_sz + chunk_data_sz) {
+			info->mssg("Bogus chunk size for chunk type Raw",
+				   response);
+			return -EINVAL;
+		}
+		/* Consecutive raw chunks are collected in the same buffer */
+		ss->total_blocks += chunk->chunk_sz;
+		ss->left = chunk_data_sz;
+		ss->state = SPARSE_STREAM_RAW_DATA;
+		if (!ss->left)
+			sparse_stream_next_chunk(ss);
+		break;
+
+	case CHUNK_TYPE_FILL:
+		if (chunk->total_sz != hdr_sz + sizeof(uint32_t)) {
+			info->mssg("Bogus chunk size for chunk type FILL",
+				   response);
+			return -EINVAL;
+		}
+		ss->state = SPARSE_STREAM_FILL_VAL;
+		break;
+
+	case CHUNK_TYPE_DONT_CARE:
+		ret = sparse_stream_flush(ss, response);
+		if (ret)
+			return ret;
+		ss->blk += info->reserve(info, ss->blk, blkcnt);
+		ss->total_blocks += chunk->chunk_sz;
+		ss->skip += chunk->total_sz - hdr_sz;
+		sparse_stream_next_chunk(ss);
+		break;
+
+	case CHUNK_TYPE_CRC32:
+		ss->total_blocks += chunk->chunk_sz;
+		ss->skip += chunk->total_sz - hdr_sz;
+		sparse_stream_next_chunk(ss);
+		break;
+
+	default:
+		printf("%s: Unknown chunk type: %x\n", __func__,
+		       chunk->chunk_type);
+		info->mssg("Unknown chunk type", response);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int sparse_stream_fill(struct sparse_stream *ss, char *response)
+{
+	struct sparse_storage *info = ss->info;
+	lbaint_t fill_blks = ss->buf_size / info->blksz;
+	lbaint_t blkcnt, n;
+	u32 *fill_buf = (u32 *)ss->buf;
+	u32 fill_val;
+	int ret;
+	int i;
+
+	/* The staging buffer is reused as the fill buffer */
+	ret = sparse_stream_flush(ss, response);
+	if (ret)
+		return ret;
+
+	memcpy(&fill_val, ss->hdr, sizeof(fill_val));
+	ss->hdr_len = 0;
+	for (i = 0; i < ss->buf_size / sizeof(fill_val); i++)
+		fill_buf[i] = fill_val;
+
+	blkcnt = DIV_ROUND_UP_ULL((u64)ss->header.blk_sz * ss->chunk.chunk_sz,
+				  info->blksz);
+	while (blkcnt) {
+		n = min(blkcnt, fill_blks);
+		ret = sparse_stream_put(ss, n, fill_buf, response);
+		if (ret)
+			return ret;
+		blkcnt -= n;
+	}
+	ss->total_blocks += ss->chunk.chunk_sz;
+	sparse_stream_next_chunk(ss);
+
+	return 0;
+}
+
+int sparse_stream_write(struct sparse_stream *ss, const void *data,
+			size_t len, char *response)
+{
+	const u8 *ptr = data;
+	size_t n;
+	int ret = 0;
+
+	if (ss->state == SPARSE_STREAM_STOPPED) {
+		ss->info->mssg("image write was stopped", response);
+		return -EIO;
+	}
+
+	while (len && !ret) {
+		if (ss->skip) {
+			n = min(len, (size_t)ss->skip);
+			ss->skip -= n;
+			ptr += n;
+			len -= n;
+			continue;
+		}
+
+		switch (ss->state) {
+		case SPARSE_STREAM_FILE_HDR:
+			n = sparse_stream_collect(ss, ptr, len,
+						  sizeof(sparse_header_t));
+			if (ss->hdr_len == sizeof(sparse_header_t))
+				ret = sparse_stream_header(ss, response);
+			break;
+		case SPARSE_STREAM_CHUNK_HDR:
+			n = sparse_stream_collect(ss, ptr, len,
+						  sizeof(chunk_header_t));
+			if (ss->hdr_len == sizeof(chunk_header_t))
+				ret = sparse_stream_chunk(ss, response);
+			break;
+		case SPARSE_STREAM_RAW_DATA:
+			n = min_t(u64, len, ss->left);
+			ret = sparse_stream_data(ss, ptr, n, response);
+			ss->left -= n;
+			if (!ss->left)
+				sparse_stream_next_chunk(ss);
+			break;
+		case SPARSE_STREAM_FILL_VAL:
+			n = sparse_stream_collect(ss, ptr, len,
+						  sizeof(uint32_t));
+			if (ss->hdr_len == sizeof(uint32_t))
+				ret = sparse_stream_fill(ss, response);
+			break;
+		case SPARSE_STREAM_IMAGE:
+			n = len;
+			ret = sparse_stream_data(ss, ptr, n, response);
+			break;
+		default:
+			/* Anything after the last chunk is ignored */
+			n = len;
+			break;
+		}
+		ptr += n;
+		len -= n;
+	}
+
+	if (ret)
+		sparse_stream_abort(ss);
+
+	return ret;
+}
+
+int sparse_stream_finish(struct sparse_stream *ss, char *response)
+{
+	struct sparse_storage *info = ss->info;
+	lbaint_t blksz = info->blksz;
+	size_t rem;
+	int ret = 0;
+
+	switch (ss->state) {
+	case SPARSE_STREAM_FILE_HDR:
+		/* A raw image too short to hold a sparse header */
+		puts("Flashing Raw Image\n");
+		memcpy(ss->buf, ss->hdr, ss->hdr_len);
+		ss->buf_len = ss->hdr_len;
+		fallthrough;
+	case SPARSE_STREAM_IMAGE:
+		rem = ss->buf_len % blksz;
+		if (rem) {
+			memset(ss->buf + ss->buf_len, '\0', blksz - rem);
+			ss->buf_len += blksz - rem;
+		}
+		ret = sparse_stream_flush(ss, response);
+		break;
+	case SPARSE_STREAM_DONE:
+		if (ss->skip) {
+			info->mssg("sparse image is truncated", response);
+			ret = -EINVAL;
+			break;
+		}
+		ret = sparse_stream_flush(ss, response);
+		if (ret)
+			break;
+		debug("Wrote %d blocks, expected to write %d blocks\n",
+		      ss->total_blocks, ss->header.total_blks);
+		if (ss->total_blocks != ss->header.total_blks) {
+			info->mssg("sparse image write failure", response);
+			ret = -EINVAL;
+		}
+		break;
+	case SPARSE_STREAM_STOPPED:
+		info->mssg("image write was stopped", response);
+		ret = -EIO;
+		break;
+	default:
+		info->mssg("sparse image is truncated", response);
+		ret = -EINVAL;
+		break;
+	}
+
+	if (!ret)
+		printf("........ wrote %llu bytes to '%s'\n", ss->bytes_written,
+		       ss->part_name);
+	sparse_stream_abort(ss);
+
+	return ret;
+}
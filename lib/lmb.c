@@ -85,14 +85,57 @@ static long lmb_regions_adjacent(struct lmb_region *rgn, unsigned long r1,
 
 static void lmb_remove_region(struct lmb_region *rgn, unsigned long r)
 {
-	unsigned long i;
+	memmove(&rgn->region[r], &rgn->region[r + 1],
+		(rgn->cnt - r - 1) * sizeof(rgn->region[0]));
+	rgn->cnt--;
+}
 
-	for (i = r; i < rgn->cnt - 1; i++) {
-		rgn->region[i].base = rgn->region[i + 1].base;
-		rgn->region[i].size = rgn->region[i + 1].size;
-		rgn->region[i].flags = rgn->region[i + 1].flags;
+/*
+ * Find the first region which ends at or above @addr, or rgn->cnt if there is
+ * none. Regions are sorted by address and do not overlap, so their end
+ * addresses are sorted too.
+ */
+static unsigned long lmb_search_region(struct lmb_region *rgn,
+				       phys_addr_t addr)
+{
+	unsigned long lo = 0, hi = rgn->cnt, mid;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (rgn->region[mid].base + rgn->region[mid].size - 1 < addr)
+			lo = mid + 1;
+		else
+			hi = mid;
 	}
-	rgn->cnt--;
+
+	return lo;
+}
+
+/*
+ * Make room for more regions once malloc() is fully available. The first
+ * array is the one in struct lmb so nothing is allocated in the common case.
+ */
+static int lmb_grow_region(struct lmb_region *rgn)
+{
+#if IS_ENABLED(CONFIG_LMB_DYNAMIC_REGIONS)
+	struct lmb_property *region;
+
+	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT))
+		return -1;
+	region = malloc(rgn->max * 2 * sizeof(*region));
+	if (!region)
+		return -1;
+	memcpy(region, rgn->region, rgn->cnt * sizeof(*region));
+	if (rgn->alloced)
+		free(rgn->region);
+	rgn->region = region;
+	rgn->max *= 2;
+	rgn->alloced = true;
+
+	return 0;
+#else
+	return -1;
+#endif
 }
 
 /* Assumption: base addr of region 1 < base addr of region 2 */
@@ -113,6 +156,24 @@ void lmb_init(struct lmb *lmb)
 	lmb->reserved.max = CONFIG_LMB_RESERVED_REGIONS;
 	lmb->memory.region = lmb->memory_regions;
 	lmb->reserved.region = lmb->reserved_regions;
+#endif
+#if IS_ENABLED(CONFIG_LMB_DYNAMIC_REGIONS)
+	lmb->memory.alloced = false;
+	lmb->reserved.alloced = false;
+#endif
+	lmb->memory.cnt = 0;
+	lmb->reserved.cnt = 0;
+}
+
+void lmb_uninit(struct lmb *lmb)
+{
+#if IS_ENABLED(CONFIG_LMB_DYNAMIC_REGIONS)
+	if (lmb->memory.alloced)
+		free(lmb->memory.region);
+	if (lmb->reserved.alloced)
+		free(lmb->reserved.region);
+	lmb->memory.alloced = false;
+	lmb->reserved.alloced = false;
 #endif
 	lmb->memory.cnt = 0;
 	lmb->reserved.cnt = 0;
@@ -192,83 +253,60 @@ void lmb_init_and_reserve_range(struct lmb *lmb, phys_addr_t base,
 static long lmb_add_region_flags(struct lmb_region *rgn, phys_addr_t base,
 				 phys_size_t size, enum lmb_flags flags)
 {
+	struct lmb_property *prev = NULL, *next = NULL;
 	unsigned long coalesced = 0;
-	long adjacent, i;
-
-	if (rgn->cnt == 0) {
-		rgn->region[0].base = base;
-		rgn->region[0].size = size;
-		rgn->region[0].flags = flags;
-		rgn->cnt = 1;
-		return 0;
-	}
-
-	/* First try and coalesce this LMB with another. */
-	for (i = 0; i < rgn->cnt; i++) {
-		phys_addr_t rgnbase = rgn->region[i].base;
-		phys_size_t rgnsize = rgn->region[i].size;
-		phys_size_t rgnflags = rgn->region[i].flags;
+	unsigned long i;
 
-		if (rgnbase == base && rgnsize == size) {
-			if (flags == rgnflags)
+	/* Only the first region ending at or above base can overlap */
+	i = lmb_search_region(rgn, base);
+	if (i > 0)
+		prev = &rgn->region[i - 1];
+	if (i < rgn->cnt) {
+		next = &rgn->region[i];
+		if (next->base == base && next->size == size) {
+			if (flags == next->flags)
 				/* Already have this region, so we're done */
 				return 0;
 			else
 				return -1; /* regions with new flags */
 		}
+		if (lmb_addrs_overlap(base, size, next->base, next->size))
+			return -1;
+	}
 
-		adjacent = lmb_addrs_adjacent(base, size, rgnbase, rgnsize);
-		if (adjacent > 0) {
-			if (flags != rgnflags)
-				break;
-			rgn->region[i].base -= size;
-			rgn->region[i].size += size;
+	/* First try and coalesce this LMB with another. */
+	if (prev && lmb_addrs_adjacent(base, size, prev->base, prev->size) < 0) {
+		if (flags == prev->flags) {
+			prev->size += size;
 			coalesced++;
-			break;
-		} else if (adjacent < 0) {
-			if (flags != rgnflags)
-				break;
-			rgn->region[i].size += size;
+			i--;
+		}
+	} else if (next &&
+		   lmb_addrs_adjacent(base, size, next->base, next->size) > 0) {
+		if (flags == next->flags) {
+			next->base -= size;
+			next->size += size;
 			coalesced++;
-			break;
-		} else if (lmb_addrs_overlap(base, size, rgnbase, rgnsize)) {
-			/* regions overlap */
-			return -1;
 		}
 	}
 
-	if ((i < rgn->cnt - 1) && lmb_regions_adjacent(rgn, i, i + 1)) {
-		if (rgn->region[i].flags == rgn->region[i + 1].flags) {
+	if (coalesced) {
+		if (i < rgn->cnt - 1 && lmb_regions_adjacent(rgn, i, i + 1) &&
+		    rgn->region[i].flags == rgn->region[i + 1].flags) {
 			lmb_coalesce_regions(rgn, i, i + 1);
 			coalesced++;
 		}
-	}
-
-	if (coalesced)
 		return coalesced;
-	if (rgn->cnt >= rgn->max)
+	}
+	if (rgn->cnt >= rgn->max && lmb_grow_region(rgn))
 		return -1;
 
 	/* Couldn't coalesce the LMB, so add it to the sorted table. */
-	for (i = rgn->cnt-1; i >= 0; i--) {
-		if (base < rgn->region[i].base) {
-			rgn->region[i + 1].base = rgn->region[i].base;
-			rgn->region[i + 1].size = rgn->region[i].size;
-			rgn->region[i + 1].flags = rgn->region[i].flags;
-		} else {
-			rgn->region[i + 1].base = base;
-			rgn->region[i + 1].size = size;
-			rgn->region[i + 1].flags = flags;
-			break;
-		}
-	}
-
-	if (base < rgn->region[0].base) {
-		rgn->region[0].base = base;
-		rgn->region[0].size = size;
-		rgn->region[0].flags = flags;
-	}
-
+	memmove(&rgn->region[i + 1], &rgn->region[i],
+		(rgn->cnt - i) * sizeof(rgn->region[0]));
+	rgn->region[i].base = base;
+	rgn->region[i].size = size;
+	rgn->region[i].flags = flags;
 	rgn->cnt++;
 
 	return 0;
@@ -293,21 +331,17 @@ long lmb_free(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 	struct lmb_region *rgn = &(lmb->reserved);
 	phys_addr_t rgnbegin, rgnend;
 	phys_addr_t end = base + size - 1;
-	int i;
-
-	rgnbegin = rgnend = 0; /* supress gcc warnings */
+	unsigned long i;
 
 	/* Find the region where (base, size) belongs to */
-	for (i = 0; i < rgn->cnt; i++) {
-		rgnbegin = rgn->region[i].base;
-		rgnend = rgnbegin + rgn->region[i].size - 1;
-
-		if ((rgnbegin <= base) && (end <= rgnend))
-			break;
-	}
+	i = lmb_search_region(rgn, base);
+	if (i == rgn->cnt)
+		return -1;
+	rgnbegin = rgn->region[i].base;
+	rgnend = rgnbegin + rgn->region[i].size - 1;
 
 	/* Didn't find the region */
-	if (i == rgn->cnt)
+	if (rgnbegin > base || end > rgnend)
 		return -1;
 
 	/* Check to see if we are removing entire region */
@@ -356,14 +390,12 @@ static long lmb_overlaps_region(struct lmb_region *rgn, phys_addr_t base,
 {
 	unsigned long i;
 
-	for (i = 0; i < rgn->cnt; i++) {
-		phys_addr_t rgnbase = rgn->region[i].base;
-		phys_size_t rgnsize = rgn->region[i].size;
-		if (lmb_addrs_overlap(base, size, rgnbase, rgnsize))
-			break;
-	}
+	i = lmb_search_region(rgn, base);
+	if (i < rgn->cnt && lmb_addrs_overlap(base, size, rgn->region[i].base,
+					      rgn->region[i].size))
+		return i;
 
-	return (i < rgn->cnt) ? i : -1;
+	return -1;
 }
 
 phys_addr_t lmb_alloc(struct lmb *lmb, phys_size_t size, ulong align)
@@ -459,22 +491,20 @@ phys_addr_t lmb_alloc_addr(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 /* Return number of bytes from a given address that are free */
 phys_size_t lmb_get_free_size(struct lmb *lmb, phys_addr_t addr)
 {
-	int i;
+	unsigned long i;
 	long rgn;
 
 	/* check if the requested address is in the memory regions */
 	rgn = lmb_overlaps_region(&lmb->memory, addr, 1);
 	if (rgn >= 0) {
-		for (i = 0; i < lmb->reserved.cnt; i++) {
+		i = lmb_search_region(&lmb->reserved, addr);
+		if (i < lmb->reserved.cnt) {
 			if (addr < lmb->reserved.region[i].base) {
 				/* first reserved range > requested address */
 				return lmb->reserved.region[i].base - addr;
 			}
-			if (lmb->reserved.region[i].base +
-			    lmb->reserved.region[i].size > addr) {
-				/* requested addr is in this reserved range */
-				return 0;
-			}
+			/* requested addr is in this reserved range */
+			return 0;
 		}
 		/* if we come here: no reserved ranges above requested addr */
 		return lmb->memory.region[lmb->memory.cnt - 1].base +
@@ -485,14 +515,12 @@ phys_size_t lmb_get_free_size(struct lmb *lmb, phys_addr_t addr)
 
 int lmb_is_reserved_flags(struct lmb *lmb, phys_addr_t addr, int flags)
 {
-	int i;
+	unsigned long i;
+
+	i = lmb_search_region(&lmb->reserved, addr);
+	if (i < lmb->reserved.cnt && addr >= lmb->reserved.region[i].base)
+		return (lmb->reserved.region[i].flags & flags) == flags;
 
-	for (i = 0; i < lmb->reserved.cnt; i++) {
-		phys_addr_t upper = lmb->reserved.region[i].base +
-			lmb->reserved.region[i].size - 1;
-		if ((addr >= lmb->reserved.region[i].base) && (addr <= upper))
-			return (lmb->reserved.region[i].flags & flags) == flags;
-	}
 	return 0;
 }
 
@@ -16,6 +16,20 @@
 #include <dm/of_access.h>
 #include <linux/err.h>
 
+/**
+ * struct of_live_tree - Root node of a live tree, with its flat tree
+ *
+ * With CONFIG_OF_LIVE_LAZY this is allocated in place of the root node, since
+ * each live tree may be built from a different flat tree.
+ *
+ * @blob: Flat tree which the properties of the nodes are read from
+ * @root: Root node, which must come last since its name follows it
+ */
+struct of_live_tree {
+	const void *blob;
+	struct device_node root;
+};
+
 static void *unflatten_dt_alloc(void **mem, unsigned long size,
 				unsigned long align)
 {
@@ -55,6 +69,7 @@ static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 	int offset;
 	int has_name = 0;
 	int new_format = 0;
+	char *name = NULL;
 
 	pathp = fdt_get_name(blob, *poffset, &l);
 	if (!pathp)
@@ -91,8 +106,19 @@ static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 		}
 	}
 
-	np = unflatten_dt_alloc(&mem, sizeof(struct device_node) + allocl,
-				__alignof__(struct device_node));
+	if (CONFIG_IS_ENABLED(OF_LIVE_LAZY) && !dad) {
+		struct of_live_tree *tree;
+
+		tree = unflatten_dt_alloc(&mem, sizeof(*tree) + allocl,
+					  __alignof__(*tree));
+		np = &tree->root;
+		if (!dryrun)
+			tree->blob = blob;
+	} else {
+		np = unflatten_dt_alloc(&mem,
+					sizeof(struct device_node) + allocl,
+					__alignof__(struct device_node));
+	}
 	if (!dryrun) {
 		char *fn;
 
@@ -122,10 +148,17 @@ static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 			dad->child = np;
 		}
 	}
-	/* process properties */
-	for (offset = fdt_first_property_offset(blob, *poffset);
-	     (offset >= 0);
-	     (offset = fdt_next_property_offset(blob, offset))) {
+	/*
+	 * process properties. With OF_LIVE_LAZY this is left until they are
+	 * first used, see of_live_read_props()
+	 */
+	if (CONFIG_IS_ENABLED(OF_LIVE_LAZY)) {
+		has_name = fdt_getprop(blob, *poffset, "name", NULL) != NULL;
+		offset = -FDT_ERR_NOTFOUND;
+	} else {
+		offset = fdt_first_property_offset(blob, *poffset);
+	}
+	for (; offset >= 0; offset = fdt_next_property_offset(blob, offset)) {
 		const char *pname;
 		int sz;
 
@@ -186,9 +219,19 @@ static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 		if (pa < ps)
 			pa = p1;
 		sz = (pa - ps) + 1;
-		pp = unflatten_dt_alloc(&mem, sizeof(struct property) + sz,
-					__alignof__(struct property));
-		if (!dryrun) {
+		if (CONFIG_IS_ENABLED(OF_LIVE_LAZY)) {
+			/* The property is added with the others */
+			name = unflatten_dt_alloc(&mem, sz, 1);
+			if (!dryrun) {
+				memcpy(name, ps, sz - 1);
+				name[sz - 1] = 0;
+			}
+		} else {
+			pp = unflatten_dt_alloc(&mem,
+						sizeof(struct property) + sz,
+						__alignof__(struct property));
+		}
+		if (!dryrun && !CONFIG_IS_ENABLED(OF_LIVE_LAZY)) {
 			pp->name = "name";
 			pp->length = sz;
 			pp->value = pp + 1;
@@ -202,8 +245,16 @@ static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 	}
 	if (!dryrun) {
 		*prev_pp = NULL;
+#if CONFIG_IS_ENABLED(OF_LIVE_LAZY)
+		np->offset = *poffset;
+		np->phandle = fdt_get_phandle(blob, *poffset);
+		np->name = name ? name : fdt_getprop(blob, *poffset, "name",
+						     NULL);
+		np->type = fdt_getprop(blob, *poffset, "device_type", NULL);
+#else
 		np->name = of_get_property(np, "name", NULL);
 		np->type = of_get_property(np, "device_type", NULL);
+#endif
 
 		if (!np->name)
 			np->name = "<NULL>";
@@ -315,6 +366,60 @@ static int unflatten_device_tree(const void *blob,
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(OF_LIVE_LAZY)
+/* Get the flat tree which the live tree holding @np was built from */
+static const void *of_live_get_blob(const struct device_node *np)
+{
+	while (np->parent)
+		np = np->parent;
+
+	return container_of(np, struct of_live_tree, root)->blob;
+}
+
+int of_live_read_props(struct device_node *np)
+{
+	struct property *pp, **prev_pp;
+	bool has_name = false;
+	const char *pname;
+	const void *blob;
+	int offset, count;
+
+	if (np->offset < 0)
+		return 0;
+
+	blob = of_live_get_blob(np);
+
+	/* Leave room for the 'name' property, which may be missing */
+	count = 1;
+	fdt_for_each_property_offset(offset, blob, np->offset)
+		count++;
+	pp = calloc(count, sizeof(*pp));
+	if (!pp)
+		return -ENOMEM;
+
+	prev_pp = &np->properties;
+	fdt_for_each_property_offset(offset, blob, np->offset) {
+		pp->value = (void *)fdt_getprop_by_offset(blob, offset, &pname,
+							  &pp->length);
+		pp->name = (char *)pname;
+		if (!strcmp(pname, "name"))
+			has_name = true;
+		*prev_pp = pp;
+		prev_pp = &pp->next;
+		pp++;
+	}
+	if (!has_name) {
+		pp->name = "name";
+		pp->value = (void *)np->name;
+		pp->length = strlen(np->name) + 1;
+		*prev_pp = pp;
+	}
+	np->offset = -1;
+
+	return 0;
+}
+#endif
+
 int of_live_build(const void *fdt_blob, struct device_node **rootp)
 {
 	int ret;
@@ -330,7 +435,28 @@ int of_live_build(const void *fdt_blob, struct device_node **rootp)
 		debug("Failed to scan live tree aliases: err=%d\n", ret);
 		return ret;
 	}
+	/* Without the cache, phandles are found by scanning the tree */
+	if (of_phandle_cache_init())
+		debug("Failed to build phandle cache\n");
 	debug("%s: stop\n", __func__);
 
-	return ret;
+	return 0;
+}
+
+void of_live_free(struct device_node *root)
+{
+	struct device_node *np;
+
+	if (!CONFIG_IS_ENABLED(OF_LIVE_LAZY)) {
+		/* The tree is a single block, starting with the root node */
+		free(root);
+		return;
+	}
+
+	/* Properties read by of_live_read_props() have a block per node */
+	for (np = root; np; np = of_find_all_nodes(np)) {
+		if (np->offset < 0)
+			free(np->properties);
+	}
+	free(container_of(root, struct of_live_tree, root));
 }
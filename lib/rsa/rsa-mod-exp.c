@@ -36,6 +36,11 @@ static inline uint64_t fdt64_to_cpup(const void *p)
 /* Default public exponent for backward compatibility */
 #define RSA_DEFAULT_PUBEXP	65537
 
+/* 64-bit words can only be used if the compiler has a 128-bit product */
+#if IS_ENABLED(CONFIG_RSA_SOFTWARE_EXP_64BIT) && defined(__SIZEOF_INT128__)
+#define RSA_MOD_EXP_64BIT
+#endif
+
 /**
  * subtract_modulus() - subtract modulus from the given value
  *
@@ -135,17 +140,14 @@ static void montgomery_mul(const struct rsa_public_key *key,
 /**
  * num_pub_exponent_bits() - Number of bits in the public exponent
  *
- * @key:	RSA key
+ * @exponent:	Public exponent of the RSA key
  * @num_bits:	Storage for the number of public exponent bits
  */
-static int num_public_exponent_bits(const struct rsa_public_key *key,
-		int *num_bits)
+static int num_public_exponent_bits(uint64_t exponent, int *num_bits)
 {
-	uint64_t exponent;
 	int exponent_bits;
 	const uint max_bits = (sizeof(exponent) * 8);
 
-	exponent = key->exponent;
 	exponent_bits = 0;
 
 	if (!exponent) {
@@ -165,13 +167,38 @@ static int num_public_exponent_bits(const struct rsa_public_key *key,
 /**
  * is_public_exponent_bit_set() - Check if a bit in the public exponent is set
  *
- * @key:	RSA key
+ * @exponent:	Public exponent of the RSA key
  * @pos:	The bit position to check
  */
-static int is_public_exponent_bit_set(const struct rsa_public_key *key,
-		int pos)
+static int is_public_exponent_bit_set(uint64_t exponent, int pos)
+{
+	return exponent & (1ULL << pos);
+}
+
+/**
+ * check_public_exponent() - Check that the public exponent can be used
+ *
+ * @exponent:	Public exponent of the RSA key
+ * @num_bits:	Storage for the number of public exponent bits
+ * Return: 0 if OK, -EINVAL if the exponent is too short or even
+ */
+static int check_public_exponent(uint64_t exponent, int *num_bits)
 {
-	return key->exponent & (1ULL << pos);
+	if (num_public_exponent_bits(exponent, num_bits))
+		return -EINVAL;
+
+	if (*num_bits < 2) {
+		debug("Public exponent is too short (%d bits, minimum 2)\n",
+		      *num_bits);
+		return -EINVAL;
+	}
+
+	if (!is_public_exponent_bit_set(exponent, 0)) {
+		debug("LSB of RSA public exponent must be set.\n");
+		return -EINVAL;
+	}
+
+	return 0;
 }
 
 /**
@@ -201,19 +228,8 @@ static int pow_mod(const struct rsa_public_key *key, uint32_t *inout)
 	for (i = 0, ptr = inout + key->len - 1; i < key->len; i++, ptr--)
 		val[i] = get_unaligned_be32(ptr);
 
-	if (0 != num_public_exponent_bits(key, &k))
-		return -EINVAL;
-
-	if (k < 2) {
-		debug("Public exponent is too short (%d bits, minimum 2)\n",
-		      k);
+	if (check_public_exponent(key->exponent, &k))
 		return -EINVAL;
-	}
-
-	if (!is_public_exponent_bit_set(key, 0)) {
-		debug("LSB of RSA public exponent must be set.\n");
-		return -EINVAL;
-	}
 
 	/* the bit at e[k-1] is 1 by definition, so start with: C := M */
 	montgomery_mul(key, acc, val, key->rr); /* acc = a * RR / R mod n */
@@ -223,7 +239,7 @@ static int pow_mod(const struct rsa_public_key *key, uint32_t *inout)
 	for (j = k - 2; j > 0; --j) {
 		montgomery_mul(key, tmp, acc, acc); /* tmp = acc^2 / R mod n */
 
-		if (is_public_exponent_bit_set(key, j)) {
+		if (is_public_exponent_bit_set(key->exponent, j)) {
 			/* acc = tmp * val / R mod n */
 			montgomery_mul(key, acc, tmp, a_scaled);
 		} else {
@@ -247,6 +263,241 @@ static int pow_mod(const struct rsa_public_key *key, uint32_t *inout)
 	return 0;
 }
 
+#ifdef RSA_MOD_EXP_64BIT
+/**
+ * struct rsa_public_key64 - RSA public key split into 64-bit words
+ *
+ * R is the same as for 32-bit words, since the key length is a multiple of
+ * 64 bits, so R^2 can be taken from the key properties as it is.
+ */
+struct rsa_public_key64 {
+	uint len;		/* len of modulus[] in number of uint64_t */
+	uint64_t n0inv;		/* -1 / modulus[0] mod 2^64 */
+	uint64_t *modulus;	/* modulus as little endian array */
+	uint64_t *rr;		/* R^2 as little endian array */
+	uint64_t exponent;	/* public exponent */
+};
+
+/**
+ * subtract_modulus64() - subtract modulus from the given value
+ *
+ * @key:	Key containing modulus to subtract
+ * @num:	Number to subtract modulus from, as little endian word array
+ */
+static void subtract_modulus64(const struct rsa_public_key64 *key,
+			       uint64_t num[])
+{
+	unsigned __int128 acc;
+	uint64_t borrow = 0;
+	uint i;
+
+	for (i = 0; i < key->len; i++) {
+		acc = (unsigned __int128)num[i] - key->modulus[i] - borrow;
+		num[i] = (uint64_t)acc;
+		borrow = (uint64_t)(acc >> 64) & 1;
+	}
+}
+
+/**
+ * greater_equal_modulus64() - check if a value is >= modulus
+ *
+ * @key:	Key containing modulus to check
+ * @num:	Number to check against modulus, as little endian word array
+ * Return: 0 if num < modulus, 1 if num >= modulus
+ */
+static int greater_equal_modulus64(const struct rsa_public_key64 *key,
+				   uint64_t num[])
+{
+	int i;
+
+	for (i = (int)key->len - 1; i >= 0; i--) {
+		if (num[i] < key->modulus[i])
+			return 0;
+		if (num[i] > key->modulus[i])
+			return 1;
+	}
+
+	return 1;  /* equal */
+}
+
+/**
+ * montgomery_mul_add_step64() - Perform montgomery multiply-add step
+ *
+ * This is montgomery_mul_add_step() with 64-bit words, which halves the
+ * number of steps and quarters the number of multiplications.
+ *
+ * @key:	RSA key
+ * @result:	Place to put result, as little endian word array
+ * @a:		Multiplier
+ * @b:		Multiplicand, as little endian word array
+ */
+static void montgomery_mul_add_step64(const struct rsa_public_key64 *key,
+				      uint64_t result[], const uint64_t a,
+				      const uint64_t b[])
+{
+	unsigned __int128 acc_a, acc_b;
+	uint64_t d0;
+	uint i;
+
+	acc_a = (unsigned __int128)a * b[0] + result[0];
+	d0 = (uint64_t)acc_a * key->n0inv;
+	acc_b = (unsigned __int128)d0 * key->modulus[0] + (uint64_t)acc_a;
+	for (i = 1; i < key->len; i++) {
+		acc_a = (acc_a >> 64) + (unsigned __int128)a * b[i] + result[i];
+		acc_b = (acc_b >> 64) +
+			(unsigned __int128)d0 * key->modulus[i] +
+			(uint64_t)acc_a;
+		result[i - 1] = (uint64_t)acc_b;
+	}
+
+	acc_a = (acc_a >> 64) + (acc_b >> 64);
+
+	result[i - 1] = (uint64_t)acc_a;
+
+	if (acc_a >> 64)
+		subtract_modulus64(key, result);
+}
+
+/**
+ * montgomery_mul64() - Perform montgomery mutitply
+ *
+ * Operation: montgomery result[] = a[] * b[] / n0inv % modulus
+ *
+ * @key:	RSA key
+ * @result:	Place to put result, as little endian word array
+ * @a:		Multiplier, as little endian word array
+ * @b:		Multiplicand, as little endian word array
+ */
+static void montgomery_mul64(const struct rsa_public_key64 *key,
+			     uint64_t result[], uint64_t a[],
+			     const uint64_t b[])
+{
+	uint i;
+
+	for (i = 0; i < key->len; ++i)
+		result[i] = 0;
+	for (i = 0; i < key->len; ++i)
+		montgomery_mul_add_step64(key, result, a[i], b);
+}
+
+/**
+ * pow_mod64() - in-place public exponentiation with 64-bit words
+ *
+ * @key:	RSA key
+ * @val:	Little endian word array containing value and result
+ * Return: 0 on success, -EINVAL if the exponent cannot be used
+ */
+static int pow_mod64(const struct rsa_public_key64 *key, uint64_t *val)
+{
+	uint64_t acc[key->len], tmp[key->len], a_scaled[key->len];
+	int j, k;
+
+	if (check_public_exponent(key->exponent, &k))
+		return -EINVAL;
+
+	/* the bit at e[k-1] is 1 by definition, so start with: C := M */
+	montgomery_mul64(key, acc, val, key->rr); /* acc = a * RR / R mod n */
+	/* retain scaled version for intermediate use */
+	memcpy(a_scaled, acc, key->len * sizeof(a_scaled[0]));
+
+	for (j = k - 2; j > 0; --j) {
+		montgomery_mul64(key, tmp, acc, acc); /* tmp = acc^2 / R mod n */
+
+		if (is_public_exponent_bit_set(key->exponent, j)) {
+			/* acc = tmp * val / R mod n */
+			montgomery_mul64(key, acc, tmp, a_scaled);
+		} else {
+			/* e[j] == 0, copy tmp back to acc for next operation */
+			memcpy(acc, tmp, key->len * sizeof(acc[0]));
+		}
+	}
+
+	/* the bit at e[0] is always 1 */
+	montgomery_mul64(key, tmp, acc, acc); /* tmp = acc^2 / R mod n */
+	montgomery_mul64(key, acc, tmp, val); /* acc = tmp * a / R mod M */
+	memcpy(val, acc, key->len * sizeof(val[0]));
+
+	/* Make sure result < mod; result is at most 1x mod too large. */
+	if (greater_equal_modulus64(key, val))
+		subtract_modulus64(key, val);
+
+	return 0;
+}
+
+/**
+ * rsa_inverse64() - Calculate -1 / num mod 2^64
+ *
+ * Each Newton step doubles the number of correct bits, starting from the 3
+ * bits for which any odd number is its own inverse.
+ *
+ * @num:	Odd number to invert
+ * Return: -1 / num mod 2^64
+ */
+static uint64_t rsa_inverse64(uint64_t num)
+{
+	uint64_t inv = num;
+	int i;
+
+	for (i = 0; i < 5; i++)
+		inv *= 2 - num * inv;
+
+	return -inv;
+}
+
+static void rsa_convert_big_endian64(uint64_t *dst, const void *src, int len)
+{
+	int i;
+
+	for (i = 0; i < len; i++)
+		dst[i] = fdt64_to_cpup(src + (len - 1 - i) * sizeof(*dst));
+}
+
+/**
+ * rsa_mod_exp_sw64() - Perform RSA Modular Exponentiation with 64-bit words
+ *
+ * @sig:	Signature, as a big endian byte array
+ * @sig_len:	Length of signature in bytes, which must match the key
+ * @prop:	Key properties
+ * @exponent:	Public exponent
+ * @out:	Result in form of byte array of len equal to sig_len
+ * Return: 0 on success, -ve on error
+ */
+static int rsa_mod_exp_sw64(const uint8_t *sig, uint32_t sig_len,
+			    struct key_prop *prop, uint64_t exponent,
+			    uint8_t *out)
+{
+	struct rsa_public_key64 key;
+	uint64_t word;
+	uint i;
+	int ret;
+
+	key.len = prop->num_bits / 64;
+	if (sig_len != key.len * sizeof(uint64_t))
+		return -EINVAL;
+
+	uint64_t modulus[key.len], rr[key.len], val[key.len];
+
+	key.modulus = modulus;
+	key.rr = rr;
+	key.exponent = exponent;
+	rsa_convert_big_endian64(key.modulus, prop->modulus, key.len);
+	rsa_convert_big_endian64(key.rr, prop->rr, key.len);
+	rsa_convert_big_endian64(val, sig, key.len);
+	key.n0inv = rsa_inverse64(key.modulus[0]);
+
+	ret = pow_mod64(&key, val);
+	if (ret)
+		return ret;
+
+	for (i = 0; i < key.len; i++) {
+		word = cpu_to_fdt64(val[key.len - 1 - i]);
+		memcpy(out + i * sizeof(word), &word, sizeof(word));
+	}
+
+	return 0;
+}
+#endif
+
 static void rsa_convert_big_endian(uint32_t *dst, const uint32_t *src, int len)
 {
 	int i;
@@ -284,6 +535,10 @@ int rsa_mod_exp_sw(const uint8_t *sig, uint32_t sig_len,
 		      key.len, RSA_MIN_KEY_BITS, RSA_MAX_KEY_BITS);
 		return -EFAULT;
 	}
+#ifdef RSA_MOD_EXP_64BIT
+	if (!(key.len % 64))
+		return rsa_mod_exp_sw64(sig, sig_len, prop, key.exponent, out);
+#endif
 	key.len /= sizeof(uint32_t) * 8;
 	uint32_t key1[key.len], key2[key.len];
 
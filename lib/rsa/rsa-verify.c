@@ -13,6 +13,7 @@
 #include <linux/errno.h>
 #include <asm/types.h>
 #include <asm/unaligned.h>
+#include <asm/global_data.h>
 #include <dm.h>
 #else
 #include "fdt_host.h"
@@ -38,6 +39,15 @@
 /* Default public exponent for backward compatibility */
 #define RSA_DEFAULT_PUBEXP	65537
 
+/* Number of public keys whose properties are kept by rsa_key_prop_get() */
+#define RSA_KEY_PROP_CACHE_SIZE	4
+
+/*
+ * Name of the key node which last verified a signature when the hinted key
+ * did not, so that it is tried first next time
+ */
+static char rsa_last_keynode[32];
+
 /**
  * rsa_verify_padding() - Verify RSA message padding is valid
  *
@@ -385,6 +395,111 @@ static int rsa_verify_key(struct image_sign_info *info,
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(RSA_VERIFY_WITH_PKEY)
+DECLARE_GLOBAL_DATA_PTR;
+
+/**
+ * struct rsa_key_prop_cache - properties calculated for a public key
+ *
+ * @key:	Copy of the public key in DER format, NULL if unused
+ * @keylen:	Length of @key
+ * @prop:	Key properties generated from @key
+ */
+static struct rsa_key_prop_cache {
+	void *key;
+	uint keylen;
+	struct key_prop *prop;
+} rsa_key_props[RSA_KEY_PROP_CACHE_SIZE];
+
+static uint rsa_key_props_next;
+
+/**
+ * rsa_key_prop_get() - Get the properties of a public key
+ * @key:	Public key in DER format
+ * @keylen:	Length of @key
+ * @propp:	Returns the key properties
+ *
+ * Calculating R^2 for a key takes longer than checking a signature with it,
+ * so the properties of the last few keys are kept. Keys are recognised by
+ * their contents, not their address, since the buffer holding a key may be
+ * reused.
+ *
+ * Return:	0 on success, -ve on error
+ */
+static int rsa_key_prop_get(const void *key, uint keylen,
+			    struct key_prop **propp)
+{
+	struct rsa_key_prop_cache *entry;
+	void *copy;
+	int ret;
+	int i;
+
+	/*
+	 * Only keep keys once malloc() can free them again. Until then BSS,
+	 * which holds the cache, may not be usable either.
+	 */
+	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT))
+		return rsa_gen_key_prop(key, keylen, propp);
+
+	for (i = 0; i < RSA_KEY_PROP_CACHE_SIZE; i++) {
+		entry = &rsa_key_props[i];
+		if (entry->key && entry->keylen == keylen &&
+		    !memcmp(entry->key, key, keylen)) {
+			*propp = entry->prop;
+			return 0;
+		}
+	}
+
+	ret = rsa_gen_key_prop(key, keylen, propp);
+	if (ret)
+		return ret;
+
+	copy = malloc(keylen);
+	if (!copy)
+		return 0;
+	memcpy(copy, key, keylen);
+
+	entry = &rsa_key_props[rsa_key_props_next];
+	rsa_key_props_next = (rsa_key_props_next + 1) % RSA_KEY_PROP_CACHE_SIZE;
+	free(entry->key);
+	rsa_free_key_prop(entry->prop);
+	entry->key = copy;
+	entry->keylen = keylen;
+	entry->prop = *propp;
+
+	return 0;
+}
+
+/**
+ * rsa_key_prop_put() - Release key properties from rsa_key_prop_get()
+ * @prop:	Key properties
+ */
+static void rsa_key_prop_put(struct key_prop *prop)
+{
+	int i;
+
+	/* Nothing is cached before rsa_key_prop_get() can keep keys */
+	if (gd->flags & GD_FLG_FULL_MALLOC_INIT) {
+		for (i = 0; i < RSA_KEY_PROP_CACHE_SIZE; i++) {
+			if (rsa_key_props[i].prop == prop)
+				return;
+		}
+	}
+	rsa_free_key_prop(prop);
+}
+#else
+static int rsa_key_prop_get(const void *key, uint keylen,
+			    struct key_prop **propp)
+{
+	return rsa_gen_key_prop(key, keylen, propp);
+}
+
+static void rsa_key_prop_put(struct key_prop *prop)
+{
+	rsa_free_key_prop(prop);
+}
+#endif
+
 /**
  * rsa_verify_with_pkey() - Verify a signature against some data using
  * only modulus and exponent as RSA key properties.
@@ -409,7 +524,7 @@ int rsa_verify_with_pkey(struct image_sign_info *info,
 		return -EACCES;
 
 	/* Public key is self-described to fill key_prop */
-	ret = rsa_gen_key_prop(info->key, info->keylen, &prop);
+	ret = rsa_key_prop_get(info->key, info->keylen, &prop);
 	if (ret) {
 		debug("Generating necessary parameter for decoding failed\n");
 		return ret;
@@ -418,7 +533,7 @@ int rsa_verify_with_pkey(struct image_sign_info *info,
 	ret = rsa_verify_key(info, prop, sig, sig_len, hash,
 			     info->crypto->key_len);
 
-	rsa_free_key_prop(prop);
+	rsa_key_prop_put(prop);
 
 	return ret;
 }
@@ -510,8 +625,10 @@ int rsa_verify_hash(struct image_sign_info *info,
 	if (CONFIG_IS_ENABLED(FIT_SIGNATURE)) {
 		const void *blob = info->fdt_blob;
 		int ndepth, noffset;
-		int sig_node, node;
+		int sig_node, node, last;
+		const char *last_name;
 		char name[100];
+		int len;
 
 		sig_node = fdt_subnode_offset(blob, 0, FIT_SIG_NODENAME);
 		if (sig_node < 0) {
@@ -538,17 +655,35 @@ int rsa_verify_hash(struct image_sign_info *info,
 		debug("%s: Could not verify key '%s', trying all\n", __func__,
 		      name);
 
+		/* Then the key which worked last time */
+		last = -FDT_ERR_NOTFOUND;
+		if (*rsa_last_keynode)
+			last = fdt_subnode_offset(blob, sig_node,
+						  rsa_last_keynode);
+		if (last >= 0 && last != node) {
+			ret = rsa_verify_with_keynode(info, hash, sig, sig_len,
+						      last);
+			if (!ret)
+				return ret;
+		}
+
 		/* No luck, so try each of the keys in turn */
 		for (ndepth = 0, noffset = fdt_next_node(blob, sig_node,
 							 &ndepth);
 		     (noffset >= 0) && (ndepth > 0);
 		     noffset = fdt_next_node(blob, noffset, &ndepth)) {
-			if (ndepth == 1 && noffset != node) {
+			if (ndepth == 1 && noffset != node &&
+			    noffset != last) {
 				ret = rsa_verify_with_keynode(info, hash,
 							      sig, sig_len,
 							      noffset);
-				if (!ret)
-					break;
+				if (ret)
+					continue;
+
+				last_name = fdt_get_name(blob, noffset, &len);
+				if (last_name && len < sizeof(rsa_last_keynode))
+					strcpy(rsa_last_keynode, last_name);
+				return 0;
 			}
 		}
 	}
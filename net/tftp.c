@@ -730,6 +730,7 @@ static int tftp_init_load_addr(void)
 	lmb_init_and_reserve(&lmb, gd->bd, (void *)gd->fdt_blob);
 
 	max_size = lmb_get_free_size(&lmb, image_load_addr);
+	lmb_uninit(&lmb);
 	if (!max_size)
 		return -1;
 
@@ -64,6 +64,7 @@ static int fdt_splice_(void *fdt, void *splicepoint, int oldlen, int newlen)
 		return -FDT_ERR_BADOFFSET;
 	if ((end - oldlen + newlen) > ((char *)fdt + fdt_totalsize(fdt)))
 		return -FDT_ERR_NOSPACE;
+	FDT_STRUCT_CHANGED(fdt);
 	memmove(p + newlen, p + oldlen, end - p - oldlen);
 	return 0;
 }
@@ -65,6 +65,7 @@ int fdt_nop_property(void *fdt, int nodeoffset, const char *name)
 	if (!prop)
 		return len;
 
+	FDT_STRUCT_CHANGED(fdt);
 	fdt_nop_region_(prop, len + sizeof(*prop));
 
 	return 0;
@@ -88,6 +89,7 @@ int fdt_nop_node(void *fdt, int nodeoffset)
 	if (endoffset < 0)
 		return endoffset;
 
+	FDT_STRUCT_CHANGED(fdt);
 	fdt_nop_region_(fdt_offset_ptr_w(fdt, nodeoffset, 0),
 			endoffset - nodeoffset);
 	return 0;
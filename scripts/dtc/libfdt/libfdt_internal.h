@@ -134,4 +134,14 @@ static inline bool fdt_chk_extra(void)
 	return !(FDT_ASSUME_MASK & FDT_ASSUME_FRIENDLY);
 }
 
+/*
+ * U-Boot: FDT_STRUCT_CHANGED(fdt) is called before nodes or properties of
+ * @fdt are added, removed or renamed, which moves or invalidates their
+ * offsets. The environment can define it to drop anything which holds such
+ * offsets.
+ */
+#ifndef FDT_STRUCT_CHANGED
+#define FDT_STRUCT_CHANGED(fdt)	do { } while (0)
+#endif
+
 #endif /* LIBFDT_INTERNAL_H */
@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the generic filesystem 'load' command
+ */
+
+#include <common.h>
+#include <command.h>
+#include <console.h>
+#include <env.h>
+#include <mapmem.h>
+#include <os.h>
+#include <test/suites.h>
+#include <test/ut.h>
+#include <u-boot/sha256.h>
+
+#define LOAD_FILE	"load_hash.bin"
+#define SRC_ADDR	0x100000
+#define DST_ADDR	0x400000
+/* More than one chunk, so the hash is calculated while reading */
+#define FILE_SIZE	0x280000
+
+/* Declare a new load test */
+#define LOAD_TEST(_name, _flags)	UNIT_TEST(_name, _flags, load_test)
+
+/* Check the digest line printed by 'load -h sha256' */
+static int check_digest(struct unit_test_state *uts, const void *buf,
+			ulong addr, ulong size)
+{
+	u8 digest[SHA256_SUM_LEN];
+	char hex[SHA256_SUM_LEN * 2 + 1];
+	int i;
+
+	sha256_csum_wd(buf, size, digest, CHUNKSZ_SHA256);
+	for (i = 0; i < SHA256_SUM_LEN; i++)
+		sprintf(hex + i * 2, "%02x", digest[i]);
+	ut_assert_nextlinen("%lu bytes read in", size);
+	ut_assert_nextline("sha256 for %08lx ... %08lx ==> %s", addr,
+			   addr + size - 1, hex);
+	ut_assert_console_end();
+
+	return 0;
+}
+
+/* Test hashing a file while it is loaded */
+static int load_test_hash(struct unit_test_state *uts)
+{
+	u8 *src, *dst;
+	int i;
+
+	src = map_sysmem(SRC_ADDR, FILE_SIZE);
+	for (i = 0; i < FILE_SIZE; i++)
+		src[i] = i * 7 + (i >> 12);
+	ut_assertok(os_write_file(LOAD_FILE, src, FILE_SIZE));
+	dst = map_sysmem(DST_ADDR, FILE_SIZE);
+	memset(dst, '\0', FILE_SIZE);
+
+	/* The whole file */
+	ut_assertok(console_record_reset_enable());
+	ut_assertok(run_command("load -h sha256 hostfs - 400000 " LOAD_FILE,
+				0));
+	ut_assertok(check_digest(uts, src, DST_ADDR, FILE_SIZE));
+	ut_asserteq_mem(src, dst, FILE_SIZE);
+	ut_asserteq(FILE_SIZE, env_get_hex("filesize", 0));
+
+	/* Part of it, starting at an offset */
+	ut_assertok(run_command("load -h sha256 hostfs - 400000 " LOAD_FILE
+				" 123456 1200", 0));
+	ut_assertok(check_digest(uts, src + 0x1200, DST_ADDR, 0x123456));
+
+	/* An unknown algorithm is an error */
+	ut_asserteq(1, run_command("load -h fred hostfs - 400000 " LOAD_FILE,
+				   0));
+	ut_assert_nextline("Unknown hash algorithm 'fred'");
+	ut_assert_nextline("Failed to load '%s'", LOAD_FILE);
+	ut_assert_console_end();
+
+	unmap_sysmem(dst);
+	unmap_sysmem(src);
+	os_unlink(LOAD_FILE);
+
+	return 0;
+}
+LOAD_TEST(load_test_hash, UT_TESTF_CONSOLE_REC);
+
+int do_ut_load(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
+{
+	struct unit_test *tests = UNIT_TEST_SUITE_START(load_test);
+	const int n_ents = UNIT_TEST_SUITE_COUNT(load_test);
+
+	return cmd_ut_category("cmd_load", "load_test_", tests, n_ents,
+			       argc, argv);
+}
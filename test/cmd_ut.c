@@ -44,6 +44,10 @@ static struct cmd_tbl cmd_ut_sub[] = {
 #ifdef CONFIG_UT_LIB
 	U_BOOT_CMD_MKENT(lib, CONFIG_SYS_MAXARGS, 1, do_ut_lib, "", ""),
 #endif
+#if defined(CONFIG_SANDBOX) && defined(CONFIG_CMD_FS_GENERIC) && \
+	defined(CONFIG_HASH)
+	U_BOOT_CMD_MKENT(load, CONFIG_SYS_MAXARGS, 1, do_ut_load, "", ""),
+#endif
 #ifdef CONFIG_UT_LOG
 	U_BOOT_CMD_MKENT(log, CONFIG_SYS_MAXARGS, 1, do_ut_log, "", ""),
 #endif
@@ -124,6 +128,10 @@ static char ut_help_text[] =
 #ifdef CONFIG_UT_LIB
 	"ut lib [test-name] - test library functions\n"
 #endif
+#if defined(CONFIG_SANDBOX) && defined(CONFIG_CMD_FS_GENERIC) && \
+	defined(CONFIG_HASH)
+	"ut load [test-name] - test the load command\n"
+#endif
 #ifdef CONFIG_UT_LOG
 	"ut log [test-name] - test logging functions\n"
 #endif
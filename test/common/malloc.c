@@ -0,0 +1,180 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the heap for large malloc() blocks and the slab caches
+ */
+
+#include <common.h>
+#include <console.h>
+#include <malloc.h>
+#include <malloc_cache.h>
+#include <test/common.h>
+#include <test/ut.h>
+
+#define LARGE_SIZE	CONFIG_SYS_MALLOC_LARGE_THRESHOLD
+
+static bool in_main_heap(void *ptr)
+{
+	return (ulong)ptr >= mem_malloc_start && (ulong)ptr < mem_malloc_end;
+}
+
+/* Test that large blocks are kept out of the main heap */
+static int common_test_malloc_large(struct unit_test_state *uts)
+{
+	struct malloc_heap_info before, info;
+	ulong start = ut_check_free();
+	char *ptr, *ptr2;
+	int i;
+
+	malloc_get_heap_info(&before);
+	ut_assert(before.large_size);
+
+	ptr = malloc(LARGE_SIZE);
+	ut_assertnonnull(ptr);
+	ut_assert(!in_main_heap(ptr));
+	malloc_get_heap_info(&info);
+	ut_asserteq(before.in_use, info.in_use);
+	ut_asserteq(before.large_blocks + 1, info.large_blocks);
+	ut_assert(info.large_in_use > before.large_in_use + LARGE_SIZE);
+
+	/* Smaller blocks still come from the main heap */
+	ptr2 = malloc(LARGE_SIZE / 2);
+	ut_assert(in_main_heap(ptr2));
+	free(ptr2);
+
+	/* realloc() keeps the contents */
+	memset(ptr, 0xaa, LARGE_SIZE);
+	ptr = realloc(ptr, LARGE_SIZE * 2);
+	ut_assertnonnull(ptr);
+	ut_assert(!in_main_heap(ptr));
+	for (i = 0; i < LARGE_SIZE; i++)
+		ut_asserteq(0xaa, (u8)ptr[i]);
+	free(ptr);
+	malloc_get_heap_info(&info);
+	ut_asserteq(before.large_in_use, info.large_in_use);
+
+	/* calloc() clears the memory even though free() does not */
+	ptr = malloc(LARGE_SIZE);
+	memset(ptr, 0xaa, LARGE_SIZE);
+	free(ptr);
+	ptr = calloc(1, LARGE_SIZE);
+	ut_assertnonnull(ptr);
+	for (i = 0; i < LARGE_SIZE; i++)
+		ut_asserteq(0, ptr[i]);
+	free(ptr);
+
+	ptr = memalign(0x10000, LARGE_SIZE);
+	ut_assertnonnull(ptr);
+	ut_assert(!in_main_heap(ptr));
+	ut_asserteq(0, (ulong)ptr & 0xffff);
+	free(ptr);
+
+	ut_asserteq(0, ut_check_delta(start));
+
+	return 0;
+}
+COMMON_TEST(common_test_malloc_large, 0);
+
+/* Test that a full heap for large blocks falls back to the main heap */
+static int common_test_malloc_large_full(struct unit_test_state *uts)
+{
+	struct malloc_heap_info info;
+	ulong start = ut_check_free();
+	void *ptrs[4], *ptr;
+	int i, count;
+
+	/* Fill each free area, leaving room for the chunk header */
+	for (count = 0; count < ARRAY_SIZE(ptrs); count++) {
+		malloc_get_heap_info(&info);
+		if (info.large_largest_free < LARGE_SIZE * 2)
+			break;
+		ptrs[count] = malloc(info.large_largest_free - 0x40);
+		ut_assertnonnull(ptrs[count]);
+		ut_assert(!in_main_heap(ptrs[count]));
+	}
+	ut_assert(count < ARRAY_SIZE(ptrs));
+
+	ptr = malloc(LARGE_SIZE * 2);
+	ut_assertnonnull(ptr);
+	ut_assert(in_main_heap(ptr));
+
+	free(ptr);
+	for (i = 0; i < count; i++)
+		free(ptrs[i]);
+	ut_asserteq(0, ut_check_delta(start));
+
+	return 0;
+}
+COMMON_TEST(common_test_malloc_large_full, 0);
+
+static MALLOC_CACHE(test_cache, 40);
+
+/* Test allocating from a slab cache */
+static int common_test_malloc_cache(struct unit_test_state *uts)
+{
+	ulong unused = malloc_cache_unused();
+	ulong start = ut_check_free();
+	void *objs[200], *ptr;
+	int i, per_slab;
+
+	objs[0] = malloc_cache_alloc(&test_cache);
+	ut_assertnonnull(objs[0]);
+	ut_asserteq(1, test_cache.slab_count);
+	per_slab = test_cache.per_slab;
+	ut_assert(per_slab > 1 && per_slab < ARRAY_SIZE(objs) / 2);
+
+	/* Objects are handed out in order and cleared */
+	memset(objs[0], 0xaa, test_cache.size);
+	malloc_cache_free(&test_cache, objs[0]);
+	ut_asserteq(0, test_cache.slab_count);
+	for (i = 0; i < per_slab * 2; i++) {
+		objs[i] = malloc_cache_alloc(&test_cache);
+		ut_assertnonnull(objs[i]);
+		ut_asserteq(0, *(ulong *)objs[i]);
+		if (i % per_slab)
+			ut_asserteq_ptr(objs[i - 1] + test_cache.size, objs[i]);
+	}
+	ut_asserteq(2, test_cache.slab_count);
+	ut_asserteq(per_slab * 2, test_cache.in_use);
+	ut_asserteq(unused, malloc_cache_unused());
+
+	/* A freed object is used again */
+	malloc_cache_free(&test_cache, objs[3]);
+	ut_asserteq(unused + test_cache.size, malloc_cache_unused());
+	ut_asserteq_ptr(objs[3], malloc_cache_alloc(&test_cache));
+
+	/* Slabs are freed once empty */
+	for (i = 0; i < per_slab; i++)
+		malloc_cache_free(&test_cache, objs[i]);
+	ut_asserteq(1, test_cache.slab_count);
+	for (; i < per_slab * 2; i++)
+		malloc_cache_free(&test_cache, objs[i]);
+	ut_asserteq(0, test_cache.slab_count);
+	ut_asserteq(0, test_cache.in_use);
+
+	/* Other blocks are passed to free() */
+	ptr = malloc(40);
+	malloc_cache_free(&test_cache, ptr);
+	ut_asserteq(0, ut_check_delta(start));
+
+	return 0;
+}
+COMMON_TEST(common_test_malloc_cache, 0);
+
+/* Test the 'malloc info' command */
+static int common_test_malloc_cmd(struct unit_test_state *uts)
+{
+	ut_assertok(console_record_reset_enable());
+	ut_assertok(run_command("malloc info", 0));
+	ut_assert_nextlinen("heap        size ");
+	ut_assert_nextlinen("            largest free ");
+	ut_assert_nextlinen("large heap  size %x, ",
+			    CONFIG_SYS_MALLOC_LARGE_LEN);
+	ut_assert_nextlinen("            largest free ");
+	ut_assert_nextlinen("caches      unused ");
+	ut_assert_nextline("cache                  size   in use    total  slabs");
+	ut_assert_nextlinen("uclass_cache ");
+	ut_assert_nextlinen("udevice_cache ");
+
+	return 0;
+}
+COMMON_TEST(common_test_malloc_cmd, UT_TESTF_CONSOLE_REC);
@@ -0,0 +1,273 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the simple malloc() pool with SYS_MALLOC_F_ARENA
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <asm/global_data.h>
+#include <test/common.h>
+#include <test/ut.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define POOL_SIZE	0x1000
+
+/* Run a test with the simple malloc() pool set up in a fresh buffer */
+static int run_with_pool(struct unit_test_state *uts,
+			 int (*func)(struct unit_test_state *uts))
+{
+	ulong base = gd->malloc_base;
+	ulong limit = gd->malloc_limit;
+	ulong ptr = gd->malloc_ptr;
+	ulong peak = gd->malloc_peak;
+	void *pool;
+	int ret;
+
+	pool = malloc(POOL_SIZE);
+	ut_assertnonnull(pool);
+	gd->malloc_base = map_to_sysmem(pool);
+	gd->malloc_limit = POOL_SIZE;
+	gd->malloc_ptr = 0;
+
+	ret = func(uts);
+
+	gd->malloc_base = base;
+	gd->malloc_limit = limit;
+	gd->malloc_ptr = ptr;
+	gd->malloc_peak = peak;
+	free(pool);
+
+	return ret;
+}
+
+static int test_free(struct unit_test_state *uts)
+{
+	void *ptr1, *ptr2, *ptr3, *ptr4;
+	ulong start;
+
+	ptr1 = malloc_simple(40);
+	ptr2 = malloc_simple(40);
+	ptr3 = malloc_simple(100);
+	ut_assertnonnull(ptr1);
+	ut_assertnonnull(ptr2);
+	ut_assertnonnull(ptr3);
+	start = map_to_sysmem(ptr1) - sizeof(ulong) - gd->malloc_base;
+
+	/* A freed block is handed out again for the same size */
+	free_simple(ptr2);
+	ptr4 = malloc_simple(36);
+	ut_asserteq_ptr(ptr2, ptr4);
+
+	/* but not for a larger one */
+	free_simple(ptr4);
+	ptr4 = malloc_simple(200);
+	ut_assert(ptr4 > ptr3);
+
+	/* Freeing the top block lowers the top of the pool */
+	free_simple(ptr4);
+	ut_asserteq(map_to_sysmem(ptr4) - sizeof(ulong),
+		    gd->malloc_base + gd->malloc_ptr);
+
+	/* ...past any free blocks below it */
+	free_simple(ptr3);
+	ut_asserteq(map_to_sysmem(ptr2) - sizeof(ulong),
+		    gd->malloc_base + gd->malloc_ptr);
+	free_simple(ptr1);
+	ut_asserteq(start, gd->malloc_ptr);
+
+	/* Anything above the top of the pool is ignored */
+	free_simple(NULL);
+	free_simple(ptr3);
+	ut_asserteq(start, gd->malloc_ptr);
+	ut_asserteq_ptr(ptr1, malloc_simple(40));
+
+	return 0;
+}
+
+static int common_test_malloc_simple_free(struct unit_test_state *uts)
+{
+	return run_with_pool(uts, test_free);
+}
+COMMON_TEST(common_test_malloc_simple_free, 0);
+
+static int test_exhaust(struct unit_test_state *uts)
+{
+	void *ptr, *last = NULL;
+	int count = 0;
+
+	/* Fill the pool, then check that freed space can be used again */
+	while ((ptr = malloc_simple(100))) {
+		last = ptr;
+		count++;
+	}
+	ut_assert(count > 1);
+	ut_assert(gd->malloc_ptr <= POOL_SIZE);
+	ut_asserteq(gd->malloc_ptr, gd->malloc_peak);
+
+	free_simple(last);
+	ut_asserteq_ptr(last, malloc_simple(100));
+	ut_assertnull(malloc_simple(100));
+
+	return 0;
+}
+
+static int common_test_malloc_simple_exhaust(struct unit_test_state *uts)
+{
+	return run_with_pool(uts, test_exhaust);
+}
+COMMON_TEST(common_test_malloc_simple_exhaust, 0);
+
+static int test_realloc(struct unit_test_state *uts)
+{
+	char *ptr1, *ptr2, *ptr3;
+
+	ptr1 = realloc_simple(NULL, 16);
+	ut_assertnonnull(ptr1);
+	strcpy(ptr1, "test");
+
+	/* The top block grows in place, and shrinking does nothing */
+	ut_asserteq_ptr(ptr1, realloc_simple(ptr1, 64));
+	ut_asserteq_ptr(ptr1, realloc_simple(ptr1, 8));
+
+	/* Other blocks are moved */
+	ptr2 = malloc_simple(16);
+	ut_assertnonnull(ptr2);
+	ptr3 = realloc_simple(ptr1, 128);
+	ut_assert(ptr3 > ptr2);
+	ut_asserteq_str("test", ptr3);
+
+	/* and the old block is freed */
+	ut_asserteq_ptr(ptr1, malloc_simple(64));
+
+	/* A failed realloc() leaves the block alone */
+	ut_assertnull(realloc_simple(ptr3, POOL_SIZE));
+	ut_asserteq_str("test", ptr3);
+
+	return 0;
+}
+
+static int common_test_malloc_simple_realloc(struct unit_test_state *uts)
+{
+	return run_with_pool(uts, test_realloc);
+}
+COMMON_TEST(common_test_malloc_simple_realloc, 0);
+
+static int test_memalign(struct unit_test_state *uts)
+{
+	void *ptr1, *ptr2;
+
+	ut_assertnonnull(malloc_simple(8));
+	ptr1 = memalign_simple(64, 24);
+	ut_assertnonnull(ptr1);
+	ut_asserteq(0, map_to_sysmem(ptr1) & 63);
+
+	/* An aligned block is freed like any other */
+	ptr2 = malloc_simple(24);
+	free_simple(ptr1);
+	ut_asserteq_ptr(ptr1, malloc_simple(24));
+	ut_assert(ptr2 > ptr1);
+
+	return 0;
+}
+
+static int common_test_malloc_simple_memalign(struct unit_test_state *uts)
+{
+	return run_with_pool(uts, test_memalign);
+}
+COMMON_TEST(common_test_malloc_simple_memalign, 0);
+
+static int test_release(struct unit_test_state *uts)
+{
+	void *keep, *ptr1, *ptr2;
+	ulong mark, peak;
+
+	keep = malloc_simple(32);
+	ut_assertnonnull(keep);
+	mark = malloc_simple_mark();
+
+	ptr1 = malloc_simple(32);
+	ptr2 = malloc_simple(500);
+	ut_assertnonnull(ptr1);
+	ut_assertnonnull(ptr2);
+	ut_assertnonnull(malloc_simple(32));
+	free_simple(ptr1);
+	peak = gd->malloc_ptr;
+
+	/* Everything since the mark goes, including the free lists */
+	malloc_simple_release(mark);
+	ut_asserteq(mark, gd->malloc_ptr);
+	ut_asserteq(peak, gd->malloc_peak);
+	ut_asserteq_ptr(ptr1, malloc_simple(32));
+
+	/* A later mark is no use once released */
+	malloc_simple_release(peak);
+	ut_asserteq(map_to_sysmem(ptr1) + 32 - gd->malloc_base,
+		    gd->malloc_ptr);
+
+	/* Earlier allocations are kept */
+	free_simple(ptr1);
+	free_simple(keep);
+	ut_asserteq(mark - 32 - sizeof(ulong), gd->malloc_ptr);
+
+	return 0;
+}
+
+static int common_test_malloc_simple_release(struct unit_test_state *uts)
+{
+	return run_with_pool(uts, test_release);
+}
+COMMON_TEST(common_test_malloc_simple_release, 0);
+
+static int test_release_lists(struct unit_test_state *uts)
+{
+	void *low, *ptr;
+	ulong mark;
+
+	low = malloc_simple(32);
+	ut_assertnonnull(low);
+	ut_assertnonnull(malloc_simple(32));
+	free_simple(low);
+	mark = malloc_simple_mark();
+
+	/* The free lists are not used while there is a mark */
+	ptr = malloc_simple(32);
+	ut_assertnonnull(ptr);
+	ut_assert(map_to_sysmem(ptr) > gd->malloc_base + mark);
+	malloc_simple_release(mark);
+	ut_asserteq(mark, gd->malloc_ptr);
+
+	/* but are once it is released */
+	ut_asserteq_ptr(low, malloc_simple(32));
+
+	return 0;
+}
+
+static int common_test_malloc_simple_release_lists(struct unit_test_state *uts)
+{
+	return run_with_pool(uts, test_release_lists);
+}
+COMMON_TEST(common_test_malloc_simple_release_lists, 0);
+
+static int test_avail(struct unit_test_state *uts)
+{
+	ulong avail;
+
+	ut_assertnonnull(malloc_simple(100));
+	avail = malloc_simple_avail();
+	ut_assert(avail > 0 && avail < POOL_SIZE);
+
+	/* All of it can be allocated in one block */
+	ut_assertnonnull(malloc_simple(avail));
+	ut_asserteq(0, malloc_simple_avail());
+	ut_asserteq(POOL_SIZE, gd->malloc_ptr);
+
+	return 0;
+}
+
+static int common_test_malloc_simple_avail(struct unit_test_state *uts)
+{
+	return run_with_pool(uts, test_avail);
+}
+COMMON_TEST(common_test_malloc_simple_avail, 0);
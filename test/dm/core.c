@@ -110,6 +110,7 @@ int dm_leak_check_end(struct unit_test_state *uts)
 	else if (diff < 0)
 		printf("Leak: gained %#xd bytes\n", -diff);
 	ut_asserteq(uts->start.uordblks, end.uordblks);
+	ut_asserteq(uts->start.hblkhd, end.hblkhd);
 
 	return 0;
 }
@@ -284,6 +285,95 @@ static int dm_test_autoprobe(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_autoprobe, UT_TESTF_SCAN_PDATA);
 
+/* Test that devices marked for deferred probing are probed on first use */
+static int dm_test_probe_deferred(struct unit_test_state *uts)
+{
+	struct udevice *dev;
+
+	if (!CONFIG_IS_ENABLED(DM_DEFERRED_PROBE))
+		return -EAGAIN;
+
+	ut_assertok(uclass_find_device_by_name(UCLASS_TEST_FDT, "b-test",
+					       &dev));
+	ut_assert(dev_get_flags(dev) & DM_FLAG_PROBE_DEFERRED);
+	ut_assert(!device_active(dev));
+	ut_assert(device_probe_deferred(dev));
+
+	/* Asking for the device probes it as usual */
+	ut_assertok(uclass_get_device_by_name(UCLASS_TEST_FDT, "b-test",
+					      &dev));
+	ut_assert(device_active(dev));
+	ut_assert(!device_probe_deferred(dev));
+
+	/* Devices without the property are not affected */
+	ut_assertok(uclass_find_device_by_name(UCLASS_TEST_FDT, "a-test",
+					       &dev));
+	ut_assert(!(dev_get_flags(dev) & DM_FLAG_PROBE_DEFERRED));
+	ut_assert(!device_probe_deferred(dev));
+
+	return 0;
+}
+DM_TEST(dm_test_probe_deferred, UT_TESTF_SCAN_FDT);
+
+/* Test finding devices by their node through the hash table */
+static int dm_test_ofnode_hash(struct unit_test_state *uts)
+{
+	struct device_ofnode_hash_stats stats;
+	struct udevice *dev, *found, *expect;
+	struct uclass *uc;
+	ulong lookups;
+	ofnode node;
+	uint count;
+
+	if (!CONFIG_IS_ENABLED(DM_OFNODE_HASH))
+		return -EAGAIN;
+
+	device_ofnode_hash_get_stats(&stats);
+	lookups = stats.lookups;
+
+	/* Each device must give the same result as a search of its uclass */
+	list_for_each_entry(uc, gd->uclass_root, sibling_node) {
+		uclass_foreach_dev(dev, uc) {
+			node = dev_ofnode(dev);
+			if (!ofnode_valid(node))
+				continue;
+			uclass_foreach_dev(expect, uc) {
+				if (ofnode_equal(dev_ofnode(expect), node))
+					break;
+			}
+			ut_assertok(uclass_find_device_by_ofnode(uc->uc_drv->id,
+								 node, &found));
+			ut_asserteq_ptr(expect, found);
+
+			/* No parent of a global match may use the node */
+			ut_assertok(device_find_global_by_ofnode(node, &found));
+			ut_assert(ofnode_equal(dev_ofnode(found), node));
+			for (expect = found->parent; expect;
+			     expect = expect->parent)
+				ut_assert(!ofnode_equal(dev_ofnode(expect), node));
+		}
+	}
+
+	device_ofnode_hash_get_stats(&stats);
+	ut_assert(stats.lookups > lookups);
+	ut_assert(stats.devices > 0);
+	count = stats.devices;
+
+	/* An unbound device can no longer be found */
+	ut_assertok(uclass_find_device_by_name(UCLASS_TEST_FDT, "a-test",
+					       &dev));
+	node = dev_ofnode(dev);
+	ut_assertok(device_unbind(dev));
+	ut_asserteq(-ENODEV, uclass_find_device_by_ofnode(UCLASS_TEST_FDT, node,
+							  &found));
+	ut_asserteq(-ENOENT, device_find_global_by_ofnode(node, &found));
+	device_ofnode_hash_get_stats(&stats);
+	ut_asserteq(count - 1, stats.devices);
+
+	return 0;
+}
+DM_TEST(dm_test_ofnode_hash, UT_TESTF_SCAN_FDT);
+
 /* Check that we see the correct plat in each device */
 static int dm_test_plat(struct unit_test_state *uts)
 {
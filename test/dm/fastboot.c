@@ -7,9 +7,11 @@
 #include <dm.h>
 #include <fastboot.h>
 #include <fb_mmc.h>
+#include <malloc.h>
 #include <mmc.h>
 #include <part.h>
 #include <part_efi.h>
+#include <sparse_format.h>
 #include <dm/test.h>
 #include <test/ut.h>
 #include <linux/stringify.h>
@@ -93,3 +95,177 @@ static int dm_test_fastboot_mmc_part(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_fastboot_mmc_part, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
+#if CONFIG_IS_ENABLED(FASTBOOT_CMD_OEM_STREAM)
+static int fastboot_test_cmd(struct unit_test_state *uts, const char *cmd,
+			     const char *expect)
+{
+	char response[FASTBOOT_RESPONSE_LEN] = {0};
+	char buf[64];
+
+	strlcpy(buf, cmd, sizeof(buf));
+	fastboot_handle_command(buf, response);
+	ut_asserteq_strn(expect, response);
+
+	return 0;
+}
+
+/* Send an image in uneven pieces, as if it arrived over USB */
+static int fastboot_test_download(struct unit_test_state *uts,
+				  const u8 *img, u32 size)
+{
+	char response[FASTBOOT_RESPONSE_LEN] = {0};
+	char cmd[32];
+	u32 pos, len, piece = 1;
+
+	snprintf(cmd, sizeof(cmd), "download:%08x", size);
+	ut_assertok(fastboot_test_cmd(uts, cmd, "DATA"));
+
+	for (pos = 0; pos < size; pos += len) {
+		len = min(piece, size - pos);
+		fastboot_data_download(img + pos, len, response);
+		ut_asserteq_str("", response);
+		piece = piece * 3 + 1;
+	}
+	ut_asserteq(0, fastboot_data_remaining());
+	fastboot_data_complete(response);
+	ut_asserteq_str("OKAY", response);
+
+	return 0;
+}
+
+static int dm_test_fastboot_mmc_stream(struct unit_test_state *uts)
+{
+	struct blk_desc *mmc_dev_desc;
+	struct disk_partition parts[] = {
+		{
+			.start = 48,
+			.size = 128,
+			.name = "stream",
+		},
+	};
+	const u32 blksz = 512;
+	char str_disk_guid[UUID_STR_LEN + 1];
+	sparse_header_t *hdr;
+	chunk_header_t *chunk;
+	u8 *img, *buf, *ptr;
+	u32 raw_size, size;
+	int i;
+
+	ut_assertok(blk_get_device_by_str("mmc", "0", &mmc_dev_desc));
+	ut_asserteq(blksz, mmc_dev_desc->blksz);
+	if (CONFIG_IS_ENABLED(RANDOM_UUID)) {
+		gen_rand_uuid_str(parts[0].uuid, UUID_STR_FORMAT_STD);
+		gen_rand_uuid_str(str_disk_guid, UUID_STR_FORMAT_STD);
+	}
+	ut_assertok(gpt_restore(mmc_dev_desc, str_disk_guid, parts,
+				ARRAY_SIZE(parts)));
+	fastboot_init(NULL, 0);
+
+	/* A raw image larger than the download buffer */
+	raw_size = ALIGN(CONFIG_FASTBOOT_BUF_SIZE, blksz) + 3 * blksz + 100;
+	ut_assert(raw_size < parts[0].size * blksz);
+	img = malloc(raw_size);
+	buf = malloc(parts[0].size * blksz);
+	ut_assertnonnull(img);
+	ut_assertnonnull(buf);
+	for (i = 0; i < raw_size; i++)
+		img[i] = i * 7 + i / 251;
+
+	/* Nothing is written until a partition is chosen */
+	snprintf((char *)buf, 32, "download:%08x", raw_size);
+	ut_assertok(fastboot_test_cmd(uts, (char *)buf, "FAIL"));
+
+	ut_assertok(fastboot_test_cmd(uts, "oem stream:stream", "OKAY"));
+	ut_assertok(fastboot_test_download(uts, img, raw_size));
+	ut_assertok(fastboot_test_cmd(uts, "flash:other", "FAIL"));
+	ut_assertok(fastboot_test_download(uts, img, raw_size));
+	ut_assertok(fastboot_test_cmd(uts, "flash:stream", "OKAY"));
+
+	ut_asserteq(DIV_ROUND_UP(raw_size, blksz),
+		    blk_dread(mmc_dev_desc, parts[0].start,
+			      DIV_ROUND_UP(raw_size, blksz), buf));
+	ut_asserteq_mem(img, buf, raw_size);
+	for (i = raw_size; i < ALIGN(raw_size, blksz); i++)
+		ut_asserteq(0, buf[i]);
+
+	/*
+	 * A sparse image: two raw blocks, three filled, one left alone and
+	 * one more raw block
+	 */
+	ptr = img;
+	hdr = (sparse_header_t *)ptr;
+	memset(hdr, '\0', sizeof(*hdr));
+	hdr->magic = SPARSE_HEADER_MAGIC;
+	hdr->major_version = 1;
+	hdr->file_hdr_sz = sizeof(*hdr);
+	hdr->chunk_hdr_sz = sizeof(*chunk);
+	hdr->blk_sz = blksz;
+	hdr->total_blks = 7;
+	hdr->total_chunks = 4;
+	ptr += sizeof(*hdr);
+
+	chunk = (chunk_header_t *)ptr;
+	chunk->chunk_type = CHUNK_TYPE_RAW;
+	chunk->chunk_sz = 2;
+	chunk->total_sz = sizeof(*chunk) + 2 * blksz;
+	ptr += sizeof(*chunk);
+	for (i = 0; i < 2 * blksz; i++)
+		*ptr++ = i ^ 0xa5;
+
+	chunk = (chunk_header_t *)ptr;
+	chunk->chunk_type = CHUNK_TYPE_FILL;
+	chunk->chunk_sz = 3;
+	chunk->total_sz = sizeof(*chunk) + sizeof(u32);
+	ptr += sizeof(*chunk);
+	memset(ptr, 0x5a, sizeof(u32));
+	ptr += sizeof(u32);
+
+	chunk = (chunk_header_t *)ptr;
+	chunk->chunk_type = CHUNK_TYPE_DONT_CARE;
+	chunk->chunk_sz = 1;
+	chunk->total_sz = sizeof(*chunk);
+	ptr += sizeof(*chunk);
+
+	chunk = (chunk_header_t *)ptr;
+	chunk->chunk_type = CHUNK_TYPE_RAW;
+	chunk->chunk_sz = 1;
+	chunk->total_sz = sizeof(*chunk) + blksz;
+	ptr += sizeof(*chunk);
+	memset(ptr, 0x3c, blksz);
+	ptr += blksz;
+	size = ptr - img;
+
+	/* The block which is not cared about keeps its contents */
+	memset(buf, 0xff, 7 * blksz);
+	ut_asserteq(7, blk_dwrite(mmc_dev_desc, parts[0].start, 7, buf));
+
+	ut_assertok(fastboot_test_download(uts, img, size));
+	ut_assertok(fastboot_test_cmd(uts, "flash:stream", "OKAY"));
+
+	ut_asserteq(7, blk_dread(mmc_dev_desc, parts[0].start, 7, buf));
+	for (i = 0; i < 2 * blksz; i++)
+		ut_asserteq((u8)(i ^ 0xa5), buf[i]);
+	for (; i < 5 * blksz; i++)
+		ut_asserteq(0x5a, buf[i]);
+	for (; i < 6 * blksz; i++)
+		ut_asserteq(0xff, buf[i]);
+	for (; i < 7 * blksz; i++)
+		ut_asserteq(0x3c, buf[i]);
+
+	/* A truncated sparse image fails the download */
+	ut_assertok(fastboot_test_cmd(uts, "download:00000100", "DATA"));
+	fastboot_data_download(img, 0x100, (char *)buf);
+	ut_asserteq_str("", (char *)buf);
+	fastboot_data_complete((char *)buf);
+	ut_asserteq_strn("FAIL", (char *)buf);
+	ut_assertok(fastboot_test_cmd(uts, "flash:stream", "FAIL"));
+
+	ut_assertok(fastboot_test_cmd(uts, "oem stream", "OKAY"));
+	free(buf);
+	free(img);
+
+	return 0;
+}
+DM_TEST(dm_test_fastboot_mmc_stream, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+#endif
@@ -5,6 +5,7 @@
 
 #include <common.h>
 #include <dm.h>
+#include <fdt_support.h>
 #include <asm/global_data.h>
 #include <dm/of_extra.h>
 #include <dm/test.h>
@@ -130,3 +131,128 @@ static int dm_test_fdtdec_add_reserved_memory(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_fdtdec_add_reserved_memory,
 	UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT | UT_TESTF_FLAT_TREE);
+
+/* Check that two FDTs have the same nodes and properties, in the same order */
+static int check_fdt_same(struct unit_test_state *uts, const void *fdt1,
+			  const void *fdt2)
+{
+	int node1, node2, prop1, prop2, len1, len2;
+	int depth1 = 0, depth2 = 0;
+	const char *name1, *name2;
+	const void *val1, *val2;
+
+	for (node1 = 0, node2 = 0; depth1 >= 0;
+	     node1 = fdt_next_node(fdt1, node1, &depth1),
+	     node2 = fdt_next_node(fdt2, node2, &depth2)) {
+		ut_assert(node1 >= 0);
+		ut_assert(node2 >= 0);
+		ut_asserteq(depth1, depth2);
+		ut_asserteq_str(fdt_get_name(fdt1, node1, NULL),
+				fdt_get_name(fdt2, node2, NULL));
+
+		prop2 = fdt_first_property_offset(fdt2, node2);
+		fdt_for_each_property_offset(prop1, fdt1, node1) {
+			ut_assert(prop2 >= 0);
+			val1 = fdt_getprop_by_offset(fdt1, prop1, &name1, &len1);
+			val2 = fdt_getprop_by_offset(fdt2, prop2, &name2, &len2);
+			ut_asserteq_str(name1, name2);
+			ut_asserteq(len1, len2);
+			ut_asserteq_mem(val1, val2, len1);
+			prop2 = fdt_next_property_offset(fdt2, prop2);
+		}
+		ut_asserteq(-FDT_ERR_NOTFOUND, prop2);
+	}
+	ut_asserteq(depth1, depth2);
+
+	return 0;
+}
+
+static int dm_test_fdt_batch(struct unit_test_state *uts)
+{
+	const char *compat = "denx,u-boot-fdt-test-with-a-longer-name";
+	struct fdt_batch batch;
+	char big[64] = { 0 };
+	void *blob, *ref;
+	int blob_sz, node, port, child;
+
+	blob_sz = fdt_totalsize(gd->fdt_blob) + 4096;
+	blob = malloc(blob_sz);
+	ut_assertnonnull(blob);
+	ref = malloc(blob_sz);
+	ut_assertnonnull(ref);
+	ut_assertok(fdt_open_into(gd->fdt_blob, blob, blob_sz));
+	ut_assertok(fdt_open_into(gd->fdt_blob, ref, blob_sz));
+
+	/* Make the changes in a batch */
+	node = fdt_path_offset(blob, "/a-test");
+	ut_assert(node > 0);
+	port = fdt_path_offset(blob, "/dsa-test/ports/port@0");
+	ut_assert(port > node);
+
+	fdt_batch_init(&batch, blob);
+	ut_assertok(fdt_batch_setprop_string(&batch, 0, "serial-number",
+					     "1234"));
+	ut_assertok(fdt_batch_setprop_u32(&batch, node, "ping-expect", 5));
+	ut_assertok(fdt_batch_setprop_string(&batch, node, "compatible",
+					     compat));
+	ut_assertok(fdt_batch_delprop(&batch, node, "ping-add"));
+	ut_assertok(fdt_batch_delprop(&batch, node, "no-such-prop"));
+	ut_assertok(fdt_batch_setprop_u32(&batch, node, "reg", 1));
+	ut_assertok(fdt_batch_setprop_u64(&batch, node, "reg", 2));
+	ut_assertok(fdt_batch_setprop_string(&batch, port, "label", "wan"));
+	ut_assertok(fdt_batch_setprop(&batch, port, "u-boot,new-prop", NULL,
+				      0));
+	ut_assertok(fdt_batch_setprop_u32(&batch, port, "reg", 3));
+
+	/* The FDT is not touched until the changes are committed */
+	ut_asserteq_mem(ref, blob, fdt_totalsize(ref));
+
+	/* Adding a node commits the pending changes first */
+	child = fdt_batch_subnode(&batch, node, "new-child");
+	ut_assert(child > 0);
+	ut_asserteq(child, fdt_path_offset(blob, "/a-test/new-child"));
+	node = fdt_path_offset(blob, "/a-test");
+	ut_asserteq(node, fdt_batch_subnode(&batch, 0, "a-test"));
+	ut_assertok(fdt_batch_setprop_string(&batch, child, "status", "okay"));
+	ut_asserteq(-FDT_ERR_BADOFFSET,
+		    fdt_batch_setprop_u32(&batch, node + 1, "reg", 0));
+	ut_asserteq(-FDT_ERR_BADOFFSET, fdt_batch_commit(&batch));
+	ut_assertok(fdt_batch_setprop_string(&batch, child, "status", "okay"));
+	ut_assertok(fdt_batch_commit(&batch));
+
+	/* Make the same changes one at a time */
+	ut_assertok(fdt_setprop_string(ref, 0, "serial-number", "1234"));
+	node = fdt_path_offset(ref, "/a-test");
+	ut_assertok(fdt_setprop_u32(ref, node, "ping-expect", 5));
+	ut_assertok(fdt_setprop_string(ref, node, "compatible", compat));
+	ut_assertok(fdt_delprop(ref, node, "ping-add"));
+	ut_assertok(fdt_setprop_u64(ref, node, "reg", 2));
+	port = fdt_path_offset(ref, "/dsa-test/ports/port@0");
+	ut_assertok(fdt_setprop_string(ref, port, "label", "wan"));
+	ut_assertok(fdt_setprop_empty(ref, port, "u-boot,new-prop"));
+	ut_assertok(fdt_setprop_u32(ref, port, "reg", 3));
+	child = fdt_add_subnode(ref, node, "new-child");
+	ut_assert(child > 0);
+	ut_assertok(fdt_setprop_string(ref, child, "status", "okay"));
+
+	ut_assertok(check_fdt_same(uts, ref, blob));
+	ut_assertok(check_fdt_same(uts, blob, ref));
+	ut_asserteq(fdt_size_dt_struct(ref), fdt_size_dt_struct(blob));
+	ut_asserteq(fdt_size_dt_strings(ref), fdt_size_dt_strings(blob));
+
+	/* A batch which does not fit leaves the FDT alone */
+	ut_assertok(fdt_pack(blob));
+	memcpy(ref, blob, fdt_totalsize(blob));
+	node = fdt_path_offset(blob, "/a-test");
+	ut_assertok(fdt_batch_setprop(&batch, node, "u-boot,big", big,
+				      sizeof(big)));
+	ut_asserteq(-FDT_ERR_NOSPACE, fdt_batch_commit(&batch));
+	ut_asserteq_mem(ref, blob, fdt_totalsize(ref));
+
+	fdt_batch_uninit(&batch);
+	free(ref);
+	free(blob);
+
+	return 0;
+}
+DM_TEST(dm_test_fdt_batch, UT_TESTF_SCAN_FDT | UT_TESTF_FLAT_TREE);
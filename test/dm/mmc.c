@@ -5,6 +5,7 @@
 
 #include <common.h>
 #include <dm.h>
+#include <memalign.h>
 #include <mmc.h>
 #include <part.h>
 #include <dm/test.h>
@@ -52,3 +53,104 @@ static int dm_test_mmc_blk(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_mmc_blk, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
+static int dm_test_mmc_blk_sg(struct unit_test_state *uts)
+{
+	ALLOC_CACHE_ALIGN_BUFFER(char, write, 6 * 512);
+	ALLOC_CACHE_ALIGN_BUFFER(char, read, 6 * 512);
+	struct blk_desc *dev_desc;
+	struct udevice *dev;
+	int i;
+	/* Two runs which follow each other on the card, then a gap */
+	struct blk_sg sg[] = {
+		{ .start = 0, .blkcnt = 2, .buffer = read + 3 * 512 },
+		{ .start = 2, .blkcnt = 1, .buffer = read + 1 * 512 },
+		{ .start = 3, .blkcnt = 1, .buffer = read + 0 * 512 },
+		{ .start = 5, .blkcnt = 1, .buffer = read + 2 * 512 },
+		{ .start = 4, .blkcnt = 1, .buffer = read + 5 * 512 },
+	};
+
+	ut_assertok(uclass_get_device(UCLASS_MMC, 0, &dev));
+	ut_assertok(blk_get_device_by_str("mmc", "0", &dev_desc));
+
+	for (i = 0; i < 6 * 512; i++)
+		write[i] = i / 512 + 1;
+	ut_asserteq(6, blk_dwrite(dev_desc, 0, 6, write));
+
+	memset(read, '\0', 6 * 512);
+	ut_asserteq(6, blk_dread_sg(dev_desc, sg, ARRAY_SIZE(sg)));
+	for (i = 0; i < ARRAY_SIZE(sg); i++)
+		ut_asserteq_mem(write + sg[i].start * 512, sg[i].buffer,
+				sg[i].blkcnt * 512);
+
+	/* A read past the end of the card stops at that segment */
+	sg[2].start = dev_desc->lba;
+	ut_asserteq(3, blk_dread_sg(dev_desc, sg, ARRAY_SIZE(sg)));
+
+	return 0;
+}
+DM_TEST(dm_test_mmc_blk_sg, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+static int mmc_test_idle(void *priv)
+{
+	int *calls = priv;
+
+	(*calls)++;
+
+	return 1;
+}
+
+static int dm_test_mmc_blk_async(struct unit_test_state *uts)
+{
+	ALLOC_CACHE_ALIGN_BUFFER(char, write, 4 * 512);
+	ALLOC_CACHE_ALIGN_BUFFER(char, read, 4 * 512);
+	struct blk_desc *dev_desc;
+	struct udevice *dev;
+	struct blk_req req;
+	int i, calls = 0;
+
+	ut_assertok(uclass_get_device(UCLASS_MMC, 0, &dev));
+	ut_assertok(blk_get_device_by_str("mmc", "0", &dev_desc));
+
+	for (i = 0; i < 4 * 512; i++)
+		write[i] = i / 512 + 0x10;
+	ut_asserteq(4, blk_dwrite(dev_desc, 0, 4, write));
+
+	memset(read, '\0', 4 * 512);
+	req.start = 0;
+	req.blkcnt = 4;
+	req.buffer = read;
+	ut_assertok(blk_submit_read(dev_desc, &req));
+	ut_asserteq(-EBUSY, blk_poll(dev_desc, &req));
+	ut_assertok(blk_wait(dev_desc, &req));
+	ut_asserteq(4, req.xfered);
+	ut_asserteq_mem(write, read, 4 * 512);
+
+	/* Reads run the idle work while the transfer is in flight */
+	memset(read, '\0', 4 * 512);
+	blk_set_idle_work(mmc_test_idle, &calls);
+	ut_asserteq(4, blk_dread(dev_desc, 0, 4, read));
+	blk_set_idle_work(NULL, NULL);
+	ut_assert(calls > 0);
+	ut_asserteq_mem(write, read, 4 * 512);
+
+	/* So do writes */
+	for (i = 0; i < 4 * 512; i++)
+		write[i] = i / 512 + 0x20;
+	calls = 0;
+	blk_set_idle_work(mmc_test_idle, &calls);
+	ut_asserteq(4, blk_dwrite(dev_desc, 0, 4, write));
+	blk_set_idle_work(NULL, NULL);
+	ut_assert(calls > 0);
+	ut_asserteq(4, blk_dread(dev_desc, 0, 4, read));
+	ut_asserteq_mem(write, read, 4 * 512);
+
+	/* A read past the end of the card is rejected */
+	req.start = dev_desc->lba;
+	ut_assert(blk_submit_read(dev_desc, &req) < 0);
+
+	return 0;
+}
+DM_TEST(dm_test_mmc_blk_async, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+#endif
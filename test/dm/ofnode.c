@@ -2,12 +2,18 @@
 
 #include <common.h>
 #include <dm.h>
+#include <fdtdec.h>
 #include <log.h>
+#include <malloc.h>
+#include <of_live.h>
+#include <asm/global_data.h>
 #include <dm/of_extra.h>
 #include <dm/test.h>
 #include <test/test.h>
 #include <test/ut.h>
 
+DECLARE_GLOBAL_DATA_PTR;
+
 static int dm_test_ofnode_compatible(struct unit_test_state *uts)
 {
 	ofnode root_node = ofnode_path("/");
@@ -35,6 +41,229 @@ static int dm_test_ofnode_get_by_phandle(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_ofnode_get_by_phandle, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
 
+/* Check that every phandle resolves to the same node as a full scan finds */
+static int dm_test_ofnode_phandle_cache(struct unit_test_state *uts)
+{
+	const void *blob = gd->fdt_blob;
+	uint32_t max, phandle, val;
+	int pass, offset;
+	ofnode node;
+
+	ut_assertok(fdt_find_max_phandle(blob, &max));
+	ut_assert(max > 1);
+
+	/* The second pass is served from the cache */
+	for (pass = 0; pass < 2; pass++) {
+		for (phandle = 1; phandle <= max; phandle++) {
+			offset = fdt_node_offset_by_phandle(blob, phandle);
+			node = ofnode_get_by_phandle(phandle);
+			if (offset < 0) {
+				ut_assert(!ofnode_valid(node));
+				continue;
+			}
+			ut_assert(ofnode_valid(node));
+			ut_assertok(ofnode_read_u32(node, "phandle", &val));
+			ut_asserteq(phandle, val);
+			ut_asserteq_str(fdt_get_name(blob, offset, NULL),
+					ofnode_get_name(node));
+		}
+	}
+	ut_assert(!ofnode_valid(ofnode_get_by_phandle(max + 1)));
+
+	return 0;
+}
+DM_TEST(dm_test_ofnode_phandle_cache, UT_TESTF_SCAN_FDT);
+
+/* Check that lookups through the flat-tree index match libfdt */
+static int dm_test_ofnode_flat_index(struct unit_test_state *uts)
+{
+	const void *blob = gd->fdt_blob;
+	int offset, prop, subnode, len, ilen;
+	const char *name, *at;
+	char path[256];
+	const void *val;
+
+	fdtdec_index_reset();
+
+	/* Every lookup must give the same result as libfdt */
+	for (offset = 0; offset >= 0; offset = fdt_next_node(blob, offset,
+							     NULL)) {
+		ut_assertok(fdt_get_path(blob, offset, path, sizeof(path)));
+		ut_asserteq(fdt_path_offset(blob, path),
+			    fdtdec_path_offset(blob, path));
+
+		fdt_for_each_property_offset(prop, blob, offset) {
+			val = fdt_getprop_by_offset(blob, prop, &name, &len);
+			ut_asserteq_ptr(val, fdtdec_getprop(blob, offset, name,
+							    &ilen));
+			ut_asserteq(len, ilen);
+		}
+		ut_assertnull(fdtdec_getprop(blob, offset, "no-such-prop",
+					     &ilen));
+		ut_asserteq(-FDT_ERR_NOTFOUND, ilen);
+
+		fdt_for_each_subnode(subnode, blob, offset) {
+			name = fdt_get_name(blob, subnode, &len);
+			ut_asserteq(fdt_subnode_offset(blob, offset, name),
+				    fdtdec_subnode_offset(blob, offset, name));
+
+			/* The unit address may be left out */
+			at = strchr(name, '@');
+			if (!at)
+				continue;
+			len = at - name;
+			ut_asserteq(fdt_subnode_offset_namelen(blob, offset,
+							       name, len),
+				    fdtdec_subnode_offset_namelen(blob, offset,
+								  name, len));
+		}
+		ut_asserteq(-FDT_ERR_NOTFOUND,
+			    fdtdec_subnode_offset(blob, offset, "no-such-node"));
+	}
+
+	/* Aliases are followed too */
+	ut_asserteq(fdt_path_offset(blob, "testfdt5"),
+		    fdtdec_path_offset(blob, "testfdt5"));
+	ut_asserteq(fdt_path_offset(blob, "/some-bus//c-test@5/"),
+		    fdtdec_path_offset(blob, "/some-bus//c-test@5/"));
+	ut_asserteq(-FDT_ERR_BADPATH, fdtdec_path_offset(blob, "no-alias"));
+
+	return 0;
+}
+DM_TEST(dm_test_ofnode_flat_index, UT_TESTF_SCAN_FDT);
+
+/* Check that editing the control FDT with libfdt drops the index */
+static int dm_test_ofnode_flat_index_edit(struct unit_test_state *uts)
+{
+	const void *old_fdt = gd->fdt_blob;
+	int size = fdt_totalsize(old_fdt) + 256;
+	int bus, node;
+	void *blob;
+
+	blob = malloc(size);
+	ut_assertnonnull(blob);
+	ut_assertok(fdt_open_into(old_fdt, blob, size));
+	gd->fdt_blob = blob;
+
+	bus = fdtdec_path_offset(blob, "/some-bus");
+	ut_assert(bus >= 0);
+	node = fdtdec_subnode_offset(blob, bus, "c-test@5");
+	ut_assert(node >= 0);
+	ut_assertnonnull(fdtdec_getprop(blob, node, "compatible", NULL));
+
+	/* A rename keeps the size of the tree */
+	ut_assertok(fdt_set_name(blob, node, "d-test@5"));
+	ut_asserteq(-FDT_ERR_NOTFOUND, fdtdec_subnode_offset(blob, bus,
+							     "c-test@5"));
+	ut_asserteq(node, fdtdec_subnode_offset(blob, bus, "d-test@5"));
+	ut_asserteq(node, fdtdec_path_offset(blob, "/some-bus/d-test"));
+
+	ut_assertok(fdt_nop_property(blob, node, "compatible"));
+	ut_assertnull(fdtdec_getprop(blob, node, "compatible", NULL));
+
+	ut_assertok(fdt_setprop_u32(blob, node, "new-prop", 5));
+	ut_assertnonnull(fdtdec_getprop(blob, node, "new-prop", NULL));
+
+	gd->fdt_blob = old_fdt;
+	fdtdec_index_reset();
+	free(blob);
+
+	return 0;
+}
+DM_TEST(dm_test_ofnode_flat_index_edit, UT_TESTF_SCAN_FDT);
+
+#if CONFIG_IS_ENABLED(OF_LIVE_LAZY)
+/* Check that properties of the live tree are read from the flat tree */
+static int dm_test_ofnode_live_lazy(struct unit_test_state *uts)
+{
+	const void *blob = gd->fdt_blob;
+	const struct property *pp;
+	struct device_node *np;
+	int offset, prop, len;
+	const char *name;
+	const void *val;
+
+	/* Both trees are walked in the same order */
+	offset = 0;
+	for_each_of_allnodes(np) {
+		ut_assert(offset >= 0);
+		ut_assert(np->offset == -1 || np->offset == offset);
+		ut_asserteq(fdt_get_phandle(blob, offset), np->phandle);
+
+		/* Values are used in place */
+		fdt_for_each_property_offset(prop, blob, offset) {
+			val = fdt_getprop_by_offset(blob, prop, &name, &len);
+			ut_asserteq_ptr(val, of_get_property(np, name, NULL));
+		}
+
+		/* The properties are in order, followed by the name */
+		pp = of_get_first_property(np);
+		ut_asserteq(-1, np->offset);
+		fdt_for_each_property_offset(prop, blob, offset) {
+			ut_assertnonnull(pp);
+			fdt_getprop_by_offset(blob, prop, &name, &len);
+			ut_asserteq_str(name, pp->name);
+			ut_asserteq(len, pp->length);
+			pp = of_get_next_property(np, pp);
+		}
+		if (!fdt_getprop(blob, offset, "name", NULL)) {
+			ut_assertnonnull(pp);
+			ut_asserteq_str("name", pp->name);
+			ut_asserteq_str(np->name, pp->value);
+			pp = of_get_next_property(np, pp);
+		}
+		ut_assertnull(pp);
+		offset = fdt_next_node(blob, offset, NULL);
+	}
+	ut_asserteq(-FDT_ERR_NOTFOUND, offset);
+
+	return 0;
+}
+DM_TEST(dm_test_ofnode_live_lazy, UT_TESTF_SCAN_FDT | UT_TESTF_LIVE_TREE);
+
+/* Create a small flat tree with a node holding @val */
+static int make_lazy_fdt(struct unit_test_state *uts, void *buf, int size,
+			 const char *val)
+{
+	int node;
+
+	ut_assertok(fdt_create_empty_tree(buf, size));
+	node = fdt_add_subnode(buf, 0, "node");
+	ut_assert(node >= 0);
+	ut_assertok(fdt_setprop_string(buf, node, "val", val));
+
+	return 0;
+}
+
+/* Check that each live tree reads its properties from its own flat tree */
+static int dm_test_ofnode_live_lazy_mult(struct unit_test_state *uts)
+{
+	struct device_node *root1, *root2;
+	char fdt1[256], fdt2[256];
+	const char *val;
+
+	ut_assertok(make_lazy_fdt(uts, fdt1, sizeof(fdt1), "one"));
+	ut_assertok(make_lazy_fdt(uts, fdt2, sizeof(fdt2), "two"));
+	ut_assertok(of_live_build(fdt1, &root1));
+	ut_assertok(of_live_build(fdt2, &root2));
+
+	/* Read the first tree after the second is built */
+	val = of_get_property(root1->child, "val", NULL);
+	ut_asserteq_str("one", val);
+	ut_assert(val >= fdt1 && val < fdt1 + sizeof(fdt1));
+
+	val = of_get_property(root2->child, "val", NULL);
+	ut_asserteq_str("two", val);
+	ut_assert(val >= fdt2 && val < fdt2 + sizeof(fdt2));
+
+	of_live_free(root2);
+	of_live_free(root1);
+
+	return 0;
+}
+DM_TEST(dm_test_ofnode_live_lazy_mult, UT_TESTF_LIVE_TREE);
+#endif
+
 static int dm_test_ofnode_by_prop_value(struct unit_test_state *uts)
 {
 	const char propname[] = "compatible";
@@ -10,6 +10,7 @@
 #include <mapmem.h>
 #include <os.h>
 #include <spi.h>
+#include <spi-mem.h>
 #include <spi_flash.h>
 #include <asm/state.h>
 #include <asm/test.h>
@@ -21,7 +22,9 @@
 /* Simple test of sandbox SPI flash */
 static int dm_test_spi_flash(struct unit_test_state *uts)
 {
+	struct spi_mem_dirmap_desc *rdesc;
 	struct udevice *dev, *emul;
+	struct spi_flash *flash;
 	int full_size = 0x200000;
 	int size = 0x10000;
 	u8 *src, *dst;
@@ -38,6 +41,16 @@ static int dm_test_spi_flash(struct unit_test_state *uts)
 	ut_assertok(spi_flash_read_dm(dev, 0, size, dst));
 	ut_asserteq_mem(src, dst, size);
 
+	/* Sandbox has no memory window, so the read dirmap uses plain ops */
+	flash = dev_get_uclass_priv(dev);
+	rdesc = flash->dirmap.rdesc;
+	ut_assertnonnull(rdesc);
+	ut_asserteq(1, rdesc->nodirmap);
+	ut_asserteq(full_size, rdesc->info.length);
+	ut_asserteq(size - 0x100,
+		    spi_mem_dirmap_read(rdesc, 0x100, size - 0x100, dst));
+	ut_asserteq_mem(src + 0x100, dst, size - 0x100);
+
 	/* Erase */
 	ut_assertok(spi_flash_erase_dm(dev, 0, size));
 	ut_assertok(spi_flash_read_dm(dev, 0, size, dst));
@@ -51,6 +64,12 @@ static int dm_test_spi_flash(struct unit_test_state *uts)
 	ut_assertok(spi_flash_read_dm(dev, 0, size, dst));
 	ut_asserteq_mem(src, dst, size);
 
+	/* Erasing the whole flash is done with a chip erase */
+	ut_assertok(spi_flash_erase_dm(dev, 0, full_size));
+	ut_assertok(spi_flash_read_dm(dev, 0, full_size, dst));
+	for (i = 0; i < full_size; i++)
+		ut_asserteq(dst[i], 0xff);
+
 	/* Try the write-protect stuff */
 	ut_assertok(uclass_first_device_err(UCLASS_SPI_EMUL, &emul));
 	ut_asserteq(0, spl_flash_get_sw_write_prot(dev));
@@ -75,6 +94,116 @@ static int dm_test_spi_flash(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_spi_flash, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
 
+/* Test that an erase uses the largest erase type fitting each part of it */
+static int dm_test_spi_flash_erase_types(struct unit_test_state *uts)
+{
+	const struct sandbox_sf_erase *erases;
+	struct udevice *dev, *emul;
+	struct spi_flash *flash;
+	int full_size = 0x200000;
+	u8 *buf;
+	int i;
+
+	buf = map_sysmem(0x20000, full_size);
+	memset(buf, '\0', full_size);
+	ut_assertok(os_write_file("spi.bin", buf, full_size));
+	ut_assertok(uclass_first_device_err(UCLASS_SPI_FLASH, &dev));
+	ut_assertok(uclass_first_device_err(UCLASS_SPI_EMUL, &emul));
+
+	/* The m25p16 only has 64K sectors, so set up what SFDP could give */
+	flash = dev_get_uclass_priv(dev);
+	ut_asserteq(0x10000, flash->erase_types[0].size);
+	ut_asserteq(0, flash->erase_types[1].size);
+	flash->mtd.erasesize = 0x1000;
+	flash->erase_types[1].size = 0x8000;
+	flash->erase_types[1].opcode = SPINOR_OP_BE_32K;
+	flash->erase_types[2].size = 0x1000;
+	flash->erase_types[2].opcode = SPINOR_OP_BE_4K;
+
+	/* 4K up to a 32K boundary, 32K up to 64K, then back down at the end */
+	sandbox_sf_get_erases(emul, &erases);
+	ut_assertok(spi_flash_erase_dm(dev, 0x7000, 0x32000));
+	ut_asserteq(6, sandbox_sf_get_erases(emul, &erases));
+	ut_asserteq(0x7000, erases[0].offset);
+	ut_asserteq(0x1000, erases[0].size);
+	ut_asserteq(0x8000, erases[1].offset);
+	ut_asserteq(0x8000, erases[1].size);
+	ut_asserteq(0x10000, erases[2].offset);
+	ut_asserteq(0x10000, erases[2].size);
+	ut_asserteq(0x20000, erases[3].offset);
+	ut_asserteq(0x10000, erases[3].size);
+	ut_asserteq(0x30000, erases[4].offset);
+	ut_asserteq(0x8000, erases[4].size);
+	ut_asserteq(0x38000, erases[5].offset);
+	ut_asserteq(0x1000, erases[5].size);
+
+	/* Only the requested range is erased */
+	ut_assertok(spi_flash_read_dm(dev, 0, 0x40000, buf));
+	for (i = 0; i < 0x40000; i++)
+		ut_asserteq(i >= 0x7000 && i < 0x39000 ? 0xff : 0, buf[i]);
+
+	/* A range too short for the larger types uses the smallest one */
+	ut_assertok(spi_flash_erase_dm(dev, 0x48000, 0x2000));
+	ut_asserteq(2, sandbox_sf_get_erases(emul, &erases));
+	ut_asserteq(0x48000, erases[0].offset);
+	ut_asserteq(0x1000, erases[0].size);
+	ut_asserteq(0x49000, erases[1].offset);
+	ut_asserteq(0x1000, erases[1].size);
+
+	sandbox_sf_unbind_emul(state_get_current(), 0, 0);
+
+	return 0;
+}
+DM_TEST(dm_test_spi_flash_erase_types,
+	UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
+/* Test that 'sf update' does not erase sectors which are already blank */
+static int dm_test_spi_flash_update(struct unit_test_state *uts)
+{
+	const struct sandbox_sf_erase *erases;
+	struct udevice *dev, *emul;
+	int full_size = 0x200000;
+	int size = 0x20000;
+	u8 *buf, *src, *dst;
+	int i;
+
+	buf = map_sysmem(0x20000, full_size);
+	memset(buf, '\0', full_size);
+	ut_assertok(os_write_file("spi.bin", buf, full_size));
+	src = map_sysmem(0x300000, size);
+	dst = map_sysmem(0x300000 + size, size);
+	for (i = 0; i < size; i++)
+		src[i] = i;
+
+	ut_assertok(run_command("sf probe", 0));
+	ut_assertok(uclass_first_device_err(UCLASS_SPI_FLASH, &dev));
+	ut_assertok(uclass_first_device_err(UCLASS_SPI_EMUL, &emul));
+	ut_assertok(spi_flash_erase_dm(dev, 0, size));
+	sandbox_sf_get_erases(emul, &erases);
+
+	/* Both sectors are blank, so they are only programmed */
+	ut_assertok(run_command("sf update 300000 0 20000", 0));
+	ut_asserteq(0, sandbox_sf_get_erases(emul, &erases));
+	ut_assertok(spi_flash_read_dm(dev, 0, size, dst));
+	ut_asserteq_mem(src, dst, size);
+
+	/* The first sector is unchanged, the second must be erased */
+	src[0x10000] ^= 0xff;
+	ut_assertok(run_command("sf update 300000 0 20000", 0));
+	ut_asserteq(1, sandbox_sf_get_erases(emul, &erases));
+	ut_asserteq(0x10000, erases[0].offset);
+	ut_asserteq(0x10000, erases[0].size);
+	ut_assertok(spi_flash_read_dm(dev, 0, size, dst));
+	ut_asserteq_mem(src, dst, size);
+
+	unmap_sysmem(dst);
+	unmap_sysmem(src);
+	sandbox_sf_unbind_emul(state_get_current(), 0, 0);
+
+	return 0;
+}
+DM_TEST(dm_test_spi_flash_update, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
 /* Functional test that sandbox SPI flash works correctly */
 static int dm_test_spi_flash_func(struct unit_test_state *uts)
 {
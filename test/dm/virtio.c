@@ -87,6 +87,76 @@ static int dm_test_virtio_all_ops(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_virtio_all_ops, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
 
+/* Test chains of buffers using indirect descriptors */
+static int dm_test_virtio_ring_indirect(struct unit_test_state *uts)
+{
+	struct udevice *bus, *dev;
+	struct virtio_dev_priv *uc_priv;
+	struct virtqueue *vq;
+	struct vring_desc *desc, *table;
+	struct virtio_sg sg[3];
+	struct virtio_sg *sgs[3];
+	u8 buffer[3][16];
+	uint len;
+	int i;
+
+	ut_assertok(uclass_first_device(UCLASS_VIRTIO, &bus));
+	ut_assertok(device_find_first_child(bus, &dev));
+	uc_priv = dev_get_uclass_priv(bus);
+	uc_priv->vdev = dev;
+	uc_priv->features |= BIT_ULL(VIRTIO_RING_F_INDIRECT_DESC);
+	ut_assertok(virtio_find_vqs(dev, 1, &vq));
+	ut_assert(vq->indirect);
+
+	for (i = 0; i < 3; i++) {
+		sg[i].addr = buffer[i];
+		sg[i].length = sizeof(buffer[i]);
+		sgs[i] = &sg[i];
+	}
+
+	/* Each chain of three buffers takes one of the four ring entries */
+	for (i = 0; i < 4; i++)
+		ut_assertok(virtqueue_add(vq, sgs, 1, 2));
+	ut_asserteq(0, vq->num_free);
+	ut_asserteq(-ENOSPC, virtqueue_add(vq, sgs, 1, 2));
+
+	desc = vq->vring.desc;
+	ut_asserteq(VRING_DESC_F_INDIRECT, desc[0].flags);
+	ut_asserteq(3 * sizeof(struct vring_desc), desc[0].len);
+	table = (struct vring_desc *)(uintptr_t)desc[0].addr;
+	ut_asserteq_ptr(vq->indirect_desc, table);
+	ut_asserteq(VRING_DESC_F_NEXT, table[0].flags);
+	ut_asserteq(VRING_DESC_F_NEXT | VRING_DESC_F_WRITE, table[1].flags);
+	ut_asserteq(VRING_DESC_F_WRITE, table[2].flags);
+	ut_asserteq_ptr(buffer[2], (void *)(uintptr_t)table[2].addr);
+
+	/* Complete the chains as the device would */
+	for (i = 0; i < 4; i++) {
+		vq->vring.used->ring[i].id = 3 - i;
+		vq->vring.used->ring[i].len = 32;
+	}
+	vq->vring.used->idx = 4;
+	for (i = 0; i < 4; i++) {
+		ut_asserteq_ptr(buffer[0], virtqueue_get_buf(vq, &len));
+		ut_asserteq(32, len);
+	}
+	ut_asserteq(4, vq->num_free);
+	ut_assertnull(virtqueue_get_buf(vq, &len));
+
+	/* The table of a head is used again when the head is reused */
+	ut_assertok(virtqueue_add(vq, sgs, 1, 2));
+	ut_asserteq(VRING_DESC_F_INDIRECT, desc[0].flags);
+	ut_asserteq_ptr(table, (void *)(uintptr_t)desc[0].addr);
+
+	/* A chain too long for an indirect table needs that many entries */
+	ut_asserteq(-ENOSPC, virtqueue_add(vq, sgs, 1, VIRTQUEUE_MAX_INDIRECT));
+
+	ut_assertok(virtio_del_vqs(dev));
+
+	return 0;
+}
+DM_TEST(dm_test_virtio_ring_indirect, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
 /* Test of the virtio driver that does not have required driver ops */
 static int dm_test_virtio_missing_ops(struct unit_test_state *uts)
 {
@@ -0,0 +1,166 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the bounce buffer API
+ */
+
+#include <common.h>
+#include <bouncebuf.h>
+#include <malloc.h>
+#include <memalign.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+#define BUF_SIZE	256
+
+/* Test that an aligned buffer is used directly */
+static int lib_test_bouncebuf_direct(struct unit_test_state *uts)
+{
+	ALLOC_CACHE_ALIGN_BUFFER(u8, buf, BUF_SIZE);
+	struct bounce_buffer_stats stats;
+	struct bounce_buffer bb;
+
+	bounce_buffer_reset_stats();
+	ut_assertok(bounce_buffer_start(&bb, buf, BUF_SIZE, GEN_BB_RW));
+	ut_asserteq_ptr(buf, bb.bounce_buffer);
+	ut_asserteq(1, bb.nsegs);
+	ut_asserteq_ptr(buf, bb.seg[0].addr);
+	ut_asserteq(BUF_SIZE, bb.seg[0].len);
+	ut_assertok(bounce_buffer_stop(&bb));
+
+	bounce_buffer_get_stats(&stats);
+	ut_asserteq(1, stats.starts);
+	ut_asserteq(1, stats.direct);
+	ut_asserteq(0, stats.bytes_copied);
+
+	return 0;
+}
+LIB_TEST(lib_test_bouncebuf_direct, 0);
+
+/* Test bouncing a whole misaligned buffer, and reusing the pooled buffer */
+static int lib_test_bouncebuf_full(struct unit_test_state *uts)
+{
+	ALLOC_CACHE_ALIGN_BUFFER(u8, buf, BUF_SIZE + ARCH_DMA_MINALIGN);
+	struct bounce_buffer_stats stats;
+	struct bounce_buffer bb;
+	u8 *user = buf + 1;
+	int i;
+
+	bounce_buffer_reset_stats();
+	bounce_buffer_pool_release();
+	for (i = 0; i < BUF_SIZE; i++)
+		user[i] = i;
+
+	ut_assertok(bounce_buffer_start(&bb, user, BUF_SIZE, GEN_BB_RW));
+	ut_assert(bb.bounce_buffer != user);
+	ut_asserteq(1, bb.nsegs);
+	ut_asserteq_mem(user, bb.bounce_buffer, BUF_SIZE);
+
+	/* Pretend the device modified the data */
+	memset(bb.bounce_buffer, 0xa5, BUF_SIZE);
+	ut_assertok(bounce_buffer_stop(&bb));
+	for (i = 0; i < BUF_SIZE; i++)
+		ut_asserteq(0xa5, user[i]);
+
+	/* A second transfer of the same size should reuse the buffer */
+	ut_assertok(bounce_buffer_start(&bb, user, BUF_SIZE, GEN_BB_WRITE));
+	ut_assertok(bounce_buffer_stop(&bb));
+
+	bounce_buffer_get_stats(&stats);
+	ut_asserteq(2, stats.starts);
+	ut_asserteq(2, stats.full);
+	ut_asserteq(2 * BUF_SIZE * 2 - BUF_SIZE, stats.bytes_copied);
+	if (IS_ENABLED(CONFIG_BOUNCE_BUFFER_POOL)) {
+		ut_asserteq(1, stats.pool_misses);
+		ut_asserteq(1, stats.pool_hits);
+	}
+	bounce_buffer_pool_release();
+
+	return 0;
+}
+LIB_TEST(lib_test_bouncebuf_full, 0);
+
+#ifdef CONFIG_BOUNCE_BUFFER_POOL
+/* Test that buffers above the size limit are not kept in the pool */
+static int lib_test_bouncebuf_pool_limit(struct unit_test_state *uts)
+{
+	size_t len = CONFIG_BOUNCE_BUFFER_POOL_MAX_SIZE + ARCH_DMA_MINALIGN;
+	struct bounce_buffer bb;
+	size_t size;
+	int count;
+	u8 *buf;
+
+	bounce_buffer_pool_release();
+	buf = memalign(ARCH_DMA_MINALIGN, len + 1);
+	ut_assertnonnull(buf);
+
+	ut_assertok(bounce_buffer_start(&bb, buf + 1, len, GEN_BB_WRITE));
+	ut_assert(bb.bounce_buffer != buf + 1);
+	ut_assertok(bounce_buffer_stop(&bb));
+	bounce_buffer_pool_info(&count, &size);
+	ut_asserteq(0, count);
+
+	ut_assertok(bounce_buffer_start(&bb, buf + 1, BUF_SIZE, GEN_BB_WRITE));
+	ut_assertok(bounce_buffer_stop(&bb));
+	bounce_buffer_pool_info(&count, &size);
+	ut_asserteq(1, count);
+
+	bounce_buffer_pool_release();
+	free(buf);
+
+	return 0;
+}
+LIB_TEST(lib_test_bouncebuf_pool_limit, 0);
+#endif
+
+/* Test bouncing only the head and tail of a misaligned buffer */
+static int lib_test_bouncebuf_partial(struct unit_test_state *uts)
+{
+	ALLOC_CACHE_ALIGN_BUFFER(u8, buf, BUF_SIZE + ARCH_DMA_MINALIGN);
+	const int head = 3, len = BUF_SIZE - 2;
+	struct bounce_buffer_stats stats;
+	struct bounce_buffer bb;
+	u8 *user = buf + ARCH_DMA_MINALIGN - head;
+	int i, j, pos;
+
+	bounce_buffer_reset_stats();
+	for (i = 0; i < len; i++)
+		user[i] = i;
+
+	ut_assertok(bounce_buffer_start(&bb, user, len,
+					GEN_BB_RW | GEN_BB_PARTIAL));
+	ut_asserteq(3, bb.nsegs);
+	ut_asserteq(head, bb.seg[0].len);
+	ut_asserteq_ptr(buf + ARCH_DMA_MINALIGN, bb.seg[1].addr);
+	ut_asserteq(0, bb.seg[1].len % ARCH_DMA_MINALIGN);
+	ut_asserteq(len, bb.seg[0].len + bb.seg[1].len + bb.seg[2].len);
+
+	/* The segments must hold the data in order */
+	for (i = 0, pos = 0; i < bb.nsegs; i++) {
+		u8 *addr = bb.seg[i].addr;
+
+		ut_asserteq(0, (ulong)addr % ARCH_DMA_MINALIGN);
+		for (j = 0; j < bb.seg[i].len; j++, pos++) {
+			ut_asserteq((u8)pos, addr[j]);
+			addr[j] = ~pos;
+		}
+	}
+	ut_assertok(bounce_buffer_stop(&bb));
+	for (i = 0; i < len; i++)
+		ut_asserteq((u8)~i, user[i]);
+
+	bounce_buffer_get_stats(&stats);
+	ut_asserteq(1, stats.partial);
+	ut_asserteq(2 * (head + bb.tail_len), stats.bytes_copied);
+
+	/* Too short for an aligned middle part: falls back to full bounce */
+	ut_assertok(bounce_buffer_start(&bb, user, ARCH_DMA_MINALIGN,
+					GEN_BB_RW | GEN_BB_PARTIAL));
+	ut_asserteq(1, bb.nsegs);
+	ut_assert(bb.bounce_buffer != user);
+	ut_assertok(bounce_buffer_stop(&bb));
+	bounce_buffer_pool_release();
+
+	return 0;
+}
+LIB_TEST(lib_test_bouncebuf_partial, 0);
@@ -0,0 +1,126 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the cache of signature databases used by UEFI secure boot
+ */
+
+#include <common.h>
+#include <efi_loader.h>
+#include <efi_variable.h>
+#include <malloc.h>
+#include <pe.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+#include <u-boot/sha256.h>
+
+#define DB_ATTR (EFI_VARIABLE_BOOTSERVICE_ACCESS | \
+		 EFI_VARIABLE_RUNTIME_ACCESS | \
+		 EFI_VARIABLE_TIME_BASED_AUTHENTICATED_WRITE_ACCESS)
+
+static const efi_guid_t sha256_guid = EFI_CERT_SHA256_GUID;
+static const efi_guid_t pkcs7_guid = EFI_CERT_TYPE_PKCS7_GUID;
+
+/*
+ * Set db to a list of @count sha256 hashes filled with @fill, with an empty
+ * authentication header. This is accepted as long as secure boot is in
+ * setup mode. A @count of 0 deletes the variable.
+ */
+static int set_db(struct unit_test_state *uts, u8 fill, int count)
+{
+	struct efi_variable_authentication_2 *auth;
+	struct efi_signature_list *esl;
+	struct efi_signature_data *esd;
+	efi_uintn_t size;
+	void *buf;
+	int i;
+
+	size = sizeof(*auth) + sizeof(*esl) +
+	       count * (sizeof(*esd) + SHA256_SUM_LEN);
+	buf = calloc(1, size);
+	ut_assertnonnull(buf);
+
+	auth = buf;
+	auth->auth_info.hdr.dwLength = sizeof(auth->auth_info);
+	auth->auth_info.hdr.wRevision = WIN_CERT_REVISION_2_0;
+	auth->auth_info.hdr.wCertificateType = WIN_CERT_TYPE_EFI_GUID;
+	guidcpy(&auth->auth_info.cert_type, &pkcs7_guid);
+
+	esl = buf + sizeof(*auth);
+	guidcpy(&esl->signature_type, &sha256_guid);
+	esl->signature_size = sizeof(*esd) + SHA256_SUM_LEN;
+	esl->signature_list_size = size - sizeof(*auth);
+	esd = (void *)(esl + 1);
+	for (i = 0; i < count; i++) {
+		memset(esd->signature_data, fill + i, SHA256_SUM_LEN);
+		esd = (void *)esd + esl->signature_size;
+	}
+
+	if (!count)
+		size = sizeof(*auth);
+	ut_asserteq_64(EFI_SUCCESS,
+		       efi_set_variable_int(u"db", &efi_guid_image_security_database,
+					    DB_ATTR, size, buf, false));
+	free(buf);
+
+	return 0;
+}
+
+static int count_sigs(struct efi_signature_store *store)
+{
+	struct efi_sig_data *sig_data;
+	int count = 0;
+
+	for (sig_data = store->sig_data_list; sig_data;
+	     sig_data = sig_data->next)
+		count++;
+
+	return count;
+}
+
+static int lib_test_efi_sigstore_cache(struct unit_test_state *uts)
+{
+	struct efi_signature_store *db1, *db2, *db3;
+
+	ut_asserteq_64(EFI_SUCCESS, efi_init_obj_list());
+	if (efi_secure_boot_enabled())
+		return -EAGAIN;
+
+	ut_assertok(set_db(uts, 0x10, 2));
+
+	/* The store is only built once */
+	db1 = efi_sigstore_parse_sigdb(u"db");
+	ut_assertnonnull(db1);
+	ut_asserteq(2, count_sigs(db1));
+	db2 = efi_sigstore_parse_sigdb(u"db");
+	ut_asserteq_ptr(db1, db2);
+	efi_sigstore_free(db2);
+
+	/* and kept if the variable is set to the same value */
+	ut_assertok(set_db(uts, 0x10, 2));
+	db2 = efi_sigstore_parse_sigdb(u"db");
+	ut_asserteq_ptr(db1, db2);
+	efi_sigstore_free(db2);
+
+	/* A new value gives a new store, without touching the old one */
+	ut_assertok(set_db(uts, 0x20, 3));
+	db2 = efi_sigstore_parse_sigdb(u"db");
+	ut_assertnonnull(db2);
+	ut_assert(db1 != db2);
+	ut_asserteq(3, count_sigs(db2));
+	ut_asserteq(2, count_sigs(db1));
+	ut_asserteq(0x10, ((u8 *)db1->sig_data_list->data)[0] & 0xf0);
+	efi_sigstore_free(db1);
+
+	/* Deleting the variable gives an empty store */
+	ut_assertok(set_db(uts, 0, 0));
+	db3 = efi_sigstore_parse_sigdb(u"db");
+	ut_assertnonnull(db3);
+	ut_assertnull(db3->sig_data_list);
+	ut_asserteq(3, count_sigs(db2));
+	efi_sigstore_free(db3);
+	efi_sigstore_free(db2);
+
+	return 0;
+}
+
+LIB_TEST(lib_test_efi_sigstore_cache, 0);
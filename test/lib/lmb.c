@@ -667,9 +667,11 @@ DM_TEST(lib_test_lmb_get_free_size,
 
 static int lib_test_lmb_max_regions(struct unit_test_state *uts)
 {
+	const bool grow = IS_ENABLED(CONFIG_LMB_DYNAMIC_REGIONS);
 	const phys_addr_t ram = 0x00000000;
 	const phys_size_t ram_size = 0x8000000;
 	const phys_size_t blk_size = 0x10000;
+	const int max = grow ? 9 : 8;
 	phys_addr_t offset;
 	struct lmb lmb;
 	int ret, i;
@@ -690,12 +692,13 @@ static int lib_test_lmb_max_regions(struct unit_test_state *uts)
 	ut_asserteq(lmb.memory.cnt, 8);
 	ut_asserteq(lmb.reserved.cnt, 0);
 
-	/*  error for the 9th memory regions */
+	/*  error for the 9th memory regions, unless the array can grow */
 	offset = ram + 2 * 8 * ram_size;
 	ret = lmb_add(&lmb, offset, ram_size);
-	ut_asserteq(ret, -1);
+	ut_asserteq(ret, grow ? 0 : -1);
 
-	ut_asserteq(lmb.memory.cnt, 8);
+	ut_asserteq(lmb.memory.cnt, max);
+	ut_asserteq(lmb.memory.max, grow ? 16 : 8);
 	ut_asserteq(lmb.reserved.cnt, 0);
 
 	/*  reserve 8 regions */
@@ -705,24 +708,26 @@ static int lib_test_lmb_max_regions(struct unit_test_state *uts)
 		ut_asserteq(ret, 0);
 	}
 
-	ut_asserteq(lmb.memory.cnt, 8);
+	ut_asserteq(lmb.memory.cnt, max);
 	ut_asserteq(lmb.reserved.cnt, 8);
 
-	/*  error for the 9th reserved blocks */
+	/*  error for the 9th reserved blocks, unless the array can grow */
 	offset = ram + 2 * 8 * blk_size;
 	ret = lmb_reserve(&lmb, offset, blk_size);
-	ut_asserteq(ret, -1);
+	ut_asserteq(ret, grow ? 0 : -1);
 
-	ut_asserteq(lmb.memory.cnt, 8);
-	ut_asserteq(lmb.reserved.cnt, 8);
+	ut_asserteq(lmb.memory.cnt, max);
+	ut_asserteq(lmb.reserved.cnt, max);
 
 	/*  check each regions */
-	for (i = 0; i < 8; i++)
+	for (i = 0; i < max; i++)
 		ut_asserteq(lmb.memory.region[i].base, ram + 2 * i * ram_size);
 
-	for (i = 0; i < 8; i++)
+	for (i = 0; i < max; i++)
 		ut_asserteq(lmb.reserved.region[i].base, ram + 2 * i * blk_size);
 
+	lmb_uninit(&lmb);
+
 	return 0;
 }
 
@@ -817,3 +822,74 @@ static int lib_test_lmb_flags(struct unit_test_state *uts)
 
 DM_TEST(lib_test_lmb_flags,
 	UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
+/* Reserve and free a large number of regions in a scattered order */
+static int lib_test_lmb_many_regions(struct unit_test_state *uts)
+{
+	const phys_addr_t ram = 0x40000000;
+	const phys_size_t ram_size = 0x10000000;
+	const phys_size_t blk_size = 0x1000;
+	const int count = 1000;
+	ulong start = ut_check_free();
+	phys_addr_t base;
+	struct lmb lmb;
+	int i, j;
+
+	if (!IS_ENABLED(CONFIG_LMB_DYNAMIC_REGIONS))
+		return -EAGAIN;
+
+	lmb_init(&lmb);
+	ut_asserteq(0, lmb_add(&lmb, ram, ram_size));
+
+	/* Leave a gap after each block so that none are coalesced */
+	for (i = 0; i < count; i++) {
+		j = (i * 367) % count;
+		base = ram + j * blk_size * 2;
+		ut_asserteq(0, lmb_reserve(&lmb, base, blk_size));
+	}
+	ut_asserteq(count, lmb.reserved.cnt);
+	ut_assert(lmb.reserved.max >= count);
+	for (i = 0; i < count; i++) {
+		base = ram + i * blk_size * 2;
+		ut_asserteq(base, lmb.reserved.region[i].base);
+		ut_asserteq(1, lmb_is_reserved(&lmb, base + blk_size - 1));
+		ut_asserteq(0, lmb_is_reserved(&lmb, base + blk_size));
+		ut_asserteq(0, lmb_get_free_size(&lmb, base));
+		if (i < count - 1)
+			ut_asserteq(blk_size,
+				    lmb_get_free_size(&lmb, base + blk_size));
+	}
+
+	/* Overlapping a region anywhere in the list fails */
+	ut_asserteq(-1, lmb_reserve(&lmb, ram + 500 * blk_size * 2 + 0x10,
+				    blk_size));
+	ut_asserteq(count, lmb.reserved.cnt);
+
+	/* Filling the gaps coalesces the neighbours */
+	base = ram + 999 * blk_size;
+	ut_asserteq(base, lmb_alloc_addr(&lmb, base, blk_size));
+	ut_asserteq(count - 1, lmb.reserved.cnt);
+	ut_asserteq(ram + blk_size * 3, lmb_alloc_base(&lmb, blk_size, blk_size,
+						       ram + blk_size * 4));
+	ut_asserteq(count - 2, lmb.reserved.cnt);
+
+	/* Free the blocks from the middle of their regions */
+	for (i = 0; i < count; i++) {
+		base = ram + i * blk_size * 2;
+		ut_asserteq(0, lmb_free(&lmb, base + 0x100, 0x100));
+	}
+	ut_asserteq(count * 2 - 2, lmb.reserved.cnt);
+
+	/* Check that the regions are still sorted */
+	for (i = 1; i < lmb.reserved.cnt; i++)
+		ut_assert(lmb.reserved.region[i - 1].base +
+			  lmb.reserved.region[i - 1].size <=
+			  lmb.reserved.region[i].base);
+
+	lmb_uninit(&lmb);
+	ut_asserteq(0, ut_check_delta(start));
+
+	return 0;
+}
+
+DM_TEST(lib_test_lmb_many_regions, 0);
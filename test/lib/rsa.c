@@ -9,6 +9,7 @@
 #include <common.h>
 #include <command.h>
 #include <image.h>
+#include <time.h>
 #include <test/lib.h>
 #include <test/test.h>
 #include <test/ut.h>
@@ -129,6 +130,111 @@ unsigned char data_enc[] = {
 
 static unsigned int data_enc_len = 256;
 
+/*
+ * openssl genrsa 4096 -out private4096.pem
+ * openssl rsa -in private4096.pem -pubout -outform der -out public4096.der
+ * dd if=public4096.der of=public4096.raw bs=24 skip=1
+ */
+static unsigned char public_key_4096[] = {
+	0x30, 0x82, 0x02, 0x0a, 0x02, 0x82, 0x02, 0x01, 0x00, 0xdc, 0x6c, 0x73,
+	0x8e, 0xfe, 0x55, 0xbd, 0xc5, 0xbb, 0x76, 0xe9, 0x8b, 0x44, 0xa8, 0x5d,
+	0x06, 0x7d, 0x2f, 0xf5, 0x48, 0xe0, 0xbe, 0x1f, 0xe3, 0x8d, 0x65, 0x66,
+	0x7b, 0x44, 0x4d, 0xe0, 0xd3, 0x15, 0x74, 0xa4, 0xe9, 0xf6, 0xce, 0xf8,
+	0xd1, 0x6e, 0x7c, 0xe0, 0x6c, 0x2f, 0x8c, 0xc5, 0xe4, 0x49, 0x7c, 0xd7,
+	0xdc, 0xbe, 0x34, 0x0b, 0x77, 0x20, 0xc2, 0x0a, 0xde, 0x79, 0x18, 0x74,
+	0xc7, 0x88, 0xaa, 0x65, 0xc4, 0xd3, 0x41, 0x53, 0x25, 0x0e, 0x04, 0xaf,
+	0x46, 0x04, 0xe5, 0xbd, 0x61, 0x9f, 0x53, 0xff, 0x28, 0x9a, 0x25, 0x8d,
+	0xdd, 0x67, 0xed, 0x55, 0xce, 0xda, 0xa0, 0xfc, 0xff, 0x2c, 0x73, 0x1b,
+	0x3f, 0x35, 0xa2, 0x74, 0x72, 0x8b, 0xd3, 0x1f, 0x80, 0x0f, 0xe2, 0x06,
+	0x17, 0xc4, 0x77, 0x42, 0x42, 0x99, 0xb4, 0xf0, 0xbd, 0x0d, 0xbf, 0xc0,
+	0x07, 0x8d, 0x4b, 0x33, 0x52, 0xba, 0x64, 0x2e, 0x66, 0x41, 0xa1, 0x5a,
+	0x9b, 0xff, 0xfd, 0x52, 0x2c, 0xe6, 0x5c, 0x02, 0xb1, 0x76, 0x7c, 0xb1,
+	0x40, 0x8c, 0x0a, 0xfa, 0x6a, 0x46, 0xfa, 0x8f, 0xe7, 0x58, 0x0f, 0x3f,
+	0x0f, 0x27, 0xdc, 0x55, 0xc1, 0x93, 0x51, 0x0f, 0x23, 0xd6, 0x29, 0x0d,
+	0xf5, 0x54, 0x59, 0x15, 0x93, 0x33, 0x67, 0xf6, 0x54, 0xe5, 0xe7, 0x52,
+	0x6b, 0xa1, 0x3e, 0xf7, 0xfe, 0x32, 0xc4, 0x30, 0x71, 0xa8, 0xc1, 0x43,
+	0xed, 0xac, 0x9f, 0x55, 0x22, 0xf3, 0x2f, 0xe1, 0x38, 0xb2, 0x45, 0xf8,
+	0x3f, 0xdb, 0x92, 0x9a, 0xe8, 0xca, 0x9a, 0xe9, 0x03, 0xd0, 0x57, 0x24,
+	0x9d, 0x75, 0x5d, 0x39, 0xb7, 0xed, 0xd4, 0x1a, 0x96, 0xdf, 0x3d, 0x26,
+	0x1b, 0x4e, 0x43, 0x15, 0x63, 0xe7, 0x9e, 0x60, 0x17, 0x7a, 0x77, 0xf5,
+	0x9d, 0x20, 0x09, 0xc5, 0x2c, 0x4b, 0xc5, 0xd7, 0x04, 0xfd, 0x11, 0x6b,
+	0x20, 0x7d, 0x72, 0xc0, 0xda, 0x5f, 0x39, 0xbd, 0x07, 0xc8, 0x84, 0xe3,
+	0xf7, 0xc5, 0x0d, 0xc9, 0x5c, 0x2e, 0x97, 0x4f, 0xe7, 0xdc, 0x17, 0x39,
+	0x4b, 0xdc, 0x52, 0x38, 0x50, 0x14, 0xed, 0x95, 0x85, 0x6b, 0xfe, 0x7f,
+	0x83, 0x89, 0xaf, 0x3d, 0x36, 0x57, 0x3a, 0x1b, 0x36, 0xd1, 0x88, 0xc9,
+	0x94, 0xa8, 0x61, 0x27, 0xe5, 0x8a, 0xce, 0x76, 0xc4, 0x0a, 0x32, 0xbc,
+	0xee, 0x96, 0xfe, 0x50, 0x31, 0x30, 0x6c, 0x1d, 0xa1, 0xf9, 0xa1, 0x5c,
+	0x8a, 0x5f, 0xf3, 0x2e, 0x17, 0x03, 0xbc, 0x4e, 0x4b, 0xeb, 0x00, 0x71,
+	0x7c, 0x38, 0xe9, 0x7f, 0xfb, 0x1e, 0xdd, 0x94, 0xca, 0x83, 0x3a, 0x09,
+	0x3b, 0x37, 0xed, 0x1c, 0x8d, 0x22, 0xd3, 0x14, 0xf6, 0xee, 0x6e, 0x07,
+	0x79, 0x1c, 0x49, 0x57, 0x1f, 0x79, 0x5e, 0x13, 0x37, 0xe7, 0xbc, 0x79,
+	0x30, 0x14, 0x0f, 0x23, 0xad, 0x8f, 0x0e, 0x16, 0x5f, 0x1c, 0x96, 0x1a,
+	0x2e, 0x38, 0x2a, 0x49, 0x57, 0xde, 0xcb, 0x92, 0x70, 0xf2, 0xec, 0x0d,
+	0xe2, 0x0c, 0x0c, 0x93, 0xe8, 0xd1, 0x37, 0x13, 0x23, 0xa5, 0x4e, 0xb0,
+	0x5b, 0x9e, 0x01, 0xe4, 0xa5, 0x78, 0xd2, 0xfa, 0xf3, 0xcd, 0x90, 0x1a,
+	0x4b, 0xae, 0xd5, 0x25, 0x90, 0x46, 0xf8, 0x30, 0xa1, 0x21, 0x98, 0xd7,
+	0x84, 0x74, 0x13, 0xee, 0x89, 0xa9, 0x77, 0x6b, 0xab, 0x9e, 0x79, 0x7a,
+	0x3b, 0xe8, 0x36, 0xee, 0x5e, 0xb9, 0x62, 0x3a, 0x28, 0x73, 0x7a, 0x57,
+	0x36, 0x22, 0x6d, 0x2a, 0x42, 0x25, 0xd2, 0xd9, 0xcd, 0x17, 0xe3, 0x92,
+	0x29, 0x71, 0xf8, 0xb0, 0x51, 0xd5, 0x43, 0x4b, 0xa2, 0x24, 0x55, 0x9a,
+	0x16, 0x39, 0x3e, 0x39, 0x5a, 0x8a, 0xe8, 0xb2, 0x96, 0x2b, 0xd7, 0x12,
+	0x2f, 0x4f, 0xaf, 0x50, 0xa8, 0xd5, 0xdf, 0xb6, 0xc7, 0xf6, 0x28, 0x70,
+	0xf1, 0xd1, 0x92, 0x5c, 0xd9, 0x02, 0x03, 0x01, 0x00, 0x01
+};
+
+static unsigned int public_key_4096_len = 526;
+
+/*
+ * openssl dgst -sha256 -sign private4096.pem -out data4096.enc data.raw
+ */
+static unsigned char data_enc_4096[] = {
+	0xa0, 0xfd, 0x51, 0x6c, 0x96, 0xc1, 0xc1, 0xd7, 0x0d, 0x6c, 0xf6, 0x84,
+	0x76, 0xf5, 0xde, 0x6f, 0xd3, 0x8e, 0xd0, 0x80, 0x48, 0x9f, 0xd7, 0x09,
+	0x98, 0x94, 0x44, 0xa6, 0x43, 0x31, 0x4e, 0x6c, 0x57, 0xca, 0xc2, 0xce,
+	0xd4, 0x9f, 0x42, 0x77, 0x54, 0x09, 0x90, 0x8f, 0x93, 0x40, 0xda, 0xfe,
+	0xdc, 0xcb, 0x34, 0xba, 0xca, 0x20, 0xc7, 0x26, 0x11, 0x03, 0xd7, 0xe9,
+	0xb9, 0x9a, 0x42, 0xd6, 0xe5, 0x54, 0xd2, 0x9c, 0xcc, 0x51, 0x18, 0xd5,
+	0x17, 0x1d, 0x6e, 0xce, 0x5b, 0x4d, 0x22, 0xc2, 0x28, 0xec, 0xf2, 0xca,
+	0x87, 0x4f, 0x50, 0x2a, 0xfd, 0x49, 0x07, 0x21, 0xaa, 0xa6, 0xb9, 0x38,
+	0x25, 0xa2, 0x83, 0xf4, 0x12, 0x1e, 0x7c, 0x83, 0x8c, 0x44, 0x09, 0x39,
+	0x73, 0x83, 0xfb, 0x08, 0xf0, 0xad, 0x5e, 0xd9, 0xb8, 0x7e, 0xde, 0x2d,
+	0x3a, 0x04, 0x27, 0x0c, 0xde, 0x38, 0x5b, 0xd1, 0x49, 0x36, 0xe4, 0x84,
+	0x46, 0xc5, 0xf5, 0x5d, 0x7c, 0x5a, 0x84, 0x6a, 0x8e, 0xfb, 0x77, 0x4f,
+	0x62, 0xb7, 0x7a, 0xef, 0xd1, 0x1a, 0xa4, 0xec, 0x98, 0xda, 0xd5, 0xaa,
+	0x1e, 0xcf, 0xfc, 0x67, 0x11, 0x46, 0x49, 0x34, 0xc2, 0xa7, 0x9f, 0xa2,
+	0xb9, 0x9d, 0xe6, 0x3f, 0x0a, 0x89, 0xc9, 0x45, 0x4d, 0x34, 0x46, 0x4e,
+	0x64, 0x24, 0x67, 0x3a, 0x36, 0xb3, 0xda, 0x7e, 0x31, 0xa6, 0xec, 0x8b,
+	0x1c, 0x48, 0xd1, 0xcc, 0x41, 0x56, 0xf2, 0x92, 0x78, 0x2e, 0x1b, 0x94,
+	0xc2, 0x52, 0x53, 0xd5, 0xa7, 0x18, 0xce, 0xed, 0x1c, 0x23, 0x79, 0xaa,
+	0xb7, 0xfb, 0xc5, 0x13, 0x16, 0x4f, 0xad, 0xdd, 0xe0, 0xe5, 0xb3, 0xfb,
+	0x67, 0x61, 0x8a, 0x83, 0x38, 0x94, 0x5e, 0x6e, 0x3a, 0xcf, 0x34, 0x8f,
+	0x10, 0xbc, 0xea, 0x99, 0xa8, 0x63, 0xe0, 0x86, 0x7c, 0x1f, 0xc2, 0x62,
+	0x58, 0x05, 0xdc, 0xb1, 0x42, 0xcc, 0x1e, 0xa7, 0xb4, 0xe6, 0x23, 0x30,
+	0xac, 0x97, 0x88, 0x54, 0xce, 0x90, 0x35, 0x47, 0xfc, 0x50, 0xe1, 0x86,
+	0x9f, 0xa9, 0xe1, 0x34, 0x87, 0x2d, 0x0d, 0x44, 0x3d, 0x6f, 0xb0, 0xab,
+	0x54, 0x33, 0x0f, 0x6d, 0x80, 0xd8, 0xd4, 0xd6, 0x14, 0x66, 0xbf, 0x81,
+	0x5d, 0xb0, 0x36, 0xff, 0xa9, 0x02, 0xa0, 0xa0, 0x4e, 0x34, 0x62, 0x28,
+	0x3a, 0xe9, 0x56, 0x80, 0x00, 0x46, 0xb2, 0x65, 0x43, 0xf5, 0x7f, 0x1d,
+	0xaf, 0x1c, 0x86, 0xfa, 0xcd, 0xaf, 0xb6, 0x03, 0x9d, 0x79, 0xcd, 0xd8,
+	0xe3, 0x25, 0x9e, 0x73, 0x0a, 0x9a, 0x0e, 0x2d, 0x50, 0x61, 0x8d, 0x4d,
+	0xef, 0xe0, 0x82, 0xac, 0xef, 0x4c, 0x4c, 0xf2, 0x78, 0x28, 0x94, 0x69,
+	0x99, 0xfc, 0xbd, 0xf3, 0xdb, 0x18, 0xbb, 0x03, 0x83, 0xe1, 0xb6, 0x3c,
+	0xb2, 0xc2, 0xfc, 0xda, 0x82, 0xb4, 0x9b, 0x52, 0x8b, 0x38, 0xaf, 0x6c,
+	0xd7, 0xb3, 0x0c, 0x94, 0xbf, 0x97, 0x82, 0x4d, 0x26, 0x06, 0x3a, 0x61,
+	0x63, 0xe7, 0x29, 0x22, 0xc5, 0x5d, 0x6f, 0xd6, 0x58, 0x94, 0x15, 0xa0,
+	0xb9, 0x96, 0x2a, 0x6c, 0xf8, 0xd7, 0x7c, 0xe1, 0x15, 0x39, 0x12, 0x8d,
+	0x53, 0xb8, 0xc6, 0x93, 0x06, 0x42, 0xda, 0x41, 0xa5, 0x13, 0xf5, 0xb6,
+	0x0c, 0x7a, 0xea, 0x48, 0x83, 0xeb, 0xc3, 0xbf, 0xf8, 0x8d, 0x1e, 0x01,
+	0xe7, 0x6c, 0x42, 0xa1, 0x9a, 0xbd, 0x67, 0x41, 0x9f, 0xa1, 0xe3, 0x30,
+	0x20, 0x23, 0x35, 0x7e, 0x28, 0x06, 0x48, 0xce, 0x13, 0x35, 0x9b, 0xf9,
+	0x37, 0xf4, 0x63, 0x08, 0x4b, 0x6d, 0xc0, 0x73, 0xb8, 0x09, 0x89, 0x5f,
+	0x3d, 0x5c, 0x9a, 0xd7, 0x50, 0x0e, 0x74, 0xdf, 0x92, 0x47, 0xbf, 0x62,
+	0xb2, 0x9b, 0xc6, 0x40, 0x2c, 0x3b, 0x1d, 0x84, 0xf9, 0xeb, 0x41, 0xaa,
+	0xa3, 0x39, 0x08, 0xf7, 0x5a, 0xe4, 0xcc, 0xd6
+};
+
+static unsigned int data_enc_4096_len = 512;
+
 /**
  * lib_rsa_verify_valid() - unit test for rsa_verify()
  *
@@ -203,4 +309,59 @@ static int lib_rsa_verify_invalid(struct unit_test_state *uts)
 }
 
 LIB_TEST(lib_rsa_verify_invalid, 0);
+
+/* Number of signature checks for each key in lib_rsa_verify_speed() */
+#define RSA_SPEED_COUNT		100
+
+static int rsa_verify_speed(struct unit_test_state *uts, const char *name,
+			    unsigned char *key, unsigned int key_len,
+			    unsigned char *sig, unsigned int sig_len)
+{
+	struct image_sign_info info;
+	struct image_region reg;
+	ulong start, elapsed;
+	int i;
+
+	memset(&info, '\0', sizeof(info));
+	info.name = name;
+	info.padding = image_get_padding_algo("pkcs-1.5");
+	info.checksum = image_get_checksum_algo(name);
+	info.crypto = image_get_crypto_algo(name);
+	info.key = key;
+	info.keylen = key_len;
+
+	reg.data = data_raw;
+	reg.size = data_raw_len;
+	start = timer_get_us();
+	for (i = 0; i < RSA_SPEED_COUNT; i++)
+		ut_assertok(rsa_verify(&info, &reg, 1, sig, sig_len));
+	elapsed = max(timer_get_us() - start, 1UL);
+
+	printf("%s: %lu verifications/s\n", name,
+	       RSA_SPEED_COUNT * 1000000UL / elapsed);
+
+	return 0;
+}
+
+/**
+ * lib_rsa_verify_speed() - measure the speed of rsa_verify()
+ *
+ * Check the same signature repeatedly with 2048-bit and 4096-bit keys and
+ * show the number of checks per second
+ *
+ * @uts:	unit test state
+ * Return:	0 = success, 1 = failure
+ */
+static int lib_rsa_verify_speed(struct unit_test_state *uts)
+{
+	ut_assertok(rsa_verify_speed(uts, "sha256,rsa2048", public_key,
+				     public_key_len, data_enc, data_enc_len));
+	ut_assertok(rsa_verify_speed(uts, "sha256,rsa4096", public_key_4096,
+				     public_key_4096_len, data_enc_4096,
+				     data_enc_4096_len));
+
+	return CMD_RET_SUCCESS;
+}
+
+LIB_TEST(lib_rsa_verify_speed, 0);
 #endif /* RSA_VERIFY_WITH_PKEY */
@@ -43,7 +43,8 @@ ulong ut_check_free(void)
 {
 	struct mallinfo info = mallinfo();
 
-	return info.uordblks;
+	/* Include blocks in the heap for large blocks */
+	return info.uordblks + info.hblkhd;
 }
 
 long ut_check_delta(ulong last)